@@ -0,0 +1,10 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    app \
+    ThinkTagSplitterTest \
+    ChatContextBuilderTest
+
+app.file = LLM/AIAssit.pro
+ThinkTagSplitterTest.subdir = tests/ThinkTagSplitterTest
+ChatContextBuilderTest.subdir = tests/ChatContextBuilderTest
@@ -1,4 +1,4 @@
-QT += core gui widgets network xml
+QT += core gui widgets network sql xml
 CONFIG += c++14
 TEMPLATE = app
 TARGET = AIAssit
@@ -7,11 +7,20 @@ INCLUDEPATH += $$PWD
 SOURCES += \
     AIParamWidget.cpp \
     AppConfigRepository.cpp \
+    BubbleChrome.cpp \
+    BubbleRenderService.cpp \
+    ChatArchive.cpp \
+    ChatContextBuilder.cpp \
+    ChatHistoryIndex.cpp \
     ChatInputWidget.cpp \
     ChatList.cpp \
     ChatSessionService.cpp \
     ChatShowWidget.cpp \
+    ChatTranscriptDelegate.cpp \
+    ChatTranscriptModel.cpp \
+    ChatTranscriptView.cpp \
     ClipboardTools.cpp \
+    CodeLexer.cpp \
     DataFormatTools.cpp \
     DateTimeTools.cpp \
     DifyClient.cpp \
@@ -25,29 +34,47 @@ SOURCES += \
     LLMFunctionCall.cpp \
     LLMParams.cpp \
     main.cpp \
+    MarkdownDocumentBuilder.cpp \
     MessageManager.cpp \
     ModelSelectorWidget.cpp \
+    NetworkWorker.cpp \
     OllamaClient.cpp \
     Open_WebUIClient.cpp \
     PromptLibrary.cpp \
     PromptLibraryDialog.cpp \
+    RenderCache.cpp \
+    SessionJournal.cpp \
     ShortcutEdit.cpp \
     ShortcutManager.cpp \
+    SqliteSessionStore.cpp \
+    StreamingMarkdownRenderer.cpp \
+    StreamFrameParser.cpp \
+    StreamRenderScheduler.cpp \
     SyntaxHighlighter.cpp \
     SystemInfoTools.cpp \
     TextProcessingTools.cpp \
+    ThinkTagSplitter.cpp \
     UtilityTools.cpp \
     VisionTools.cpp
 
 HEADERS += \
     AIParamWidget.h \
     AppConfigRepository.h \
+    BubbleChrome.h \
+    BubbleRenderService.h \
+    ChatArchive.h \
+    ChatContextBuilder.h \
+    ChatHistoryIndex.h \
     ChatInputWidget.h \
     ChatList.h \
     ChatSessionService.h \
     ChatSessionTypes.h \
     ChatShowWidget.h \
+    ChatTranscriptDelegate.h \
+    ChatTranscriptModel.h \
+    ChatTranscriptView.h \
     ClipboardTools.h \
+    CodeLexer.h \
     CommonTypes.h \
     DataFormatTools.h \
     DateTimeTools.h \
@@ -61,17 +88,27 @@ HEADERS += \
     LLMClientManager.h \
     LLMFunctionCall.h \
     LLMParams.h \
+    MarkdownDocumentBuilder.h \
     MessageManager.h \
     ModelSelectorWidget.h \
+    NetworkWorker.h \
     OllamaClient.h \
     Open_WebUIClient.h \
     PromptLibrary.h \
     PromptLibraryDialog.h \
+    RenderCache.h \
+    SessionJournal.h \
+    SessionStore.h \
     ShortcutEdit.h \
     ShortcutManager.h \
+    SqliteSessionStore.h \
+    StreamingMarkdownRenderer.h \
+    StreamFrameParser.h \
+    StreamRenderScheduler.h \
     SyntaxHighlighter.h \
     SystemInfoTools.h \
     TextProcessingTools.h \
+    ThinkTagSplitter.h \
     UtilityTools.h \
     VisionTools.h
 
@@ -94,6 +131,11 @@ win32:msvc {
     }
 }
 
+# 进程内存统计（ChatArchive::benchmark）
+win32 {
+    LIBS += -lpsapi
+}
+
 # output directories
 CONFIG(debug, debug|release) {
     DESTDIR = $$PROJECT_ROOT/bin/debug
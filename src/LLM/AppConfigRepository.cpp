@@ -43,6 +43,11 @@ QString AppConfigRepository::chatHistoryFile() const
 	return chatHistoryDirectory() + "/LLMChat_" + QDate::currentDate().toString("yyyy-MM-dd") + ".json";
 }
 
+QString AppConfigRepository::chatHistoryDatabaseFile() const
+{
+	return chatHistoryDirectory() + "/LLMChat_" + QDate::currentDate().toString("yyyy-MM-dd") + ".db";
+}
+
 QString AppConfigRepository::modelConfigFile() const
  {
 	return m_baseDir + "/" + kModelConfigFile;
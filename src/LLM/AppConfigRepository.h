@@ -14,6 +14,8 @@ public:
 	[[nodiscard]] QString baseConfigDir() const;
 	[[nodiscard]] QString chatHistoryDirectory() const;
 	[[nodiscard]] QString chatHistoryFile() const;
+	// 会话数据库（与当天的 JSON 文件对应）
+	[[nodiscard]] QString chatHistoryDatabaseFile() const;
 	
 	// 配置文件路径
 	[[nodiscard]] QString modelConfigFile() const;
@@ -0,0 +1,274 @@
+#include "BubbleChrome.h"
+#include <QImage>
+#include <QLinearGradient>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPixmapCache>
+#include <QPolygonF>
+#include <QVector>
+#include <QtMath>
+
+namespace
+{
+	constexpr qreal kBorderWidth = 1.2;
+	constexpr int kBlurPasses = 3;  // 三次盒式模糊近似高斯模糊
+	constexpr int kTailOverlap = 3;  // 尖角伸入气泡的宽度，盖住接缝处的边框
+
+	// 对一行（或一列）像素的一个通道做盒式模糊，step 为相邻像素的字节距离
+	void blurLine(uchar* data, int count, int step, int radius, QVector<int>& buffer)
+	{
+		buffer.resize(count);
+		for (int i = 0; i < count; ++i)
+		{
+			buffer[i] = data[i * step];
+		}
+		const int window = 2 * radius + 1;
+		int sum = 0;
+		for (int i = -radius; i <= radius; ++i)
+		{
+			sum += buffer[qBound(0, i, count - 1)];
+		}
+		for (int i = 0; i < count; ++i)
+		{
+			data[i * step] = uchar(sum / window);
+			sum += buffer[qMin(count - 1, i + radius + 1)] - buffer[qMax(0, i - radius)];
+		}
+	}
+	// 预乘 alpha 的图像可以直接逐通道模糊
+	void blurImage(QImage& image, int radius)
+	{
+		if (radius <= 0)
+		{
+			return;
+		}
+		QVector<int> buffer;
+		const int width = image.width();
+		const int height = image.height();
+		for (int pass = 0; pass < kBlurPasses; ++pass)
+		{
+			for (int y = 0; y < height; ++y)
+			{
+				uchar* line = image.scanLine(y);
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					blurLine(line + channel, width, 4, radius, buffer);
+				}
+			}
+			for (int x = 0; x < width; ++x)
+			{
+				uchar* column = image.bits() + x * 4;
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					blurLine(column + channel, height, image.bytesPerLine(), radius, buffer);
+				}
+			}
+		}
+	}
+	QLinearGradient fillGradient(const QRectF& rect, const QColor& fill)
+	{
+		QLinearGradient gradient(rect.topLeft(), rect.bottomLeft());
+		gradient.setColorAt(0.0, fill.lighter(108));
+		gradient.setColorAt(1.0, fill);
+		return gradient;
+	}
+	qreal devicePixelRatio(const QPainter& painter)
+	{
+		const QPaintDevice* device = painter.device();
+		return device ? device->devicePixelRatioF() : 1.0;
+	}
+}
+
+int BubbleChrome::margin(const Style& style)
+{
+	return style.blurRadius + qMax(qAbs(style.shadowOffset.x()), qAbs(style.shadowOffset.y())) + 2;
+}
+
+int BubbleChrome::corner(const Style& style)
+{
+	return style.radius + 2;
+}
+
+QPixmap BubbleChrome::ninePatch(const Style& style, qreal dpr)
+{
+	const QString key = QStringLiteral("bubble:%1:%2:%3:%4:%5:%6:%7:%8")
+		.arg(style.fill.rgba()).arg(style.border.rgba()).arg(style.shadow.rgba())
+		.arg(style.radius).arg(style.shadowOffset.x()).arg(style.shadowOffset.y())
+		.arg(style.blurRadius).arg(dpr);
+	QPixmap pixmap;
+	if (QPixmapCache::find(key, &pixmap))
+	{
+		return pixmap;
+	}
+
+	// 源图：外圈留出阴影的边距，中间是边长为 2*corner+kCenter 的气泡
+	const int m = margin(style);
+	const int body = 2 * corner(style) + kCenter;
+	const int side = body + 2 * m;
+	const QRectF bubbleRect(m, m, body, body);
+	QImage image(qCeil(side * dpr), qCeil(side * dpr), QImage::Format_ARGB32_Premultiplied);
+	image.setDevicePixelRatio(dpr);
+	image.fill(Qt::transparent);
+	if (style.shadow.alpha() > 0 && (style.blurRadius > 0 || !style.shadowOffset.isNull()))
+	{
+		QImage shadow(image.size(), QImage::Format_ARGB32_Premultiplied);
+		shadow.setDevicePixelRatio(dpr);
+		shadow.fill(Qt::transparent);
+		{
+			QPainter painter(&shadow);
+			painter.setRenderHint(QPainter::Antialiasing, true);
+			painter.setPen(Qt::NoPen);
+			painter.setBrush(style.shadow);
+			painter.drawRoundedRect(bubbleRect.translated(style.shadowOffset), style.radius, style.radius);
+		}
+		blurImage(shadow, qRound(style.blurRadius * dpr / 2));
+		QPainter painter(&image);
+		painter.drawImage(0, 0, shadow);
+	}
+	{
+		QPainter painter(&image);
+		painter.setRenderHint(QPainter::Antialiasing, true);
+		painter.setBrush(fillGradient(bubbleRect, style.fill));
+		painter.setPen(QPen(style.border, kBorderWidth));
+		painter.drawRoundedRect(bubbleRect, style.radius, style.radius);
+	}
+	pixmap = QPixmap::fromImage(image);
+	QPixmapCache::insert(key, pixmap);
+	return pixmap;
+}
+
+void BubbleChrome::drawDirect(QPainter& painter, const QRect& rect, const Style& style)
+{
+	painter.save();
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	if (style.shadow.alpha() > 0 && !style.shadowOffset.isNull())
+	{
+		painter.setPen(Qt::NoPen);
+		painter.setBrush(style.shadow);
+		painter.drawRoundedRect(QRectF(rect).translated(style.shadowOffset), style.radius, style.radius);
+	}
+	painter.setBrush(fillGradient(rect, style.fill));
+	painter.setPen(QPen(style.border, kBorderWidth));
+	painter.drawRoundedRect(QRectF(rect), style.radius, style.radius);
+	painter.restore();
+}
+
+void BubbleChrome::drawTail(QPainter& painter, const QRect& rect, const QRect& tailRect, bool alignLeft, const Style& style)
+{
+	const qreal inset = tailRect.height() * 0.25;
+	const qreal baseX = alignLeft ? tailRect.right() : tailRect.left();
+	const qreal tipX = alignLeft ? tailRect.left() : tailRect.right();
+	const qreal innerX = alignLeft ? baseX + kTailOverlap : baseX - kTailOverlap;
+	const QPointF top(baseX, tailRect.top() + inset);
+	const QPointF tip(tipX, tailRect.center().y());
+	const QPointF bottom(baseX, tailRect.bottom() - inset);
+	QPolygonF fill;
+	fill << QPointF(innerX, top.y()) << top << tip << bottom << QPointF(innerX, bottom.y());
+
+	painter.save();
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	painter.setPen(Qt::NoPen);
+	painter.setBrush(fillGradient(rect, style.fill));
+	painter.drawPolygon(fill);
+	painter.setPen(QPen(style.border, kBorderWidth));
+	painter.setBrush(Qt::NoBrush);
+	QPolygonF edge;
+	edge << top << tip << bottom;
+	painter.drawPolyline(edge);
+	painter.restore();
+}
+
+void BubbleChrome::drawBubble(QPainter& painter, const QRect& rect, const QRect& tailRect, bool alignLeft, const Style& style)
+{
+	if (!rect.isValid())
+	{
+		return;
+	}
+	const bool hasTail = tailRect.isValid();
+	// 硬阴影下尖角也投影；模糊阴影由主体提供即可
+	if (hasTail && style.blurRadius == 0 && style.shadow.alpha() > 0 && !style.shadowOffset.isNull())
+	{
+		const qreal inset = tailRect.height() * 0.25;
+		const qreal baseX = alignLeft ? tailRect.right() + kTailOverlap : tailRect.left() - kTailOverlap;
+		QPolygonF shadow;
+		shadow << QPointF(baseX, tailRect.top() + inset)
+			<< QPointF(alignLeft ? tailRect.left() : tailRect.right(), tailRect.center().y())
+			<< QPointF(baseX, tailRect.bottom() - inset);
+		painter.save();
+		painter.setRenderHint(QPainter::Antialiasing, true);
+		painter.setPen(Qt::NoPen);
+		painter.setBrush(style.shadow);
+		painter.drawPolygon(shadow.translated(style.shadowOffset));
+		painter.restore();
+	}
+
+	const int c = corner(style);
+	if (rect.width() < 2 * c || rect.height() < 2 * c)
+	{
+		// 比四角还小的气泡无法拼接，直接绘制
+		drawDirect(painter, rect, style);
+	}
+	else
+	{
+		const qreal dpr = devicePixelRatio(painter);
+		const QPixmap pixmap = ninePatch(style, dpr);
+		const int m = margin(style);
+		const qreal side = 2 * (m + c) + kCenter;
+		const QRectF target = QRectF(rect).adjusted(-m, -m, m, m);
+		const qreal sourceX[4] = { 0, qreal(m + c), side - (m + c), side };
+		const qreal sourceY[4] = { 0, qreal(m + c), side - (m + c), side };
+		const qreal targetX[4] = { target.left(), target.left() + m + c, target.right() - (m + c), target.right() };
+		const qreal targetY[4] = { target.top(), target.top() + m + c, target.bottom() - (m + c), target.bottom() };
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				const QRectF to(QPointF(targetX[column], targetY[row]), QPointF(targetX[column + 1], targetY[row + 1]));
+				if (to.width() <= 0 || to.height() <= 0)
+				{
+					continue;
+				}
+				const QRectF from(QPointF(sourceX[column] * dpr, sourceY[row] * dpr),
+					QPointF(sourceX[column + 1] * dpr, sourceY[row + 1] * dpr));
+				painter.drawPixmap(to, pixmap, from);
+			}
+		}
+	}
+
+	if (hasTail)
+	{
+		drawTail(painter, rect, tailRect, alignLeft, style);
+	}
+}
+
+void BubbleChrome::drawRing(QPainter& painter, const QRect& rect, const QColor& top, const QColor& bottom)
+{
+	if (!rect.isValid())
+	{
+		return;
+	}
+	const qreal dpr = devicePixelRatio(painter);
+	const QString key = QStringLiteral("ring:%1:%2:%3:%4:%5")
+		.arg(rect.width()).arg(rect.height()).arg(top.rgba()).arg(bottom.rgba()).arg(dpr);
+	QPixmap pixmap;
+	if (!QPixmapCache::find(key, &pixmap))
+	{
+		QImage image(qCeil(rect.width() * dpr), qCeil(rect.height() * dpr), QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(dpr);
+		image.fill(Qt::transparent);
+		{
+			QPainter ringPainter(&image);
+			ringPainter.setRenderHint(QPainter::Antialiasing, true);
+			const QRectF ringRect(0, 0, rect.width(), rect.height());
+			QLinearGradient gradient(ringRect.topLeft(), ringRect.bottomLeft());
+			gradient.setColorAt(0.0, top);
+			gradient.setColorAt(1.0, bottom);
+			ringPainter.setPen(Qt::NoPen);
+			ringPainter.setBrush(gradient);
+			ringPainter.drawEllipse(ringRect);
+		}
+		pixmap = QPixmap::fromImage(image);
+		QPixmapCache::insert(key, pixmap);
+	}
+	painter.drawPixmap(rect.topLeft(), pixmap);
+}
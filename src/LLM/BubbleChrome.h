@@ -0,0 +1,39 @@
+#pragma once
+#include <QColor>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+
+class QPainter;
+
+// 气泡外观（背景、边框、阴影）与头像外环的预渲染
+// 气泡按九宫格渲染一次存入 QPixmapCache，绘制时四角原样贴出、四边与中间拉伸；
+// 阴影模糊只在生成缓存时计算，不再为每个气泡挂 QGraphicsDropShadowEffect 逐帧离屏模糊
+class BubbleChrome
+{
+public:
+	struct Style
+	{
+		QColor fill;
+		QColor border;
+		QColor shadow;
+		int radius = 0;
+		QPoint shadowOffset;
+		int blurRadius = 0;  // 0 为不模糊的硬阴影
+	};
+
+	// rect 为气泡主体，tailRect 有效时在 alignLeft 指定的一侧画出尖角
+	static void drawBubble(QPainter& painter, const QRect& rect, const QRect& tailRect, bool alignLeft, const Style& style);
+	// 头像外环：自上而下渐变填充的圆
+	static void drawRing(QPainter& painter, const QRect& rect, const QColor& top, const QColor& bottom);
+
+private:
+	static QPixmap ninePatch(const Style& style, qreal dpr);
+	static void drawDirect(QPainter& painter, const QRect& rect, const Style& style);
+	static void drawTail(QPainter& painter, const QRect& rect, const QRect& tailRect, bool alignLeft, const Style& style);
+	static int margin(const Style& style);
+	static int corner(const Style& style);
+
+	static constexpr int kCenter = 16;  // 九宫格中间可拉伸部分的边长
+};
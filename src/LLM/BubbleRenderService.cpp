@@ -0,0 +1,186 @@
+#include "BubbleRenderService.h"
+#include "MarkdownDocumentBuilder.h"
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QThread>
+
+namespace
+{
+	// 缓存中文档原文的总字符数上限（排版后的文档约为原文的十几倍内存）
+	constexpr int kCacheMaxChars = 1000000;
+}
+
+// 后台渲染任务
+class BubbleRenderService::RenderTask : public QRunnable
+{
+public:
+	RenderTask(BubbleRenderService* service, quint64 ticket, const BubbleRenderRequest& request,
+		const std::shared_ptr<QAtomicInt>& cancelled)
+		: m_service(service)
+		, m_ticket(ticket)
+		, m_request(request)
+		, m_cancelled(cancelled)
+	{
+		setAutoDelete(true);
+	}
+
+	void run() override
+	{
+		if (m_cancelled->loadAcquire())
+		{
+			return;
+		}
+		// 高亮器带有词法缓存，每个任务使用独立实例
+		SyntaxHighlighter highlighter;
+		highlighter.setTheme(m_request.theme);
+		MarkdownDocumentBuilder builder(&highlighter);
+
+		auto result = std::make_shared<BubbleRenderResult>();
+		result->request = m_request;
+		result->document = std::make_unique<QTextDocument>();
+		builder.build(*result->document, m_request.markdown, m_request.textColor, &result->codeBlocks);
+		if (m_cancelled->loadAcquire())
+		{
+			return;
+		}
+		result->size = MarkdownDocumentBuilder::layoutDocument(*result->document, m_request.width);
+		// 文档交给GUI线程使用
+		result->document->moveToThread(m_service->thread());
+		m_service->finishTask(m_ticket, result);
+	}
+
+private:
+	BubbleRenderService* m_service;
+	quint64 m_ticket;
+	BubbleRenderRequest m_request;
+	std::shared_ptr<QAtomicInt> m_cancelled;
+};
+
+BubbleRenderService& BubbleRenderService::instance()
+{
+	static BubbleRenderService service;
+	return service;
+}
+
+BubbleRenderService::BubbleRenderService(QObject* parent)
+	: QObject(parent)
+	, m_cache(kCacheMaxChars)
+{
+	// 留一个核心给GUI线程
+	m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+	// 文档需要在应用退出前释放（静态对象析构时字体等资源已不可用）
+	if (QCoreApplication* app = QCoreApplication::instance())
+	{
+		connect(app, &QCoreApplication::aboutToQuit, this, &BubbleRenderService::shutdown);
+	}
+}
+
+BubbleRenderService::~BubbleRenderService()
+{
+	shutdown();
+}
+
+void BubbleRenderService::shutdown()
+{
+	m_shutDown = true;
+	m_pool.clear();
+	m_pool.waitForDone();
+	m_jobs.clear();
+	{
+		QMutexLocker locker(&m_mutex);
+		m_finished.clear();
+	}
+	m_cache.clear();
+}
+
+bool BubbleRenderService::takeCached(const BubbleRenderRequest& request, BubbleRenderResult& result)
+{
+	BubbleRenderResult* cached = m_cache.take(cacheKey(request));
+	if (!cached)
+	{
+		return false;
+	}
+	std::unique_ptr<BubbleRenderResult> holder(cached);
+	if (cached->request.markdown != request.markdown || !cached->document)
+	{
+		return false;
+	}
+	result = std::move(*cached);
+	return true;
+}
+
+quint64 BubbleRenderService::submit(const BubbleRenderRequest& request, QObject* receiver, Callback callback)
+{
+	const quint64 ticket = ++m_nextTicket;
+	PendingJob job;
+	job.receiver = receiver;
+	job.callback = std::move(callback);
+	job.cancelled = std::make_shared<QAtomicInt>(0);
+	m_jobs.insert(ticket, job);
+	m_pool.start(new RenderTask(this, ticket, request, job.cancelled));
+	return ticket;
+}
+
+void BubbleRenderService::cancel(quint64 ticket)
+{
+	auto it = m_jobs.find(ticket);
+	if (it == m_jobs.end())
+	{
+		return;
+	}
+	it.value().cancelled->storeRelease(1);
+	m_jobs.erase(it);
+}
+
+void BubbleRenderService::recycle(BubbleRenderResult&& result)
+{
+	if (!result.document || result.request.markdown.isEmpty() || m_shutDown)
+	{
+		return;
+	}
+	const int cost = result.request.markdown.size();
+	m_cache.insert(cacheKey(result.request), new BubbleRenderResult(std::move(result)), cost);
+}
+
+void BubbleRenderService::finishTask(quint64 ticket, const std::shared_ptr<BubbleRenderResult>& result)
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_finished.insert(ticket, result);
+	}
+	QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection, Q_ARG(quint64, ticket));
+}
+
+void BubbleRenderService::deliver(quint64 ticket)
+{
+	std::shared_ptr<BubbleRenderResult> result;
+	{
+		QMutexLocker locker(&m_mutex);
+		result = m_finished.take(ticket);
+	}
+	if (!result)
+	{
+		return;
+	}
+	const PendingJob job = m_jobs.take(ticket);
+	if (job.callback && job.receiver)
+	{
+		job.callback(*result);
+	}
+	// 未被取走的结果（请求已取消或请求方已销毁）进入缓存
+	if (result->document)
+	{
+		recycle(std::move(*result));
+	}
+}
+
+QString BubbleRenderService::cacheKey(const BubbleRenderRequest& request)
+{
+	const uint themeHash = SyntaxHighlighter::themeHash(request.theme);
+	return QStringLiteral("%1:%2:%3:%4:%5")
+		.arg(qHash(request.markdown))
+		.arg(request.markdown.size())
+		.arg(request.width)
+		.arg(request.textColor.rgba())
+		.arg(themeHash);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <QObject>
+#include <QThreadPool>
+#include <QTextDocument>
+#include <QAtomicInt>
+#include <QPointer>
+#include <QMutex>
+#include <QCache>
+#include <QColor>
+#include <QHash>
+#include <QSize>
+#include <functional>
+#include <memory>
+#include "SyntaxHighlighter.h"
+
+// 气泡渲染请求：Markdown原文 + 排版宽度 + 主题
+struct BubbleRenderRequest
+{
+	QString markdown;
+	int width = 0;                   // 最大排版宽度
+	QColor textColor;
+	SyntaxHighlighter::Theme theme;
+};
+
+// 气泡渲染结果：已构建并排版完成的文档
+struct BubbleRenderResult
+{
+	BubbleRenderRequest request;
+	std::unique_ptr<QTextDocument> document;
+	QSize size;                          // 收缩到理想宽度后的文档尺寸
+	QHash<QString, QString> codeBlocks;  // 代码块ID -> 代码原文
+};
+
+// 气泡渲染服务
+// Markdown解析、代码高亮、文档构建与排版在独立的 QThreadPool 中完成，完成后回到GUI线程交给请求方；
+// 气泡回收时归还的文档（以及请求方已取消的结果）进入缓存，相同内容与宽度再次出现时直接复用
+class BubbleRenderService : public QObject
+{
+	Q_OBJECT
+public:
+	// 渲染完成回调（GUI线程），回调中可以取走 result.document
+	using Callback = std::function<void(BubbleRenderResult& result)>;
+
+	static BubbleRenderService& instance();
+	~BubbleRenderService();
+
+	// 从缓存中取出已排版的文档，命中时无需提交请求
+	bool takeCached(const BubbleRenderRequest& request, BubbleRenderResult& result);
+	// 提交后台渲染请求，返回票据；receiver 销毁后回调不再执行
+	quint64 submit(const BubbleRenderRequest& request, QObject* receiver, Callback callback);
+	// 取消请求：尚未开始的任务直接跳过，已开始的任务在排版前停止
+	void cancel(quint64 ticket);
+	// 归还不再显示的文档，供以后复用
+	void recycle(BubbleRenderResult&& result);
+
+private:
+	class RenderTask;
+
+	explicit BubbleRenderService(QObject* parent = nullptr);
+	// 停止后台任务并释放所有文档
+	void shutdown();
+	// 工作线程：保存结果并通知GUI线程
+	void finishTask(quint64 ticket, const std::shared_ptr<BubbleRenderResult>& result);
+	// GUI线程：把结果交给请求方
+	Q_INVOKABLE void deliver(quint64 ticket);
+	// 缓存键：内容哈希 + 长度 + 宽度 + 颜色 + 主题
+	static QString cacheKey(const BubbleRenderRequest& request);
+
+	struct PendingJob
+	{
+		QPointer<QObject> receiver;
+		Callback callback;
+		std::shared_ptr<QAtomicInt> cancelled;
+	};
+
+	QThreadPool m_pool;
+	QHash<quint64, PendingJob> m_jobs;                                   // 未完成的请求（GUI线程）
+	QMutex m_mutex;                                                      // 保护 m_finished
+	QHash<quint64, std::shared_ptr<BubbleRenderResult>> m_finished;      // 已完成、等待交付的结果
+	QCache<QString, BubbleRenderResult> m_cache;                         // 可复用的文档，开销按原文字符数计算
+	quint64 m_nextTicket = 0;
+	bool m_shutDown = false;                                             // 应用退出后不再缓存文档
+};
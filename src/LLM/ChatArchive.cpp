@@ -0,0 +1,619 @@
+#include "ChatArchive.h"
+#include "SessionJournal.h"
+
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+	const QByteArray kMagic = QByteArrayLiteral("AICB");
+	constexpr quint32 kFormatVersion = 1;
+	constexpr int kHeaderSize = 16;   // 魔数(4) + 版本(4) + 目录位置(8)
+	constexpr int kCompressionLevel = 9;   // 冷存储写入一次、很少读取，取最高压缩率
+
+	// 整数键比字段名短得多，每条消息都要重复写一次
+	enum SessionKey {
+		SessionSaveTime = 0,
+		SessionMessages = 1
+	};
+
+	enum MessageKey {
+		MessageText = 0,
+		MessageReasoning = 1,
+		MessageTime = 2,
+		MessageWidth = 3,    // 旧版本的单一尺寸，不再写入，读取时忽略
+		MessageHeight = 4,
+		MessageUserType = 5,
+		MessageDialogName = 6,
+		MessageBubbleId = 7,
+		MessageImportant = 8,
+		MessageNote = 9,
+		MessageLayout = 10   // [内容哈希, 排版版本, 宽度区间, 高度, ...]
+	};
+
+	enum TocKey {
+		TocId = 0,
+		TocTitle = 1,
+		TocPreview = 2,
+		TocSaveTime = 3,
+		TocCount = 4,
+		TocOffset = 5,
+		TocLength = 6
+	};
+
+	void appendKey(QCborStreamWriter& writer, int key) {
+		writer.append(qint64(key));
+	}
+
+	void appendText(QCborStreamWriter& writer, int key, const QString& text) {
+		if (text.isEmpty())
+			return; // 读取时缺省为空
+		appendKey(writer, key);
+		writer.append(text);
+	}
+
+	void appendInteger(QCborStreamWriter& writer, int key, qint64 value) {
+		appendKey(writer, key);
+		writer.append(value);
+	}
+
+	void writeMessage(QCborStreamWriter& writer, const ChatMessageData& message) {
+		writer.startMap();
+		appendText(writer, MessageText, message.m_ChatMsg);
+		appendText(writer, MessageReasoning, message.m_ChatReasonMsg);
+		appendText(writer, MessageTime, message.m_ChatTime);
+		if (!message.m_Layout.heights.isEmpty()) {
+			appendKey(writer, MessageLayout);
+			writer.startArray(2 + 2 * message.m_Layout.heights.size());
+			writer.append(quint64(message.m_Layout.contentHash));
+			writer.append(quint64(message.m_Layout.version));
+			for (const QPoint& entry : message.m_Layout.heights) {
+				writer.append(qint64(entry.x()));
+				writer.append(qint64(entry.y()));
+			}
+			writer.endArray();
+		}
+		appendInteger(writer, MessageUserType, message.userType);
+		appendText(writer, MessageDialogName, message.m_DialogName);
+		appendText(writer, MessageBubbleId, message.m_BubbleID);
+		if (message.m_IsImportant) {
+			appendKey(writer, MessageImportant);
+			writer.append(true);
+		}
+		appendText(writer, MessageNote, message.m_Note);
+		writer.endMap();
+	}
+
+	void writeSession(QCborStreamWriter& writer, const ChatSession& session) {
+		writer.startMap(2);
+		appendKey(writer, SessionSaveTime);
+		writer.append(session.SaveTime.toString(Qt::ISODate));
+		appendKey(writer, SessionMessages);
+		writer.startArray(session.sMsg.size());
+		for (const ChatMessageData& message : session.sMsg)
+			writeMessage(writer, message);
+		writer.endArray();
+		writer.endMap();
+	}
+
+	void writeToc(QCborStreamWriter& writer, const QList<ChatSessionSummary>& toc) {
+		writer.startArray(toc.size());
+		for (const ChatSessionSummary& summary : toc) {
+			writer.startMap();
+			appendText(writer, TocId, summary.sessionId);
+			appendText(writer, TocTitle, summary.title);
+			appendText(writer, TocPreview, summary.preview);
+			appendText(writer, TocSaveTime, summary.saveTime.toString(Qt::ISODate));
+			appendInteger(writer, TocCount, summary.messageCount);
+			appendInteger(writer, TocOffset, summary.offset);
+			appendInteger(writer, TocLength, summary.length);
+			writer.endMap();
+		}
+		writer.endArray();
+	}
+
+	QByteArray encodeSession(const ChatSession& session) {
+		QByteArray block;
+		QCborStreamWriter writer(&block);
+		writeSession(writer, session);
+		return block;
+	}
+
+	// 写入归档文件：文件头占位，依次写会话块，最后写目录并回填文件头
+	class ArchiveWriter {
+	public:
+		explicit ArchiveWriter(const QString& filePath)
+			: m_file(filePath)
+			, m_writer(&m_file) {}
+
+		bool open() {
+			return m_file.open(QIODevice::WriteOnly)
+				&& m_file.write(QByteArray(kHeaderSize, '\0')) == kHeaderSize;
+		}
+
+		// compressed：会话块整体 qCompress 后作为 CBOR 字节串写入
+		void addSession(const QString& sessionId, const ChatSession& session, bool compressed) {
+			ChatSessionSummary summary = ChatSessionSummary::fromSession(sessionId, session);
+			summary.offset = m_file.pos();
+			if (compressed)
+				m_writer.append(qCompress(encodeSession(session), kCompressionLevel));
+			else
+				writeSession(m_writer, session);
+			summary.length = m_file.pos() - summary.offset;
+			m_toc.append(summary);
+		}
+
+		// 原样写入另一个归档中已编码的会话块
+		void addBlock(ChatSessionSummary summary, const QByteArray& block) {
+			summary.offset = m_file.pos();
+			m_file.write(block);
+			summary.length = block.size();
+			m_toc.append(summary);
+		}
+
+		bool commit() {
+			const qint64 tocOffset = m_file.pos();
+			writeToc(m_writer, m_toc);
+			QByteArray header(kHeaderSize, '\0');
+			std::memcpy(header.data(), kMagic.constData(), 4);
+			qToLittleEndian<quint32>(kFormatVersion, header.data() + 4);
+			qToLittleEndian<quint64>(quint64(tocOffset), header.data() + 8);
+			if (!m_file.seek(0) || m_file.write(header) != kHeaderSize)
+				return false;
+			return m_file.commit();
+		}
+
+	private:
+		QSaveFile m_file;
+		QCborStreamWriter m_writer;
+		QList<ChatSessionSummary> m_toc;
+	};
+
+	QByteArray readBytes(QCborStreamReader& reader) {
+		if (!reader.isByteArray()) {
+			reader.next();
+			return QByteArray();
+		}
+		QByteArray bytes;
+		auto chunk = reader.readByteArray();
+		while (chunk.status == QCborStreamReader::Ok) {
+			bytes += chunk.data;
+			chunk = reader.readByteArray();
+		}
+		return bytes;
+	}
+
+	// 字符串可能分块编码，逐块拼接；类型不符时跳过该值
+	QString readText(QCborStreamReader& reader) {
+		if (!reader.isString()) {
+			reader.next();
+			return QString();
+		}
+		QString text;
+		auto chunk = reader.readString();
+		while (chunk.status == QCborStreamReader::Ok) {
+			text += chunk.data;
+			chunk = reader.readString();
+		}
+		return text;
+	}
+
+	qint64 readInteger(QCborStreamReader& reader) {
+		if (!reader.isInteger()) {
+			reader.next();
+			return 0;
+		}
+		const qint64 value = reader.toInteger();
+		reader.next();
+		return value;
+	}
+
+	bool readBool(QCborStreamReader& reader) {
+		if (!reader.isBool()) {
+			reader.next();
+			return false;
+		}
+		const bool value = reader.toBool();
+		reader.next();
+		return value;
+	}
+
+	bool hasNext(QCborStreamReader& reader) {
+		return reader.lastError() == QCborError::NoError && reader.hasNext();
+	}
+
+	bool readLayout(QCborStreamReader& reader, ChatLayoutCache& layout) {
+		if (!reader.isArray() || !reader.enterContainer())
+			return false;
+		QVector<qint64> values;
+		while (hasNext(reader))
+			values.append(readInteger(reader));
+		if (values.size() >= 2) {
+			layout.contentHash = quint32(values.at(0));
+			layout.version = quint32(values.at(1));
+			for (int i = 2; i + 1 < values.size() && layout.heights.size() < ChatLayoutCache::kMaxWidths; i += 2)
+				layout.heights.append(QPoint(int(values.at(i)), int(values.at(i + 1))));
+		}
+		return reader.leaveContainer();
+	}
+
+	bool readMessage(QCborStreamReader& reader, ChatMessageData& message) {
+		if (!reader.isMap() || !reader.enterContainer())
+			return false;
+		while (hasNext(reader)) {
+			switch (readInteger(reader)) {
+			case MessageText: message.m_ChatMsg = readText(reader); break;
+			case MessageReasoning: message.m_ChatReasonMsg = readText(reader); break;
+			case MessageTime: message.m_ChatTime = readText(reader); break;
+			case MessageUserType: message.userType = int(readInteger(reader)); break;
+			case MessageDialogName: message.m_DialogName = readText(reader); break;
+			case MessageBubbleId: message.m_BubbleID = readText(reader); break;
+			case MessageImportant: message.m_IsImportant = readBool(reader); break;
+			case MessageNote: message.m_Note = readText(reader); break;
+			case MessageLayout:
+				if (!readLayout(reader, message.m_Layout))
+					return false;
+				break;
+			default: reader.next(); break;
+			}
+		}
+		return reader.leaveContainer();
+	}
+
+	bool readSessionBlock(QCborStreamReader& reader, ChatSession& session) {
+		if (!reader.isMap() || !reader.enterContainer())
+			return false;
+		while (hasNext(reader)) {
+			const qint64 key = readInteger(reader);
+			if (key == SessionSaveTime) {
+				session.SaveTime = QDateTime::fromString(readText(reader), Qt::ISODate);
+			}
+			else if (key == SessionMessages && reader.isArray()) {
+				if (reader.isLengthKnown())
+					session.sMsg.reserve(int(reader.length()));
+				if (!reader.enterContainer())
+					return false;
+				while (hasNext(reader)) {
+					ChatMessageData message;
+					if (!readMessage(reader, message))
+						return false;
+					session.appendMessage(std::move(message));
+				}
+				if (!reader.leaveContainer())
+					return false;
+			}
+			else {
+				reader.next();
+			}
+		}
+		return reader.leaveContainer();
+	}
+
+	bool readTocEntry(QCborStreamReader& reader, ChatSessionSummary& summary) {
+		if (!reader.isMap() || !reader.enterContainer())
+			return false;
+		while (hasNext(reader)) {
+			switch (readInteger(reader)) {
+			case TocId: summary.sessionId = readText(reader); break;
+			case TocTitle: summary.title = readText(reader); break;
+			case TocPreview: summary.preview = readText(reader); break;
+			case TocSaveTime: summary.saveTime = QDateTime::fromString(readText(reader), Qt::ISODate); break;
+			case TocCount: summary.messageCount = int(readInteger(reader)); break;
+			case TocOffset: summary.offset = readInteger(reader); break;
+			case TocLength: summary.length = readInteger(reader); break;
+			default: reader.next(); break;
+			}
+		}
+		return reader.leaveContainer();
+	}
+
+	// 映射文件的一段，析构时解除映射；解码出的字符串都是复制出来的
+	class MappedRegion {
+	public:
+		MappedRegion(QFile& file, qint64 offset, qint64 length)
+			: m_file(file)
+			, m_length(length) {
+			if (offset >= 0 && length > 0 && length <= std::numeric_limits<int>::max()
+				&& offset + length <= file.size())
+				m_data = file.map(offset, length);
+		}
+		~MappedRegion() {
+			if (m_data)
+				m_file.unmap(m_data);
+		}
+		[[nodiscard]] bool isValid() const {
+			return m_data != nullptr;
+		}
+		[[nodiscard]] QByteArray bytes() const {
+			return QByteArray::fromRawData(reinterpret_cast<const char*>(m_data), int(m_length));
+		}
+
+	private:
+		QFile& m_file;
+		uchar* m_data = nullptr;
+		qint64 m_length;
+	};
+
+	bool readTocOffset(QFile& file, qint64& tocOffset) {
+		const QByteArray header = file.read(kHeaderSize);
+		if (header.size() != kHeaderSize || !header.startsWith(kMagic))
+			return false;
+		if (qFromLittleEndian<quint32>(header.constData() + 4) != kFormatVersion)
+			return false;
+		tocOffset = qint64(qFromLittleEndian<quint64>(header.constData() + 8));
+		return tocOffset >= kHeaderSize && tocOffset <= file.size();
+	}
+
+	bool decodeSession(QFile& file, qint64 offset, qint64 length, ChatSession& session) {
+		if (offset < kHeaderSize)
+			return false;
+		const MappedRegion region(file, offset, length);
+		if (!region.isValid())
+			return false;
+		QCborStreamReader reader(region.bytes());
+		session = ChatSession();
+		if (reader.isByteArray()) {
+			// 冷存储中的会话块是压缩后的字节串
+			QCborStreamReader block(qUncompress(readBytes(reader)));
+			return readSessionBlock(block, session);
+		}
+		return readSessionBlock(reader, session);
+	}
+
+	bool decodeToc(QFile& file, QList<ChatSessionSummary>& summaries) {
+		summaries.clear();
+		qint64 tocOffset = 0;
+		if (!readTocOffset(file, tocOffset))
+			return false;
+		const MappedRegion region(file, tocOffset, file.size() - tocOffset);
+		if (!region.isValid())
+			return false;
+		QCborStreamReader reader(region.bytes());
+		if (!reader.isArray() || !reader.enterContainer())
+			return false;
+		while (hasNext(reader)) {
+			ChatSessionSummary summary;
+			if (!readTocEntry(reader, summary))
+				return false;
+			summaries.append(summary);
+		}
+		return reader.leaveContainer();
+	}
+
+	// 进程常驻内存（字节），不支持的平台返回 0
+	qint64 residentBytes() {
+#ifdef Q_OS_WIN
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return qint64(counters.WorkingSetSize);
+		return 0;
+#elif defined(Q_OS_LINUX)
+		QFile statm(QStringLiteral("/proc/self/statm"));
+		if (!statm.open(QIODevice::ReadOnly))
+			return 0;
+		const QList<QByteArray> fields = statm.readAll().split(' ');
+		return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#else
+		return 0;
+#endif
+	}
+
+	int messageCount(const ChatSessionMap& sessions) {
+		int count = 0;
+		for (const ChatSession& session : sessions)
+			count += session.sMsg.size();
+		return count;
+	}
+}
+
+bool ChatArchive::write(const QString& filePath, const ChatSessionMap& sessions, bool compressed) {
+	ArchiveWriter writer(filePath);
+	if (!writer.open())
+		return false;
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it)
+		writer.addSession(it.key(), it.value(), compressed);
+	return writer.commit();
+}
+
+bool ChatArchive::appendCompressed(const QString& filePath, const ChatSessionMap& sessions) {
+	// 已有的压缩块原样复制，不解压；先读入内存，写新文件替换时原文件已关闭
+	QList<ChatSessionSummary> toc;
+	QList<QByteArray> blocks;
+	QFile existing(filePath);
+	if (existing.exists()) {
+		if (!existing.open(QIODevice::ReadOnly) || !decodeToc(existing, toc))
+			return false;
+		for (const ChatSessionSummary& summary : toc) {
+			if (!existing.seek(summary.offset))
+				return false;
+			blocks.append(existing.read(summary.length));
+			if (blocks.last().size() != summary.length)
+				return false;
+		}
+		existing.close();
+	}
+
+	ArchiveWriter writer(filePath);
+	if (!writer.open())
+		return false;
+	for (int i = 0; i < toc.size(); ++i) {
+		if (!sessions.contains(toc.at(i).sessionId))
+			writer.addBlock(toc.at(i), blocks.at(i));
+	}
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it)
+		writer.addSession(it.key(), it.value(), true);
+	return writer.commit();
+}
+
+bool ChatArchive::readSummaries(const QString& filePath, QList<ChatSessionSummary>& summaries) {
+	QFile file(filePath);
+	return file.open(QIODevice::ReadOnly) && decodeToc(file, summaries);
+}
+
+bool ChatArchive::readSession(const QString& filePath, qint64 offset, qint64 length, ChatSession& session) {
+	QFile file(filePath);
+	return file.open(QIODevice::ReadOnly) && decodeSession(file, offset, length, session);
+}
+
+bool ChatArchive::readAll(const QString& filePath, ChatSessionMap& sessions) {
+	sessions.clear();
+	QFile file(filePath);
+	QList<ChatSessionSummary> toc;
+	if (!file.open(QIODevice::ReadOnly) || !decodeToc(file, toc))
+		return false;
+	sessions.reserve(toc.size());
+	for (const ChatSessionSummary& summary : toc) {
+		ChatSession session;
+		if (!decodeSession(file, summary.offset, summary.length, session))
+			return false;
+		sessions.insert(summary.sessionId, session);
+	}
+	return true;
+}
+
+bool ChatArchive::convertJson(const QString& jsonFile, const QString& archiveFile) {
+	// 快照必须完整解析：损坏的快照若按空表重放日志，归档会丢失其中的会话
+	ChatSessionMap sessions;
+	if (!readJson(jsonFile, sessions))
+		return false;
+	SessionJournal::replayJournals(jsonFile, sessions);
+	if (!write(archiveFile, sessions))
+		return false;
+	// 读回目录，与源文件中的会话逐个核对
+	QList<ChatSessionSummary> toc;
+	if (!readSummaries(archiveFile, toc) || toc.size() != sessions.size())
+		return false;
+	for (const ChatSessionSummary& summary : toc) {
+		if (!sessions.contains(summary.sessionId))
+			return false;
+	}
+	return true;
+}
+
+void ChatArchive::benchmark(const QString& jsonFile) {
+	const QString archiveFile = QDir::temp().filePath(
+		QFileInfo(jsonFile).completeBaseName() + QStringLiteral(".benchmark.cbor"));
+	QElapsedTimer timer;
+
+	// JSON：QJsonDocument 解析整个文件，再逐个会话 fromJson
+	qint64 rssBefore = residentBytes();
+	timer.start();
+	ChatSessionMap fromJson;
+	if (!readJson(jsonFile, fromJson)) {
+		qWarning() << "ChatArchive benchmark: cannot read" << jsonFile;
+		return;
+	}
+	const qint64 jsonMs = timer.elapsed();
+	const qint64 jsonRss = residentBytes() - rssBefore;
+	const int sessionCount = fromJson.size();
+	const int messages = messageCount(fromJson);
+
+	QString largestId;
+	int largestCount = -1;
+	for (auto it = fromJson.constBegin(); it != fromJson.constEnd(); ++it) {
+		if (it.value().sMsg.size() > largestCount) {
+			largestCount = it.value().sMsg.size();
+			largestId = it.key();
+		}
+	}
+	if (!write(archiveFile, fromJson)) {
+		qWarning() << "ChatArchive benchmark: cannot write" << archiveFile;
+		return;
+	}
+	fromJson.clear();
+
+	// 归档：只读目录（填充侧边栏）
+	timer.restart();
+	QList<ChatSessionSummary> toc;
+	readSummaries(archiveFile, toc);
+	const qint64 tocMs = timer.elapsed();
+
+	// 归档：打开最大的一个会话
+	qint64 openUs = 0;
+	for (const ChatSessionSummary& summary : toc) {
+		if (summary.sessionId != largestId)
+			continue;
+		ChatSession session;
+		timer.restart();
+		readSession(archiveFile, summary.offset, summary.length, session);
+		openUs = timer.nsecsElapsed() / 1000;
+	}
+
+	// 归档：读取全部会话
+	rssBefore = residentBytes();
+	timer.restart();
+	ChatSessionMap fromArchive;
+	readAll(archiveFile, fromArchive);
+	const qint64 archiveMs = timer.elapsed();
+	const qint64 archiveRss = residentBytes() - rssBefore;
+
+	// 冷存储：同样的会话逐个压缩
+	const QString compressedFile = archiveFile + QStringLiteral(".cold");
+	write(compressedFile, fromArchive, true);
+	fromArchive.clear();
+	qint64 coldOpenUs = 0;
+	QList<ChatSessionSummary> coldToc;
+	readSummaries(compressedFile, coldToc);
+	for (const ChatSessionSummary& summary : coldToc) {
+		if (summary.sessionId != largestId)
+			continue;
+		ChatSession session;
+		timer.restart();
+		readSession(compressedFile, summary.offset, summary.length, session);
+		coldOpenUs = timer.nsecsElapsed() / 1000;
+	}
+
+	qInfo().noquote() << QStringLiteral("ChatArchive benchmark: %1 sessions, %2 messages").arg(sessionCount).arg(messages);
+	qInfo().noquote() << QStringLiteral("  JSON  %1 bytes, load all %2 ms, RSS +%3 KB")
+		.arg(QFileInfo(jsonFile).size()).arg(jsonMs).arg(jsonRss / 1024);
+	qInfo().noquote() << QStringLiteral("  CBOR  %1 bytes, load all %2 ms, RSS +%3 KB")
+		.arg(QFileInfo(archiveFile).size()).arg(archiveMs).arg(archiveRss / 1024);
+	qInfo().noquote() << QStringLiteral("  CBOR  table of contents %1 ms, open largest session (%2 messages) %3 us")
+		.arg(tocMs).arg(largestCount).arg(openUs);
+	qInfo().noquote() << QStringLiteral("  cold  %1 bytes, open largest session %2 us")
+		.arg(QFileInfo(compressedFile).size()).arg(coldOpenUs);
+	QFile::remove(archiveFile);
+	QFile::remove(compressedFile);
+}
+
+bool ChatArchive::readJson(const QString& filePath, ChatSessionMap& sessions) {
+	sessions.clear();
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	const QByteArray data = file.readAll();
+	if (data.trimmed().isEmpty())
+		return true; // 新建的空文件
+	QJsonParseError error;
+	const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+	if (error.error != QJsonParseError::NoError || !doc.isObject())
+		return false;
+	const QJsonObject root = doc.object();
+	for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+		ChatSession session;
+		session.fromJson(it.value().toObject());
+		sessions.insert(it.key(), session);
+	}
+	return true;
+}
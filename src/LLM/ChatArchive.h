@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+
+#include "SessionStore.h"
+
+// 会话归档文件（CBOR 二进制格式，历史目录中的 LLMChat_yyyy-MM-dd.cbor）
+// 结构：文件头 | 会话块 ... | 目录
+//   文件头：魔数 "AICB"、格式版本、目录的位置
+//   会话块：一个会话的 CBOR 编码，消息字段使用整数键；冷存储中为压缩后的 CBOR 字节串
+//   目录：每个会话的摘要及会话块的位置和长度
+// 读取时映射文件，列出会话只解码目录，打开会话只解码对应的会话块
+class ChatArchive {
+public:
+	static bool write(const QString& filePath, const ChatSessionMap& sessions, bool compressed = false);
+	// 把会话压缩后加入冷存储段（同一会话替换原有的块），已有的块不解压
+	static bool appendCompressed(const QString& filePath, const ChatSessionMap& sessions);
+
+	static bool readSummaries(const QString& filePath, QList<ChatSessionSummary>& summaries);
+	static bool readSession(const QString& filePath, qint64 offset, qint64 length, ChatSession& session);
+	static bool readAll(const QString& filePath, ChatSessionMap& sessions);
+
+	// 把 JSON 快照（含未合并的日志）转换为归档文件，写完后读回目录核对；快照无法完整解析时失败
+	static bool convertJson(const QString& jsonFile, const QString& archiveFile);
+
+	// 用同一份 JSON 历史对比 JSON、归档和压缩归档的读取耗时、文件大小和内存占用，结果输出到调试日志
+	static void benchmark(const QString& jsonFile);
+
+private:
+	static bool readJson(const QString& filePath, ChatSessionMap& sessions);
+};
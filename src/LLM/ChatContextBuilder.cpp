@@ -0,0 +1,232 @@
+#include "ChatContextBuilder.h"
+#include "LLMChatFrame.h"
+#include <QVector>
+
+Q_LOGGING_CATEGORY(lcChatContext, "aiassit.context", QtInfoMsg)
+
+namespace
+{
+	// 每条消息的角色、分隔符等模板开销
+	constexpr int kMessageOverheadTokens = 4;
+	// 每条回答附带的推理内容上限（保留结尾的结论部分）
+	constexpr int kReasoningTokenLimit = 256;
+	// 窗口前移后历史只占预算的 1/kRefillDivisor，留出后续若干轮的增长空间
+	constexpr int kRefillDivisor = 2;
+
+	// 以 1/4 token 为单位的字符权重
+	int quarterTokens(ushort ch)
+	{
+		if (ch < 0x80)
+		{
+			return 1;
+		}
+		return ch >= 0x2E80 ? 4 : 2;
+	}
+
+	bool isBlank(const QString& text)
+	{
+		for (const QChar ch : text)
+		{
+			if (!ch.isSpace())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 截取推理内容的结尾，不超过 tokens；同一段推理每次截取的结果相同
+	QString reasoningTail(const QString& text, int tokens, bool* trimmed)
+	{
+		const int limit = tokens * 4;
+		int quarters = 0;
+		int start = text.size();
+		while (start > 0)
+		{
+			const int weight = quarterTokens(text.at(start - 1).unicode());
+			if (quarters + weight > limit)
+			{
+				break;
+			}
+			quarters += weight;
+			--start;
+		}
+		if (start < text.size() && text.at(start).isLowSurrogate())
+		{
+			++start;
+		}
+		*trimmed = start > 0;
+		return start > 0 ? text.mid(start) : text;
+	}
+
+	// 可作为历史发送的消息
+	struct Candidate
+	{
+		int index = 0;
+		bool assistant = false;
+		int contentTokens = 0;
+		int reasoningTokens = 0;
+	};
+}
+
+QString ChatContextReport::toString() const
+{
+	if (includedMessages == 0)
+	{
+		return QStringLiteral("context: no history (%1 skipped, budget %2)").arg(skippedMessages).arg(tokenBudget);
+	}
+	return QStringLiteral("context: %1 messages from #%2 (%3 skipped), ~%4/%5 tokens, reasoning %6 (%7 trimmed%8)")
+		.arg(includedMessages)
+		.arg(firstMessage)
+		.arg(skippedMessages)
+		.arg(estimatedTokens)
+		.arg(tokenBudget)
+		.arg(reasoningIncluded)
+		.arg(reasoningTrimmed)
+		.arg(reasoningDropped ? QStringLiteral(", dropped") : QString());
+}
+
+QList<ChatHistoryTurn> ChatContextBuilder::build(const QString& sessionId, const ChatSession& session, int endIndex,
+	int tokenBudget, ChatContextReport* report)
+{
+	ChatContextReport localReport;
+	ChatContextReport& result = report ? *report : localReport;
+	result = ChatContextReport();
+	result.tokenBudget = tokenBudget;
+
+	QList<ChatHistoryTurn> turns;
+	endIndex = qBound(0, endIndex, session.sMsg.size());
+
+	QVector<Candidate> candidates;
+	candidates.reserve(endIndex);
+	for (int i = 0; i < endIndex; ++i)
+	{
+		const ChatMessageData& message = session.sMsg.at(i);
+		if (message.userType != LLMChatFrame::User_Owner && message.userType != LLMChatFrame::User_Customer)
+		{
+			continue;
+		}
+		if (isBlank(message.m_ChatMsg))
+		{
+			continue; // 未完成或失败的回答
+		}
+		Candidate candidate;
+		candidate.index = i;
+		candidate.assistant = message.userType == LLMChatFrame::User_Customer;
+		candidate.contentTokens = messageTokens(message) + kMessageOverheadTokens;
+		if (candidate.assistant && !isBlank(message.m_ChatReasonMsg))
+		{
+			candidate.reasoningTokens = qMin(reasoningTokens(message), kReasoningTokenLimit);
+		}
+		candidates.append(candidate);
+	}
+	if (tokenBudget <= 0)
+	{
+		result.skippedMessages = candidates.size();
+		return turns;
+	}
+
+	Window& window = m_windows[sessionId];
+	if (window.start > endIndex)
+	{
+		// 会话被清空或截断
+		window = Window();
+	}
+	int first = 0;
+	while (first < candidates.size() && candidates[first].index < window.start)
+	{
+		++first;
+	}
+	auto costFrom = [&candidates](int from, bool withReasoning) {
+		int cost = 0;
+		for (int i = from; i < candidates.size(); ++i)
+		{
+			cost += candidates[i].contentTokens + (withReasoning ? candidates[i].reasoningTokens : 0);
+		}
+		return cost;
+	};
+
+	// 先去掉推理内容，仍然超出预算时成批丢弃最早的轮次
+	int total = costFrom(first, !window.reasoningDropped);
+	if (total > tokenBudget && !window.reasoningDropped)
+	{
+		window.reasoningDropped = true;
+		total = costFrom(first, false);
+	}
+	if (total > tokenBudget)
+	{
+		// 新窗口从提问开始，且只占预算的一部分
+		const int target = tokenBudget / kRefillDivisor;
+		while (first < candidates.size() && (total > target || candidates[first].assistant))
+		{
+			total -= candidates[first].contentTokens;
+			++first;
+		}
+		window.start = first < candidates.size() ? candidates[first].index : endIndex;
+	}
+
+	result.skippedMessages = first;
+	result.reasoningDropped = window.reasoningDropped;
+	for (int i = first; i < candidates.size(); ++i)
+	{
+		const Candidate& candidate = candidates[i];
+		const ChatMessageData& message = session.sMsg.at(candidate.index);
+		ChatHistoryTurn turn;
+		turn.role = candidate.assistant ? QStringLiteral("assistant") : QStringLiteral("user");
+		turn.content = message.m_ChatMsg;
+		result.estimatedTokens += candidate.contentTokens;
+		if (!window.reasoningDropped && candidate.reasoningTokens > 0)
+		{
+			bool trimmed = false;
+			turn.reasoning = reasoningTail(message.m_ChatReasonMsg, kReasoningTokenLimit, &trimmed);
+			result.estimatedTokens += candidate.reasoningTokens;
+			++result.reasoningIncluded;
+			if (trimmed)
+			{
+				++result.reasoningTrimmed;
+			}
+		}
+		turns.append(turn);
+	}
+	result.includedMessages = turns.size();
+	result.firstMessage = turns.isEmpty() ? -1 : candidates[first].index;
+	return turns;
+}
+
+void ChatContextBuilder::forgetSession(const QString& sessionId)
+{
+	m_windows.remove(sessionId);
+}
+
+int ChatContextBuilder::estimateTokens(const QString& text)
+{
+	int quarters = 0;
+	const ushort* data = text.utf16();
+	for (int i = 0, size = text.size(); i < size; ++i)
+	{
+		quarters += quarterTokens(data[i]);
+	}
+	return (quarters + 3) / 4;
+}
+
+int ChatContextBuilder::messageTokens(const ChatMessageData& message)
+{
+	const uint hash = qHash(message.m_ChatMsg);
+	if (message.m_TokenCount < 0 || message.m_TokenCountHash != hash)
+	{
+		message.m_TokenCount = estimateTokens(message.m_ChatMsg);
+		message.m_TokenCountHash = hash;
+	}
+	return message.m_TokenCount;
+}
+
+int ChatContextBuilder::reasoningTokens(const ChatMessageData& message)
+{
+	const uint hash = qHash(message.m_ChatReasonMsg);
+	if (message.m_ReasonTokenCount < 0 || message.m_ReasonTokenCountHash != hash)
+	{
+		message.m_ReasonTokenCount = estimateTokens(message.m_ChatReasonMsg);
+		message.m_ReasonTokenCountHash = hash;
+	}
+	return message.m_ReasonTokenCount;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+#include <QString>
+#include "ChatSessionTypes.h"
+#include "CommonTypes.h"
+
+// 上下文选择的诊断输出，默认关闭；QT_LOGGING_RULES="aiassit.context.debug=true" 时每次发送输出 ChatContextReport
+Q_DECLARE_LOGGING_CATEGORY(lcChatContext)
+
+// 本轮发送的上下文说明
+struct ChatContextReport
+{
+	int firstMessage = -1;       // 第一条发送的历史消息在会话中的下标，-1 表示没有历史
+	int includedMessages = 0;    // 发送的历史消息数
+	int skippedMessages = 0;     // 窗口之前未发送的消息数
+	int reasoningIncluded = 0;   // 附带推理内容的回答数
+	int reasoningTrimmed = 0;    // 推理内容被截短的回答数
+	bool reasoningDropped = false; // 预算不足，推理内容已全部去掉
+	int estimatedTokens = 0;     // 历史消息的估算token数
+	int tokenBudget = 0;
+
+	QString toString() const;
+};
+
+// 多轮对话上下文构建
+// 在token预算内从会话中选择本轮提问之前的消息：超出预算时先去掉推理内容，再成批丢弃最早的轮次；
+// 窗口起点只在超出预算时前移，并且一次让出一半预算，之后若干轮发送的前缀逐字节不变，服务端的提示词缓存可以持续命中
+class ChatContextBuilder
+{
+public:
+	// 选择会话中 [0, endIndex) 的消息作为历史，tokenBudget <= 0 时不发送历史
+	QList<ChatHistoryTurn> build(const QString& sessionId, const ChatSession& session, int endIndex,
+		int tokenBudget, ChatContextReport* report = nullptr);
+	// 会话删除后清除其窗口状态
+	void forgetSession(const QString& sessionId);
+
+	// 估算文本的token数：CJK字符约一个token，ASCII约四个字符一个token
+	static int estimateTokens(const QString& text);
+	// 消息正文 / 推理内容的token数（缓存在 ChatMessageData 上，按内容哈希校验）
+	static int messageTokens(const ChatMessageData& message);
+	static int reasoningTokens(const ChatMessageData& message);
+
+private:
+	// 每个会话的窗口状态，决定了发送内容的前缀
+	struct Window
+	{
+		int start = 0;                  // 第一条发送的消息下标
+		bool reasoningDropped = false;  // 一旦去掉推理内容就保持，避免前缀来回变化
+	};
+
+	QHash<QString, Window> m_windows;
+};
@@ -0,0 +1,603 @@
+#include "ChatHistoryIndex.h"
+#include "ChatArchive.h"
+#include "SessionJournal.h"
+#include "SqliteSessionStore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+namespace {
+	constexpr int kManifestVersion = 1;
+	const QString kManifestName = QStringLiteral("LLMChatIndex.json");
+	const QString kColdPrefix = QStringLiteral("LLMChatCold_");
+
+	bool isSpace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	int skipSpace(const QByteArray& data, int pos) {
+		while (pos < data.size() && isSpace(data.at(pos)))
+			++pos;
+		return pos;
+	}
+
+	// pos 指向起始引号，返回结束引号之后的位置，失败返回 -1
+	int skipString(const QByteArray& data, int pos) {
+		for (int i = pos + 1; i < data.size(); ++i) {
+			if (data.at(i) == '\\')
+				++i;
+			else if (data.at(i) == '"')
+				return i + 1;
+		}
+		return -1;
+	}
+
+	// 跳过一个完整的 JSON 值，返回值之后的位置，失败返回 -1
+	int skipValue(const QByteArray& data, int pos) {
+		if (pos >= data.size())
+			return -1;
+		const char first = data.at(pos);
+		if (first == '"')
+			return skipString(data, pos);
+		if (first != '{' && first != '[') {
+			while (pos < data.size() && !isSpace(data.at(pos))
+				&& data.at(pos) != ',' && data.at(pos) != '}' && data.at(pos) != ']')
+				++pos;
+			return pos;
+		}
+		int depth = 0;
+		for (int i = pos; i < data.size(); ++i) {
+			const char c = data.at(i);
+			if (c == '"') {
+				i = skipString(data, i);
+				if (i < 0)
+					return -1;
+				--i;
+			}
+			else if (c == '{' || c == '[') {
+				++depth;
+			}
+			else if (c == '}' || c == ']') {
+				if (--depth == 0)
+					return i + 1;
+			}
+		}
+		return -1;
+	}
+
+	QString decodeKey(const QByteArray& quoted) {
+		const QJsonDocument doc = QJsonDocument::fromJson("[" + quoted + "]");
+		return doc.array().at(0).toString();
+	}
+
+	QString siblingFile(const QString& fileName, const QString& suffix) {
+		return QFileInfo(fileName).completeBaseName() + suffix;
+	}
+
+	bool isArchiveFile(const QString& filePath) {
+		return filePath.endsWith(QLatin1String(".cbor"), Qt::CaseInsensitive);
+	}
+
+	qint64 fileSize(const QString& filePath) {
+		const QFileInfo info(filePath);
+		return info.exists() ? info.size() : 0;
+	}
+
+	// 快照能完整解析（或还不存在）时才能在其上合并日志并重写，否则重写会丢掉快照中的会话
+	bool snapshotReadable(const QString& filePath) {
+		QFile file(filePath);
+		if (!file.exists())
+			return true;
+		if (!file.open(QIODevice::ReadOnly))
+			return false;
+		const QByteArray data = file.readAll();
+		if (data.trimmed().isEmpty())
+			return true;
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+		return error.error == QJsonParseError::NoError && doc.isObject();
+	}
+
+	// 冷存储按会话的保存月份分段，同一段的会话一起追加
+	QString coldSegmentName(const QDateTime& saveTime) {
+		return kColdPrefix + saveTime.toString(QStringLiteral("yyyy-MM")) + QStringLiteral(".cbor");
+	}
+}
+
+void ChatHistoryIndex::setDirectory(const QString& directory) {
+	if (m_directory == directory)
+		return;
+	m_directory = directory;
+	m_files.clear();
+	m_entries.clear();
+	m_entryIndex.clear();
+	m_lastOpened.clear();
+	m_archiving.clear();
+	m_archiveFailed.clear();
+	m_manifestLoaded = false;
+}
+
+void ChatHistoryIndex::setExcludedFiles(const QStringList& files) {
+	m_excluded.clear();
+	for (const QString& file : files) {
+		if (!file.isEmpty())
+			m_excluded.append(QFileInfo(file).absoluteFilePath());
+	}
+}
+
+bool ChatHistoryIndex::refresh() {
+	if (m_directory.isEmpty())
+		return false;
+	if (!m_manifestLoaded) {
+		readManifest();
+		m_manifestLoaded = true;
+	}
+
+	const QDir dir(m_directory);
+	bool changed = false;
+	QMap<QString, FileEntry> files;
+	// JSON 文件先按原格式索引，转换为归档由 takePendingArchive 交给后台完成，不阻塞启动
+	for (const QString& fileName : historyFiles()) {
+		const QString filePath = dir.filePath(fileName);
+		auto cached = m_files.constFind(fileName);
+		if (cached != m_files.constEnd() && isCurrent(filePath, cached.value())) {
+			files.insert(fileName, cached.value());
+			continue;
+		}
+		FileEntry entry;
+		if (scanFile(filePath, entry))
+			files.insert(fileName, entry);
+		changed = true;
+	}
+	// 文件被删除或排除
+	if (files.size() != m_files.size())
+		changed = true;
+	m_files = files;
+	rebuildEntries();
+	if (changed)
+		writeManifest();
+	return true;
+}
+
+const QList<ChatSessionSummary>& ChatHistoryIndex::entries() const {
+	return m_entries;
+}
+
+const ChatSessionSummary* ChatHistoryIndex::find(const QString& sessionId) const {
+	auto it = m_entryIndex.constFind(sessionId);
+	return it == m_entryIndex.constEnd() ? nullptr : &m_entries.at(it.value());
+}
+
+bool ChatHistoryIndex::loadSession(const QString& sessionId, ChatSession& session) {
+	const ChatSessionSummary* summary = find(sessionId);
+	if (!summary)
+		return false;
+	// 清单建立之后文件又被修改过，位置可能已失效
+	const QString fileName = QFileInfo(summary->file).fileName();
+	if (!isCurrent(summary->file, m_files.value(fileName))) {
+		refresh();
+		summary = find(sessionId);
+		if (!summary)
+			return false;
+	}
+
+	if (isDatabaseFile(summary->file)) {
+		SqliteSessionStore store;
+		if (!store.open(summary->file, SqliteSessionStore::OpenMode::ReadOnly) || !store.loadSession(sessionId, session))
+			return false;
+	}
+	else if (isArchiveFile(summary->file)) {
+		// 按天的归档和冷存储段相同：只解码这个会话的块（冷存储段中先解压）
+		if (!ChatArchive::readSession(summary->file, summary->offset, summary->length, session))
+			return false;
+	}
+	else {
+		QFile file(summary->file);
+		if (!file.open(QIODevice::ReadOnly) || !file.seek(summary->offset))
+			return false;
+		const QByteArray data = file.read(summary->length);
+		if (data.size() != summary->length)
+			return false;
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject())
+			return false;
+		session = ChatSession();
+		session.fromJson(doc.object());
+	}
+	markOpened(sessionId);
+	return true;
+}
+
+void ChatHistoryIndex::removeSession(const QString& sessionId) {
+	const QDir dir(m_directory);
+	bool changed = false;
+	for (auto it = m_files.begin(); it != m_files.end(); ++it) {
+		bool contains = false;
+		for (const ChatSessionSummary& summary : it.value().sessions) {
+			if (summary.sessionId == sessionId) {
+				contains = true;
+				break;
+			}
+		}
+		if (!contains)
+			continue;
+
+		const QString filePath = dir.filePath(it.key());
+		if (isDatabaseFile(filePath)) {
+			SqliteSessionStore store;
+			if (store.open(filePath))
+				store.sessionRemoved(sessionId);
+		}
+		else if (isArchiveFile(filePath)) {
+			ChatSessionMap sessions;
+			if (ChatArchive::readAll(filePath, sessions) && sessions.remove(sessionId) > 0)
+				ChatArchive::write(filePath, sessions, isColdSegment(filePath));
+		}
+		else if (snapshotReadable(filePath)) {
+			SessionJournal journal;
+			journal.setStorageFile(filePath);
+			ChatSessionMap sessions;
+			journal.load(sessions);
+			if (sessions.remove(sessionId) > 0)
+				journal.saveAll(sessions);
+		}
+		FileEntry entry;
+		if (scanFile(filePath, entry))
+			it.value() = entry;
+		changed = true;
+	}
+	if (!changed && !m_lastOpened.contains(sessionId))
+		return;
+	m_lastOpened.remove(sessionId);
+	rebuildEntries();
+	writeManifest();
+}
+
+QString ChatHistoryIndex::takePendingArchive() {
+	const QDir dir(m_directory);
+	for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+		// 以往日期的 JSON 文件不再写入，转换为归档格式（同一天已改用数据库的除外）
+		const QString& fileName = it.key();
+		if (!fileName.endsWith(QLatin1String(".json"))
+			|| m_archiving.contains(fileName) || m_archiveFailed.contains(fileName)
+			|| m_files.contains(siblingFile(fileName, QStringLiteral(".db")))
+			|| m_files.contains(siblingFile(fileName, QStringLiteral(".cbor"))))
+			continue;
+		// 还有未合并的日志或扫描后又被修改时，等下次扫描之后再转换
+		const QString filePath = dir.filePath(fileName);
+		if (!isCurrent(filePath, it.value()))
+			continue;
+		m_archiving.insert(fileName, it.value());
+		return filePath;
+	}
+	return QString();
+}
+
+bool ChatHistoryIndex::finishArchive(const QString& jsonFile, const QString& archiveFile) {
+	const QString fileName = QFileInfo(jsonFile).fileName();
+	const FileEntry converted = m_archiving.take(fileName);
+	if (archiveFile.isEmpty()) {
+		m_archiveFailed.insert(fileName);
+		return false;
+	}
+	if (!isCurrent(jsonFile, converted)) {
+		// 转换期间删除了会话等，归档内容已过期
+		QFile::remove(archiveFile);
+		refresh();
+		return false;
+	}
+	// 原文件改名保留为备份（不再参与索引）；转换前日志已合并，剩下的只是空文件
+	const QString backupFile = jsonFile + QStringLiteral(".bak");
+	QFile::remove(backupFile);
+	if (!QFile::rename(jsonFile, backupFile)) {
+		QFile::remove(archiveFile);
+		refresh();
+		return false;
+	}
+	const QString journalFile = jsonFile + QStringLiteral(".journal");
+	QFile::remove(journalFile + QStringLiteral(".old"));
+	QFile::remove(journalFile);
+	refresh();
+	return true;
+}
+
+bool ChatHistoryIndex::moveColdSessions(int coldAfterDays) {
+	const QDate cutoff = QDate::currentDate().addDays(-coldAfterDays);
+	const QDir dir(m_directory);
+	for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+		// 只处理按天的归档；数据库和 JSON 文件（当天或转换失败的）保持原样
+		if (!isArchiveFile(it.key()) || isColdSegment(it.key()))
+			continue;
+		QHash<QString, QString> segmentOf;   // 会话ID -> 冷存储段
+		for (const ChatSessionSummary& summary : it.value().sessions) {
+			if (isCold(summary, cutoff))
+				segmentOf.insert(summary.sessionId, coldSegmentName(summary.saveTime));
+		}
+		if (segmentOf.isEmpty())
+			continue;
+
+		const QString filePath = dir.filePath(it.key());
+		ChatSessionMap sessions;
+		if (!ChatArchive::readAll(filePath, sessions))
+			continue;
+		QMap<QString, ChatSessionMap> segments;
+		for (auto cold = segmentOf.constBegin(); cold != segmentOf.constEnd(); ++cold) {
+			if (sessions.contains(cold.key()))
+				segments[cold.value()].insert(cold.key(), sessions.take(cold.key()));
+		}
+
+		qint64 bytesBefore = fileSize(filePath);
+		for (auto segment = segments.constBegin(); segment != segments.constEnd(); ++segment)
+			bytesBefore += fileSize(dir.filePath(segment.key()));
+		// 先写入冷存储段再从原文件删除，中途失败时会话至多重复一份，不会丢失
+		// 上次中断后已在冷存储段中的同一份会话不再写入，这次只从原文件删除
+		for (auto segment = segments.begin(); segment != segments.end(); ++segment) {
+			const QString segmentFile = dir.filePath(segment.key());
+			QList<ChatSessionSummary> stored;
+			if (QFile::exists(segmentFile) && !ChatArchive::readSummaries(segmentFile, stored)) {
+				qWarning() << "ChatHistoryIndex: cannot read cold segment" << segment.key();
+				return false;
+			}
+			for (const ChatSessionSummary& summary : stored) {
+				auto moved = segment.value().constFind(summary.sessionId);
+				if (moved != segment.value().constEnd() && moved.value().SaveTime == summary.saveTime)
+					segment.value().remove(summary.sessionId);
+			}
+			if (segment.value().isEmpty())
+				continue;
+			if (!ChatArchive::appendCompressed(segmentFile, segment.value())) {
+				qWarning() << "ChatHistoryIndex: cannot write cold segment" << segment.key();
+				return false;
+			}
+		}
+		if (sessions.isEmpty())
+			QFile::remove(filePath);
+		else if (!ChatArchive::write(filePath, sessions))
+			return false;
+
+		qint64 bytesAfter = fileSize(filePath);
+		for (auto segment = segments.constBegin(); segment != segments.constEnd(); ++segment)
+			bytesAfter += fileSize(dir.filePath(segment.key()));
+		qInfo().noquote() << QStringLiteral("ChatHistoryIndex: moved %1 sessions from %2 to cold storage, %3 -> %4 bytes")
+			.arg(segmentOf.size()).arg(it.key()).arg(bytesBefore).arg(bytesAfter);
+
+		// 重新扫描变化的文件并写回清单
+		refresh();
+		return true;
+	}
+	return false;
+}
+
+QString ChatHistoryIndex::manifestFile() const {
+	return m_directory.isEmpty() ? QString() : QDir(m_directory).filePath(kManifestName);
+}
+
+QStringList ChatHistoryIndex::historyFiles() const {
+	const QDir dir(m_directory);
+	const QStringList names = dir.entryList(
+		{ QStringLiteral("LLMChat_*.json"), QStringLiteral("LLMChat_*.cbor"), QStringLiteral("LLMChat_*.db"),
+			kColdPrefix + QStringLiteral("*.cbor") },
+		QDir::Files, QDir::Name);
+	QStringList files;
+	for (const QString& name : names) {
+		if (!m_excluded.contains(QFileInfo(dir.filePath(name)).absoluteFilePath()))
+			files.append(name);
+	}
+	return files;
+}
+
+bool ChatHistoryIndex::scanFile(const QString& filePath, FileEntry& entry) const {
+	entry = FileEntry();
+	if (isDatabaseFile(filePath)) {
+		SqliteSessionStore store;
+		if (!store.open(filePath, SqliteSessionStore::OpenMode::ReadOnly) || !store.loadSummaries(entry.sessions))
+			return false;
+	}
+	else if (isArchiveFile(filePath)) {
+		// 归档文件的目录就是摘要，不必解码会话
+		if (!ChatArchive::readSummaries(filePath, entry.sessions))
+			return false;
+	}
+	else {
+		// 日志中还有未合并的记录时先合并进快照，快照中的位置才是完整会话
+		const QString journalFile = filePath + QStringLiteral(".journal");
+		if ((fileSize(journalFile) > 0 || fileSize(journalFile + QStringLiteral(".old")) > 0)
+			&& snapshotReadable(filePath)) {
+			SessionJournal journal;
+			journal.setStorageFile(filePath);
+			ChatSessionMap sessions;
+			if (journal.load(sessions))
+				journal.saveAll(sessions);
+		}
+		QFile file(filePath);
+		if (!file.open(QIODevice::ReadOnly))
+			return false;
+		if (!scanSnapshot(file.readAll(), entry.sessions))
+			return false;
+	}
+	const QFileInfo info(filePath);
+	entry.size = info.size();
+	entry.modified = info.lastModified();
+	for (ChatSessionSummary& summary : entry.sessions)
+		summary.file = info.absoluteFilePath();
+	return true;
+}
+
+bool ChatHistoryIndex::isCurrent(const QString& filePath, const FileEntry& entry) const {
+	const QFileInfo info(filePath);
+	if (!info.exists() || info.size() != entry.size || info.lastModified() != entry.modified)
+		return false;
+	if (isDatabaseFile(filePath) || isArchiveFile(filePath))
+		return true;
+	const QString journalFile = filePath + QStringLiteral(".journal");
+	return fileSize(journalFile) == 0 && fileSize(journalFile + QStringLiteral(".old")) == 0;
+}
+
+bool ChatHistoryIndex::scanSnapshot(const QByteArray& data, QList<ChatSessionSummary>& sessions) {
+	// 快照的根对象是 { 会话ID: 会话, ... }，逐个记录每个会话值的字节范围
+	int pos = skipSpace(data, 0);
+	if (pos >= data.size())
+		return true; // 新建的空文件
+	if (data.at(pos) != '{')
+		return false;
+	pos = skipSpace(data, pos + 1);
+	while (pos < data.size() && data.at(pos) != '}') {
+		if (data.at(pos) != '"')
+			return false;
+		const int keyEnd = skipString(data, pos);
+		if (keyEnd < 0)
+			return false;
+		const QString sessionId = decodeKey(data.mid(pos, keyEnd - pos));
+		pos = skipSpace(data, keyEnd);
+		if (pos >= data.size() || data.at(pos) != ':')
+			return false;
+		const int valueStart = skipSpace(data, pos + 1);
+		const int valueEnd = skipValue(data, valueStart);
+		if (valueEnd < 0)
+			return false;
+
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(data.mid(valueStart, valueEnd - valueStart), &error);
+		if (error.error == QJsonParseError::NoError && doc.isObject()) {
+			ChatSession session;
+			session.fromJson(doc.object());
+			ChatSessionSummary summary = ChatSessionSummary::fromSession(sessionId, session);
+			summary.offset = valueStart;
+			summary.length = valueEnd - valueStart;
+			sessions.append(summary);
+		}
+
+		pos = skipSpace(data, valueEnd);
+		if (pos < data.size() && data.at(pos) == ',')
+			pos = skipSpace(data, pos + 1);
+	}
+	return pos < data.size();
+}
+
+QString ChatHistoryIndex::convertToArchive(const QString& jsonFile) {
+	const QFileInfo info(jsonFile);
+	const QString archiveFile = info.dir().filePath(siblingFile(info.fileName(), QStringLiteral(".cbor")));
+	if (!ChatArchive::convertJson(jsonFile, archiveFile)) {
+		QFile::remove(archiveFile);
+		return QString();
+	}
+	return archiveFile;
+}
+
+bool ChatHistoryIndex::isDatabaseFile(const QString& filePath) {
+	return filePath.endsWith(QLatin1String(".db"), Qt::CaseInsensitive);
+}
+
+bool ChatHistoryIndex::isColdSegment(const QString& filePath) {
+	return QFileInfo(filePath).fileName().startsWith(kColdPrefix) && isArchiveFile(filePath);
+}
+
+bool ChatHistoryIndex::isCold(const ChatSessionSummary& summary, const QDate& cutoff) const {
+	QDate lastUsed = summary.saveTime.date();
+	const QDate opened = m_lastOpened.value(summary.sessionId);
+	if (opened.isValid() && (!lastUsed.isValid() || opened > lastUsed))
+		lastUsed = opened;
+	return lastUsed.isValid() && lastUsed < cutoff;
+}
+
+void ChatHistoryIndex::markOpened(const QString& sessionId) {
+	// 同一天内重复打开不再写清单
+	const QDate today = QDate::currentDate();
+	if (m_lastOpened.value(sessionId) == today)
+		return;
+	m_lastOpened.insert(sessionId, today);
+	writeManifest();
+}
+
+void ChatHistoryIndex::rebuildEntries() {
+	m_entries.clear();
+	m_entryIndex.clear();
+	// 按文件名（即日期）顺序合并，较新的副本覆盖较旧的
+	for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+		// 同一天已改用数据库保存或已转换为归档时，JSON 文件只是旧数据
+		if (it.key().endsWith(QLatin1String(".json"))) {
+			auto database = m_files.constFind(siblingFile(it.key(), QStringLiteral(".db")));
+			if (database != m_files.constEnd() && !database.value().sessions.isEmpty())
+				continue;
+			if (m_files.contains(siblingFile(it.key(), QStringLiteral(".cbor"))))
+				continue;
+		}
+		for (const ChatSessionSummary& summary : it.value().sessions) {
+			auto existing = m_entryIndex.constFind(summary.sessionId);
+			if (existing == m_entryIndex.constEnd()) {
+				m_entryIndex.insert(summary.sessionId, m_entries.size());
+				m_entries.append(summary);
+			}
+			else if (summary.saveTime >= m_entries.at(existing.value()).saveTime) {
+				m_entries[existing.value()] = summary;
+			}
+		}
+	}
+}
+
+bool ChatHistoryIndex::readManifest() {
+	QFile file(manifestFile());
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+	const QJsonObject root = doc.object();
+	if (root.value("version").toInt() != kManifestVersion)
+		return false;
+
+	const QDir dir(m_directory);
+	const QJsonObject files = root.value("files").toObject();
+	for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+		const QJsonObject obj = it.value().toObject();
+		FileEntry entry;
+		entry.size = static_cast<qint64>(obj.value("size").toDouble(-1));
+		entry.modified = QDateTime::fromString(obj.value("modified").toString(), Qt::ISODateWithMs);
+		const QString filePath = QFileInfo(dir.filePath(it.key())).absoluteFilePath();
+		for (const QJsonValue& value : obj.value("sessions").toArray()) {
+			ChatSessionSummary summary;
+			summary.fromJson(value.toObject());
+			summary.file = filePath;
+			entry.sessions.append(summary);
+		}
+		m_files.insert(it.key(), entry);
+	}
+	const QJsonObject opened = root.value("opened").toObject();
+	for (auto it = opened.constBegin(); it != opened.constEnd(); ++it) {
+		const QDate date = QDate::fromString(it.value().toString(), Qt::ISODate);
+		if (date.isValid())
+			m_lastOpened.insert(it.key(), date);
+	}
+	return true;
+}
+
+bool ChatHistoryIndex::writeManifest() const {
+	QJsonObject files;
+	for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+		QJsonArray sessions;
+		for (const ChatSessionSummary& summary : it.value().sessions)
+			sessions.append(summary.toJson());
+		QJsonObject obj;
+		obj["size"] = static_cast<double>(it.value().size);
+		obj["modified"] = it.value().modified.toString(Qt::ISODateWithMs);
+		obj["sessions"] = sessions;
+		files.insert(it.key(), obj);
+	}
+	QJsonObject opened;
+	for (auto it = m_lastOpened.constBegin(); it != m_lastOpened.constEnd(); ++it)
+		opened.insert(it.key(), it.value().toString(Qt::ISODate));
+	QJsonObject root;
+	root["version"] = kManifestVersion;
+	root["files"] = files;
+	root["opened"] = opened;
+
+	QSaveFile file(manifestFile());
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+	return file.commit();
+}
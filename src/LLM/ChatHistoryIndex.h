@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "SessionStore.h"
+
+// 历史会话索引：汇总历史目录中所有按天保存的文件（LLMChat_yyyy-MM-dd.json / .cbor / .db）
+// 清单文件记录每个会话的摘要和所在位置，侧边栏只读清单；会话全文在打开时按位置读取
+// 文件大小和修改时间不变时不重新扫描；以往日期的 JSON 文件由调用方在后台转换为归档格式（ChatArchive）
+// 长期未打开的会话从按天的归档移入按月的压缩冷存储段（LLMChatCold_yyyy-MM.cbor），摘要仍在清单中
+class ChatHistoryIndex {
+public:
+	void setDirectory(const QString& directory);
+	// 正在写入的存储文件由 ChatSessionService 在内存中维护，不进入索引
+	void setExcludedFiles(const QStringList& files);
+
+	// 扫描目录，更新有变化的文件并写回清单
+	bool refresh();
+
+	// 全部历史会话（同一会话出现在多个文件时取最新的一份）
+	[[nodiscard]] const QList<ChatSessionSummary>& entries() const;
+	[[nodiscard]] const ChatSessionSummary* find(const QString& sessionId) const;
+
+	// 读取一个会话的全文，并记录打开日期
+	bool loadSession(const QString& sessionId, ChatSession& session);
+	// 从所有历史文件中删除会话
+	void removeSession(const QString& sessionId);
+
+	// 取出一个待转换为归档格式的以往日期 JSON 文件（完整路径）并记下它当前的大小和修改时间，没有时返回空
+	QString takePendingArchive();
+	// 把 JSON 文件（含未合并的日志）转换为同名归档文件，成功返回归档文件路径；只读写文件，可在后台线程调用
+	static QString convertToArchive(const QString& jsonFile);
+	// 后台转换结束后调用：转换期间 JSON 文件未被修改时把原文件改名为 .json.bak 备份并重新扫描，否则丢弃归档，下次重新转换
+	bool finishArchive(const QString& jsonFile, const QString& archiveFile);
+
+	// 把 coldAfterDays 天内既未保存也未打开的会话移入冷存储段
+	// 每次只处理一个按天的归档文件，还有待处理的文件时返回 true
+	bool moveColdSessions(int coldAfterDays);
+
+	[[nodiscard]] QString manifestFile() const;
+
+private:
+	struct FileEntry {
+		qint64 size = -1;
+		QDateTime modified;
+		QList<ChatSessionSummary> sessions;
+	};
+
+	// 历史目录中的会话文件（不含正在写入的文件）
+	[[nodiscard]] QStringList historyFiles() const;
+	bool scanFile(const QString& filePath, FileEntry& entry) const;
+	[[nodiscard]] bool isCurrent(const QString& filePath, const FileEntry& entry) const;
+	static bool scanSnapshot(const QByteArray& data, QList<ChatSessionSummary>& sessions);
+	static bool isDatabaseFile(const QString& filePath);
+	static bool isColdSegment(const QString& filePath);
+	[[nodiscard]] bool isCold(const ChatSessionSummary& summary, const QDate& cutoff) const;
+	void markOpened(const QString& sessionId);
+	void rebuildEntries();
+	bool readManifest();
+	bool writeManifest() const;
+
+	QString m_directory;
+	QStringList m_excluded;
+	QMap<QString, FileEntry> m_files;   // 文件名 -> 文件中的会话
+	QList<ChatSessionSummary> m_entries;
+	QHash<QString, int> m_entryIndex;
+	QHash<QString, QDate> m_lastOpened;   // 会话ID -> 最近一次从历史文件打开的日期
+	QMap<QString, FileEntry> m_archiving;   // 正在后台转换的 JSON 文件 -> 开始转换时的文件状态
+	QSet<QString> m_archiveFailed;   // 本次运行中转换失败的文件，不再重试
+	bool m_manifestLoaded = false;
+};
@@ -6,6 +6,7 @@
 #include <QStyle>
 #include <algorithm>
 #include "ModelSelectorWidget.h"
+#include "RenderCache.h"
 
 namespace
 {
@@ -89,27 +90,13 @@ namespace
 
 QString ChatInputWidget::markdownToHtml(const QString& markdown)
 {
-	static QHash<QString, QString> mdCache;
-	static const int MAX_CACHE_SIZE = 100;
-
-	auto it = mdCache.find(markdown);
-	if (it != mdCache.end())
-	{
-		return *it;
-	}
-
-	if (mdCache.size() >= MAX_CACHE_SIZE)
+	// 预览用的简易转换，与气泡的渲染器编号不同
+	constexpr quint32 kPreviewRenderer = 0x50520001;
+	const quint64 key = RenderCache::key(markdown, kPreviewRenderer);
+	RenderCacheEntry entry;
+	if (RenderCache::instance().find(key, entry))
 	{
-		QHash<QString, QString> newCache;
-		int count = 0;
-		for (auto cacheIt = mdCache.begin(); cacheIt != mdCache.end(); ++cacheIt)
-		{
-			if ((count++ % 2) == 0)
-			{
-				newCache.insert(cacheIt.key(), cacheIt.value());
-			}
-		}
-		mdCache.swap(newCache);
+		return entry.html;
 	}
 
 	QString html = markdown;
@@ -163,7 +150,8 @@ QString ChatInputWidget::markdownToHtml(const QString& markdown)
 	}
 	html = htmlLines.join(QString());
 
-	mdCache.insert(markdown, html);
+	entry.html = html;
+	RenderCache::instance().insert(key, entry);
 	return html;
 }
 
@@ -19,6 +19,22 @@
 
 namespace
 {
+    // ǰ棬ԭ˳
+    class ConversationItem : public QListWidgetItem
+    {
+    public:
+        bool operator<(const QListWidgetItem& other) const override
+        {
+            const int rank = data(ChatList::SearchRankRole).toInt();
+            const int otherRank = other.data(ChatList::SearchRankRole).toInt();
+            if (rank != otherRank)
+            {
+                return rank < otherRank;
+            }
+            return data(ChatList::ListOrderRole).toInt() < other.data(ChatList::ListOrderRole).toInt();
+        }
+    };
+
     class ChatListDelegate : public QStyledItemDelegate
     {
     public:
@@ -129,6 +145,7 @@ ChatList::ChatList(QWidget *parent)
     , searchEdit(nullptr)
     , searchTimer(nullptr)
     , searchCallback(nullptr)
+    , indexedSearchCallback(nullptr)
 {
     setupUI();
     connectSignals();
@@ -351,9 +368,10 @@ void ChatList::connectSignals()
 
 void ChatList::addConversationItem(const QString& text, const QString& id)
 {
-    QListWidgetItem* item = new QListWidgetItem();
+    QListWidgetItem* item = new ConversationItem();
     item->setText(text);
     item->setData(IdRole, id);
+    item->setData(ListOrderRole, m_backOrder++);
     item->setFlags(item->flags() | Qt::ItemIsSelectable);
     item->setData(SearchMatchRole, true);  // Ĭʾ
     m_conversationList->addItem(item);
@@ -367,9 +385,28 @@ void ChatList::addConversationItem(const QString& text, const QString& id)
 
 void ChatList::insertConversationItem(int index, const QString& text, const QString& id)
 {
-    QListWidgetItem* item = new QListWidgetItem();
+    QListWidgetItem* item = new ConversationItem();
     item->setText(text);
     item->setData(IdRole, id);
+    if (index <= 0)
+    {
+        item->setData(ListOrderRole, --m_frontOrder);
+    }
+    else if (index >= m_conversationList->count())
+    {
+        item->setData(ListOrderRole, m_backOrder++);
+    }
+    else
+    {
+        // 嵽мʱǰ˳±
+        for (int i = 0; i < m_conversationList->count(); ++i)
+        {
+            m_conversationList->item(i)->setData(ListOrderRole, i < index ? i : i + 1);
+        }
+        item->setData(ListOrderRole, index);
+        m_frontOrder = 0;
+        m_backOrder = m_conversationList->count() + 1;
+    }
     item->setFlags(item->flags() | Qt::ItemIsSelectable);
     item->setData(SearchMatchRole, true);  // Ĭʾ
     m_conversationList->insertItem(index, item);
@@ -407,6 +444,9 @@ void ChatList::clearConversations()
 {
     m_conversationList->clear();
     allConversationIds.clear();
+    m_ranked = false;
+    m_frontOrder = 0;
+    m_backOrder = 0;
 }
 
 void ChatList::setCurrentConversation(const QString& id)
@@ -446,6 +486,14 @@ void ChatList::setCurrentItemText(const QString& text)
     }
 }
 
+void ChatList::setConversationText(const QString& id, const QString& text)
+{
+    if (auto* item = findItemById(id))
+    {
+        item->setText(text);
+    }
+}
+
 void ChatList::onNewConversationClicked()
 {
     emit newConversationRequested();
@@ -564,6 +612,17 @@ void ChatList::setSearchCallback(std::function<QString(const QString&)> callback
     searchCallback = callback;
 }
 
+void ChatList::setIndexedSearchCallback(std::function<bool(const QString&, QList<QPair<QString, QStringList>>&)> callback)
+{
+    indexedSearchCallback = callback;
+}
+
+QStringList ChatList::searchHits(const QString& conversationId) const
+{
+    QListWidgetItem* item = findItemById(conversationId);
+    return item ? item->data(SearchHitsRole).toStringList() : QStringList();
+}
+
 void ChatList::onSearchTextChanged(const QString& text)
 {
     // öʱʵַ
@@ -591,12 +650,23 @@ void ChatList::performSearch()
             QListWidgetItem* item = m_conversationList->item(i);
             if (item)
             {
+                item->setData(SearchHitsRole, QVariant());
                 setItemVisible(item, true);
             }
         }
+        sortByRank(false);
         return;
     }
     
+    // ʹһβѯõȫеĶԻ
+    QList<QPair<QString, QStringList>> rankedHits;
+    const bool indexed = indexedSearchCallback && indexedSearchCallback(searchText, rankedHits);
+    QHash<QString, int> hitRanks;
+    for (int i = 0; i < rankedHits.size(); ++i)
+    {
+        hitRanks.insert(rankedHits.at(i).first, i);
+    }
+
     // ִ
     searchText = searchText.toLower();
     int matchCount = 0;
@@ -617,7 +687,15 @@ void ChatList::performSearch()
         
         // Ի
         bool contentMatch = false;
-        if (searchCallback && !titleMatch)
+        if (indexed)
+        {
+            auto hit = hitRanks.constFind(conversationId);
+            contentMatch = hit != hitRanks.constEnd();
+            item->setData(SearchHitsRole, contentMatch ? QVariant(rankedHits.at(hit.value()).second) : QVariant());
+            // жδе֮
+            item->setData(SearchRankRole, contentMatch ? hit.value() : rankedHits.size());
+        }
+        else if (searchCallback && !titleMatch)
         {
             contentMatch = searchInConversation(conversationId, searchText);
         }
@@ -630,6 +708,25 @@ void ChatList::performSearch()
             matchCount++;
         }
     }
+    sortByRank(indexed);
+}
+
+void ChatList::sortByRank(bool rankItems)
+{
+    if (!rankItems)
+    {
+        if (!m_ranked)
+        {
+            return;
+        }
+        for (int i = 0; i < m_conversationList->count(); ++i)
+        {
+            m_conversationList->item(i)->setData(SearchRankRole, QVariant());
+        }
+    }
+    // ֻеλãǰֲ䣬ᴥлԻ
+    m_conversationList->sortItems(Qt::AscendingOrder);
+    m_ranked = rankItems;
 }
 
 bool ChatList::searchInConversation(const QString& conversationId, const QString& searchText) const
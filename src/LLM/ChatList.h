@@ -14,6 +14,10 @@
 #include <QPoint>
 #include <QLineEdit>
 #include <QTimer>
+#include <QHash>
+#include <QStringList>
+#include <QList>
+#include <QPair>
 #include <functional>
 
 class ChatList : public QWidget
@@ -48,6 +52,8 @@ public:
 	QListWidgetItem* getCurrentItem() const;
 	// 设置当前选中项的文本
 	void setCurrentItemText(const QString& text);
+	// 设置指定对话项的文本
+	void setConversationText(const QString& id, const QString& text);
 	// 设置对话时间戳
 	void setConversationTimestamp(const QString& id, const QString& timestamp);
 	// 获取列表项数量
@@ -56,12 +62,19 @@ public:
 	void setCurrentRow(int row) { m_conversationList->setCurrentRow(row); }
 	// 设置搜索回调函数，用于搜索对话内容
 	void setSearchCallback(std::function<QString(const QString& conversationId)> callback);
+	// 设置索引检索回调：一次查询按相关度顺序返回命中的对话ID及命中的消息ID，返回 false 时退回逐个对话查找
+	void setIndexedSearchCallback(std::function<bool(const QString& text, QList<QPair<QString, QStringList>>& hits)> callback);
+	// 当前搜索中指定对话命中的消息ID（按相关度排列），未搜索或未命中时为空
+	QStringList searchHits(const QString& conversationId) const;
 	// 对话项数据角色枚举
 	enum ConversationRole
 	{
 		IdRole = Qt::UserRole,        // ID角色
 		TimestampRole = Qt::UserRole + 1,  // 时间戳角色
-		SearchMatchRole = Qt::UserRole + 2  // 搜索匹配角色
+		SearchMatchRole = Qt::UserRole + 2,  // 搜索匹配角色
+		SearchHitsRole = Qt::UserRole + 3,  // 内容命中的消息ID列表
+		SearchRankRole = Qt::UserRole + 4,  // 检索相关度名次，越小越靠前
+		ListOrderRole = Qt::UserRole + 5  // 未按相关度排列时的顺序
 	};
 
 signals:
@@ -113,6 +126,8 @@ private:
     bool searchInConversation(const QString& conversationId, const QString& searchText) const;
 	// 显示/隐藏对话项
     void setItemVisible(QListWidgetItem* item, bool visible);
+	// 按检索名次重排列表；rankItems 为 false 时恢复原有顺序
+	void sortByRank(bool rankItems);
     // UI组件
     QVBoxLayout* mainLayout;
     QPushButton* btnNewConversation;
@@ -134,7 +149,11 @@ private:
     // 搜索相关
     QTimer* searchTimer;  // 搜索防抖定时器
     std::function<QString(const QString&)> searchCallback;  // 搜索回调函数
+    std::function<bool(const QString&, QList<QPair<QString, QStringList>>&)> indexedSearchCallback;  // 索引检索回调函数
 	QStringList allConversationIds;  // 保存所有对话ID，用于搜索
+	bool m_ranked = false;  // 列表当前是否按相关度排列
+	int m_frontOrder = 0;   // 插到列表开头的项使用的顺序值
+	int m_backOrder = 0;    // 追加到列表末尾的项使用的顺序值
 
 
 };
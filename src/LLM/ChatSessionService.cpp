@@ -1,17 +1,57 @@
 #include "ChatSessionService.h"
+#include "SessionJournal.h"
+#include "SqliteSessionStore.h"
 
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QRunnable>
+#include <QTimer>
 #include <QUuid>
 
+// 后台转换任务：只读写文件，结果回到GUI线程由历史索引确认后替换原文件
+class ChatSessionService::ArchiveTask : public QRunnable {
+public:
+	ArchiveTask(ChatSessionService* service, const QString& jsonFile)
+		: m_service(service)
+		, m_jsonFile(jsonFile) {
+		setAutoDelete(true);
+	}
+
+	void run() override {
+		const QString archiveFile = ChatHistoryIndex::convertToArchive(m_jsonFile);
+		// 析构时会等待任务结束，这里 m_service 一定有效
+		ChatSessionService* service = m_service;
+		const QString jsonFile = m_jsonFile;
+		QMetaObject::invokeMethod(service, [service, jsonFile, archiveFile]() {
+			service->onArchiveFinished(jsonFile, archiveFile);
+		}, Qt::QueuedConnection);
+	}
+
+private:
+	ChatSessionService* m_service;
+	QString m_jsonFile;
+};
+
 ChatSessionService::ChatSessionService(QObject* parent)
-	: QObject(parent) {}
+	: QObject(parent)
+	, m_store(std::make_unique<SessionJournal>()) {
+	m_archivePool.setMaxThreadCount(1);
+	m_autosaveTimer = new QTimer(this);
+	m_autosaveTimer->setSingleShot(true);
+	m_autosaveTimer->setInterval(kAutosaveDelayMs);
+	connect(m_autosaveTimer, &QTimer::timeout, this, &ChatSessionService::autosave);
+}
+
+ChatSessionService::~ChatSessionService() {
+	m_archivePool.waitForDone();
+}
 
 void ChatSessionService::setStorageFile(const QString& filePath) {
 	if (m_storageFile == filePath)
 		return;
 	m_storageFile = filePath;
+	// 已改用数据库时 JSON 文件只作为导入来源
+	if (m_databaseFile.isEmpty())
+		m_store->setStorageFile(filePath);
+	updateHistoryExclusions();
 	emit storageFileChanged(m_storageFile);
 }
 
@@ -19,20 +59,58 @@ QString ChatSessionService::storageFile() const {
 	return m_storageFile;
 }
 
+bool ChatSessionService::enableDatabase(const QString& databaseFile) {
+	if (databaseFile.isEmpty())
+		return false;
+	if (m_databaseFile == databaseFile)
+		return true;
+	auto store = std::make_unique<SqliteSessionStore>();
+	if (!store->open(databaseFile))
+		return false;
+	// 首次启用：把现有的快照和日志导入数据库，原文件保留不动
+	if (store->isEmpty() && m_databaseFile.isEmpty() && !m_storageFile.isEmpty()) {
+		ChatSessionMap imported;
+		if (m_store->load(imported) && !store->saveAll(imported))
+			return false;
+	}
+	m_store = std::move(store);
+	m_databaseFile = databaseFile;
+	updateHistoryExclusions();
+	return true;
+}
+
+void ChatSessionService::setHistoryDirectory(const QString& directory) {
+	m_history.setDirectory(directory);
+	updateHistoryExclusions();
+}
+
+void ChatSessionService::setSessionInUseCallback(SessionInUse callback) {
+	m_sessionInUse = std::move(callback);
+}
+
 bool ChatSessionService::loadSessions() {
-	if (m_storageFile.isEmpty())
+	if (!isPersistent())
 		return false;
-	bool loaded = loadFromJson(m_storageFile);
+	m_loadedHistory.clear();
+	m_modifiedSessions.clear();
+	bool loaded = m_store->load(m_sessions);
+	// 历史文件只读清单，会话全文在打开时读取
+	m_history.refresh();
+	loaded = loaded || !m_history.entries().isEmpty();
+	scheduleMaintenance(kMaintenanceDelayMs);
 	if (loaded) {
 		emit sessionsChanged();
 	}
 	return loaded;
 }
 
-bool ChatSessionService::saveSessions() const {
-	if (m_storageFile.isEmpty())
+bool ChatSessionService::saveSessions() {
+	if (!isPersistent())
 		return false;
-	return saveToJson(m_storageFile);
+	emit aboutToSave();
+	m_autosaveTimer->stop();
+	m_modifiedSessions.clear();
+	return m_store->saveAll(m_loadedHistory.isEmpty() ? m_sessions : storedSessions());
 }
 
 QString ChatSessionService::createSession(const QString& displayNameHint) {
@@ -40,21 +118,36 @@ QString ChatSessionService::createSession(const QString& displayNameHint) {
 	ChatSession session;
 	session.SaveTime = QDateTime::currentDateTime();
 	m_sessions.insert(sessionId, session);
+	if (isPersistent()) {
+		m_store->sessionCreated(sessionId, session);
+		compactStore();
+	}
 	emit sessionsChanged();
 	return sessionId;
 }
 
 void ChatSessionService::removeSession(const QString& sessionId) {
-	if (!m_sessions.contains(sessionId))
+	const bool inHistory = m_history.find(sessionId) != nullptr;
+	if (!m_sessions.contains(sessionId) && !inHistory)
 		return;
 	m_sessions.remove(sessionId);
+	m_loadedHistory.removeOne(sessionId);
+	m_modifiedSessions.remove(sessionId);
+	if (isPersistent()) {
+		m_store->sessionRemoved(sessionId);
+		compactStore();
+	}
+	if (inHistory)
+		m_history.removeSession(sessionId);
 	emit sessionsChanged();
 }
 
 ChatSession* ChatSessionService::session(const QString& sessionId) {
 	auto it = m_sessions.find(sessionId);
 	if (it == m_sessions.end())
-		return nullptr;
+		return loadHistorySession(sessionId);
+	if (m_loadedHistory.removeOne(sessionId))
+		m_loadedHistory.append(sessionId);
 	return &it.value();
 }
 
@@ -73,45 +166,158 @@ const ChatSessionMap& ChatSessionService::sessions() const {
 	return m_sessions;
 }
 
+QList<ChatSessionSummary> ChatSessionService::sessionSummaries() const {
+	QList<ChatSessionSummary> summaries;
+	QSet<QString> current;
+	for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+		if (m_loadedHistory.contains(it.key()))
+			continue;
+		summaries.append(ChatSessionSummary::fromSession(it.key(), it.value()));
+		current.insert(it.key());
+	}
+	// 继续过的历史会话已转入当前存储，以当前存储中的为准
+	for (const ChatSessionSummary& summary : m_history.entries()) {
+		if (!current.contains(summary.sessionId))
+			summaries.append(summary);
+	}
+	return summaries;
+}
+
+const ChatSessionSummary* ChatSessionService::historySummary(const QString& sessionId) const {
+	return m_history.find(sessionId);
+}
+
 void ChatSessionService::updateSession(const QString& sessionId, const ChatSession& session) {
 	m_sessions.insert(sessionId, session);
+	m_loadedHistory.removeOne(sessionId);
+	if (isPersistent()) {
+		m_store->sessionReplaced(sessionId, session);
+		compactStore();
+	}
 	emit sessionsChanged();
 }
 
-bool ChatSessionService::loadFromJson(const QString& filePath) {
-	QFile file(filePath);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-		return false;
+void ChatSessionService::recordMessage(const QString& sessionId, const QString& bubbleId) {
+	const ChatSession* target = session(sessionId);
+	const int index = target ? target->messageIndex(bubbleId) : -1;
+	if (index < 0 || !isPersistent())
+		return;
+	adoptHistorySession(sessionId);
+	m_store->messagePut(sessionId, *target, target->sMsg.at(index));
+	compactStore();
+}
+
+void ChatSessionService::recordAnnotation(const QString& sessionId, const QString& bubbleId) {
+	const ChatSession* target = session(sessionId);
+	const int index = target ? target->messageIndex(bubbleId) : -1;
+	if (index < 0 || !isPersistent())
+		return;
+	adoptHistorySession(sessionId);
+	m_store->messageAnnotated(sessionId, *target, target->sMsg.at(index));
+	compactStore();
+}
 
-	QJsonParseError error;
-	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
-	file.close();
+void ChatSessionService::markModified(const QString& sessionId) {
+	if (!isPersistent() || !m_sessions.contains(sessionId))
+		return;
+	adoptHistorySession(sessionId);
+	m_modifiedSessions.insert(sessionId);
+	// 不重新计时：持续修改（流式回答）时也按固定间隔保存
+	if (!m_autosaveTimer->isActive())
+		m_autosaveTimer->start();
+}
 
-	if (error.error != QJsonParseError::NoError || !doc.isObject())
+bool ChatSessionService::searchSessions(const QString& text, QList<SessionSearchHit>& hits, int limit) const {
+	if (!isPersistent())
 		return false;
+	return m_store->search(text, limit, hits);
+}
 
-	m_sessions.clear();
-	const QJsonObject root = doc.object();
-	for (const QString& key : root.keys()) {
-		ChatSession session;
-		session.fromJson(root.value(key).toObject());
-		m_sessions.insert(key, session);
-	}
-	return !m_sessions.isEmpty();
+bool ChatSessionService::isPersistent() const {
+	return !m_storageFile.isEmpty() || !m_databaseFile.isEmpty();
 }
 
-bool ChatSessionService::saveToJson(const QString& filePath) const {
-	QJsonObject root;
+void ChatSessionService::compactStore() {
+	m_store->compactIfNeeded(m_loadedHistory.isEmpty() ? m_sessions : storedSessions());
+}
+
+ChatSessionMap ChatSessionService::storedSessions() const {
+	ChatSessionMap stored;
+	stored.reserve(m_sessions.size());
 	for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
-		root.insert(it.key(), it.value().toJson());
+		if (!m_loadedHistory.contains(it.key()))
+			stored.insert(it.key(), it.value());
 	}
+	return stored;
+}
 
-	QFile file(filePath);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-		return false;
+ChatSession* ChatSessionService::loadHistorySession(const QString& sessionId) {
+	ChatSession loaded;
+	if (!m_history.loadSession(sessionId, loaded))
+		return nullptr;
+	auto it = m_sessions.insert(sessionId, loaded);
+	m_loadedHistory.append(sessionId);
+	// 释放最久未使用的历史会话；刚读入的和界面仍在使用的保留（都在使用时暂时超出上限）
+	for (int i = 0; m_loadedHistory.size() > kLoadedHistoryLimit && i < m_loadedHistory.size() - 1;) {
+		const QString candidate = m_loadedHistory.at(i);
+		if (m_sessionInUse && m_sessionInUse(candidate)) {
+			++i;
+			continue;
+		}
+		m_loadedHistory.removeAt(i);
+		m_sessions.remove(candidate);
+	}
+	return &it.value();
+}
 
-	file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
-	file.close();
-	return true;
+void ChatSessionService::adoptHistorySession(const QString& sessionId) {
+	if (!m_loadedHistory.removeOne(sessionId))
+		return;
+	// 当前存储中还没有这个会话，先写入完整会话，之后的增量记录才能重放
+	auto it = m_sessions.constFind(sessionId);
+	if (it != m_sessions.constEnd())
+		m_store->sessionReplaced(sessionId, it.value());
+}
+
+void ChatSessionService::updateHistoryExclusions() {
+	m_history.setExcludedFiles({ m_storageFile, m_databaseFile });
 }
 
+void ChatSessionService::autosave() {
+	if (m_modifiedSessions.isEmpty() || !isPersistent())
+		return;
+	emit aboutToSave();
+	// 逐个会话浅拷贝：消息列表隐式共享，GUI线程之后的修改各自分离
+	if (m_store->saveAsync(storedSessions(), m_modifiedSessions))
+		m_modifiedSessions.clear();
+	else
+		m_autosaveTimer->start(); // 上一次保存还在写入，稍后重试
+}
+
+void ChatSessionService::scheduleMaintenance(int delayMs) {
+	if (m_maintenanceScheduled)
+		return;
+	m_maintenanceScheduled = true;
+	QTimer::singleShot(delayMs, this, &ChatSessionService::maintainHistory);
+}
+
+void ChatSessionService::maintainHistory() {
+	m_maintenanceScheduled = false;
+	if (m_archiving)
+		return; // 转换结束后继续
+	// 已读入内存的历史会话不受影响；会话ID和标题不变，侧边栏无需刷新
+	const QString jsonFile = m_history.takePendingArchive();
+	if (!jsonFile.isEmpty()) {
+		m_archiving = true;
+		m_archivePool.start(new ArchiveTask(this, jsonFile));
+		return;
+	}
+	if (m_history.moveColdSessions(kColdAfterDays))
+		scheduleMaintenance(kMaintenanceIntervalMs);
+}
+
+void ChatSessionService::onArchiveFinished(const QString& jsonFile, const QString& archiveFile) {
+	m_archiving = false;
+	m_history.finishArchive(jsonFile, archiveFile);
+	scheduleMaintenance(kMaintenanceIntervalMs);
+}
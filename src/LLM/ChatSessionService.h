@@ -3,39 +3,112 @@
 #include <QObject>
 #include <QPointer>
 
+#include <QSet>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+
+#include "ChatHistoryIndex.h"
 #include "ChatSessionTypes.h"
+#include "SessionStore.h"
+
+// 会话存储：当前存储文件中的会话保存在内存中，修改只把变化的部分交给存储后端
+// 默认后端为 JSON 快照 + 日志（SessionJournal），可切换为 SQLite（SqliteSessionStore）
+// 历史目录中其他文件的会话只保留摘要（ChatHistoryIndex），打开时才读取全文，长时间不用再释放
+class QTimer;
 
 class ChatSessionService : public QObject {
 	Q_OBJECT
 public:
+	// 会话是否正被界面使用（正在显示或有进行中的回答）
+	using SessionInUse = std::function<bool(const QString& sessionId)>;
+
 	explicit ChatSessionService(QObject* parent = nullptr);
+	~ChatSessionService() override;
 
 	void setStorageFile(const QString& filePath);
 	[[nodiscard]] QString storageFile() const;
+	// 改用 SQLite 数据库保存会话；数据库为空时导入当前 JSON 存储中的会话
+	// 驱动或 FTS5 不可用时返回 false，继续使用 JSON 存储
+	bool enableDatabase(const QString& databaseFile);
+	// 历史目录：其中其他日期的文件通过索引按需读取
+	void setHistoryDirectory(const QString& directory);
+	// 正被界面使用的历史会话不会因超出 kLoadedHistoryLimit 而释放
+	void setSessionInUseCallback(SessionInUse callback);
 
 	bool loadSessions();
-	bool saveSessions() const;
+	// 同步保存全部会话（退出、清空时）
+	bool saveSessions();
 
 	QString createSession(const QString& displayNameHint = QString());
 	void removeSession(const QString& sessionId);
 
+	// 历史会话不在内存中时从磁盘读取；const 版本只查找已在内存中的会话
 	ChatSession* session(const QString& sessionId);
 	const ChatSession* session(const QString& sessionId) const;
 
+	// 全部会话（当前文件 + 历史索引）的摘要，用于填充侧边栏
+	[[nodiscard]] QList<ChatSessionSummary> sessionSummaries() const;
+	// 历史会话的摘要，不读取全文；不在历史索引中时返回 nullptr
+	[[nodiscard]] const ChatSessionSummary* historySummary(const QString& sessionId) const;
+
 	ChatSessionMap& sessions();
 	const ChatSessionMap& sessions() const;
 
 	void updateSession(const QString& sessionId, const ChatSession& session);
 
+	// 直接修改会话数据后调用，把修改写入日志
+	// 消息新增或内容变化（按气泡ID覆盖）
+	void recordMessage(const QString& sessionId, const QString& bubbleId);
+	// 消息备注、重要标记变化
+	void recordAnnotation(const QString& sessionId, const QString& bubbleId);
+	// 会话数据已修改但还不能记录时调用（例如流式回答仍在接收），由自动保存在 kAutosaveDelayMs 内写入
+	void markModified(const QString& sessionId);
+
+	// 全文检索会话内容；后端不支持时返回 false
+	bool searchSessions(const QString& text, QList<SessionSearchHit>& hits, int limit = 200) const;
+
 signals:
 	void storageFileChanged(const QString& filePath);
 	void sessionsChanged();
+	// 保存前发出，界面把还没有写回会话的数据（接收中的回答）写回
+	void aboutToSave();
 
 private:
-	bool loadFromJson(const QString& filePath);
-	bool saveToJson(const QString& filePath) const;
+	static constexpr int kLoadedHistoryLimit = 8;   // 同时留在内存中的历史会话数
+	static constexpr int kAutosaveDelayMs = 3000;   // 第一次修改之后最多等待的时间（期间的修改不推迟保存）
+	static constexpr int kColdAfterDays = 30;   // 超过这么多天未保存也未打开的历史会话移入冷存储
+	static constexpr int kMaintenanceDelayMs = 10000;   // 启动后等界面空闲再整理历史文件
+	static constexpr int kMaintenanceIntervalMs = 1000;   // 每次只处理一个文件，文件之间的间隔
+
+	class ArchiveTask;
+
+	[[nodiscard]] bool isPersistent() const;
+	void compactStore();
+	// 只属于当前存储的会话（不含从历史文件读入、尚未修改的会话）
+	[[nodiscard]] ChatSessionMap storedSessions() const;
+	ChatSession* loadHistorySession(const QString& sessionId);
+	// 历史会话被修改后转入当前存储
+	void adoptHistorySession(const QString& sessionId);
+	void updateHistoryExclusions();
+	void autosave();
+	// 整理历史文件：先在后台把以往日期的 JSON 文件转换为归档，再把长期未用的会话移入冷存储
+	void scheduleMaintenance(int delayMs);
+	void maintainHistory();
+	void onArchiveFinished(const QString& jsonFile, const QString& archiveFile);
 
 	QString m_storageFile;
+	QString m_databaseFile;
 	ChatSessionMap m_sessions;
+	std::unique_ptr<SessionStore> m_store;
+	ChatHistoryIndex m_history;
+	QStringList m_loadedHistory;   // 从历史文件读入的会话，最近使用的在末尾
+	QSet<QString> m_modifiedSessions;   // 等待自动保存的会话
+	QTimer* m_autosaveTimer = nullptr;
+	SessionInUse m_sessionInUse;
+	bool m_maintenanceScheduled = false;
+	bool m_archiving = false;
+	QThreadPool m_archivePool;   // 单线程，一次转换一个文件
 };
 
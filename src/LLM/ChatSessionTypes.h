@@ -5,25 +5,111 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QList>
-#include <QSize>
+#include <QPoint>
 #include <QString>
+#include <QVector>
+
+// 气泡在几个宽度区间下的实测高度，随消息保存
+// 按内容哈希和排版版本（字体等）校验，任一变化时整体作废
+struct ChatLayoutCache {
+	static constexpr int kMaxWidths = 4;      // 保留的宽度区间数
+	static constexpr int kWidthBucket = 16;   // 宽度区间（像素），同一区间内高度差别很小，绑定后再实测
+
+	quint32 contentHash = 0;
+	quint32 version = 0;
+	QVector<QPoint> heights;   // x：宽度区间，y：高度；最近写入的在末尾
+
+	// 未命中返回 -1
+	int height(int width, quint32 hash, quint32 layoutVersion) const {
+		if (hash != contentHash || layoutVersion != version) {
+			return -1;
+		}
+		const int bucket = width / kWidthBucket;
+		for (const QPoint& entry : heights) {
+			if (entry.x() == bucket) {
+				return entry.y();
+			}
+		}
+		return -1;
+	}
+
+	// 缓存中已是相同的值时返回 false
+	bool store(int width, int height, quint32 hash, quint32 layoutVersion) {
+		if (hash != contentHash || layoutVersion != version) {
+			heights.clear();
+			contentHash = hash;
+			version = layoutVersion;
+		}
+		const int bucket = width / kWidthBucket;
+		for (int i = 0; i < heights.size(); ++i) {
+			if (heights[i].x() == bucket) {
+				if (heights[i].y() == height) {
+					return false;
+				}
+				heights.removeAt(i);
+				break;
+			}
+		}
+		if (heights.size() >= kMaxWidths) {
+			heights.removeFirst();
+		}
+		heights.append(QPoint(bucket, height));
+		return true;
+	}
+
+	void clear() {
+		heights.clear();
+	}
+
+	QJsonObject toJson() const {
+		QJsonArray array;
+		for (const QPoint& entry : heights) {
+			array.append(entry.x());
+			array.append(entry.y());
+		}
+		QJsonObject obj;
+		obj["hash"] = static_cast<qint64>(contentHash);
+		obj["version"] = static_cast<qint64>(version);
+		obj["heights"] = array;
+		return obj;
+	}
+
+	void fromJson(const QJsonObject& obj) {
+		contentHash = static_cast<quint32>(obj.value("hash").toDouble());
+		version = static_cast<quint32>(obj.value("version").toDouble());
+		heights.clear();
+		const QJsonArray array = obj.value("heights").toArray();
+		for (int i = 0; i + 1 < array.size() && heights.size() < kMaxWidths; i += 2) {
+			heights.append(QPoint(array.at(i).toInt(), array.at(i + 1).toInt()));
+		}
+	}
+};
 
 struct ChatMessageData {
 	QString m_ChatMsg;
 	QString m_ChatReasonMsg;
 	QString m_ChatTime;
-	QSize m_AllSize;
+	ChatLayoutCache m_Layout;
 	int userType = 1;
 	QString m_DialogName;
 	QString m_BubbleID;
 	bool m_IsImportant = false;
 	QString m_Note;
+	// 估算token数的缓存（ChatContextBuilder 使用），按对应文本的哈希校验，内容变化（即使长度相同）后重新计算
+	mutable int m_TokenCount = -1;
+	mutable uint m_TokenCountHash = 0;
+	mutable int m_ReasonTokenCount = -1;
+	mutable uint m_ReasonTokenCountHash = 0;
+
+	// 排版缓存校验用的内容哈希：影响气泡高度的只有正文、推理和消息类型
+	quint32 layoutHash() const {
+		return qHash(m_ChatMsg, qHash(m_ChatReasonMsg, static_cast<uint>(userType)));
+	}
 
 	ChatMessageData() = default;
 
 	ChatMessageData(QString message,
 		QString time,
-		QSize size,
 		int type,
 		QString dialog,
 		QString reasoning,
@@ -33,7 +119,6 @@ struct ChatMessageData {
 		: m_ChatMsg(std::move(message))
 		, m_ChatReasonMsg(std::move(reasoning))
 		, m_ChatTime(std::move(time))
-		, m_AllSize(size)
 		, userType(type)
 		, m_DialogName(std::move(dialog))
 		, m_BubbleID(std::move(id))
@@ -44,8 +129,9 @@ struct ChatMessageData {
 		QJsonObject obj;
 		obj["msg"] = m_ChatMsg;
 		obj["time"] = m_ChatTime;
-		obj["width"] = m_AllSize.width();
-		obj["height"] = m_AllSize.height();
+		if (!m_Layout.heights.isEmpty()) {
+			obj["layout"] = m_Layout.toJson();
+		}
 		obj["userType"] = userType;
 		obj["dialogname"] = m_DialogName;
 		obj["reasoningMsg"] = m_ChatReasonMsg;
@@ -58,7 +144,7 @@ struct ChatMessageData {
 	void fromJson(const QJsonObject& obj) {
 		m_ChatMsg = obj["msg"].toString();
 		m_ChatTime = obj["time"].toString();
-		m_AllSize = QSize(obj["width"].toInt(), obj["height"].toInt());
+		m_Layout.fromJson(obj.value("layout").toObject());
 		userType = obj["userType"].toInt();
 		m_DialogName = obj["dialogname"].toString();
 		m_ChatReasonMsg = obj["reasoningMsg"].toString();
@@ -88,29 +174,82 @@ struct ChatSession {
 	void fromJson(const QJsonObject& obj) {
 		SaveTime = QDateTime::fromString(obj["saveTime"].toString(), Qt::ISODate);
 		QJsonArray msgArray = obj["messages"].toArray();
-		sMsg.clear();
+		clearMessages();
 		for (const QJsonValue& val : msgArray) {
 			if (!val.isObject()) {
 				continue;
 			}
 			ChatMessageData msg;
 			msg.fromJson(val.toObject());
-			sMsg.append(msg);
+			appendMessage(std::move(msg));
 		}
 	}
 
+	// 按气泡ID查找消息下标（同一ID出现多次时取第一条）
+	// 索引在第一次查找时建立；增删消息请用下面的函数，直接改动 sMsg 结构后查找时会发现并重建
 	int messageIndex(const QString& bubbleId) const {
-		for (int i = 0; i < sMsg.size(); ++i) {
-			if (sMsg[i].m_BubbleID == bubbleId) {
-				return i;
-			}
+		if (m_indexedCount != sMsg.size()) {
+			rebuildMessageIndex();
 		}
-		return -1;
+		const int index = m_messageIndex.value(bubbleId, -1);
+		if (index < 0 || (index < sMsg.size() && sMsg.at(index).m_BubbleID == bubbleId)) {
+			return index;
+		}
+		rebuildMessageIndex();
+		return m_messageIndex.value(bubbleId, -1);
 	}
 
 	int GetMsgIndex(const QString& bubbleId) const {
 		return messageIndex(bubbleId);
 	}
+
+	// 追加消息时索引同步更新；插入、删除、移动会改变后续消息的下标，索引在下次查找时重建
+	void appendMessage(ChatMessageData message) {
+		const bool indexed = m_indexedCount == sMsg.size();
+		if (indexed && !m_messageIndex.contains(message.m_BubbleID)) {
+			m_messageIndex.insert(message.m_BubbleID, sMsg.size());
+		}
+		sMsg.append(std::move(message));
+		if (indexed) {
+			m_indexedCount = sMsg.size();
+		}
+	}
+
+	void insertMessage(int row, ChatMessageData message) {
+		sMsg.insert(row, std::move(message));
+		m_indexedCount = -1;
+	}
+
+	void removeMessage(int row) {
+		sMsg.removeAt(row);
+		m_indexedCount = -1;
+	}
+
+	void moveMessage(int from, int to) {
+		sMsg.move(from, to);
+		m_indexedCount = -1;
+	}
+
+	void clearMessages() {
+		sMsg.clear();
+		m_messageIndex.clear();
+		m_indexedCount = 0;
+	}
+
+private:
+	void rebuildMessageIndex() const {
+		m_messageIndex.clear();
+		m_messageIndex.reserve(sMsg.size());
+		for (int i = 0; i < sMsg.size(); ++i) {
+			if (!m_messageIndex.contains(sMsg[i].m_BubbleID)) {
+				m_messageIndex.insert(sMsg[i].m_BubbleID, i);
+			}
+		}
+		m_indexedCount = sMsg.size();
+	}
+
+	mutable QHash<QString, int> m_messageIndex;   // 气泡ID -> sMsg 下标
+	mutable int m_indexedCount = -1;   // 建立索引时的消息数，-1 表示需要重建
 };
 
 using ChatSessionMap = QHash<QString, ChatSession>;
@@ -139,8 +139,8 @@ void ChatShowWidget::setupUI()
 	stackedWidget = new QStackedWidget(chatFrame);
 	stackedWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
-	// 聊天消息列表
-	listWgChatFrame = new QListWidget();
+	// 聊天消息列表（虚拟化视图，只为可见行创建气泡）
+	listWgChatFrame = new ChatTranscriptView();
 	listWgChatFrame->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 	listWgChatFrame->setObjectName("listWgChatFrame");
 	listWgChatFrame->setSpacing(2);
@@ -7,11 +7,11 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
-#include <QListWidget>
 #include <QWheelEvent>
 #include <QScrollBar>
 #include <QStackedWidget> 
 #include <QPainter>
+#include "ChatTranscriptView.h"
 class ChatShowWidget : public QWidget
 {
 	Q_OBJECT
@@ -23,7 +23,7 @@ public:
 	// 获取组件的访问器
 	QLabel* getChatTitle() const { return chatTitle; }
 	QPushButton* getToggleButton() const { return toggleButton; }
-	QListWidget* getChatFrame() const { return listWgChatFrame; }
+	ChatTranscriptView* getChatFrame() const { return listWgChatFrame; }
 	// 设置标题
 	void setChatTitle(const QString& title);
 	// 设置切换按钮图标
@@ -77,7 +77,7 @@ private:
 	QPushButton* UpButton;
 	QPushButton* DownButton;
 	// Chat组件
-	QListWidget* listWgChatFrame;
+	ChatTranscriptView* listWgChatFrame;
 	// 空状态组件
 	QStackedWidget* stackedWidget;
 	QWidget* emptyStateWidget;
@@ -0,0 +1,61 @@
+#include "ChatTranscriptDelegate.h"
+#include "ChatTranscriptModel.h"
+#include "ChatTranscriptView.h"
+#include "LLMChatFrame.h"
+#include <QPainter>
+#include <QPainterPath>
+
+namespace
+{
+	// 占位气泡最多绘制的字符数，避免对超长消息做整段排版
+	constexpr int kPreviewChars = 600;
+}
+
+ChatTranscriptDelegate::ChatTranscriptDelegate(ChatTranscriptView* view)
+	: QStyledItemDelegate(view)
+	, m_view(view)
+{
+}
+
+void ChatTranscriptDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+	if (!index.isValid() || (m_view && m_view->isRowBound(index.row())))
+	{
+		return;
+	}
+
+	using Layout = LLMChatFrame::LayoutConstants;
+	using Colors = LLMChatFrame::ColorScheme;
+	const bool isAnswer = index.data(ChatTranscriptModel::UserTypeRole).toInt() == LLMChatFrame::User_Customer;
+	const int sideInset = Layout::ICON_SPACING + Layout::ICON_SIZE + Layout::ICON_SPACING;
+	const int topInset = Layout::TIME_HEIGHT + Layout::TIME_MARGIN + Layout::ICON_MARGIN;
+	QRect frameRect = option.rect.adjusted(sideInset, topInset, -sideInset, -Layout::ICON_MARGIN);
+	if (frameRect.width() <= 0 || frameRect.height() <= 0)
+	{
+		return;
+	}
+
+	painter->save();
+	painter->setRenderHint(QPainter::Antialiasing, true);
+	QPainterPath path;
+	path.addRoundedRect(frameRect, Layout::BORDER_RADIUS, Layout::BORDER_RADIUS);
+	painter->setPen(QPen(isAnswer ? Colors::ANSWER_BORDER : Colors::USER_BACKGROUND, 1));
+	painter->setBrush(isAnswer ? Colors::ANSWER_BACKGROUND : Colors::USER_BACKGROUND);
+	painter->drawPath(path);
+
+	const QRect textRect = frameRect.adjusted(Layout::TEXT_PADDING, Layout::TEXT_PADDING,
+		-Layout::TEXT_PADDING, -Layout::TEXT_PADDING);
+	const QString preview = index.data(ChatTranscriptModel::AnswerRole).toString().left(kPreviewChars);
+	QFont font("Microsoft YaHei", 12);
+	painter->setFont(font);
+	painter->setPen(isAnswer ? QColor(Colors::TIME_TEXT) : QColor(Qt::white));
+	painter->setClipRect(textRect);
+	painter->drawText(textRect, Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, preview);
+	painter->restore();
+}
+
+QSize ChatTranscriptDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+	const QSize size = index.data(Qt::SizeHintRole).toSize();
+	return size.isValid() ? size : QStyledItemDelegate::sizeHint(option, index);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <QStyledItemDelegate>
+
+class ChatTranscriptView;
+
+// 聊天记录绘制代理
+// 尺寸直接取自模型（实测或估算），未绑定气泡控件的行只绘制轻量占位气泡，
+// 快速滚动时无需创建任何控件或文档
+class ChatTranscriptDelegate : public QStyledItemDelegate
+{
+	Q_OBJECT
+public:
+	explicit ChatTranscriptDelegate(ChatTranscriptView* view);
+
+	// 绘制占位气泡（已绑定控件的行由控件自己绘制）
+	void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+	// 行尺寸
+	QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+	ChatTranscriptView* m_view;
+};
@@ -0,0 +1,309 @@
+#include "ChatTranscriptModel.h"
+#include "LLMChatFrame.h"
+#include <QElapsedTimer>
+#include <QFontInfo>
+#include <QFontMetricsF>
+#include <QtMath>
+
+namespace
+{
+	// 与 MarkdownDocumentBuilder 的段落行高保持一致
+	constexpr qreal kLineHeightFactor = 1.7;
+	// 宽字符（中日韩等）按两个字符宽度计算
+	constexpr ushort kWideCharStart = 0x2E80;
+	// 气泡排版规则（LLMChatFrame、MarkdownDocumentBuilder）修改后递增，使保存的高度作废
+	constexpr uint kLayoutRevision = 1;
+	// 粗估时每个字符按 1.5 个宽度单位计算（中英文混排的平均值）
+	constexpr qreal kRoughUnitsPerChar = 1.5;
+}
+
+ChatTranscriptModel::ChatTranscriptModel(QObject* parent)
+	: QAbstractListModel(parent)
+	, m_session(&m_detachedSession)
+{
+	const QFont font("Microsoft YaHei", 12);
+	const QFontMetricsF metrics(font);
+	m_charWidth = qMax<qreal>(1.0, metrics.averageCharWidth());
+	m_lineHeight = metrics.lineSpacing() * kLineHeightFactor;
+	// 实际匹配到的字体不同（系统缺少该字体）时高度也不同
+	m_layoutVersion = qHash(QFontInfo(font).family(), kLayoutRevision);
+}
+
+int ChatTranscriptModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_session->sMsg.size();
+}
+
+QVariant ChatTranscriptModel::data(const QModelIndex& index, int role) const
+{
+	const ChatMessageData* msg = message(index.row());
+	if (!msg || index.column() != 0)
+	{
+		return QVariant();
+	}
+	switch (role)
+	{
+	case Qt::DisplayRole:
+	case AnswerRole:
+		return msg->m_ChatMsg;
+	case ReasoningRole:
+		return msg->m_ChatReasonMsg;
+	case Qt::SizeHintRole:
+		return rowSize(index.row());
+	case BubbleIdRole:
+		return msg->m_BubbleID;
+	case TimeRole:
+		return msg->m_ChatTime;
+	case UserTypeRole:
+		return msg->userType;
+	case ImportantRole:
+		return msg->m_IsImportant;
+	case NoteRole:
+		return msg->m_Note;
+	case MeasuredRole:
+		return isMeasured(index.row());
+	default:
+		return QVariant();
+	}
+}
+
+void ChatTranscriptModel::setSession(ChatSession* session)
+{
+	beginResetModel();
+	m_detachedSession.clearMessages();
+	m_session = session ? session : &m_detachedSession;
+	m_rows.fill(RowLayout(), m_session->sMsg.size());
+	m_resolvedFrom = 0;
+	endResetModel();
+}
+
+const ChatMessageData* ChatTranscriptModel::message(int row) const
+{
+	if (row < 0 || row >= m_session->sMsg.size())
+	{
+		return nullptr;
+	}
+	return &m_session->sMsg.at(row);
+}
+
+ChatMessageData* ChatTranscriptModel::message(int row)
+{
+	if (row < 0 || row >= m_session->sMsg.size())
+	{
+		return nullptr;
+	}
+	return &m_session->sMsg[row];
+}
+
+int ChatTranscriptModel::appendMessage(const ChatMessageData& message)
+{
+	const int row = m_session->sMsg.size();
+	beginInsertRows(QModelIndex(), row, row);
+	m_session->appendMessage(message);
+	m_rows.append(RowLayout());
+	endInsertRows();
+	return row;
+}
+
+void ChatTranscriptModel::messageChanged(int row)
+{
+	if (row < 0 || row >= m_session->sMsg.size())
+	{
+		return;
+	}
+	if (row < m_rows.size())
+	{
+		m_rows[row] = RowLayout();
+	}
+	const QModelIndex idx = index(row);
+	emit dataChanged(idx, idx);
+}
+
+int ChatTranscriptModel::rowForBubble(const QString& bubbleId) const
+{
+	return bubbleId.isEmpty() ? -1 : m_session->messageIndex(bubbleId);
+}
+
+void ChatTranscriptModel::setLayoutWidth(int width)
+{
+	if (width <= 0 || width == m_layoutWidth)
+	{
+		return;
+	}
+	m_layoutWidth = width;
+	// 内容哈希仍然有效，只重新查找行高
+	for (RowLayout& layout : m_rows)
+	{
+		layout.height = -1;
+		layout.measured = false;
+	}
+	if (!m_session->sMsg.isEmpty())
+	{
+		emit dataChanged(index(0), index(m_session->sMsg.size() - 1), { Qt::SizeHintRole });
+	}
+}
+
+void ChatTranscriptModel::setMeasuredSize(int row, const QSize& size)
+{
+	ChatMessageData* msg = message(row);
+	if (!msg || m_layoutWidth <= 0 || size.height() <= 0)
+	{
+		return;
+	}
+	RowLayout& layout = rowLayout(row);
+	msg->m_Layout.store(m_layoutWidth, size.height(), contentHash(row), m_layoutVersion);
+	if (layout.measured && layout.height == size.height())
+	{
+		return;
+	}
+	layout.height = size.height();
+	layout.measured = true;
+	layout.rough = false;
+	const QModelIndex idx = index(row);
+	emit dataChanged(idx, idx, { Qt::SizeHintRole });
+}
+
+bool ChatTranscriptModel::isMeasured(int row) const
+{
+	return message(row) && m_layoutWidth > 0 && rowLayout(row).measured;
+}
+
+QSize ChatTranscriptModel::rowSize(int row) const
+{
+	if (!message(row))
+	{
+		return QSize();
+	}
+	return QSize(m_layoutWidth, rowLayout(row).height);
+}
+
+QSize ChatTranscriptModel::measuredSize(int row) const
+{
+	return isMeasured(row) ? rowSize(row) : QSize();
+}
+
+void ChatTranscriptModel::beginProgressiveLayout(int tailHeight)
+{
+	m_resolvedFrom = m_session->sMsg.size();
+	int height = 0;
+	while (m_resolvedFrom > 0 && height < tailHeight)
+	{
+		--m_resolvedFrom;
+		height += rowLayout(m_resolvedFrom).height;
+	}
+}
+
+int ChatTranscriptModel::resolvePendingRows(int budgetMs)
+{
+	const int end = qMin(m_resolvedFrom, m_session->sMsg.size());
+	QElapsedTimer timer;
+	timer.start();
+	bool changed = false;
+	while (m_resolvedFrom > 0 && !timer.hasExpired(budgetMs))
+	{
+		--m_resolvedFrom;
+		const int rough = m_rows.value(m_resolvedFrom).height;
+		changed = rowLayout(m_resolvedFrom).height != rough || changed;
+	}
+	if (changed)
+	{
+		emit dataChanged(index(m_resolvedFrom), index(end - 1), { Qt::SizeHintRole });
+	}
+	return m_resolvedFrom;
+}
+
+ChatTranscriptModel::RowLayout& ChatTranscriptModel::rowLayout(int row) const
+{
+	if (m_rows.size() != m_session->sMsg.size())
+	{
+		m_rows.fill(RowLayout(), m_session->sMsg.size());
+	}
+	RowLayout& layout = m_rows[row];
+	if (row < m_resolvedFrom)
+	{
+		if (layout.height < 0)
+		{
+			layout.height = roughHeight(m_session->sMsg.at(row));
+			layout.measured = false;
+			layout.rough = true;
+		}
+		return layout;
+	}
+	if (layout.height < 0 || layout.rough)
+	{
+		layout.rough = false;
+		// 打开会话和改变宽度时多数行在这里命中缓存，不需要排版
+		const ChatMessageData& msg = m_session->sMsg.at(row);
+		const int cached = msg.m_Layout.height(m_layoutWidth, contentHash(row), m_layoutVersion);
+		layout.measured = cached > 0;
+		layout.height = layout.measured ? cached : estimateHeight(msg);
+	}
+	return layout;
+}
+
+quint32 ChatTranscriptModel::contentHash(int row) const
+{
+	RowLayout& layout = m_rows[row];
+	if (!layout.hashed)
+	{
+		layout.hash = m_session->sMsg.at(row).layoutHash();
+		layout.hashed = true;
+	}
+	return layout.hash;
+}
+
+int ChatTranscriptModel::roughHeight(const ChatMessageData& message) const
+{
+	using Layout = LLMChatFrame::LayoutConstants;
+	const int frameWidth = m_layoutWidth - Layout::FRAME_MARGIN
+		- 2 * (Layout::ICON_SIZE + Layout::ICON_SPACING + Layout::ICON_BORDER_WIDTH);
+	const qreal unitsPerLine = qMax<qreal>(1.0, qMax(80, frameWidth - 2 * Layout::TEXT_PADDING) / m_charWidth);
+	int length = message.m_ChatMsg.size();
+	if (message.userType == LLMChatFrame::User_Customer)
+	{
+		length += message.m_ChatReasonMsg.size();
+	}
+	const int lines = qMax(1, qCeil(length * kRoughUnitsPerChar / unitsPerLine));
+	return qMax(Layout::MIN_HEIGHT, qCeil(lines * m_lineHeight))
+		+ Layout::TIME_HEIGHT + Layout::TIME_MARGIN + Layout::EXTRA_HEIGHT;
+}
+
+int ChatTranscriptModel::estimateHeight(const ChatMessageData& message) const
+{
+	using Layout = LLMChatFrame::LayoutConstants;
+	const int frameWidth = m_layoutWidth - Layout::FRAME_MARGIN
+		- 2 * (Layout::ICON_SIZE + Layout::ICON_SPACING + Layout::ICON_BORDER_WIDTH);
+	const qreal textWidth = qMax(80, frameWidth - 2 * Layout::TEXT_PADDING);
+	const int chrome = Layout::TIME_HEIGHT + Layout::TIME_MARGIN + Layout::EXTRA_HEIGHT;
+
+	int height = qMax(Layout::MIN_HEIGHT, qCeil(estimateLines(message.m_ChatMsg, textWidth) * m_lineHeight));
+	// 只有回答气泡显示推理区域
+	if (message.userType == LLMChatFrame::User_Customer && !message.m_ChatReasonMsg.trimmed().isEmpty())
+	{
+		height += qMax(Layout::MIN_HEIGHT, qCeil(estimateLines(message.m_ChatReasonMsg, textWidth) * m_lineHeight));
+		height += 2 * (Layout::SECTION_HEADER_HEIGHT + Layout::SECTION_HEADER_MARGIN);
+	}
+	return height + chrome;
+}
+
+int ChatTranscriptModel::estimateLines(const QString& text, qreal textWidth) const
+{
+	const qreal unitsPerLine = qMax<qreal>(1.0, textWidth / m_charWidth);
+	int lines = 0;
+	int units = 0;
+	for (const QChar ch : text)
+	{
+		if (ch == QLatin1Char('\n'))
+		{
+			lines += qMax(1, qCeil(units / unitsPerLine));
+			units = 0;
+			continue;
+		}
+		units += ch.unicode() >= kWideCharStart ? 2 : 1;
+	}
+	if (units > 0)
+	{
+		lines += qCeil(units / unitsPerLine);
+	}
+	return qMax(1, lines);
+}
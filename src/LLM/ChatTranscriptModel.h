@@ -0,0 +1,90 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QVector>
+#include <QSize>
+#include "ChatSessionTypes.h"
+
+// 聊天记录模型：直接映射 ChatSession::sMsg，不持有任何控件
+// 行高优先使用消息排版缓存（ChatLayoutCache）中当前宽度区间的实测值，否则按文本长度估算
+class ChatTranscriptModel : public QAbstractListModel
+{
+	Q_OBJECT
+public:
+	enum Roles
+	{
+		BubbleIdRole = Qt::UserRole + 1, // 气泡ID
+		AnswerRole,                      // 回答原文
+		ReasoningRole,                   // 推理原文
+		TimeRole,                        // 时间戳
+		UserTypeRole,                    // 用户类型
+		ImportantRole,                   // 重要标记
+		NoteRole,                        // 用户笔记
+		MeasuredRole                     // 当前宽度下是否已实测
+	};
+
+	explicit ChatTranscriptModel(QObject* parent = nullptr);
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+	// 绑定会话（nullptr 时使用内部临时会话，消息不会被保存）
+	void setSession(ChatSession* session);
+	// 获取当前会话
+	ChatSession* session() const { return m_session; }
+	// 获取指定行的消息
+	const ChatMessageData* message(int row) const;
+	ChatMessageData* message(int row);
+	// 追加消息，返回新行号
+	int appendMessage(const ChatMessageData& message);
+	// 通知某行内容已变化（直接修改 message(row) 之后调用）
+	void messageChanged(int row);
+	// 根据气泡ID查找行号
+	int rowForBubble(const QString& bubbleId) const;
+
+	// 设置布局宽度，宽度变化后改查新宽度区间的缓存
+	void setLayoutWidth(int width);
+	// 获取布局宽度
+	int layoutWidth() const { return m_layoutWidth; }
+	// 记录气泡在当前宽度下的实测尺寸（写入消息的排版缓存，随会话保存）
+	void setMeasuredSize(int row, const QSize& size);
+	// 当前宽度下是否已实测
+	bool isMeasured(int row) const;
+	// 获取行尺寸（实测值或估算值）
+	QSize rowSize(int row) const;
+	// 当前宽度下的实测尺寸，未实测时返回无效尺寸
+	QSize measuredSize(int row) const;
+
+	// 分批计算行高：只精确计算末尾约 tailHeight 像素的行，更早的行先按字符数粗估
+	void beginProgressiveLayout(int tailHeight);
+	// 从下往上精确计算粗估的行，用时不超过 budgetMs，返回还剩多少行
+	int resolvePendingRows(int budgetMs);
+
+private:
+	struct RowLayout
+	{
+		int height = -1;         // 当前宽度下的行高，-1 表示未计算
+		bool measured = false;   // 行高来自排版缓存
+		bool rough = false;      // 行高只是按字符数粗估
+		bool hashed = false;
+		quint32 hash = 0;        // 消息内容哈希，内容变化时重新计算
+	};
+
+	// 取行的布局记录，必要时先计算行高
+	RowLayout& rowLayout(int row) const;
+	quint32 contentHash(int row) const;
+	// 只按字符数粗估，不扫描文本
+	int roughHeight(const ChatMessageData& message) const;
+	// 按文本长度估算气泡高度
+	int estimateHeight(const ChatMessageData& message) const;
+	// 估算一段文本在给定宽度下的行数
+	int estimateLines(const QString& text, qreal textWidth) const;
+
+	ChatSession m_detachedSession;
+	ChatSession* m_session = nullptr;
+	mutable QVector<RowLayout> m_rows;
+	int m_layoutWidth = 0;
+	int m_resolvedFrom = 0;                  // 此行之前的行高还是粗估值
+	quint32 m_layoutVersion = 0;             // 字体和排版规则的版本，变化后缓存的高度作废
+	qreal m_charWidth = 8.0;                 // 平均字符宽度
+	qreal m_lineHeight = 20.0;               // 行高
+};
@@ -0,0 +1,499 @@
+#include "ChatTranscriptView.h"
+#include "ChatTranscriptModel.h"
+#include "ChatTranscriptDelegate.h"
+#include "LLMChatFrame.h"
+#include <QElapsedTimer>
+#include <QResizeEvent>
+#include <QScrollBar>
+#include <QTimer>
+
+ChatTranscriptView::ChatTranscriptView(QWidget* parent)
+	: QListView(parent)
+	, m_model(new ChatTranscriptModel(this))
+	, m_delegate(new ChatTranscriptDelegate(this))
+{
+	setModel(m_model);
+	setItemDelegate(m_delegate);
+	setSelectionMode(QAbstractItemView::NoSelection);
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	// 行高来自模型缓存（实测或估算），单次布局的开销很小，使用单次布局便于保持滚动锚点
+	setLayoutMode(QListView::SinglePass);
+	setUniformItemSizes(false);
+
+	m_populateTimer = new QTimer(this);
+	m_populateTimer->setInterval(0);
+	connect(m_populateTimer, &QTimer::timeout, this, &ChatTranscriptView::populatePendingRows);
+
+	m_relayoutTimer = new QTimer(this);
+	m_relayoutTimer->setSingleShot(true);
+	m_relayoutTimer->setInterval(kRelayoutIntervalMs);
+	connect(m_relayoutTimer, &QTimer::timeout, this, &ChatTranscriptView::onRelayoutTimeout);
+
+	m_fastScrollTimer = new QTimer(this);
+	m_fastScrollTimer->setSingleShot(true);
+	m_fastScrollTimer->setInterval(kFastScrollSettleMs);
+	connect(m_fastScrollTimer, &QTimer::timeout, this, &ChatTranscriptView::onFastScrollSettled);
+}
+
+ChatTranscriptView::~ChatTranscriptView()
+{
+}
+
+void ChatTranscriptView::setBubbleFactory(BubbleAcquirer acquire, BubbleReleaser release)
+{
+	m_acquire = std::move(acquire);
+	m_release = std::move(release);
+}
+
+void ChatTranscriptView::setSession(ChatSession* session)
+{
+	m_populateTimer->stop();
+	releaseAllBubbles();
+	m_model->setSession(session);
+	m_model->setLayoutWidth(viewport()->width());
+	// 末尾一屏先精确计算（打开会话时显示在底部），其余行在空闲时补齐
+	m_model->beginProgressiveLayout(viewport()->height());
+	m_populateTimer->start();
+	scheduleBind();
+}
+
+int ChatTranscriptView::count() const
+{
+	return m_model->rowCount();
+}
+
+LLMChatFrame* ChatTranscriptView::appendMessage(const ChatMessageData& message, bool live)
+{
+	m_model->setLayoutWidth(viewport()->width());
+	const int row = m_model->appendMessage(message);
+	if (live)
+	{
+		m_pinnedRow = row;
+	}
+	LLMChatFrame* bubble = bindRow(row, live);
+	scrollToBottom();
+	positionBoundBubbles();
+	return bubble;
+}
+
+LLMChatFrame* ChatTranscriptView::latestBubble()
+{
+	const int row = count() - 1;
+	if (row < 0)
+	{
+		return nullptr;
+	}
+	LLMChatFrame* bubble = bindRow(row, false);
+	positionBoundBubbles();
+	return bubble;
+}
+
+LLMChatFrame* ChatTranscriptView::bubbleForId(const QString& bubbleId) const
+{
+	const int row = m_model->rowForBubble(bubbleId);
+	return row >= 0 ? m_boundBubbles.value(row).data() : nullptr;
+}
+
+bool ChatTranscriptView::scrollToBubble(const QString& bubbleId)
+{
+	const int row = count() > 0 ? m_model->rowForBubble(bubbleId) : -1;
+	if (row < 0)
+	{
+		return false;
+	}
+	scrollTo(m_model->index(row), QAbstractItemView::PositionAtTop);
+	scheduleBind();
+	return true;
+}
+
+void ChatTranscriptView::updateBubbleSize(LLMChatFrame* bubble)
+{
+	const int row = rowForBubble(bubble);
+	if (row < 0)
+	{
+		return;
+	}
+	QSize bubbleSize = bubble->getSize();
+	if (!bubbleSize.isValid())
+	{
+		bubbleSize = bubble->size();
+	}
+	const int availableWidth = viewport()->width();
+	if (availableWidth > 0)
+	{
+		bubble->resize(availableWidth, bubbleSize.height());
+	}
+	m_model->setMeasuredSize(row, bubbleSize);
+}
+
+void ChatTranscriptView::setPinnedRow(int row)
+{
+	if (m_pinnedRow == row)
+	{
+		return;
+	}
+	m_pinnedRow = row;
+	scheduleBind();
+}
+
+void ChatTranscriptView::relayoutBubbles()
+{
+	if (m_relayoutTimer->isActive())
+	{
+		m_relayoutPending = true;
+		return;
+	}
+	relayoutVisibleBubbles();
+	m_relayoutTimer->start();
+}
+
+void ChatTranscriptView::onRelayoutTimeout()
+{
+	if (!m_relayoutPending)
+	{
+		return;
+	}
+	m_relayoutPending = false;
+	relayoutVisibleBubbles();
+	m_relayoutTimer->start();
+}
+
+void ChatTranscriptView::relayoutVisibleBubbles()
+{
+	const int availableWidth = viewport()->width();
+	if (availableWidth != m_model->layoutWidth())
+	{
+		m_model->setLayoutWidth(availableWidth);
+		// 新宽度下末尾一屏先算，其余行高在空闲时补齐（多数命中排版缓存）
+		m_model->beginProgressiveLayout(viewport()->height());
+		m_populateTimer->start();
+	}
+	const QRect visibleRect = viewport()->rect();
+	const QList<int> rows = m_boundBubbles.keys();
+	for (int row : rows)
+	{
+		LLMChatFrame* bubble = m_boundBubbles.value(row).data();
+		if (!bubble)
+		{
+			continue;
+		}
+		// 视口外的气泡不在旧宽度上重排，滚动进入视口时重新绑定
+		if (row != m_pinnedRow && !bubble->geometry().intersects(visibleRect))
+		{
+			unbindRow(row);
+			continue;
+		}
+		// 宽度变化时气泡在 resizeEvent 中重新排版
+		bubble->resize(availableWidth, bubble->height());
+		QSize bubbleSize = bubble->getSize();
+		if (!bubbleSize.isValid())
+		{
+			bubbleSize = bubble->size();
+		}
+		m_model->setMeasuredSize(row, bubbleSize);
+	}
+	scheduleDelayedItemsLayout();
+	scheduleBind();
+}
+
+void ChatTranscriptView::releaseAllBubbles()
+{
+	const QList<int> rows = m_boundBubbles.keys();
+	for (int row : rows)
+	{
+		unbindRow(row);
+	}
+	m_pinnedRow = -1;
+}
+
+bool ChatTranscriptView::isRowBound(int row) const
+{
+	return m_boundBubbles.value(row) != nullptr;
+}
+
+void ChatTranscriptView::doItemsLayout()
+{
+	// 视口外的行从估算高度变为实测高度时，保持首个可见行不跳动；已在底部时保持在底部
+	QScrollBar* bar = verticalScrollBar();
+	const bool atBottom = bar->maximum() > 0 && bar->value() >= bar->maximum() - 2;
+	int anchorRow = -1;
+	int anchorTop = 0;
+	if (!atBottom && count() > 0)
+	{
+		anchorRow = rowAtOffset(0);
+		anchorTop = visualRect(m_model->index(anchorRow)).top();
+	}
+
+	QListView::doItemsLayout();
+
+	if (atBottom)
+	{
+		bar->setValue(bar->maximum());
+	}
+	else if (anchorRow >= 0 && anchorRow < count())
+	{
+		const int delta = visualRect(m_model->index(anchorRow)).top() - anchorTop;
+		if (delta != 0)
+		{
+			bar->setValue(bar->value() + delta);
+		}
+	}
+	positionBoundBubbles();
+	scheduleBind();
+}
+
+void ChatTranscriptView::scrollContentsBy(int dx, int dy)
+{
+	QListView::scrollContentsBy(dx, dy);
+	if (m_fastScrollEnabled && dy != 0)
+	{
+		if (!m_fastScrolling)
+		{
+			m_fastScrolling = true;
+			setBubblesFastPaint(true);
+		}
+		m_fastScrollTimer->start();
+	}
+	scheduleBind();
+}
+
+void ChatTranscriptView::resizeEvent(QResizeEvent* event)
+{
+	QListView::resizeEvent(event);
+	if (viewport()->width() != m_model->layoutWidth())
+	{
+		relayoutBubbles();
+	}
+	scheduleBind();
+}
+
+void ChatTranscriptView::dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+{
+	QListView::dataChanged(topLeft, bottomRight, roles);
+	if (roles.isEmpty() || roles.contains(Qt::SizeHintRole))
+	{
+		scheduleDelayedItemsLayout();
+	}
+}
+
+void ChatTranscriptView::bindVisibleRows()
+{
+	m_bindScheduled = false;
+	executeDelayedItemsLayout();
+	const int rows = count();
+	if (rows == 0 || !m_acquire)
+	{
+		return;
+	}
+
+	const int first = qMax(0, rowAtOffset(0) - kOverscanRows);
+	const int last = qMin(rows - 1, rowAtOffset(viewport()->height()) + kOverscanRows);
+
+	// 回收视口外的气泡
+	const QList<int> boundRows = m_boundBubbles.keys();
+	for (int row : boundRows)
+	{
+		if ((row < first || row > last) && row != m_pinnedRow)
+		{
+			unbindRow(row);
+		}
+	}
+	// 从下往上绑定新进入视口的行，超出时间的行留到下一轮，先绑定的气泡先显示
+	QElapsedTimer timer;
+	timer.start();
+	for (int row = last; row >= first; --row)
+	{
+		if (isRowBound(row))
+		{
+			continue;
+		}
+		if (timer.hasExpired(kBindBudgetMs))
+		{
+			scheduleBind();
+			break;
+		}
+		bindRow(row, false);
+	}
+	positionBoundBubbles();
+}
+
+void ChatTranscriptView::onBubbleContentRendered()
+{
+	LLMChatFrame* bubble = qobject_cast<LLMChatFrame*>(sender());
+	if (bubble)
+	{
+		// 快照已过时
+		bubble->setFastPaint(false);
+	}
+	updateBubbleSize(bubble);
+}
+
+void ChatTranscriptView::setFastScrollEnabled(bool enabled)
+{
+	m_fastScrollEnabled = enabled;
+	if (!enabled && m_fastScrolling)
+	{
+		m_fastScrollTimer->stop();
+		onFastScrollSettled();
+	}
+}
+
+void ChatTranscriptView::onFastScrollSettled()
+{
+	m_fastScrolling = false;
+	setBubblesFastPaint(false);
+}
+
+void ChatTranscriptView::setBubblesFastPaint(bool enabled)
+{
+	for (auto it = m_boundBubbles.cbegin(); it != m_boundBubbles.cend(); ++it)
+	{
+		LLMChatFrame* bubble = it.value().data();
+		if (bubble && it.key() != m_pinnedRow)
+		{
+			bubble->setFastPaint(enabled);
+		}
+	}
+}
+
+void ChatTranscriptView::populatePendingRows()
+{
+	if (m_model->resolvePendingRows(kPopulateBudgetMs) == 0)
+	{
+		m_populateTimer->stop();
+	}
+}
+
+void ChatTranscriptView::scheduleBind()
+{
+	if (m_bindScheduled)
+	{
+		return;
+	}
+	m_bindScheduled = true;
+	QTimer::singleShot(0, this, &ChatTranscriptView::bindVisibleRows);
+}
+
+LLMChatFrame* ChatTranscriptView::bindRow(int row, bool live)
+{
+	auto existing = m_boundBubbles.find(row);
+	if (existing != m_boundBubbles.end())
+	{
+		if (existing.value())
+		{
+			return existing.value().data();
+		}
+		m_boundBubbles.erase(existing);
+	}
+
+	const ChatMessageData* msg = m_model->message(row);
+	if (!msg || !m_acquire)
+	{
+		return nullptr;
+	}
+	LLMChatFrame* bubble = m_acquire(viewport());
+	if (!bubble)
+	{
+		return nullptr;
+	}
+
+	bubble->resize(viewport()->width(), qMax(1, bubble->height()));
+	const LLMChatFrame::User_Type auth = msg->userType == LLMChatFrame::User_Customer
+		? LLMChatFrame::User_Customer : LLMChatFrame::User_Owner;
+	bubble->setUserType(auth);
+	bubble->setTextWithReason(msg->m_ChatReasonMsg, msg->m_ChatMsg, msg->m_ChatTime, m_model->measuredSize(row), auth);
+	if (!live)
+	{
+		// 历史消息：隐藏加载动画，回答气泡在此完成排版
+		bubble->setTextSuccess();
+	}
+	bubble->setImportant(msg->m_IsImportant);
+	bubble->setUserNote(msg->m_Note);
+	bubble->setBubbleID(msg->m_BubbleID);
+	if (live || auth != LLMChatFrame::User_Customer)
+	{
+		bubble->fontRect(msg->m_ChatReasonMsg, msg->m_ChatMsg);
+	}
+
+	m_boundBubbles.insert(row, QPointer<LLMChatFrame>(bubble));
+	// 后台渲染完成后用实测尺寸替换占位尺寸
+	connect(bubble, &LLMChatFrame::contentRendered, this, &ChatTranscriptView::onBubbleContentRendered, Qt::UniqueConnection);
+	updateBubbleSize(bubble);
+	bubble->show();
+	return bubble;
+}
+
+void ChatTranscriptView::unbindRow(int row)
+{
+	QPointer<LLMChatFrame> bubble = m_boundBubbles.take(row);
+	if (bubble)
+	{
+		bubble->setFastPaint(false);
+		disconnect(bubble.data(), &LLMChatFrame::contentRendered, this, &ChatTranscriptView::onBubbleContentRendered);
+	}
+	if (bubble && m_release)
+	{
+		m_release(bubble.data());
+	}
+	viewport()->update(visualRect(m_model->index(row)));
+}
+
+void ChatTranscriptView::positionBoundBubbles()
+{
+	for (auto it = m_boundBubbles.begin(); it != m_boundBubbles.end(); ++it)
+	{
+		LLMChatFrame* bubble = it.value().data();
+		if (!bubble)
+		{
+			continue;
+		}
+		const QRect rect = visualRect(m_model->index(it.key()));
+		if (rect.isValid() && bubble->geometry() != rect)
+		{
+			bubble->setGeometry(rect);
+		}
+	}
+}
+
+int ChatTranscriptView::rowAtOffset(int y) const
+{
+	int low = 0;
+	int high = count() - 1;
+	int result = high;
+	while (low <= high)
+	{
+		const int mid = (low + high) / 2;
+		if (visualRect(m_model->index(mid)).bottom() < y)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			result = mid;
+			high = mid - 1;
+		}
+	}
+	return qMax(0, result);
+}
+
+int ChatTranscriptView::rowForBubble(const LLMChatFrame* bubble) const
+{
+	if (!bubble)
+	{
+		return -1;
+	}
+	// 先按气泡ID查索引，行上绑定的正是这个气泡时直接返回
+	const int row = m_model->rowForBubble(bubble->getBubbleID());
+	if (row >= 0 && m_boundBubbles.value(row).data() == bubble)
+	{
+		return row;
+	}
+	for (auto it = m_boundBubbles.constBegin(); it != m_boundBubbles.constEnd(); ++it)
+	{
+		if (it.value().data() == bubble)
+		{
+			return it.key();
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <QListView>
+#include <QPointer>
+#include <QHash>
+#include <functional>
+#include "ChatSessionTypes.h"
+
+class LLMChatFrame;
+class ChatTranscriptModel;
+class ChatTranscriptDelegate;
+class QTimer;
+
+// 虚拟化聊天记录视图
+// 模型只保存消息数据与行高，真实的 LLMChatFrame 气泡只绑定到视口内（含少量预加载）的行，
+// 滚出视口的气泡回收给对象池；未实测的行使用估算高度，因此打开长会话的耗时与内存与历史长度无关
+// 切换会话时先算出末尾一屏的行高并从下往上绑定气泡，更早的行高在空闲时分批计算
+class ChatTranscriptView : public QListView
+{
+	Q_OBJECT
+public:
+	// 气泡获取/回收函数（由外部对象池提供，负责信号连接）
+	using BubbleAcquirer = std::function<LLMChatFrame*(QWidget* parent)>;
+	using BubbleReleaser = std::function<void(LLMChatFrame* bubble)>;
+
+	explicit ChatTranscriptView(QWidget* parent = nullptr);
+	~ChatTranscriptView();
+
+	// 设置气泡获取/回收函数
+	void setBubbleFactory(BubbleAcquirer acquire, BubbleReleaser release);
+	// 获取聊天记录模型
+	ChatTranscriptModel* transcriptModel() const { return m_model; }
+	// 切换显示的会话（nullptr 表示清空），上一个会话未完成的分批计算随之取消
+	void setSession(ChatSession* session);
+	// 消息数量
+	int count() const;
+
+	// 追加消息并立即绑定气泡；live 为 true 时气泡保持加载状态并固定，直到 setPinnedRow(-1)
+	LLMChatFrame* appendMessage(const ChatMessageData& message, bool live);
+	// 获取最新一条消息的气泡（未绑定时立即绑定）
+	LLMChatFrame* latestBubble();
+	// 根据气泡ID获取已绑定的气泡
+	LLMChatFrame* bubbleForId(const QString& bubbleId) const;
+	// 滚动到气泡ID对应的行（置于视口顶部），会话中没有该消息时返回 false
+	bool scrollToBubble(const QString& bubbleId);
+	// 气泡内容变化后同步行高
+	void updateBubbleSize(LLMChatFrame* bubble);
+	// 固定行（固定的行即使滚出视口也不回收），-1 取消固定
+	void setPinnedRow(int row);
+	// 请求重新排版：立即重排视口内的气泡，视口外的气泡回收，滚动到可见时按新宽度绑定
+	// 短时间内的多次请求（拖动窗口边缘、侧边栏动画）合并为每 kRelayoutIntervalMs 一次
+	void relayoutBubbles();
+	// 回收所有气泡
+	void releaseAllBubbles();
+	// 行是否已绑定气泡
+	bool isRowBound(int row) const;
+	// 快速滚动：滚动期间已绑定的气泡改画快照，停止滚动 kFastScrollSettleMs 后恢复正常绘制
+	void setFastScrollEnabled(bool enabled);
+
+protected:
+	// 重新布局后保持首个可见行的位置不变，并重新定位气泡
+	void doItemsLayout() override;
+	// 滚动后绑定新进入视口的行
+	void scrollContentsBy(int dx, int dy) override;
+	// 大小改变事件
+	void resizeEvent(QResizeEvent* event) override;
+
+protected slots:
+	// 行高变化时重新布局
+	void dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles = QVector<int>()) override;
+
+private slots:
+	// 绑定视口内的行并回收视口外的气泡
+	void bindVisibleRows();
+	// 气泡后台渲染完成，同步行高
+	void onBubbleContentRendered();
+	// 空闲时计算一批粗估的行高
+	void populatePendingRows();
+	// 合并期间有新的重排请求时补做一次
+	void onRelayoutTimeout();
+	// 滚动停止，恢复正常绘制
+	void onFastScrollSettled();
+
+private:
+	// 合并到下一次事件循环再绑定
+	void scheduleBind();
+	// 为指定行绑定气泡
+	LLMChatFrame* bindRow(int row, bool live);
+	// 回收指定行的气泡
+	void unbindRow(int row);
+	// 按视口宽度重排可见的气泡
+	void relayoutVisibleBubbles();
+	// 按当前布局放置所有已绑定的气泡
+	void positionBoundBubbles();
+	// 二分查找覆盖给定纵坐标的行
+	int rowAtOffset(int y) const;
+	// 查找气泡对应的行
+	int rowForBubble(const LLMChatFrame* bubble) const;
+	// 切换已绑定气泡（固定行除外，其内容仍在变化）的快照绘制
+	void setBubblesFastPaint(bool enabled);
+
+	ChatTranscriptModel* m_model = nullptr;
+	ChatTranscriptDelegate* m_delegate = nullptr;
+	BubbleAcquirer m_acquire;
+	BubbleReleaser m_release;
+	QHash<int, QPointer<LLMChatFrame>> m_boundBubbles; // 行号 -> 已绑定的气泡
+	QTimer* m_populateTimer = nullptr;
+	QTimer* m_relayoutTimer = nullptr;
+	bool m_relayoutPending = false;
+	QTimer* m_fastScrollTimer = nullptr;
+	bool m_fastScrollEnabled = false;
+	bool m_fastScrolling = false;
+	int m_pinnedRow = -1;
+	bool m_bindScheduled = false;
+	static constexpr int kOverscanRows = 2;            // 视口上下各预绑定的行数
+	static constexpr int kBindBudgetMs = 8;            // 每次事件循环绑定气泡的时间上限，超出的行下一轮再绑定
+	static constexpr int kPopulateBudgetMs = 4;        // 每批计算行高的时间上限
+	static constexpr int kRelayoutIntervalMs = 60;     // 两次重排的最小间隔
+	static constexpr int kFastScrollSettleMs = 150;    // 最后一次滚动后多久视为停止
+};
@@ -0,0 +1,534 @@
+#include "CodeLexer.h"
+#include <cstddef>
+
+namespace
+{
+	// ---------------- 关键字哈希表 ----------------
+	// FNV-1a 变体：单词长度作为初值，线性探测解决冲突；表在静态初始化时建好一次，槽位数约为关键字数的 1.5 倍
+
+	constexpr unsigned kFnvPrime = 16777619u;
+	constexpr unsigned kFnvOffset = 2166136261u;
+
+	constexpr unsigned charCode(char c)
+	{
+		return static_cast<unsigned char>(c);
+	}
+
+	inline unsigned charCode(QChar c)
+	{
+		return c.unicode();
+	}
+
+	template <typename Char>
+	unsigned keywordHash(const Char* word, int length)
+	{
+		unsigned hash = kFnvOffset ^ static_cast<unsigned>(length);
+		for (int i = 0; i < length; ++i)
+		{
+			hash = (hash ^ charCode(word[i])) * kFnvPrime;
+		}
+		return hash;
+	}
+
+	constexpr int wordLength(const char* word)
+	{
+		return *word == '\0' ? 0 : 1 + wordLength(word + 1);
+	}
+
+	template <std::size_t Count>
+	class KeywordTable
+	{
+	public:
+		// 至少留一个空槽，查找不到时探测一定会停下
+		static constexpr std::size_t kSize = Count + Count / 2 + 1;
+
+		explicit KeywordTable(const char* const (&words)[Count])
+		{
+			for (const char* word : words)
+			{
+				std::size_t slot = keywordHash(word, wordLength(word)) % kSize;
+				while (m_slots[slot])
+				{
+					slot = (slot + 1) % kSize;
+				}
+				m_slots[slot] = word;
+			}
+		}
+
+		bool contains(const QChar* word, int length) const
+		{
+			for (std::size_t slot = keywordHash(word, length) % kSize; m_slots[slot]; slot = (slot + 1) % kSize)
+			{
+				if (equals(m_slots[slot], word, length))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+	private:
+		static bool equals(const char* candidate, const QChar* word, int length)
+		{
+			for (int i = 0; i < length; ++i)
+			{
+				if (candidate[i] == '\0' || charCode(candidate[i]) != charCode(word[i]))
+				{
+					return false;
+				}
+			}
+			return candidate[length] == '\0';
+		}
+
+		const char* m_slots[kSize] = {};
+	};
+
+	template <std::size_t Count>
+	KeywordTable<Count> makeKeywordTable(const char* const (&words)[Count])
+	{
+		return KeywordTable<Count>(words);
+	}
+
+	constexpr const char* kCppKeywords[] = {
+		"alignas", "alignof", "and", "and_eq", "asm", "atomic_cancel", "atomic_commit",
+		"atomic_noexcept", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+		"char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const",
+		"consteval", "constexpr", "constinit", "const_cast", "continue", "co_await",
+		"co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+		"dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+		"float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+		"namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+		"or_eq", "private", "protected", "public", "reflexpr", "register",
+		"reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
+		"static_assert", "static_cast", "struct", "switch", "synchronized", "template",
+		"this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+		"union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
+		"xor", "xor_eq", "include", "define", "ifdef", "ifndef", "endif", "pragma"
+	};
+
+	constexpr const char* kPythonKeywords[] = {
+		"False", "None", "True", "and", "as", "assert", "async", "await", "break",
+		"class", "continue", "def", "del", "elif", "else", "except", "finally",
+		"for", "from", "global", "if", "import", "in", "is", "lambda", "nonlocal",
+		"not", "or", "pass", "raise", "return", "try", "while", "with", "yield"
+	};
+
+	constexpr const char* kJavaScriptKeywords[] = {
+		"abstract", "arguments", "await", "boolean", "break", "byte", "case", "catch",
+		"char", "class", "const", "continue", "debugger", "default", "delete", "do",
+		"double", "else", "enum", "eval", "export", "extends", "false", "final",
+		"finally", "float", "for", "function", "goto", "if", "implements", "import",
+		"in", "instanceof", "int", "interface", "let", "long", "native", "new",
+		"null", "package", "private", "protected", "public", "return", "short",
+		"static", "super", "switch", "synchronized", "this", "throw", "throws",
+		"transient", "true", "try", "typeof", "var", "void", "volatile", "while",
+		"with", "yield", "async", "of"
+	};
+
+	constexpr const char* kJsonKeywords[] = { "true", "false", "null" };
+
+	const auto kCppTable = makeKeywordTable(kCppKeywords);
+	const auto kPythonTable = makeKeywordTable(kPythonKeywords);
+	const auto kJavaScriptTable = makeKeywordTable(kJavaScriptKeywords);
+	const auto kJsonTable = makeKeywordTable(kJsonKeywords);
+
+	// ---------------- 状态机扫描器 ----------------
+
+	using Grammar = CodeLexer::Grammar;
+	using TokenKind = CodeLexer::TokenKind;
+	using State = CodeLexer::State;
+
+	class Scanner
+	{
+	public:
+		Scanner(Grammar grammar, const QString& text, int to, State& state, QVector<CodeLexer::Token>& tokens)
+			: m_grammar(grammar)
+			, m_text(text.constData())
+			, m_to(to)
+			, m_state(state)
+			, m_tokens(tokens)
+		{
+		}
+
+		void run(int pos)
+		{
+			pos = resume(pos);
+			while (pos < m_to)
+			{
+				pos = scanToken(pos);
+			}
+		}
+
+	private:
+		// 越界时返回 0，省去各处的边界判断
+		ushort at(int pos) const
+		{
+			return pos < m_to ? m_text[pos].unicode() : 0;
+		}
+
+		bool isIdentifierStart(ushort c) const
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+				|| (c == '$' && m_grammar == Grammar::JavaScript)
+				|| (c >= 0x80 && QChar(c).isLetter());
+		}
+
+		bool isIdentifierChar(ushort c) const
+		{
+			return isIdentifierStart(c) || (c >= '0' && c <= '9') || (c >= 0x80 && QChar(c).isNumber());
+		}
+
+		static bool isDigit(ushort c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		bool startsWith(int pos, const char* literal) const
+		{
+			for (int i = 0; literal[i] != '\0'; ++i)
+			{
+				if (at(pos + i) != charCode(literal[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool wordEquals(int start, int end, const char* word) const
+		{
+			return end - start == wordLength(word) && startsWith(start, word);
+		}
+
+		int lineEnd(int pos) const
+		{
+			while (pos < m_to && m_text[pos].unicode() != '\n')
+			{
+				++pos;
+			}
+			return pos;
+		}
+
+		// 当前位置之前只有空白（用于识别预处理指令）
+		bool atLineStart(int pos) const
+		{
+			int i = pos - 1;
+			while (i >= 0 && (m_text[i].unicode() == ' ' || m_text[i].unicode() == '\t'))
+			{
+				--i;
+			}
+			return i < 0 || m_text[i].unicode() == '\n';
+		}
+
+		void emitToken(int start, int end, TokenKind kind)
+		{
+			if (end <= start)
+			{
+				return;
+			}
+			CodeLexer::Token token;
+			token.start = start;
+			token.length = end - start;
+			token.kind = kind;
+			m_tokens.append(token);
+		}
+
+		// 从上一段未闭合的结构继续
+		int resume(int pos)
+		{
+			switch (m_state.mode)
+			{
+			case State::BlockComment:
+				return closeComment(pos, pos, "*/", State::BlockComment);
+			case State::HtmlComment:
+				return closeComment(pos, pos, "-->", State::HtmlComment);
+			case State::TripleString:
+				return closeString(pos, pos, m_state.quote, 3, State::TripleString);
+			case State::TemplateString:
+				return closeString(pos, pos, '`', 1, State::TemplateString);
+			default:
+				return pos;
+			}
+		}
+
+		// 多行注释：找到结束标记则恢复 Normal，否则注释延续到区间末尾
+		int closeComment(int start, int bodyStart, const char* terminator, State::Mode openMode)
+		{
+			const int terminatorLength = wordLength(terminator);
+			for (int pos = bodyStart; pos < m_to; ++pos)
+			{
+				if (startsWith(pos, terminator))
+				{
+					const int end = pos + terminatorLength;
+					emitToken(start, end, TokenKind::Comment);
+					m_state = State();
+					return end;
+				}
+			}
+			emitToken(start, m_to, TokenKind::Comment);
+			m_state.mode = openMode;
+			m_state.quote = 0;
+			return m_to;
+		}
+
+		// 多行字符串（三引号、模板字符串）：连续 quoteCount 个引号结束，支持反斜杠转义
+		int closeString(int start, int bodyStart, ushort quote, int quoteCount, State::Mode openMode)
+		{
+			int pos = bodyStart;
+			while (pos < m_to)
+			{
+				const ushort c = m_text[pos].unicode();
+				if (c == '\\')
+				{
+					pos += 2;
+					continue;
+				}
+				if (c == quote && (quoteCount == 1 || (at(pos + 1) == quote && at(pos + 2) == quote)))
+				{
+					const int end = pos + quoteCount;
+					emitToken(start, end, TokenKind::String);
+					m_state = State();
+					return end;
+				}
+				++pos;
+			}
+			emitToken(start, m_to, TokenKind::String);
+			m_state.mode = openMode;
+			m_state.quote = quote;
+			return m_to;
+		}
+
+		// 单行字符串：遇到同样的引号或行尾结束
+		int scanString(int start, int bodyStart, ushort quote)
+		{
+			int pos = bodyStart;
+			while (pos < m_to)
+			{
+				const ushort c = m_text[pos].unicode();
+				if (c == '\n')
+				{
+					break;
+				}
+				++pos;
+				if (c == quote)
+				{
+					break;
+				}
+				if (c == '\\' && pos < m_to && m_text[pos].unicode() != '\n')
+				{
+					++pos;
+				}
+			}
+			emitToken(start, pos, TokenKind::String);
+			return pos;
+		}
+
+		// 数字：整数、小数、十六进制、指数与类型后缀一并识别
+		int scanNumber(int start)
+		{
+			int pos = start;
+			if (at(pos) == '-')
+			{
+				++pos;
+			}
+			while (pos < m_to)
+			{
+				const ushort c = m_text[pos].unicode();
+				if ((c == 'e' || c == 'E' || c == 'p' || c == 'P') && (at(pos + 1) == '+' || at(pos + 1) == '-'))
+				{
+					pos += 2;
+				}
+				else if (isIdentifierChar(c) || c == '.' || (c == '\'' && m_grammar == Grammar::Cpp && isDigit(at(pos + 1))))
+				{
+					++pos;
+				}
+				else
+				{
+					break;
+				}
+			}
+			emitToken(start, pos, TokenKind::Number);
+			return pos;
+		}
+
+		// 关键字之后的名称（def/class/function 定义）
+		int scanDeclaredName(int pos, TokenKind kind)
+		{
+			int start = pos;
+			while (at(start) == ' ' || at(start) == '\t')
+			{
+				++start;
+			}
+			if (!isIdentifierStart(at(start)))
+			{
+				return pos;
+			}
+			int end = start + 1;
+			while (isIdentifierChar(at(end)))
+			{
+				++end;
+			}
+			emitToken(start, end, kind);
+			return end;
+		}
+
+		// 标识符：关键字、函数调用、定义名称；Python 的字符串前缀（r、b、f、u 及组合）也在这里识别
+		int scanWord(int start)
+		{
+			int end = start + 1;
+			while (isIdentifierChar(at(end)))
+			{
+				++end;
+			}
+
+			if (m_grammar == Grammar::Python && end - start <= 2 && (at(end) == '"' || at(end) == '\''))
+			{
+				bool isPrefix = true;
+				for (int i = start; i < end; ++i)
+				{
+					const ushort c = QChar::toLower(m_text[i].unicode());
+					isPrefix = isPrefix && (c == 'r' || c == 'b' || c == 'f' || c == 'u');
+				}
+				if (isPrefix)
+				{
+					return scanQuote(start, end);
+				}
+			}
+
+			if (CodeLexer::isKeyword(m_grammar, m_text + start, end - start))
+			{
+				emitToken(start, end, TokenKind::Keyword);
+				if (m_grammar == Grammar::Python && wordEquals(start, end, "def"))
+				{
+					return scanDeclaredName(end, TokenKind::Definition);
+				}
+				if (m_grammar == Grammar::Python && wordEquals(start, end, "class"))
+				{
+					return scanDeclaredName(end, TokenKind::Type);
+				}
+				if (m_grammar == Grammar::JavaScript && wordEquals(start, end, "function"))
+				{
+					return scanDeclaredName(end, TokenKind::Definition);
+				}
+				return end;
+			}
+
+			if (m_grammar == Grammar::Cpp)
+			{
+				int next = end;
+				while (at(next) == ' ' || at(next) == '\t')
+				{
+					++next;
+				}
+				if (at(next) == '(')
+				{
+					emitToken(start, end, TokenKind::Function);
+				}
+			}
+			return end;
+		}
+
+		// 字符串起始（start 包含前缀，quotePos 为引号位置）
+		int scanQuote(int start, int quotePos)
+		{
+			const ushort quote = at(quotePos);
+			if (m_grammar == Grammar::Python && at(quotePos + 1) == quote && at(quotePos + 2) == quote)
+			{
+				return closeString(start, quotePos + 3, quote, 3, State::TripleString);
+			}
+			return scanString(start, quotePos + 1, quote);
+		}
+
+		int scanToken(int pos)
+		{
+			const ushort c = m_text[pos].unicode();
+			const bool cStyleComments = m_grammar == Grammar::Cpp || m_grammar == Grammar::JavaScript || m_grammar == Grammar::Generic;
+
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			{
+				return pos + 1;
+			}
+			if (cStyleComments && c == '/' && at(pos + 1) == '/')
+			{
+				const int end = lineEnd(pos);
+				emitToken(pos, end, TokenKind::Comment);
+				return end;
+			}
+			if (cStyleComments && c == '/' && at(pos + 1) == '*')
+			{
+				return closeComment(pos, pos + 2, "*/", State::BlockComment);
+			}
+			if (c == '#')
+			{
+				if (m_grammar == Grammar::Python || m_grammar == Grammar::Generic)
+				{
+					const int end = lineEnd(pos);
+					emitToken(pos, end, TokenKind::Comment);
+					return end;
+				}
+				if (m_grammar == Grammar::Cpp && atLineStart(pos))
+				{
+					const int end = lineEnd(pos);
+					emitToken(pos, end, TokenKind::Preprocessor);
+					return end;
+				}
+			}
+			if (m_grammar == Grammar::Generic && c == '<' && startsWith(pos, "<!--"))
+			{
+				return closeComment(pos, pos + 4, "-->", State::HtmlComment);
+			}
+			if (c == '"' || (c == '\'' && m_grammar != Grammar::Json))
+			{
+				return scanQuote(pos, pos);
+			}
+			if (c == '`' && m_grammar == Grammar::JavaScript)
+			{
+				return closeString(pos, pos + 1, '`', 1, State::TemplateString);
+			}
+			if (isDigit(c) || (c == '.' && isDigit(at(pos + 1)))
+				|| (c == '-' && m_grammar == Grammar::Json && isDigit(at(pos + 1))))
+			{
+				return scanNumber(pos);
+			}
+			if (isIdentifierStart(c))
+			{
+				return scanWord(pos);
+			}
+			if (m_grammar == Grammar::Json && (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ','))
+			{
+				emitToken(pos, pos + 1, TokenKind::Punctuation);
+			}
+			return pos + 1;
+		}
+
+		Grammar m_grammar;
+		const QChar* m_text;
+		int m_to;
+		State& m_state;
+		QVector<CodeLexer::Token>& m_tokens;
+	};
+}
+
+void CodeLexer::tokenize(Grammar grammar, const QString& text, int from, int to, State& state, QVector<Token>& tokens)
+{
+	from = qBound(0, from, text.size());
+	to = qBound(from, to, text.size());
+	Scanner(grammar, text, to, state, tokens).run(from);
+}
+
+bool CodeLexer::isKeyword(Grammar grammar, const QChar* word, int length)
+{
+	switch (grammar)
+	{
+	case Grammar::Cpp:
+		return kCppTable.contains(word, length);
+	case Grammar::Python:
+		return kPythonTable.contains(word, length);
+	case Grammar::JavaScript:
+		return kJavaScriptTable.contains(word, length);
+	case Grammar::Json:
+		return kJsonTable.contains(word, length);
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <QString>
+#include <QVector>
+
+// 代码词法分析器
+// 每种语法一个状态机，单遍扫描即可识别注释、字符串、数字、关键字与标识符；
+// 关键字使用编译期生成的完美哈希表查找，跨行的结构（块注释、三引号字符串等）保存在 State 中，
+// 因此可以从任意一行的行首继续分析，流式输出的代码块只需分析新增的行
+class CodeLexer
+{
+public:
+	// 词法规则
+	enum class Grammar : quint8
+	{
+		Generic,
+		Cpp,
+		Python,
+		JavaScript,
+		Json
+	};
+
+	// 词法单元类型（未被词法单元覆盖的区间为普通文本）
+	enum class TokenKind : quint8
+	{
+		Keyword,      // 关键字
+		String,       // 字符串
+		Comment,      // 注释
+		Number,       // 数字
+		Function,     // 函数调用
+		Definition,   // 函数定义的名称
+		Type,         // 类定义的名称
+		Preprocessor, // 预处理指令
+		Punctuation   // 标点符号（JSON）
+	};
+
+	// 词法单元
+	struct Token
+	{
+		int start = 0;
+		int length = 0;
+		TokenKind kind = TokenKind::Keyword;
+	};
+
+	// 跨行的词法状态
+	struct State
+	{
+		enum Mode : quint8
+		{
+			Normal,
+			BlockComment,   // /* ... */
+			HtmlComment,    // <!-- ... -->
+			TripleString,   // Python 三引号字符串
+			TemplateString  // JavaScript 模板字符串
+		};
+
+		Mode mode = Normal;
+		ushort quote = 0; // 三引号字符串的引号字符
+
+		bool operator==(const State& other) const { return mode == other.mode && quote == other.quote; }
+		bool operator!=(const State& other) const { return !(*this == other); }
+	};
+
+	// 分析 text 的 [from, to) 区间，词法单元追加到 tokens；
+	// state 传入起始状态（from 应位于行首），返回时为 to 处的状态
+	static void tokenize(Grammar grammar, const QString& text, int from, int to, State& state, QVector<Token>& tokens);
+	// 判断单词是否为该语法的关键字
+	static bool isKeyword(Grammar grammar, const QChar* word, int length);
+};
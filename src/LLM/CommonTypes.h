@@ -2,6 +2,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QList>
 
 // 发送按钮状态（从 ChatInputWidget 中提取为公共类型）
 enum class SendButtonState
@@ -21,12 +22,22 @@ enum class AIProvider
     Custom
 };
 
+// 多轮对话中的一条历史消息
+struct ChatHistoryTurn
+{
+    QString role;              // "user" / "assistant"
+    QString content;           // 消息正文
+    QString reasoning;         // 回答附带的推理内容（可能已截短，可为空）
+};
+
 // 聊天发送消息结构（从 ChatInputWidget 中提取为公共类型）
 struct ChatSendMessage
 {
     QString SendText = "";     // 发送的文本内容
     QStringList Image64;       // Base64 编码的图片列表
     QStringList fileContext;   // 文件内容列表
+    QList<ChatHistoryTurn> history; // 本轮提问之前的对话（由 ChatContextBuilder 选择）
+    QString sessionId;         // 发起请求的本地会话ID，应答按此回写
 };
 
 
@@ -4,27 +4,81 @@
 #include <QHttpMultiPart>
 #include <QMimeDatabase>
 
+namespace
+{
+	// һ Dify ʽ¼ΪỰ/Ϣ/ID out.meta
+	void decodeStreamEvent(const QJsonObject& eventObj, StreamBatch& out)
+	{
+		// ͬ¼
+		QString event = eventObj["event"].toString();
+
+		if (event == "message")
+		{
+			out.append(StreamChannel::Answer, eventObj["answer"].toString());
+
+			// conversation_id
+			for (const char* key : { "conversation_id", "message_id", "task_id" })
+			{
+				if (eventObj.contains(key))
+				{
+					out.meta.insert(key, eventObj[key]);
+				}
+			}
+		}
+		else if (event == "message_end")
+		{
+			// ϢԻȡusageϢ
+			if (eventObj.contains("metadata"))
+			{
+				QJsonObject metadata = eventObj["metadata"].toObject();
+				if (metadata.contains("usage"))
+				{
+					QJsonObject usage = metadata["usage"].toObject();
+					out.append(StreamChannel::Usage, QString::fromUtf8(QJsonDocument(usage).toJson(QJsonDocument::Compact)));
+				}
+			}
+		}
+		else if (event == "error")
+		{
+			QString errorMsg = eventObj["message"].toString();
+			out.error = "Stream error: " + errorMsg;
+		}
+	}
+
+	// DifyʽӦʽ: data: {...}\n\n߳н
+	class DifyStreamDecoder : public StreamDecoder
+	{
+	public:
+		StreamFrameParser::Format format() const override
+		{
+			return StreamFrameParser::Format::ServerSentEvents;
+		}
+
+		void decode(const StreamFrameParser::Frame& frame, StreamBatch& out) override
+		{
+			if (frame.done)
+			{
+				return; // 
+			}
+			QJsonDocument doc = QJsonDocument::fromJson(frame.data);
+			if (doc.isObject())
+			{
+				decodeStreamEvent(doc.object(), out);
+			}
+		}
+	};
+}
+
 DifyClient::DifyClient(QObject *parent)
 	: MessageManager(parent)
 {
 	m_LLMParams = new LLMParams();
 	m_NetWorkParams = new ClientNetWork();
-
-	// ʼӲԶʱ
-	m_connectionCheckTimer = new QTimer(this);
-	m_connectionCheckTimer->setSingleShot(true);
-	connect(m_connectionCheckTimer, &QTimer::timeout, this, &DifyClient::onCheckConnectionTimeout);
-
-	// ʼȡģбʱ
-	m_fetchModelsTimer = new QTimer(this);
-	m_fetchModelsTimer->setSingleShot(true);
-	connect(m_fetchModelsTimer, &QTimer::timeout, this, &DifyClient::onFetchModelsTimeout);
-
-	m_currentRequestType = RequestType::ConnectionCheck;
 }
 
 DifyClient::~DifyClient()
 {
+	cancelCurrentRequest();
 }
 
 AIProvider DifyClient::getProvider() const
@@ -85,6 +139,7 @@ QString DifyClient::getMessageId() const
 void DifyClient::resetConversationId()
 {
 	m_conversationId.clear();
+	m_sessionConversations.clear();
 }
 
 void DifyClient::resetUserId()
@@ -128,10 +183,11 @@ QByteArray DifyClient::buildMessageBody(const ChatSendMessage& msg)
 										// Ӧģʽʽʽ
 	SendMessageBody["response_mode"] = m_LLMParams->getStreamChat() ? "streaming" : "blocking";
 
-	// ỰIDеĻ
-	if (!m_conversationId.isEmpty())
+	// ỰIDеĻÿػỰӦԵ Dify Ự
+	const QString conversationId = msg.sessionId.isEmpty() ? m_conversationId : m_sessionConversations.value(msg.sessionId);
+	if (!conversationId.isEmpty())
 	{
-		SendMessageBody["conversation_id"] = m_conversationId;
+		SendMessageBody["conversation_id"] = conversationId;
 	}
 
 	// ûʶѡ
@@ -184,14 +240,15 @@ QByteArray DifyClient::buildStopAnswerBody()
 	return QJsonDocument(SendMessageBody).toJson();
 }
 
-void DifyClient::SendPreProcess(const ChatSendMessage& msg)
+ClientRequest* DifyClient::SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder)
 {
 	QByteArray postData = buildMessageBody(msg);
 	QSslConfiguration config = QSslConfiguration::defaultConfiguration();
 	config.setProtocol(QSsl::AnyProtocol);
 	config.setPeerVerifyMode(QSslSocket::VerifyNone);
 	m_NetWorkParams->clientRequest.setSslConfiguration(config);
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(m_NetWorkParams->clientNetWorkManager->post(m_NetWorkParams->clientRequest, postData));
+	return startRequest(RequestType::ChatRequest,
+		NetworkOperation::post(m_NetWorkParams->clientRequest, postData, std::move(decoder)), 0, msg.sessionId);
 }
 
 QJsonObject DifyClient::parseJsonReplyToMsg(const QByteArray &data)
@@ -204,19 +261,22 @@ QJsonObject DifyClient::parseJsonReplyToMsg(const QByteArray &data)
 	return rsp_json;
 }
 
-int DifyClient::send(const ChatSendMessage& msg)
+quint64 DifyClient::send(const ChatSendMessage& msg)
 {
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &DifyClient::getAnswer);
-	return true;
+	ClientRequest* request = SendPreProcess(msg);
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &DifyClient::getAnswer);
+	return request->id;
 }
 
-int DifyClient::StreamSend(const ChatSendMessage& msg)
+quint64 DifyClient::StreamSend(const ChatSendMessage& msg)
 {
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::readyRead, this, &DifyClient::getStreamAnswer, Qt::QueuedConnection);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &DifyClient::processStreamEnded);
-	return true;
+	ClientRequest* request = SendPreProcess(msg, std::make_shared<DifyStreamDecoder>());
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &DifyClient::processStreamEnded);
+	return request->id;
 }
 
 QString DifyClient::GetError(const QString& errorLevel, const QString& errorContext)
@@ -268,15 +328,22 @@ QString DifyClient::GetError(const QString& errorLevel, const QString& errorCont
 
 void DifyClient::processStreamEnded()
 {
-	if (m_NetWorkParams->clientNetWorkReply->error())
+	ClientRequest* request = senderRequest();
+	if (!request)
+		return;
+	const quint64 requestId = request->id;
+	NetworkReplyData* reply = &request->result;
+	if (reply->error())
 	{
-		QString errorMsg = GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll());
-		emit Answer(errorMsg, true);
+		QString errorMsg = GetError(reply->errorString(),
+			reply->readAll());
+		finishRequest(request);
+		emit Answer(requestId, errorMsg, true);
 		return;
 	}
-	m_NetWorkParams->rawBuffer.clear();
-	emit StreamEnded();
+	// ʣ߳ڽź֮ǰͶ
+	finishRequest(request);
+	emit StreamEnded(requestId);
 }
 
 QNetworkRequest DifyClient::createApiRequest(const QUrl& url)
@@ -303,44 +370,36 @@ QNetworkRequest DifyClient::createApiRequest(const QUrl& url)
 	return request;
 }
 
-void DifyClient::sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs)
+void DifyClient::sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs)
 {
-	if (m_currentRequestType == RequestType::StopStreamAns)
+	if (type == RequestType::StopStreamAns)
 	{
 		QByteArray postData = buildStopAnswerBody();
-		m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-			m_NetWorkParams->clientNetWorkManager->post(request, postData));
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onStopStreamAnsFinished);
+		ClientRequest* stopRequest = startRequest(type,
+			NetworkOperation::post(request, postData), timeoutMs);
+		onRequestFinished(stopRequest, this, &DifyClient::onStopStreamAnsFinished);
 		return;
 	}
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->get(request));
+	ClientRequest* apiRequest = startRequest(type, NetworkOperation::get(request), timeoutMs);
+	if (!apiRequest)
+		return;
 
 	// ӦĴ
-	if (m_currentRequestType == RequestType::FetchModels)
+	if (type == RequestType::FetchModels)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onFetchModelsFinished);
-		// ʱʱ
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &DifyClient::onFetchModelsFinished);
 	}
-	else if (m_currentRequestType == RequestType::ConnectionCheck)
+	else if (type == RequestType::ConnectionCheck)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onCheckConnectionFinished);
-		// ʱʱ
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &DifyClient::onCheckConnectionFinished);
 	}
-	else if (m_currentRequestType == RequestType::FollowUpSuggest)
+	else if (type == RequestType::FollowUpSuggest)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onGetFollowUpSuggestFinished);
+		onRequestFinished(apiRequest, this, &DifyClient::onGetFollowUpSuggestFinished);
 	}
-	else if (m_currentRequestType == RequestType::GetKonwledgeBase)
+	else if (type == RequestType::GetKonwledgeBase)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onGetKnowledgeBaseFinished);
+		onRequestFinished(apiRequest, this, &DifyClient::onGetKnowledgeBaseFinished);
 	}
 }
 
@@ -415,24 +474,28 @@ QUrl DifyClient::buildApiUrl(const QString& apiPath, const QString& User)
 
 void DifyClient::getAnswer()
 {
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	ClientRequest* request = senderRequest();
+	if (!request)
+		return;
+	NetworkReplyData* reply = &request->result;
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		QByteArray read_data = m_NetWorkParams->clientNetWorkReply->readAll();
+		QByteArray read_data = reply->readAll();
 		QJsonDocument response_doc = QJsonDocument::fromJson(read_data);
 		QJsonObject response_obj = response_doc.object();
 
-		AnalysisBlockResponse(response_obj);
+		AnalysisBlockResponse(request, response_obj);
 	}
 	else
 	{
-		emit Answer(GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll()), true);
+		emit Answer(request->id, GetError(reply->errorString(),
+			reply->readAll()), true);
 	}
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	ChangeButtonStatus(SendButtonState::Ready);
 }
 
-void DifyClient::AnalysisBlockResponse(QJsonObject& response_obj)
+void DifyClient::AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj)
 {
 	QString textresponse;
 
@@ -442,119 +505,59 @@ void DifyClient::AnalysisBlockResponse(QJsonObject& response_obj)
 		textresponse = response_obj["answer"].toString();
 
 		// conversation_idںԻ
-		if (response_obj.contains("conversation_id"))
-		{
-			m_conversationId = response_obj["conversation_id"].toString();
-		}
-		if (response_obj.contains("message_id"))
-		{
-			m_messageId = response_obj["message_id"].toString();
-		}
-		if (response_obj.contains("task_id"))
-		{
-			m_taskId = response_obj["task_id"].toString();
-		}
+		rememberIds(request, response_obj);
 
-		emit Answer(textresponse, false);
+		emit Answer(request->id, textresponse, false);
 	}
 	else if (response_obj.contains("message"))
 	{
 		textresponse = response_obj["message"].toString();
-		emit Answer(textresponse, true);
+		emit Answer(request->id, textresponse, true);
 	}
 	else
 	{
-		emit Answer("Invalid response format", true);
+		emit Answer(request->id, "Invalid response format", true);
 	}
 }
 
-void DifyClient::getStreamAnswer()
+void DifyClient::rememberIds(ClientRequest* request, const QJsonObject& obj)
 {
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (obj.contains("conversation_id"))
 	{
-		QByteArray response_data = m_NetWorkParams->clientNetWorkReply->readAll();
-		m_NetWorkParams->rawBuffer.append(response_data);
-
-		// DifyʽӦʽ: data: {...}\n\n
-		QString dataStr = QString::fromUtf8(response_data);
-		QStringList lines = dataStr.split('\n');
-
-		for (const QString& line : lines)
+		m_conversationId = obj["conversation_id"].toString();
+		if (!request->sessionId.isEmpty())
 		{
-			if (line.startsWith("data: "))
-			{
-				QString jsonStr = line.mid(6); // Ƴ"data: "ǰ׺
-				if (jsonStr.trimmed() == "[DONE]")
-				{
-					continue; // 
-				}
-
-				QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-				if (!doc.isNull())
-				{
-					QJsonObject obj = doc.object();
-					AnalysisStreamResponse(obj);
-				}
-			}
-		}
-	}
-}
-
-void DifyClient::AnalysisStreamResponse(QJsonObject& eventObj)
-{
-	// ͬ¼
-	QString event = eventObj["event"].toString();
-
-	if (event == "message")
-	{
-		QString answer = eventObj["answer"].toString();
-		if (!answer.isEmpty())
-		{
-			emit AnswerStream(answer);
-		}
-
-		// conversation_id
-		if (eventObj.contains("conversation_id"))
-		{
-			m_conversationId = eventObj["conversation_id"].toString();
-		}
-		if (eventObj.contains("message_id"))
-		{
-			m_messageId = eventObj["message_id"].toString();
-		}
-		if (eventObj.contains("task_id"))
-		{
-			m_taskId = eventObj["task_id"].toString();
+			m_sessionConversations.insert(request->sessionId, m_conversationId);
 		}
 	}
-	else if (event == "message_end")
+	if (obj.contains("message_id"))
 	{
-		// ϢԻȡusageϢ
-		if (eventObj.contains("metadata"))
-		{
-			QJsonObject metadata = eventObj["metadata"].toObject();
-			if (metadata.contains("usage"))
-			{
-				QJsonObject usage = metadata["usage"].toObject();
-				int totalTokens = usage["total_tokens"].toInt();
-			}
-		}
+		m_messageId = obj["message_id"].toString();
 	}
-	else if (event == "error")
+	if (obj.contains("task_id"))
 	{
-		QString errorMsg = eventObj["message"].toString();
-		emit Answer("Stream error: " + errorMsg, true);
-		return;
+		m_taskId = obj["task_id"].toString();
+		request->taskId = m_taskId;
 	}
 }
 
-void DifyClient::checkServerConnectionAsync(int timeoutMs)
+void DifyClient::AnalysisStreamResponse(ClientRequest* request, QJsonObject& eventObj)
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
+	StreamBatch batch;
+	decodeStreamEvent(eventObj, batch);
+	handleStreamBatch(request, batch);
+}
 
-	// 
-	m_currentRequestType = RequestType::ConnectionCheck;
+void DifyClient::handleStreamMeta(ClientRequest* request, const QJsonObject& meta)
+{
+	// conversation_id
+	rememberIds(request, meta);
+}
+
+void DifyClient::checkServerConnectionAsync(int timeoutMs)
+{
+	// ȡ֮ǰӼ
+	cancelRequests(RequestType::ConnectionCheck);
 
 	// ֤URL
 	if (!validateServerUrl())
@@ -566,29 +569,24 @@ void DifyClient::checkServerConnectionAsync(int timeoutMs)
 	// DifyӲʹûAPI˵
 	QUrl testUrl = buildApiUrl("/v1/info");
 	QNetworkRequest testRequest = createApiRequest(testUrl);
-	sendApiRequest(testRequest, m_connectionCheckTimer, timeoutMs);
+	sendApiRequest(RequestType::ConnectionCheck, testRequest, timeoutMs);
 }
 
 void DifyClient::onCheckConnectionFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
+	// ʱѱֹƳ
+	ClientRequest* request = senderRequest();
+	if (!request) {
 		return;
 	}
-
-	// Ƿʱ
-	if (!m_connectionCheckTimer->isActive()) {
-		m_NetWorkParams->clientNetWorkReply.reset();
-		return;
-	}
-
-	m_connectionCheckTimer->stop();
+	NetworkReplyData* reply = &request->result;
 
 	bool isConnected = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
@@ -603,10 +601,10 @@ void DifyClient::onCheckConnectionFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	emit serverConnectionCheckFinished(isConnected, errorMessage);
 }
 
@@ -632,14 +630,6 @@ void DifyClient::onFetchModelsFinished()
 
 void DifyClient::onCheckConnectionTimeout()
 {
-	if (m_NetWorkParams->clientNetWorkReply)
-	{
-		disconnect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &DifyClient::onCheckConnectionFinished);
-
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
 	emit serverConnectionCheckFinished(false, tr("Please Check IP Address or Network Setting"));
 }
 
@@ -653,11 +643,8 @@ void DifyClient::onFetchModelsTimeout()
 
 QStringList DifyClient::GetFollowUpSuggestions()
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::FollowUpSuggest;
+	// ȡ֮ǰĽ
+	cancelRequests(RequestType::FollowUpSuggest);
 
 	if (!validateServerUrl())
 	{
@@ -666,27 +653,32 @@ QStringList DifyClient::GetFollowUpSuggestions()
 	QString endpoint = "/v1/messages/" + m_messageId + "/" + "suggested";
 	QUrl suggestUrl = buildApiUrl(endpoint, m_userId);
 	QNetworkRequest suggestRequest = createApiRequest(suggestUrl);
-	sendApiRequest(suggestRequest, m_fetchModelsTimer, 5000);
+	sendApiRequest(RequestType::FollowUpSuggest, suggestRequest, 0);
+	// ͨ FollowSuggestSignal 첽
+	return QStringList();
 }
 
 void DifyClient::onGetFollowUpSuggestFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
-	}
+	NetworkReplyData* reply = &request->result;
+	// жദǰأƳӦӳͷţԿã
+	finishRequest(request);
 
 	bool success = false;
 	QString errorMessage;
 	QStringList suggestions;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
@@ -737,19 +729,14 @@ void DifyClient::onGetFollowUpSuggestFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
-
-	m_NetWorkParams->clientNetWorkReply.reset();
 }
 
 void DifyClient::getKnowledgeBase()
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::GetKonwledgeBase;
+	// ȡ֮ǰ֪ʶ
+	cancelRequests(RequestType::GetKonwledgeBase);
 
 	if (!validateServerUrl())
 		return;
@@ -773,25 +760,27 @@ void DifyClient::getKnowledgeBase()
 	{
 		request.setRawHeader("Authorization", ("Bearer " + m_LLMParams->getKnowledgeApi()).toUtf8());
 	}
-	sendApiRequest(request, m_fetchModelsTimer, 50000);
+	sendApiRequest(RequestType::GetKonwledgeBase, request, 0);
 }
 
 void DifyClient::onGetKnowledgeBaseFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 
 	bool success = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 			QJsonObject jsonObj = doc.object();
@@ -825,18 +814,15 @@ void DifyClient::onGetKnowledgeBaseFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
 void DifyClient::StopGenerateStreamAns()
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::StopStreamAns;
+	// ȡ֮ǰֹͣ
+	cancelRequests(RequestType::StopStreamAns);
 
 	if (!validateServerUrl())
 		return;
@@ -844,33 +830,32 @@ void DifyClient::StopGenerateStreamAns()
 	QString endpoint = "/v1/messages/" + m_taskId + "/" + "stop";
 	QUrl suggestUrl = buildApiUrl(endpoint, m_userId);
 	QNetworkRequest suggestRequest = createApiRequest(suggestUrl);
-	sendApiRequest(suggestRequest, m_fetchModelsTimer, 50000);
+	sendApiRequest(RequestType::StopStreamAns, suggestRequest, 0);
 }
 
 void DifyClient::onStopStreamAnsFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 	bool success = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 			errorMessage = "success";
 	}
+	finishRequest(request);
 }
 
 void DifyClient::uploadFile(const QString& filePath)
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::FileUpload;
+	// ϴԻУȡ
 
 	// ֤URL
 	if (!validateServerUrl())
@@ -929,15 +914,10 @@ void DifyClient::uploadFile(const QString& filePath)
 	}
 
 	// POST
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->post(uploadRequest, multiPart));
-
-	// multiPartreplyɾʱԶɾ
-	multiPart->setParent(m_NetWorkParams->clientNetWorkReply.get());
-
-	// ź
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-		this, &DifyClient::onFileUploadFinished);
+	// multiPart ߳̽ӹܣӦɾǼʧʱɾ
+	ClientRequest* request = startRequest(RequestType::FileUpload,
+		NetworkOperation::post(uploadRequest, multiPart));
+	onRequestFinished(request, this, &DifyClient::onFileUploadFinished);
 }
 
 void DifyClient::DeleteFile(const QString& fileID)
@@ -947,21 +927,23 @@ void DifyClient::DeleteFile(const QString& fileID)
 
 void DifyClient::onFileUploadFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 	bool success = false;
 	QString errorMessage;
 	QString fileId;
 	QString fileName;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200 || statusCode == 201)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
@@ -990,7 +972,7 @@ void DifyClient::onFileUploadFinished()
 		}
 		else
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonDocument doc = QJsonDocument::fromJson(responseData);
 			if (doc.isObject())
 			{
@@ -1012,27 +994,29 @@ void DifyClient::onFileUploadFinished()
 	}
 	else
 	{
-		errorMessage = GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll());
+		errorMessage = GetError(reply->errorString(),
+			reply->readAll());
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
 void DifyClient::onDeleteFileFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 	bool success = false;
 	QString errorMessage;
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200 || statusCode == 201)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
@@ -1050,11 +1034,11 @@ void DifyClient::onDeleteFileFinished()
 	}
 	else
 	{
-		errorMessage = GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll());
+		errorMessage = GetError(reply->errorString(),
+			reply->readAll());
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
 void DifyClient::ChangeKnowledgeGraph(const QString& kownledgeID)
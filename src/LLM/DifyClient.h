@@ -3,6 +3,7 @@
 #include <QJsonDocument>
 #include <QUrlQuery>
 #include <QJsonArray>
+#include <QHash>
 class DifyClient :
     public MessageManager
 {
@@ -16,14 +17,14 @@ public:
     QString getProviderName() const override;
     QString getVersion() const override;
     QByteArray buildMessageBody(const ChatSendMessage& msg) override;
-    void SendPreProcess(const ChatSendMessage& msg) override;
+    ClientRequest* SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder = nullptr) override;
     QJsonObject parseJsonReplyToMsg(const QByteArray &data) override;
-    int send(const ChatSendMessage& msg) override;
-    int StreamSend(const ChatSendMessage& msg) override;
+    quint64 send(const ChatSendMessage& msg) override;
+    quint64 StreamSend(const ChatSendMessage& msg) override;
     QString GetError(const QString& errorLevel, const QString& errorContext) override;
     void processStreamEnded() override;
     QNetworkRequest createApiRequest(const QUrl& url) override;
-    void sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs) override;
+    void sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs) override;
     void checkServerConnectionAsync(int timeoutMs) override;
     QStringList parseModelIds(const QByteArray &jsonData) override;
     void fetchModelsAsync(int timeoutMs = 5000) override;
@@ -33,8 +34,8 @@ public:
     QStringList GetFollowUpSuggestions()override;
     void uploadFile(const QString& filePath) override;
     void DeleteFile(const QString& fileID) override;
-    void AnalysisBlockResponse(QJsonObject& response_obj) override;
-    void AnalysisStreamResponse(QJsonObject& response_obj) override;
+    void AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj) override;
+    void AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj) override;
     void ChangeKnowledgeGraph(const QString& kownledgeID) override;
     void CancelUpdateFile(const QString& file) override;
     void CancelAllUpdateFiles(const QStringList& fileList)override;
@@ -68,10 +69,16 @@ public slots:
 
 private slots:
     void getAnswer() override;
-    void getStreamAnswer() override;
 
 private:
+    // 流中带回的会话/消息/任务ID
+    void handleStreamMeta(ClientRequest* request, const QJsonObject& meta) override;
+
+    // 保存服务端返回的会话/消息/任务ID
+    void rememberIds(ClientRequest* request, const QJsonObject& obj);
+
     QString m_conversationId;
+    QHash<QString, QString> m_sessionConversations; // 本地会话ID -> Dify conversation_id
     QString m_messageId;
     QString m_taskId;
     QString m_userId = "GKG";
@@ -6,6 +6,10 @@
 #include "ChatSessionService.h"
 #include "LLMClientManager.h"
 #include "AIParamWidget.h"
+#include "ChatTranscriptModel.h"
+#include "RenderCache.h"
+#include "StreamRenderScheduler.h"
+#include "ThinkTagSplitter.h"
 
 #include <QResizeEvent>
 #include <QGraphicsOpacityEffect>
@@ -163,6 +167,10 @@ Frm_AIAssit::Frm_AIAssit(QWidget *parent)
 	connect(m_clientManager.get(), &LLMClientManager::modelsFetchFailed, this, &Frm_AIAssit::onModelsFetchFailed);
 	connect(m_clientManager.get(), &LLMClientManager::clientError, this, &Frm_AIAssit::onClientManagerError);
 
+	// 流式文本按帧间隔合并刷新到所有进行中的气泡
+	m_streamScheduler = new StreamRenderScheduler(this, this);
+	connect(m_streamScheduler, &StreamRenderScheduler::frame, this, &Frm_AIAssit::flushPendingAnswers);
+
 	initParams();
 	setupSignals();
 	initUI();
@@ -212,6 +220,16 @@ void Frm_AIAssit::setupSignals()
 		}
 	});
 	connect(ui.ChatShow, &ChatShowWidget::toggleButtonClicked, this, &Frm_AIAssit::toggleSidebar);
+	// 聊天记录视图只为可见行创建气泡，气泡来自对象池
+	ui.ChatShow->getChatFrame()->setBubbleFactory(
+		[this](QWidget* parent) { return acquireBubble(parent); },
+		[this](LLMChatFrame* bubble) { releaseBubble(bubble); });
+	// 滚动时贴气泡快照，避免拖动滚动条时逐帧排版绘制 Markdown 文档
+	ui.ChatShow->getChatFrame()->setFastScrollEnabled(true);
+	if (m_chatSessionService)
+	{
+		connect(m_chatSessionService.get(), &ChatSessionService::aboutToSave, this, &Frm_AIAssit::storePendingAnswers);
+	}
 	connect(ui.ChatListWidget, &ChatList::newConversationRequested, this, &Frm_AIAssit::createNewConversation, Qt::UniqueConnection);
 	connect(ui.ChatListWidget, &ChatList::conversationChanged, this, &Frm_AIAssit::onConversationSelected);
 	connect(ui.ChatListWidget, &ChatList::renameRequested, this, &Frm_AIAssit::renameCurrentConversation);
@@ -242,6 +260,7 @@ void Frm_AIAssit::setupSignals()
 				if (m_chatSessionService) {
 					m_chatSessionService->removeSession(id);
 				}
+				m_contextBuilder.forgetSession(id);
 			}
 			ui.ChatListWidget->clearConversations();
 			if (m_chatSessionService) {
@@ -253,16 +272,45 @@ void Frm_AIAssit::setupSignals()
 		}
 	});
 	
-	// 设置搜索回调函数
+	// 设置搜索回调函数：只查内存中的会话，未读入的历史会话按摘要匹配，搜索不读取历史文件
 	ui.ChatListWidget->setSearchCallback([this](const QString& conversationId) -> QString {
 		if (m_chatSessionService) {
-			const ChatSession* session = m_chatSessionService->session(conversationId);
-			if (session) {
+			const ChatSessionService& service = *m_chatSessionService;
+			if (const ChatSession* session = service.session(conversationId)) {
 				return buildConversationPlainText(*session);
 			}
+			if (const ChatSessionSummary* summary = service.historySummary(conversationId)) {
+				return summary->title + QLatin1Char('\n') + summary->preview;
+			}
 		}
 		return QString();
 	});
+	ui.ChatListWidget->setIndexedSearchCallback([this](const QString& text, QList<QPair<QString, QStringList>>& hits) -> bool {
+		QList<SessionSearchHit> results;
+		if (!m_chatSessionService || !m_chatSessionService->searchSessions(text, results)) {
+			return false;
+		}
+		// 保持检索的相关度顺序
+		for (const SessionSearchHit& hit : results) {
+			hits.append(qMakePair(hit.sessionId, hit.bubbleIds));
+		}
+		return true;
+	});
+
+	// 正在显示和有进行中回答的会话不能释放：视图和回答仍持有其中的数据
+	if (m_chatSessionService) {
+		m_chatSessionService->setSessionInUseCallback([this](const QString& sessionId) {
+			if (sessionId == m_currentConversationId) {
+				return true;
+			}
+			for (const PendingAnswer& pending : m_pendingAnswers) {
+				if (pending.conversationId == sessionId) {
+					return true;
+				}
+			}
+			return false;
+		});
+	}
 
 	// 连接LLMClient的信号（需要在LLMClient创建后调用setupLLMClientSignals()）
 	if (LLMClient) {
@@ -281,8 +329,9 @@ void Frm_AIAssit::setupLLMClientSignals()
 
 	// 连接LLMClient的通用信号
 	connect(LLMClient, &MessageManager::Answer, this, &Frm_AIAssit::getAnswerShow);
-	connect(LLMClient, &MessageManager::AnswerStream, this, &Frm_AIAssit::getStreamAnswerShow);
-	connect(LLMClient, &MessageManager::ChangeButtonStatus, ui.ChatInput, &ChatInputWidget::SetButtonState);
+	connect(LLMClient, &MessageManager::StreamDeltaReceived, this, &Frm_AIAssit::onStreamDelta);
+	// 按钮状态取决于当前会话是否还有进行中的回答
+	connect(LLMClient, &MessageManager::ChangeButtonStatus, this, &Frm_AIAssit::updateSendButton);
 	connect(LLMClient, &MessageManager::FunctionCallSignal, this, &Frm_AIAssit::preFuncall);
 	connect(LLMClient, &MessageManager::StreamEnded, this, &Frm_AIAssit::getStreamAnswerEnd);
 	connect(LLMClient, &MessageManager::modelsListFetched, ui.ChatInput, &ChatInputWidget::UpdateModelList);
@@ -342,7 +391,7 @@ void Frm_AIAssit::setupShortcuts()
 			// Stop current generation
 			if (LLMClient)
 			{
-				LLMClient->cancelCurrentRequest();
+				onUserCancelRequested();
 			}
 			break;
 		case ShortcutManager::Settings:
@@ -355,12 +404,9 @@ void Frm_AIAssit::setupShortcuts()
 			{
 				return;
 			}
-			QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-			if (chatFrame)
-			{
-				releaseAllBubbles();
-				ui.ChatShow->updateEmptyState();
-			}
+			detachPendingAnswers();
+			releaseAllBubbles();
+			ui.ChatShow->updateEmptyState();
 			break;
 		}
 		case ShortcutManager::ExportConversation:
@@ -463,8 +509,15 @@ void Frm_AIAssit::initHistoryFile()
 		qDebug() << "文件已存在：" << ChatJsonFile;
 	}
 	if (m_chatSessionService) {
+		m_chatSessionService->setHistoryDirectory(m_configRepository->chatHistoryDirectory());
 		m_chatSessionService->setStorageFile(ChatJsonFile);
+		// SQLite 可用时改用数据库保存并建立全文索引，否则继续使用 JSON 文件
+		if (!m_chatSessionService->enableDatabase(m_configRepository->chatHistoryDatabaseFile())) {
+			qDebug() << "会话数据库不可用，使用JSON存储：" << ChatJsonFile;
+		}
 	}
+	// 渲染结果的磁盘缓存放在配置目录下
+	RenderCache::instance().setDiskDirectory(m_configRepository->configPath(QStringLiteral("RenderCache")));
 }
 void Frm_AIAssit::initUI()
 {
@@ -630,53 +683,42 @@ void Frm_AIAssit::initParams()
 	AIProvider platform = static_cast<AIProvider>(params->getLLMPlatForm());
 	setLLMClient(platform);
 }
-void Frm_AIAssit::addChatBubble(const QString& text, bool bIsUser)
+QString Frm_AIAssit::addChatBubble(const QString& text, bool bIsUser)
 {
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
 	if (!chatFrame)
 	{
-		return;
+		return QString();
 	}
 
-	LLMChatFrame* userBubble = acquireBubble(chatFrame);
-	if (QWidget* viewport = chatFrame->viewport())
-	{
-		userBubble->resize(viewport->width(), userBubble->height());
-	}
 	LLMChatFrame::User_Type bubbleType = bIsUser ? LLMChatFrame::User_Customer : LLMChatFrame::User_Owner;
-	userBubble->setUserType(bubbleType);
-	//文本以及大小设置
-	QSize textSize = userBubble->fontRect(text);
-	userBubble->setText(text, QString::number(QDateTime::currentDateTime().toTime_t()), textSize,
-		bubbleType);
-	textSize = userBubble->getSize();
 	//每个bubble都有唯一ID
 	QString bubbleID = QUuid::createUuid().toString();
-	userBubble->setBubbleID(bubbleID);
-	//将最新项添加至当前对话下并滚动至最新项
-	QListWidgetItem* item = new QListWidgetItem();
-	chatFrame->addItem(item);
-	chatFrame->setItemWidget(item, userBubble);
-	userBubble->setAttribute(Qt::WA_DeleteOnClose, false);
-	refreshBubbleSize(userBubble, item);
-	chatFrame->scrollToBottom();
+	//消息先写入当前对话，再由视图绑定气泡；回答气泡在生成结束前保持加载状态并固定在视图中
+	sSingleMsg singleMsg(text, QString::number(QDateTime::currentDateTime().toTime_t()), bubbleType,
+		tr("New Conversation"), "", bubbleID);
+	chatFrame->appendMessage(singleMsg, bIsUser);
 	// 添加消息后更新空状态
 	ui.ChatShow->updateEmptyState();
-	//用户bubble需要在此处将bubble信息存入到m_ChatMSg
-	if (!bIsUser)
-	{
-		sSingleMsg singleMsg(text, QString::number(QDateTime::currentDateTime().toTime_t()), textSize, LLMChatFrame::User_Owner, tr("New Conversation"), "", userBubble->getBubbleID());
-		if (ChatSession* session = currentSession()) {
-			session->sMsg.append(singleMsg);
-			session->SaveTime = QDateTime::currentDateTime();
-		}
+	if (ChatSession* session = currentSession()) {
+		session->SaveTime = QDateTime::currentDateTime();
+		m_chatSessionService->recordMessage(m_currentConversationId, bubbleID);
 	}
+	return bubbleID;
 }
 void Frm_AIAssit::on_pushButton_clicked(ChatSendMessage msg)
 {
+	// 在提问写入会话之前选择历史消息
+	if (const ChatSession* session = currentSession()) {
+		ChatContextReport report;
+		msg.history = m_contextBuilder.build(m_currentConversationId, *session, session->sMsg.size(),
+			params ? params->getContextTokens() : 0, &report);
+		qCDebug(lcChatContext).noquote() << report.toString();
+	}
 	addChatBubble(msg.SendText, false);
+	// 回答写回发起请求的会话，期间可以切换到其他会话
+	msg.sessionId = m_currentConversationId;
 	const bool enableStream = m_paramWidget ? m_paramWidget->GetAIParambStream() : false;
-	m_lastRequestUsedStream = enableStream;
 	if (enableStream)
 		StreamSend(msg);
 	else
@@ -716,7 +758,7 @@ QJsonObject Frm_AIAssit::parseJsonReplyToMsg(const QByteArray &data, bool isStre
 		msg = choice0.value("delta").toObject();
 	return msg;
 }
-void Frm_AIAssit::preFuncall(QJsonObject& Content)
+void Frm_AIAssit::preFuncall(quint64 requestId, QJsonObject& Content)
 {
 	// 处理函数调用
 	QJsonArray toolCalls = Content["tool_calls"].toArray();
@@ -737,9 +779,9 @@ void Frm_AIAssit::preFuncall(QJsonObject& Content)
 
 	QJsonObject result = LLMFunctionCall::Get()->executeFunction(name, arguments);
 	Content["content"] = QString(QJsonDocument(result).toJson(QJsonDocument::Indented));
-	ProcessFunctionCall(Content);
+	ProcessFunctionCall(requestId, Content);
 }
-void Frm_AIAssit::ProcessFunctionCall(QJsonObject FunctionMsg)
+void Frm_AIAssit::ProcessFunctionCall(quint64 requestId, QJsonObject FunctionMsg)
 {
 	QJsonArray toolCalls = FunctionMsg["tool_calls"].toArray();
 	if (toolCalls.isEmpty())
@@ -770,28 +812,40 @@ void Frm_AIAssit::ProcessFunctionCall(QJsonObject FunctionMsg)
 	config.setPeerVerifyMode(QSslSocket::VerifyNone);
 	// 使用封装接口配置 SSL 并发送请求，避免直接访问内部网络成员
 	LLMClient->configureRequestSsl(config);
-	QNetworkReply *reply = LLMClient->postRequest(data);
-	connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-		if (reply->error())
+	// 应答在网络线程中完成，处理函数在界面线程中调用
+	QPointer<Frm_AIAssit> self(this);
+	LLMClient->postRequest(data, [self, requestId](NetworkReplyData& reply) {
+		if (!self)
 		{
-			qDebug() << "Error:" << reply->errorString();
+			return;
+		}
+		if (reply.error())
+		{
+			qDebug() << "Error:" << reply.errorString();
+			emit self->Answer(requestId, reply.errorString(), true);
 		}
 		else {
-			QByteArray response_data = reply->readAll();
+			QByteArray response_data = reply.readAll();
 			if (response_data.isEmpty())
 			{
 				return;
 			}
-			QJsonDocument response_doc = QJsonDocument::fromJson(response_data);
-			QJsonObject msg = parseJsonReplyToMsg(response_data);
+			QJsonObject msg = self->parseJsonReplyToMsg(response_data);
 			QString content = msg.value("content").toString();
-			emit Answer(content, false);
+			emit self->Answer(requestId, content, false);
 		}
-		reply->deleteLater();
 	});
 }
-void Frm_AIAssit::getAnswerShow(const QString& word, bool bError)
+void Frm_AIAssit::getAnswerShow(quint64 requestId, const QString& word, bool bError)
 {
+	auto pendingIt = m_pendingAnswers.find(requestId);
+	if (pendingIt == m_pendingAnswers.end())
+	{
+		return; // 已取消
+	}
+	const PendingAnswer pending = pendingIt.value();
+	m_pendingAnswers.erase(pendingIt);
+
 	// 使用静态常量避免重复创建字符串
 	static const QString ANSWER_HEADER = QStringLiteral("\n ### 回答 \n");
 	static const QString ANSWER_HEADER_NEWLINE = QStringLiteral("\n ### 回答 \n\n");
@@ -844,21 +898,11 @@ void Frm_AIAssit::getAnswerShow(const QString& word, bool bError)
 		}
 	}
 
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	if (!chatFrame || chatFrame->count() == 0) {
-		qWarning() << "Chat frame is empty or invalid";
-		return;
-	}
-
-	QListWidgetItem* latestItem = chatFrame->item(chatFrame->count() - 1);
-	if (!latestItem) {
-		qWarning() << "Latest item is null";
-		return;
-	}
-
-	LLMChatFrame *latestWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(latestItem));
+	LLMChatFrame *latestWidget = liveBubble(pending);
 	if (!latestWidget) {
-		qWarning() << "Latest widget is null or invalid type";
+		// 发起请求的会话已不在显示，直接写回该会话
+		finalizeDetachedAnswer(pending, buildDialogName(tempWord), TextAnswer, TextReasoning);
+		updateSendButton();
 		return;
 	}
 
@@ -872,129 +916,303 @@ void Frm_AIAssit::getAnswerShow(const QString& word, bool bError)
 	}
 	// 注意：fontRect()内部已经调用了update()，这里不需要再次调用
 	QString DialogName = updateDialogName(tempWord);
-	finalizeLatestBubble(latestWidget, latestItem, DialogName, TextAnswer, TextReasoning, false);
+	finalizeLatestBubble(latestWidget, DialogName, TextAnswer, TextReasoning, false);
 }
 
-void Frm_AIAssit::getStreamAnswerShow(const QString& word)
+void Frm_AIAssit::getStreamAnswerShow(quint64 requestId, const QString& word)
 {
-	m_pendingStreamChunk.append(word);
+	auto pendingIt = m_pendingAnswers.find(requestId);
+	if (pendingIt == m_pendingAnswers.end())
+	{
+		return; // 已取消
+	}
+	pendingIt->rawText.append(word);
+	pendingIt->pendingChunk.append(word);
+	streamDataArrived(*pendingIt);
+}
 
-	const int DEFAULT_INTERVAL_MS = 75;
-	const int MIN_INTERVAL_MS = 30;
-	const int MAX_INTERVAL_MS = 150;
+void Frm_AIAssit::onStreamDelta(quint64 requestId, const StreamDelta& delta)
+{
+	switch (delta.channel)
+	{
+	case StreamChannel::Answer:
+		getStreamAnswerShow(requestId, delta.text);
+		break;
+	case StreamChannel::Reasoning:
+	{
+		auto pendingIt = m_pendingAnswers.find(requestId);
+		if (pendingIt == m_pendingAnswers.end())
+		{
+			return; // 已取消
+		}
+		pendingIt->reasoningText.append(delta.text);
+		pendingIt->pendingReasoning.append(delta.text);
+		streamDataArrived(*pendingIt);
+		break;
+	}
+	default:
+		// 工具调用与用量不显示
+		break;
+	}
+}
 
-	if (!m_streamDebounceTimer) {
-		m_streamDebounceTimer = new QTimer(this);
-		m_streamDebounceTimer->setSingleShot(true);
-		m_streamDebounceTimer->setInterval(DEFAULT_INTERVAL_MS);
+void Frm_AIAssit::flushPendingAnswers()
+{
+	for (auto it = m_pendingAnswers.begin(); it != m_pendingAnswers.end(); ++it)
+	{
+		PendingAnswer& pending = it.value();
+		if (pending.pendingChunk.isEmpty() && pending.pendingReasoning.isEmpty())
+		{
+			continue;
+		}
+		if (LLMChatFrame* bubble = liveBubble(pending))
+		{
+			bubble->appendReasoning(pending.pendingReasoning);
+			bubble->appendText(pending.pendingChunk);
+			// 增量渲染：已闭合的Markdown块不再重复转换
+			bubble->refreshStreamingLayout();
+			refreshBubbleSize(bubble);
+		}
+		else if (pending.conversationId == m_currentConversationId)
+		{
+			// 切回会话后气泡已重新绑定，按已收到的全部文本刷新
+			QString answer;
+			QString reasoning;
+			splitPendingText(pending, answer, reasoning);
+			writeDetachedAnswer(pending, answer, reasoning);
+		}
+		pending.pendingChunk.clear();
+		pending.pendingReasoning.clear();
+	}
+}
 
-		connect(m_streamDebounceTimer, &QTimer::timeout, this, [this]() {
-			QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-			if (!chatFrame || chatFrame->count() == 0) {
-				m_pendingStreamChunk.clear();
-				return;
-			}
+void Frm_AIAssit::streamDataArrived(const PendingAnswer& pending)
+{
+	// 接收中的文本由自动保存定期写入，崩溃时最多丢失几秒；窗口隐藏、不刷新气泡时也照常保存
+	if (pending.stream && m_chatSessionService)
+	{
+		m_chatSessionService->markModified(pending.conversationId);
+	}
+	m_streamScheduler->requestFrame();
+}
 
-			QListWidgetItem* latestItem = chatFrame->item(chatFrame->count() - 1);
-			if (!latestItem) {
-				m_pendingStreamChunk.clear();
-				return;
-			}
+void Frm_AIAssit::trackAnswer(quint64 requestId, const QString& bubbleId, bool stream)
+{
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	PendingAnswer pending;
+	pending.conversationId = m_currentConversationId;
+	pending.bubbleId = bubbleId;
+	pending.bubble = chatFrame ? chatFrame->bubbleForId(bubbleId) : nullptr;
+	pending.stream = stream;
+	m_pendingAnswers.insert(requestId, pending);
+	updateSendButton();
+	if (requestId == 0)
+	{
+		// 请求未能发出，直接结束回答气泡
+		getAnswerShow(0, tr("Request failed"), true);
+	}
+}
 
-			LLMChatFrame* latestWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(latestItem));
-			if (!latestWidget) {
-				m_pendingStreamChunk.clear();
-				return;
-			}
+LLMChatFrame* Frm_AIAssit::liveBubble(const PendingAnswer& pending) const
+{
+	if (!pending.bubble || pending.conversationId != m_currentConversationId)
+	{
+		return nullptr;
+	}
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	return (chatFrame && chatFrame->bubbleForId(pending.bubbleId) == pending.bubble) ? pending.bubble.data() : nullptr;
+}
 
-			if (!m_pendingStreamChunk.isEmpty()) {
-				latestWidget->appendText(m_pendingStreamChunk);
-			}
+ChatMessageData* Frm_AIAssit::pendingMessage(const PendingAnswer& pending)
+{
+	ChatSessionMap& sessions = sessionMap();
+	auto sessionIt = sessions.find(pending.conversationId);
+	if (sessionIt == sessions.end())
+	{
+		return nullptr; // 会话已删除
+	}
+	const int row = sessionIt->messageIndex(pending.bubbleId);
+	return row >= 0 ? &sessionIt->sMsg[row] : nullptr;
+}
 
-			m_pendingStreamChunk.clear();
+void Frm_AIAssit::splitPendingText(const PendingAnswer& pending, QString& answer, QString& reasoning)
+{
+	ThinkTagSplitter::split(pending.rawText, answer, reasoning);
+	if (!pending.reasoningText.isEmpty())
+	{
+		reasoning.prepend(pending.reasoningText);
+	}
+}
 
-			const QString reasoningHtml = latestWidget->getReasonRawText();
-			if (!reasoningHtml.trimmed().isEmpty()) {
-				latestWidget->fontRect(reasoningHtml, latestWidget->getRawText());
-			}
-			else {
-				latestWidget->fontRect(latestWidget->getRawText());
-			}
-			refreshBubbleSize(latestWidget, latestItem);
-			//scheduleScrollToBottom();
-		});
+void Frm_AIAssit::detachPendingAnswers()
+{
+	for (auto it = m_pendingAnswers.begin(); it != m_pendingAnswers.end(); ++it)
+	{
+		PendingAnswer& pending = it.value();
+		if (!pending.bubble)
+		{
+			continue;
+		}
+		pending.bubble = nullptr;
+		// 已收到的流式文本先写回会话，切回时直接显示
+		ChatMessageData* message = pending.stream ? pendingMessage(pending) : nullptr;
+		if (message)
+		{
+			splitPendingText(pending, message->m_ChatMsg, message->m_ChatReasonMsg);
+			message->m_Layout.clear();
+		}
 	}
-	else {
-		int currentInterval = m_streamDebounceTimer->interval();
-		if (word.length() > 50 && currentInterval < MAX_INTERVAL_MS) {
-			m_streamDebounceTimer->setInterval(std::min(currentInterval + 20, MAX_INTERVAL_MS));
+}
+
+void Frm_AIAssit::storePendingAnswers()
+{
+	for (auto it = m_pendingAnswers.constBegin(); it != m_pendingAnswers.constEnd(); ++it)
+	{
+		const PendingAnswer& pending = it.value();
+		ChatMessageData* message = pending.stream ? pendingMessage(pending) : nullptr;
+		if (message && (!pending.rawText.isEmpty() || !pending.reasoningText.isEmpty()))
+		{
+			// 不清除尺寸：实时气泡仍在显示，结束时按最终文本重新计算
+			splitPendingText(pending, message->m_ChatMsg, message->m_ChatReasonMsg);
+		}
+	}
+}
+
+void Frm_AIAssit::writeDetachedAnswer(const PendingAnswer& pending, const QString& answer, const QString& reasoning)
+{
+	ChatMessageData* message = pendingMessage(pending);
+	if (!message)
+	{
+		return;
+	}
+	message->m_ChatMsg = answer;
+	message->m_ChatReasonMsg = reasoning;
+	message->m_Layout.clear();
+	if (pending.conversationId != m_currentConversationId)
+	{
+		return;
+	}
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	if (LLMChatFrame* bubble = chatFrame->bubbleForId(pending.bubbleId))
+	{
+		if (!reasoning.trimmed().isEmpty())
+		{
+			bubble->fontRect(reasoning, answer);
 		}
-		else if (word.length() < 10 && currentInterval > MIN_INTERVAL_MS) {
-			m_streamDebounceTimer->setInterval(std::max(currentInterval - 10, MIN_INTERVAL_MS));
+		else
+		{
+			bubble->fontRect(answer);
 		}
+		refreshBubbleSize(bubble);
 	}
+	else
+	{
+		ChatTranscriptModel* model = chatFrame->transcriptModel();
+		model->messageChanged(model->rowForBubble(pending.bubbleId));
+	}
+}
 
-	m_streamDebounceTimer->start();
+void Frm_AIAssit::finalizeDetachedAnswer(const PendingAnswer& pending, const QString& dialogName,
+	const QString& answer, const QString& reasoning)
+{
+	writeDetachedAnswer(pending, answer, reasoning);
+	ChatMessageData* message = pendingMessage(pending);
+	if (!message)
+	{
+		return;
+	}
+	message->m_ChatTime = QString::number(QDateTime::currentDateTime().toTime_t());
+	message->m_DialogName = dialogName;
+	ChatSession& session = sessionMap()[pending.conversationId];
+	session.SaveTime = QDateTime::currentDateTime();
+	if (m_chatSessionService)
+	{
+		m_chatSessionService->recordMessage(pending.conversationId, pending.bubbleId);
+	}
+	if (session.sMsg.last().m_BubbleID == pending.bubbleId)
+	{
+		ui.ChatListWidget->setConversationText(pending.conversationId, dialogName);
+	}
+}
+
+void Frm_AIAssit::updateSendButton()
+{
+	// 当前会话仍有回答在生成时保持可取消状态
+	for (auto it = m_pendingAnswers.constBegin(); it != m_pendingAnswers.constEnd(); ++it)
+	{
+		if (it->conversationId == m_currentConversationId)
+		{
+			PushBtnChanged(SendButtonState::Cancelable);
+			return;
+		}
+	}
+	if (ui.ChatInput->currentButtonState() == SendButtonState::Cancelable)
+	{
+		PushBtnChanged(SendButtonState::Ready);
+	}
 }
 
-int Frm_AIAssit::send(const ChatSendMessage& msg)
+quint64 Frm_AIAssit::send(const ChatSendMessage& msg)
 {
 	if (!LLMClient) {
 		qWarning() << "LLMClient is null in send";
-		return -1;
+		return 0;
 	}
-	addChatBubble(" ", true);
-	int rtn = LLMClient->send(msg);
-	return rtn;
+	const QString bubbleId = addChatBubble(" ", true);
+	const quint64 requestId = LLMClient->send(msg);
+	trackAnswer(requestId, bubbleId, false);
+	return requestId;
 }
-int Frm_AIAssit::StreamSend(const ChatSendMessage& msg)
+quint64 Frm_AIAssit::StreamSend(const ChatSendMessage& msg)
 {
 	if (!LLMClient) {
 		qWarning() << "LLMClient is null in StreamSend";
-		return -1;
+		return 0;
 	}
-	addChatBubble(" ", true);
-	int rtn = LLMClient->StreamSend(msg);
-	return rtn;
+	const QString bubbleId = addChatBubble(" ", true);
+	const quint64 requestId = LLMClient->StreamSend(msg);
+	trackAnswer(requestId, bubbleId, true);
+	return requestId;
 }
-void Frm_AIAssit::getStreamAnswerEnd()
+void Frm_AIAssit::getStreamAnswerEnd(quint64 requestId)
 {
-	if (m_skipNextStreamFinalize)
+	auto pendingIt = m_pendingAnswers.find(requestId);
+	if (pendingIt == m_pendingAnswers.end())
 	{
-		m_skipNextStreamFinalize = false;
-		return;
+		return; // 已取消或已按错误结束
 	}
-	//获取最新对应项
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
+	const PendingAnswer pending = pendingIt.value();
+	m_pendingAnswers.erase(pendingIt);
 
-	if (m_streamDebounceTimer) {
-		m_streamDebounceTimer->stop();
+	// 构造包含标记的文本用于提取对话名称
+	static const QString ANSWER_HEADER = QStringLiteral("\n ### 回答 \n");
+	LLMChatFrame *latestWidget = liveBubble(pending);
+	if (!latestWidget) {
+		// 发起请求的会话已不在显示，直接写回该会话
+		QString answer;
+		QString reasoning;
+		splitPendingText(pending, answer, reasoning);
+		const QString textForName = answer.trimmed().isEmpty() ? QString() : (ANSWER_HEADER + answer.trimmed());
+		finalizeDetachedAnswer(pending, buildDialogName(textForName), answer, reasoning);
+		updateSendButton();
+		return;
 	}
 
-	QListWidgetItem* latestItem = chatFrame->item(chatFrame->count() - 1);
-	LLMChatFrame *latestWidget = (LLMChatFrame*)chatFrame->itemWidget(latestItem);
-
-	if (!m_pendingStreamChunk.isEmpty()) {
-		latestWidget->appendText(m_pendingStreamChunk);
-		m_pendingStreamChunk.clear();
+	latestWidget->appendReasoning(pending.pendingReasoning);
+	if (!pending.pendingChunk.isEmpty()) {
+		latestWidget->appendText(pending.pendingChunk);
 	}
+	latestWidget->finishText();
 
 	const QString reasoningHtml = latestWidget->getReasonRawText();
 	const QString answerHtml = latestWidget->getRawText();
-	if (!reasoningHtml.trimmed().isEmpty()) {
-		latestWidget->fontRect(reasoningHtml, answerHtml);
-	}
-	else {
-		latestWidget->fontRect(answerHtml);
-	}
+	latestWidget->refreshStreamingLayout();
 
-	// 构造包含标记的文本用于提取对话名称
-	static const QString ANSWER_HEADER = QStringLiteral("\n ### 回答 \n");
 	QString textForName = answerHtml.trimmed().isEmpty() ? QString() : (ANSWER_HEADER + answerHtml.trimmed());
 	QString DialogName = updateDialogName(textForName);
-	finalizeLatestBubble(latestWidget, latestItem, DialogName,
+	finalizeLatestBubble(latestWidget, DialogName,
 		answerHtml, reasoningHtml, true);
-	chatFrame->scrollToBottom();
+	ui.ChatShow->getChatFrame()->scrollToBottom();
 }
 void Frm_AIAssit::createNewConversation() {
 	// 生成唯一对话ID 
@@ -1005,72 +1223,33 @@ void Frm_AIAssit::createNewConversation() {
 		sessionMap().insert(convId, newMsg);
 	}
 	// 使用 ChatList 的方法添加新对话
+	detachPendingAnswers();
 	ui.ChatListWidget->insertConversationItem(0, tr("New Conversation"), convId);
 	ui.ChatListWidget->setCurrentConversation(convId);
 	m_currentConversationId = convId;
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	releaseAllBubbles();
+	ui.ChatShow->getChatFrame()->setSession(currentSession());
 	// 新建对话后更新空状态（此时应该显示空状态）
 	ui.ChatShow->updateEmptyState();
 }
 void Frm_AIAssit::onConversationSelected(QListWidgetItem* current, QListWidgetItem* previous) {
 	if (!current) return;
 
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	releaseAllBubbles();
-
-	m_currentConversationId = current->data(Qt::UserRole).toString();
-	sMsgList* session = m_chatSessionService ? m_chatSessionService->session(m_currentConversationId) : nullptr;
-	if (!session) {
-		return;
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	// 进行中的回答留在原会话，继续在后台接收
+	detachPendingAnswers();
+	// 先读入新会话再切换当前ID：读入时视图仍显示原会话，原会话不会被释放
+	const QString conversationId = current->data(Qt::UserRole).toString();
+	sMsgList* session = m_chatSessionService ? m_chatSessionService->session(conversationId) : nullptr;
+	m_currentConversationId = conversationId;
+	// 视图只绑定可见行的气泡，其余行使用保存的尺寸或估算高度，打开耗时与消息数量无关
+	chatFrame->setSession(session);
+	// 从搜索结果打开时定位到最相关的命中消息，否则显示最新消息
+	const QStringList searchHits = ui.ChatListWidget->searchHits(m_currentConversationId);
+	if (searchHits.isEmpty() || !chatFrame->scrollToBubble(searchHits.first())) {
+		chatFrame->scrollToBottom();
 	}
-	const sMsgList& ml = *session;
-
-	chatFrame->setUpdatesEnabled(false);
-	for (int idx = 0; idx < session->sMsg.size(); ++idx)
-	{
-		auto& frame = session->sMsg[idx];
-		LLMChatFrame* userBubble = acquireBubble(chatFrame);
-		if (QWidget* viewport = chatFrame->viewport())
-		{
-			userBubble->resize(viewport->width(), userBubble->height());
-		}
-
-		LLMChatFrame::User_Type Auth = frame.userType == 2 ? LLMChatFrame::User_Customer : LLMChatFrame::User_Owner;
-		userBubble->setUserType(Auth);
-
-		QSize textSize = frame.m_AllSize;
-		if (!textSize.isValid() || textSize.isEmpty())
-		{
-			textSize = userBubble->fontRect(frame.m_ChatReasonMsg, frame.m_ChatMsg);
-			frame.m_AllSize = textSize;
-		}
-
-		userBubble->setTextWithReason(frame.m_ChatReasonMsg, frame.m_ChatMsg,
-			frame.m_ChatTime, textSize, Auth);
-		userBubble->setTextSuccess();
-		userBubble->setImportant(frame.m_IsImportant);
-		userBubble->setUserNote(frame.m_Note);
-		userBubble->setBubbleID(frame.m_BubbleID);
-
-		QSize finalSize = userBubble->getSize();
-		frame.m_AllSize = finalSize;
-
-		QListWidgetItem* item = new QListWidgetItem();
-		item->setSizeHint(finalSize);
-		chatFrame->addItem(item);
-		chatFrame->setItemWidget(item, userBubble);
-	}
-
-	chatFrame->setUpdatesEnabled(true);
-	chatFrame->scrollToBottom();
 	ui.ChatShow->updateEmptyState();
-	if (ml.sMsg.size() > 0)
-	{
-		QTimer::singleShot(100, this, [this]() {
-			recalculateVisibleBubbles();
-		});
-	}
+	updateSendButton();
 }
 bool Frm_AIAssit::loadChatMapFromJson()
 {
@@ -1085,33 +1264,32 @@ void Frm_AIAssit::PreLoadChat()
 	QListWidget* chatList = ui.ChatListWidget->getConversationList();
 	chatList->setUpdatesEnabled(false);
 
-	// 按时间倒序排列对话
-	QList<QPair<QString, sMsgList>> sortedChats;
-	const ChatSessionMap& chats = sessionMap();
-	for (auto it = chats.constBegin(); it != chats.constEnd(); ++it)
+	// 侧边栏只需要会话摘要，历史会话的全文在打开时才读取
+	QList<ChatSessionSummary> summaries;
+	if (m_chatSessionService)
 	{
-		sortedChats.append(qMakePair(it.key(), it.value()));
+		summaries = m_chatSessionService->sessionSummaries();
 	}
-	// 按保存时间排序
-	std::sort(sortedChats.begin(), sortedChats.end(),
-		[](const QPair<QString, sMsgList>& a, const QPair<QString, sMsgList>& b) {
-		return a.second.SaveTime > b.second.SaveTime;
+	// 按保存时间倒序排列对话
+	std::sort(summaries.begin(), summaries.end(),
+		[](const ChatSessionSummary& a, const ChatSessionSummary& b) {
+		return a.saveTime > b.saveTime;
 	});
 	// 添加到界面
 	static const int MAX_DISPLAY_NAME_LENGTH = 12;
 	static const QString ELLIPSIS = QStringLiteral("...");
 	static const QString NEW_CONVERSATION = tr("New Conversation");
 
-	for (const auto& chat : sortedChats)
+	for (const ChatSessionSummary& chat : summaries)
 	{
 		QString displayName;
-		if (!chat.second.sMsg.isEmpty())
+		if (chat.messageCount > 0)
 		{
-			displayName = chat.second.sMsg.last().m_DialogName;
-			if (displayName == NEW_CONVERSATION && chat.second.sMsg.size() > 1)
+			displayName = chat.title;
+			if (displayName == NEW_CONVERSATION && chat.messageCount > 1)
 			{
 				// 尝试从最后一条消息生成名称
-				QString lastMsg = chat.second.sMsg.last().m_ChatMsg;
+				const QString& lastMsg = chat.preview;
 				if (lastMsg.length() > MAX_DISPLAY_NAME_LENGTH)
 				{
 					displayName = lastMsg.left(MAX_DISPLAY_NAME_LENGTH) + ELLIPSIS;
@@ -1126,7 +1304,7 @@ void Frm_AIAssit::PreLoadChat()
 		{
 			displayName = NEW_CONVERSATION;
 		}
-		ui.ChatListWidget->addConversationItem(displayName, chat.first);
+		ui.ChatListWidget->addConversationItem(displayName, chat.sessionId);
 	}
 
 	// UI性能优化：重新启用更新，并一次性刷新
@@ -1141,6 +1319,13 @@ void Frm_AIAssit::PreLoadChat()
 	QTimer::singleShot(50, this, &Frm_AIAssit::recalculateAllChatBubbles);
 }
 QString Frm_AIAssit::updateDialogName(const QString& dialogName)
+{
+	const QString tempName = buildDialogName(dialogName);
+	ui.ChatListWidget->setCurrentItemText(tempName);
+	return tempName;
+}
+
+QString Frm_AIAssit::buildDialogName(const QString& dialogName) const
 {
 	static const QString ANSWER_HEADER = QStringLiteral("\n ### 回答 \n");
 	static const int MAX_NAME_LENGTH = 12;
@@ -1161,7 +1346,6 @@ QString Frm_AIAssit::updateDialogName(const QString& dialogName)
 	{
 		tempName = tr("New Conversation");
 	}
-	ui.ChatListWidget->setCurrentItemText(tempName);
 	return tempName;
 }
 
@@ -1180,9 +1364,9 @@ void Frm_AIAssit::attachBubbleSignals(LLMChatFrame* bubble)
 LLMChatFrame* Frm_AIAssit::acquireBubble(QWidget* parent)
 {
 	QWidget* targetParent = parent;
-	if (auto* listWidget = qobject_cast<QListWidget*>(parent))
+	if (auto* itemView = qobject_cast<QAbstractItemView*>(parent))
 	{
-		targetParent = listWidget->viewport();
+		targetParent = itemView->viewport();
 	}
 
 	if (!m_enableBubblePool)
@@ -1247,37 +1431,15 @@ void Frm_AIAssit::releaseBubble(LLMChatFrame* bubble)
 
 void Frm_AIAssit::releaseAllBubbles()
 {
-	QListWidget* chatFrame = ui.ChatShow ? ui.ChatShow->getChatFrame() : nullptr;
+	ChatTranscriptView* chatFrame = ui.ChatShow ? ui.ChatShow->getChatFrame() : nullptr;
 	if (!chatFrame)
 	{
 		return;
 	}
 
+	// 与会话解绑，所有气泡回收到对象池
 	const QSignalBlocker blocker(chatFrame);
-	for (int idx = chatFrame->count() - 1; idx >= 0; --idx)
-	{
-		QListWidgetItem* item = chatFrame->item(idx);
-		if (!item)
-		{
-			continue;
-		}
-
-		if (QWidget* widget = chatFrame->itemWidget(item))
-		{
-			chatFrame->removeItemWidget(item);
-			if (auto* bubble = qobject_cast<LLMChatFrame*>(widget))
-			{
-				releaseBubble(bubble);
-			}
-			else
-			{
-				widget->deleteLater();
-			}
-		}
-
-		QListWidgetItem* removed = chatFrame->takeItem(idx);
-		delete removed;
-	}
+	chatFrame->setSession(nullptr);
 
 	if (!m_enableBubblePool)
 	{
@@ -1314,10 +1476,29 @@ void Frm_AIAssit::deleteCurrentConversation()
 		QMessageBox::Yes | QMessageBox::No);
 	if (reply == QMessageBox::Yes)
 	{
+		// 该会话的请求一并取消
+		if (LLMClient)
+		{
+			LLMClient->cancelSessionRequests(convId);
+		}
+		auto pendingIt = m_pendingAnswers.begin();
+		while (pendingIt != m_pendingAnswers.end())
+		{
+			if (pendingIt->conversationId == convId)
+				pendingIt = m_pendingAnswers.erase(pendingIt);
+			else
+				++pendingIt;
+		}
+		// 视图直接引用会话数据，移除前先解绑
+		if (convId == m_currentConversationId)
+		{
+			releaseAllBubbles();
+		}
 		// 从数据中移除
 		if (m_chatSessionService) {
 			m_chatSessionService->removeSession(convId);
 		}
+		m_contextBuilder.forgetSession(convId);
 		// 从界面移除
 		int row = ui.ChatListWidget->getConversationList()->row(currentItem);
 		ui.ChatListWidget->getConversationList()->takeItem(row);
@@ -1325,7 +1506,6 @@ void Frm_AIAssit::deleteCurrentConversation()
 		// 如果是当前对话，清空聊天区域
 		if (convId == m_currentConversationId)
 		{
-			releaseAllBubbles();
 			if (ui.ChatListWidget->getConversationList()->count() > 0)
 			{
 				ui.ChatListWidget->getConversationList()->setCurrentRow(0);
@@ -1360,6 +1540,7 @@ void Frm_AIAssit::renameCurrentConversation()
 	{
 		currentItem->setText(cnverNewName);
 		session->sMsg.last().m_DialogName = cnverNewName;
+		m_chatSessionService->recordMessage(m_currentConversationId, session->sMsg.last().m_BubbleID);
 	}
 }
 void Frm_AIAssit::toggleSidebar()
@@ -1402,66 +1583,21 @@ void Frm_AIAssit::resizeEvent(QResizeEvent *event)
 {
 	QWidget::resizeEvent(event);
 	applyResponsiveLayout(event->size().width());
-	// 使用成员变量存储定时器
-	if (!m_resizeTimer) {
-		m_resizeTimer = new QTimer(this);
-		m_resizeTimer->setSingleShot(true);
-		connect(m_resizeTimer, &QTimer::timeout, this, [this]() {
-			recalculateVisibleBubbles();
-		});
-	}
-	m_resizeTimer->stop();
-	m_resizeTimer->start(150);
+	// 气泡的重新排版由聊天视图在自身宽度变化时调度（只重排视口内的气泡，拖动中合并）
 }
-void Frm_AIAssit::refreshBubbleSize(LLMChatFrame* bubble, QListWidgetItem* item, const QString& conversationId)
+void Frm_AIAssit::refreshBubbleSize(LLMChatFrame* bubble)
 {
-	if (!bubble || !item)
-	{
-		return;
-	}
-	QSize bubbleSize = bubble->getSize();
-	if (!bubbleSize.isValid())
-	{
-		bubbleSize = bubble->size();
-	}
-	if (QListWidget* ownerList = item->listWidget())
-	{
-		const int availableWidth = ownerList->viewport()->width();
-		if (availableWidth > 0)
-		{
-			bubble->resize(availableWidth, bubbleSize.height());
-			bubbleSize.setWidth(availableWidth);
-		}
-	}
-	item->setSizeHint(bubbleSize);
-	QString convId = conversationId.isEmpty() ? m_currentConversationId : conversationId;
-	if (convId.isEmpty())
-	{
-		return;
-	}
-	auto convIt = sessionMap().find(convId);
-	if (convIt == sessionMap().end())
-	{
-		return;
-	}
-	const QString bubbleId = bubble->getBubbleID();
-	if (bubbleId.isEmpty())
+	if (!bubble)
 	{
 		return;
 	}
-	for (auto& msg : convIt->sMsg)
-	{
-		if (msg.m_BubbleID == bubbleId)
-		{
-			msg.m_AllSize = bubbleSize;
-			break;
-		}
-	}
+	// 尺寸写回消息的排版缓存，并更新视图行高
+	ui.ChatShow->getChatFrame()->updateBubbleSize(bubble);
 }
-void Frm_AIAssit::finalizeLatestBubble(LLMChatFrame* bubble, QListWidgetItem* item, const QString& dialogName,
+void Frm_AIAssit::finalizeLatestBubble(LLMChatFrame* bubble, const QString& dialogName,
 	const QString& answerHtml, const QString& reasoningHtml, bool markStreamCompleted)
 {
-	if (!bubble || !item)
+	if (!bubble)
 	{
 		return;
 	}
@@ -1470,74 +1606,76 @@ void Frm_AIAssit::finalizeLatestBubble(LLMChatFrame* bubble, QListWidgetItem* it
 	{
 		bubble->ChangeStream();
 	}
-	refreshBubbleSize(bubble, item);
-			PushBtnChanged(SendButtonState::Ready);
+	updateSendButton();
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	chatFrame->setPinnedRow(-1);
 	const QString bubbleId = bubble->getBubbleID();
 	if (bubbleId.isEmpty())
 	{
+		refreshBubbleSize(bubble);
 		return;
 	}
 	sSingleMsg singleMsg(answerHtml,
 		QString::number(QDateTime::currentDateTime().toTime_t()),
-		bubble->getSize(),
 		LLMChatFrame::User_Customer,
 		dialogName,
 		reasoningHtml,
 		bubbleId,
 		bubble->isImportant(),
 		bubble->userNote());
+	// 占位消息在创建气泡时已写入对话，这里按ID替换
+	ChatTranscriptModel* model = chatFrame->transcriptModel();
+	const int existingIndex = model->rowForBubble(bubbleId);
+	if (existingIndex >= 0) {
+		*model->message(existingIndex) = singleMsg;
+		model->messageChanged(existingIndex);
+	}
+	else {
+		model->appendMessage(singleMsg);
+	}
+	refreshBubbleSize(bubble);
 	if (ChatSession* session = currentSession()) {
-		const int existingIndex = session->GetMsgIndex(bubbleId);
-		if (existingIndex >= 0 && existingIndex < session->sMsg.size()) {
-			session->sMsg[existingIndex] = singleMsg;
-		}
-		else {
-			session->sMsg.append(singleMsg);
-		}
 		session->SaveTime = QDateTime::currentDateTime();
+		m_chatSessionService->recordMessage(m_currentConversationId, bubbleId);
 		
 		// 如果这是最后一条消息，更新对话列表的显示名称
 		if (!session->sMsg.isEmpty() && session->sMsg.last().m_BubbleID == bubbleId) {
 			ui.ChatListWidget->setCurrentItemText(dialogName);
 		}
 	}
-	m_lastRequestUsedStream = false;
 }
 
-void Frm_AIAssit::finalizeCancelledResponse()
+void Frm_AIAssit::finalizeCancelledResponse(quint64 requestId)
 {
-	auto resetState = [this]()
+	auto pendingIt = m_pendingAnswers.find(requestId);
+	if (pendingIt == m_pendingAnswers.end())
 	{
-		m_pendingStreamChunk.clear();
-		PushBtnChanged(SendButtonState::Ready);
-	};
-
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	if (!chatFrame || chatFrame->count() == 0)
-	{
-		resetState();
 		return;
 	}
+	const PendingAnswer pending = pendingIt.value();
+	m_pendingAnswers.erase(pendingIt);
 
-	QListWidgetItem* latestItem = chatFrame->item(chatFrame->count() - 1);
-	if (!latestItem)
-	{
-		resetState();
-		return;
-	}
-
-	LLMChatFrame* latestWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(latestItem));
+	LLMChatFrame* latestWidget = liveBubble(pending);
 	if (!latestWidget)
 	{
-		resetState();
+		QString answer;
+		QString reasoning;
+		splitPendingText(pending, answer, reasoning);
+		if (answer.trimmed().isEmpty() && reasoning.trimmed().isEmpty())
+		{
+			answer = tr("Response cancelled by user.");
+		}
+		finalizeDetachedAnswer(pending, buildDialogName(answer), answer, reasoning);
+		updateSendButton();
 		return;
 	}
 
-	if (!m_pendingStreamChunk.isEmpty())
+	latestWidget->appendReasoning(pending.pendingReasoning);
+	if (!pending.pendingChunk.isEmpty())
 	{
-		latestWidget->appendText(m_pendingStreamChunk);
+		latestWidget->appendText(pending.pendingChunk);
 	}
-	m_pendingStreamChunk.clear();
+	latestWidget->finishText();
 
 	const bool hasReasoning = !latestWidget->getReasonRawText().trimmed().isEmpty();
 	const bool hasAnswer = !latestWidget->getRawText().trimmed().isEmpty();
@@ -1546,61 +1684,19 @@ void Frm_AIAssit::finalizeCancelledResponse()
 		latestWidget->appendText(tr("Response cancelled by user."));
 	}
 
-	if (!latestWidget->getReasonRawText().trimmed().isEmpty())
-	{
-		latestWidget->fontRect(latestWidget->getReasonRawText(), latestWidget->getRawText());
-	}
-	else
-	{
-		latestWidget->fontRect(latestWidget->getRawText());
-	}
+	latestWidget->refreshStreamingLayout();
 
 	QString dialogName = updateDialogName(latestWidget->getRawText());
-	finalizeLatestBubble(latestWidget, latestItem, dialogName,
-		latestWidget->getRawText(), latestWidget->getReasonRawText(), m_lastRequestUsedStream);
-}
-void Frm_AIAssit::recalculateVisibleBubbles()
-{
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	if (!chatFrame) return;
-	// 获取可见区域
-	QRect viewport = chatFrame->viewport()->rect();
-	for (int i = 0; i < chatFrame->count(); ++i)
-	{
-		QListWidgetItem* item = chatFrame->item(i);
-		QRect itemRect = chatFrame->visualItemRect(item);
-		// 只处理可见的项
-		if (!viewport.intersects(itemRect))
-		{
-			continue;
-		}
-		LLMChatFrame* bubbleWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(item));
-		if (bubbleWidget && bubbleWidget->isSending())
-		{
-			int availableWidth = chatFrame->viewport()->width();
-			bubbleWidget->resize(availableWidth, bubbleWidget->height());
-			refreshBubbleSize(bubbleWidget, item);
-		}
-	}
-	chatFrame->update();
+	finalizeLatestBubble(latestWidget, dialogName,
+		latestWidget->getRawText(), latestWidget->getReasonRawText(), pending.stream);
 }
 void Frm_AIAssit::recalculateAllChatBubbles()
 {
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
 	if (!chatFrame || chatFrame->count() == 0) return;
-	// 批量处理
-	chatFrame->setUpdatesEnabled(false);
-	int availableWidth = chatFrame->viewport()->width();
-	for (int i = 0; i < chatFrame->count(); ++i)
-	{
-		QListWidgetItem* item = chatFrame->item(i);
-		LLMChatFrame* bubbleWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(item));
-		if (!bubbleWidget) continue;
-		bubbleWidget->resize(availableWidth, bubbleWidget->height());
-		refreshBubbleSize(bubbleWidget, item);
-	}
-	chatFrame->setUpdatesEnabled(true);
-	chatFrame->update();
+	// 未绑定的行在宽度变化后自动改用估算高度，滚动到可见时再实测
+	chatFrame->relayoutBubbles();
+	chatFrame->viewport()->update();
 }
 void Frm_AIAssit::setLLMClient(AIProvider platform)
 {
@@ -1632,17 +1728,13 @@ void Frm_AIAssit::onBubbleNoteChanged(const QString& bubbleId, const QString& no
 	{
 		return;
 	}
-	if (ChatSession* session = currentSession())
+	ChatSession* session = currentSession();
+	const int index = session ? session->messageIndex(bubbleId) : -1;
+	if (index >= 0)
 	{
-		for (auto& msg : session->sMsg)
-		{
-			if (msg.m_BubbleID == bubbleId)
-			{
-				msg.m_Note = note;
-				session->SaveTime = QDateTime::currentDateTime();
-				break;
-			}
-		}
+		session->sMsg[index].m_Note = note;
+		session->SaveTime = QDateTime::currentDateTime();
+		m_chatSessionService->recordAnnotation(m_currentConversationId, bubbleId);
 	}
 }
 
@@ -1653,44 +1745,19 @@ void Frm_AIAssit::onBubbleCollapsedToggled(const QString& bubbleId, bool isColla
 		return;
 	}
 	
-	// 找到对应的列表项并更新大小
-	QListWidget* chatFrame = ui.ChatShow->getChatFrame();
-	if (!chatFrame)
+	// 只有已绑定的气泡才能切换折叠状态
+	ChatTranscriptView* chatFrame = ui.ChatShow->getChatFrame();
+	LLMChatFrame* bubbleWidget = chatFrame ? chatFrame->bubbleForId(bubbleId) : nullptr;
+	if (!bubbleWidget)
 	{
 		return;
 	}
-	
-	// 遍历所有列表项，找到对应的气泡
-	for (int i = 0; i < chatFrame->count(); ++i)
+	// 重新计算布局以获取新的大小（refreshLayoutAfterContentChange 已经在 setCollapsed 中调用）
+	// 这里只需要更新行高，尺寸会同步写回会话数据
+	refreshBubbleSize(bubbleWidget);
+	if (ChatSession* session = currentSession())
 	{
-		QListWidgetItem* item = chatFrame->item(i);
-		if (!item)
-		{
-			continue;
-		}
-		
-		LLMChatFrame* bubbleWidget = qobject_cast<LLMChatFrame*>(chatFrame->itemWidget(item));
-		if (bubbleWidget && bubbleWidget->getBubbleID() == bubbleId)
-		{
-			// 重新计算布局以获取新的大小（refreshLayoutAfterContentChange 已经在 setCollapsed 中调用）
-			// 这里只需要更新列表项的大小
-			refreshBubbleSize(bubbleWidget, item);
-			
-			// 更新会话数据中的大小
-			if (ChatSession* session = currentSession())
-			{
-				for (auto& msg : session->sMsg)
-				{
-					if (msg.m_BubbleID == bubbleId)
-					{
-						msg.m_AllSize = bubbleWidget->getSize();
-						session->SaveTime = QDateTime::currentDateTime();
-						break;
-					}
-				}
-			}
-			break;
-		}
+		session->SaveTime = QDateTime::currentDateTime();
 	}
 }
 
@@ -1700,39 +1767,37 @@ void Frm_AIAssit::onBubbleImportantToggled(const QString& bubbleId, bool isImpor
 	{
 		return;
 	}
-	if (ChatSession* session = currentSession())
+	ChatSession* session = currentSession();
+	const int index = session ? session->messageIndex(bubbleId) : -1;
+	if (index >= 0)
 	{
-		for (auto& msg : session->sMsg)
-		{
-			if (msg.m_BubbleID == bubbleId)
-			{
-				msg.m_IsImportant = isImportant;
-				session->SaveTime = QDateTime::currentDateTime();
-				break;
-			}
-		}
+		session->sMsg[index].m_IsImportant = isImportant;
+		session->SaveTime = QDateTime::currentDateTime();
+		m_chatSessionService->recordAnnotation(m_currentConversationId, bubbleId);
 	}
 }
 
 void Frm_AIAssit::onUserCancelRequested()
 {
+	// 只取消当前会话的请求，其他会话的回答继续接收
 	if (LLMClient)
 	{
-		LLMClient->cancelCurrentRequest();
+		LLMClient->cancelSessionRequests(m_currentConversationId);
 	}
 
-	if (m_streamDebounceTimer)
+	QList<quint64> cancelled;
+	for (auto it = m_pendingAnswers.constBegin(); it != m_pendingAnswers.constEnd(); ++it)
 	{
-		m_streamDebounceTimer->stop();
+		if (it->conversationId == m_currentConversationId)
+		{
+			cancelled.append(it.key());
+		}
 	}
-
-	if (m_lastRequestUsedStream)
+	for (quint64 requestId : cancelled)
 	{
-		m_skipNextStreamFinalize = true;
+		finalizeCancelledResponse(requestId);
 	}
-
-	finalizeCancelledResponse();
-	m_lastRequestUsedStream = false;
+	updateSendButton();
 }
 
 void Frm_AIAssit::onConnectionCheckFailed(const QString& errorMessage)
@@ -2160,6 +2225,11 @@ QString Frm_AIAssit::buildConversationPlainText(const ChatSession& session) cons
 }
 
 void Frm_AIAssit::attachToClient(MessageManager* client) {
+	// 旧客户端销毁时已中止其请求，新客户端的请求ID重新编号
+	const QList<quint64> orphaned = m_pendingAnswers.keys();
+	for (quint64 requestId : orphaned) {
+		finalizeCancelledResponse(requestId);
+	}
 	LLMClient = client;
 	if (LLMClient) {
 		setupLLMClientSignals();
@@ -8,6 +8,7 @@
 #include <memory> 
 #include <QVector>
 #include <QPointer>
+#include <QHash>
 #include <QListWidgetItem>
 #include "LLMParams.h"
 #include "ui_Frm_AIAssit.h" 
@@ -15,6 +16,8 @@
 #include "ChatInputWidget.h"
 #include "ChatSessionTypes.h"
 #include "CommonTypes.h"
+#include "ChatContextBuilder.h"
+#include "NetworkWorker.h"
 
 // 前向声明：使用指针/引用/unique_ptr 时只需要前向声明
 class LLMFunctionCall;
@@ -23,6 +26,7 @@ class AppConfigRepository;
 class ChatSessionService;
 class LLMClientManager;
 class AIParamWidget;
+class StreamRenderScheduler;
 class QDialog;
 class Frm_AIAssit : public QWidget
 {
@@ -36,9 +40,11 @@ public:
 	void SetLLMCommandFunction(std::function<QString(QString)> function);
 	public slots:
 	// 显示服务器返回的答案 
-	void getAnswerShow(const QString& word, bool bError);
+	void getAnswerShow(quint64 requestId, const QString& word, bool bError);
 	//显示服务器流式数据
-	void getStreamAnswerShow(const QString& word);
+	void getStreamAnswerShow(quint64 requestId, const QString& word);
+	// 按类别处理流式增量：推理直接进入推理区域，正文仍按推理标记分流
+	void onStreamDelta(quint64 requestId, const StreamDelta& delta);
 	//获取最新的提问内容
 	void AskQuestionAgain(QString msg);
 protected:
@@ -54,10 +60,8 @@ protected:
 	//信息格式转换
 	QJsonObject parseJsonReplyToMsg(const QByteArray &data, bool isStream = false);
 	//流式数据结束处理
-	void getStreamAnswerEnd();
+	void getStreamAnswerEnd(quint64 requestId);
 private:
-	// 初始化函数 
-	void recalculateVisibleBubbles();
 	//UI初始化
 	void initUI();
 	// 应用响应式布局
@@ -90,18 +94,20 @@ private:
 	//侧边栏
 	void toggleSidebar();
 	//添加气泡聊天框
-	void addChatBubble(const QString& text, bool bIsUser);
+	QString addChatBubble(const QString& text, bool bIsUser);
 	//重新计算所有对话气泡
 	void recalculateAllChatBubbles();
 	// 刷新气泡大小
-	void refreshBubbleSize(LLMChatFrame* bubble, QListWidgetItem* item, const QString& conversationId = QString());
+	void refreshBubbleSize(LLMChatFrame* bubble);
 	// 完成最新气泡的最终化处理
-	void finalizeLatestBubble(LLMChatFrame* bubble, QListWidgetItem* item, const QString& dialogName,
+	void finalizeLatestBubble(LLMChatFrame* bubble, const QString& dialogName,
 		const QString& answerHtml, const QString& reasoningHtml, bool markStreamCompleted);
 	// 处理取消生成后的气泡
-	void finalizeCancelledResponse();
+	void finalizeCancelledResponse(quint64 requestId);
 	// 使用最新回答更新对话名
 	QString updateDialogName(const QString& dialogName);
+	// 根据回答文本生成对话名
+	QString buildDialogName(const QString& dialogName) const;
 	// 连接气泡信号
 	void attachBubbleSignals(LLMChatFrame* bubble);
 	// 气泡对象池
@@ -110,13 +116,47 @@ private:
 	void releaseAllBubbles();
 	void clearBubblePool();
 	// 发送消息到服务器 
-	int send(const ChatSendMessage& msg);
+	quint64 send(const ChatSendMessage& msg);
 	// 发送消息到流式服务器 
-	int StreamSend(const ChatSendMessage& msg);
+	quint64 StreamSend(const ChatSendMessage& msg);
 	//处理functioncall结果
-	void ProcessFunctionCall(QJsonObject FunctionMsg);
+	void ProcessFunctionCall(quint64 requestId, QJsonObject FunctionMsg);
 	//functioncall预处理
-	void preFuncall(QJsonObject& Content);
+	void preFuncall(quint64 requestId, QJsonObject& Content);
+	// 一次进行中的回答：绑定发起请求的会话和回答气泡，与当前显示的会话无关
+	struct PendingAnswer
+	{
+		QString conversationId;
+		QString bubbleId;
+		QString rawText;                // 已收到的全部流式文本
+		QString pendingChunk;           // 尚未刷新到气泡的文本
+		QString reasoningText;          // 推理通道收到的全部推理内容
+		QString pendingReasoning;       // 尚未刷新到气泡的推理内容
+		QPointer<LLMChatFrame> bubble;  // 发起时的实时气泡，切换会话后置空
+		bool stream = false;
+	};
+	// 登记新请求对应的回答气泡
+	void trackAnswer(quint64 requestId, const QString& bubbleId, bool stream);
+	// 回答仍显示在发起时的实时气泡中则返回该气泡
+	LLMChatFrame* liveBubble(const PendingAnswer& pending) const;
+	// 回答在所属会话中的消息
+	ChatMessageData* pendingMessage(const PendingAnswer& pending);
+	// 把缓存的流式文本刷新到各自的气泡
+	void flushPendingAnswers();
+	// 收到流式数据：标记会话已修改并请求刷新一帧
+	void streamDataArrived(const PendingAnswer& pending);
+	// 拆分回答：推理通道的内容在前，正文中标记出的推理在后
+	static void splitPendingText(const PendingAnswer& pending, QString& answer, QString& reasoning);
+	// 切换会话前把进行中的回答与实时气泡解绑
+	void detachPendingAnswers();
+	// 保存前把进行中的回答已收到的文本写回所属会话
+	void storePendingAnswers();
+	// 回答气泡不在视图中时，直接写回所属会话
+	void writeDetachedAnswer(const PendingAnswer& pending, const QString& answer, const QString& reasoning);
+	void finalizeDetachedAnswer(const PendingAnswer& pending, const QString& dialogName,
+		const QString& answer, const QString& reasoning);
+	// 按当前会话是否有进行中的回答更新发送按钮
+	void updateSendButton();
 	//设置LLM客户端
 	void setLLMClient(AIProvider platform);
 	//构建推荐问题气泡
@@ -134,21 +174,19 @@ private:
 	QString m_currentConversationId; // 当前激活的对话ID 
 	MessageManager* LLMClient = nullptr;
 	std::unique_ptr<LLMParams> params;
-	QTimer* m_resizeTimer = nullptr;
 	bool m_sidebarManuallyHidden = false;
 	bool m_sidebarCollapsedByResponsive = false;
 	QTimer* m_scrollTimer = nullptr; // UI性能优化：流式更新时的滚动定时器
-	QTimer* m_streamDebounceTimer = nullptr;
-	QString m_pendingStreamChunk;
+	StreamRenderScheduler* m_streamScheduler = nullptr;
+	QHash<quint64, PendingAnswer> m_pendingAnswers; // 请求ID -> 进行中的回答
 	std::unique_ptr<AppConfigRepository> m_configRepository;
 	std::unique_ptr<ChatSessionService> m_chatSessionService;
+	ChatContextBuilder m_contextBuilder; // 多轮对话历史选择
 	std::unique_ptr<LLMClientManager> m_clientManager;
 	QVector<QPointer<LLMChatFrame>> m_bubblePool;
 	QWidget* m_bubblePoolHost = nullptr;
 	static constexpr int kBubblePoolMaxSize = 64;
 	bool m_enableBubblePool = false;
-	bool m_lastRequestUsedStream = false;
-	bool m_skipNextStreamFinalize = false;
 	// 获取当前会话（非const版本）
 	ChatSession* currentSession();
 	// 获取当前会话（const版本）
@@ -173,9 +211,9 @@ signals:
 	//改变当前模型
 	void ChangeCurModel(int iModel);
 	// 发出答案信号 
-	void Answer(const QString& word, bool bError);
+	void Answer(quint64 requestId, const QString& word, bool bError);
 	//发出流式信号
-	void AnswerStream(const QString& word);
+	void AnswerStream(quint64 requestId, const QString& word);
 	private slots:
 	// 连接检查失败处理
 	void onConnectionCheckFailed(const QString& errorMessage);
@@ -1,4 +1,6 @@
 ﻿#include "LLMChatFrame.h"
+#include "BubbleChrome.h"
+#include "RenderCache.h"
 #include <QFontMetrics>
 #include <QPaintEvent>
 #include <QDateTime>
@@ -17,12 +19,14 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QTextStream>
+#include <QTimer>
 #include <QMessageBox>
 #include <QFileInfo>
 #include <QMimeData>
 #include <QInputDialog>
 #include <QDialog>
 #include <QTextEdit>
+#include <QTextCursor>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QtMath>
@@ -41,69 +45,27 @@ const QColor LLMChatFrame::ColorScheme::TIME_BACKGROUND(148, 163, 184, 60);
 const QColor LLMChatFrame::ColorScheme::SECTION_HEADER_TEXT(15, 23, 42, 210);
 namespace
 {
-	QPainterPath createBubblePath(const QRect& bubbleRect, const QRect& triangleRect, bool alignLeft, int radius)
+	// 接收完成后超过该长度的内容交给后台线程渲染，短消息直接在GUI线程构建
+	constexpr int kAsyncRenderThreshold = 2000;
+	// 占位文本的字号与最多绘制的字符数
+	constexpr int kPlaceholderPixelSize = 15;
+	constexpr int kPlaceholderChars = 1200;
+	// 折叠摘要只解析原文开头的字符数，不必为 100 字的摘要转换整段 Markdown
+	constexpr int kSummarySourceChars = 400;
+	// 导出/复制用HTML的渲染器编号，渲染规则修改后递增使缓存作废
+	constexpr quint32 kExportHtmlRenderer = 1;
+	// 悬停时的柔和阴影（原先由整个气泡上的 QGraphicsDropShadowEffect 实时模糊得到）
+	constexpr int kHoverShadowBlur = 14;
+	constexpr int kHoverShadowOffsetY = 6;
+	constexpr int kHoverShadowAlpha = 70;
+
+	void applyHoverShadow(BubbleChrome::Style& style)
 	{
-		QPainterPath path;
-		if (!bubbleRect.isValid())
-		{
-			return path;
-		}
-		QRectF rect = bubbleRect;
-		path.addRoundedRect(rect, radius, radius);
-		if (triangleRect.isValid())
-		{
-			QPainterPath tail;
-			double topOffset = triangleRect.height() * 0.25;
-			double bottomOffset = triangleRect.height() * 0.25;
-			if (alignLeft)
-			{
-				tail.moveTo(triangleRect.right(), triangleRect.top() + topOffset);
-				tail.lineTo(triangleRect.left(), triangleRect.center().y());
-				tail.lineTo(triangleRect.right(), triangleRect.bottom() - bottomOffset);
-			}
-			else
-			{
-				tail.moveTo(triangleRect.left(), triangleRect.top() + topOffset);
-				tail.lineTo(triangleRect.right(), triangleRect.center().y());
-				tail.lineTo(triangleRect.left(), triangleRect.bottom() - bottomOffset);
-			}
-			tail.closeSubpath();
-			path = path.united(tail);
-		}
-		return path;
-	}
-	void drawBubble(QPainter& painter, const QRect& rect, const QRect& triangleRect, bool alignLeft,
-		const QColor& fillColor, const QColor& borderColor, const QColor& shadowColor,
-		int radius, int shadowOffset)
-	{
-		if (!rect.isValid())
-		{
-			return;
-		}
-		QPainterPath path = createBubblePath(rect, triangleRect, alignLeft, radius);
-		if (path.isEmpty())
-		{
-			return;
-		}
-		if (shadowOffset > 0 && shadowColor.alpha() > 0)
-		{
-			painter.save();
-			painter.setRenderHint(QPainter::Antialiasing, true);
-			painter.setPen(Qt::NoPen);
-			painter.setBrush(shadowColor);
-			painter.drawPath(path.translated(shadowOffset, shadowOffset));
-			painter.restore();
-		}
-		painter.save();
-		painter.setRenderHint(QPainter::Antialiasing, true);
-		QLinearGradient gradient(rect.topLeft(), rect.bottomLeft());
-		gradient.setColorAt(0.0, fillColor.lighter(108));
-		gradient.setColorAt(1.0, fillColor);
-		painter.setBrush(gradient);
-		painter.setPen(QPen(borderColor, 1.2));
-		painter.drawPath(path);
-		painter.restore();
+		style.shadow.setAlpha(kHoverShadowAlpha);
+		style.shadowOffset = QPoint(0, kHoverShadowOffsetY);
+		style.blurRadius = kHoverShadowBlur;
 	}
+
 	QPixmap createAvatarPixmap(const QPixmap& source)
 	{
 		if (source.isNull())
@@ -129,10 +91,7 @@ namespace
 
 void LLMChatFrame::copyToClipboardPlain(bool reasoningSection)
 {
-	const QString html = (reasoningSection && !m_messageData.reasoningText.isEmpty())
-		? m_messageData.reasoningText
-		: m_messageData.msg;
-	const QString plainText = htmlToPlainText(html);
+	const QString plainText = m_documentBuilder.toPlainText(sectionMarkdown(reasoningSection));
 	if (plainText.isEmpty())
 	{
 		return;
@@ -147,16 +106,14 @@ void LLMChatFrame::copyToClipboardMarkdown(bool reasoningSection)
 {
 	const QString titleReasoning = tr("### Thinking");
 	const QString titleAnswer = tr("### Answer");
-	const QString html = (reasoningSection && !m_messageData.reasoningText.isEmpty())
-		? m_messageData.reasoningText
-		: m_messageData.msg;
-	const QString plainText = htmlToPlainText(html).trimmed();
-	if (plainText.isEmpty())
+	// 原文本身就是Markdown，无需再从HTML还原
+	const QString content = sectionMarkdown(reasoningSection).trimmed();
+	if (content.isEmpty())
 	{
 		return;
 	}
-	const QString heading = (reasoningSection && !m_messageData.reasoningText.isEmpty()) ? titleReasoning : titleAnswer;
-	const QString markdown = QStringLiteral("%1\n\n%2").arg(heading, plainText);
+	const QString heading = (reasoningSection && !m_messageData.rawReasoningMsg.isEmpty()) ? titleReasoning : titleAnswer;
+	const QString markdown = QStringLiteral("%1\n\n%2").arg(heading, content);
 	if (QClipboard* clipboard = QApplication::clipboard())
 	{
 		clipboard->setText(markdown);
@@ -165,9 +122,7 @@ void LLMChatFrame::copyToClipboardMarkdown(bool reasoningSection)
 
 void LLMChatFrame::copyToClipboardHtml(bool reasoningSection)
 {
-	const QString html = (reasoningSection && !m_messageData.reasoningText.isEmpty())
-		? m_messageData.reasoningText
-		: m_messageData.msg;
+	const QString html = markdownToHtml(sectionMarkdown(reasoningSection));
 	if (html.isEmpty())
 	{
 		return;
@@ -184,15 +139,15 @@ void LLMChatFrame::copyToClipboardHtml(bool reasoningSection)
 QString LLMChatFrame::buildPlainExport() const
 {
 	QStringList sections;
-	if (!m_messageData.reasoningText.isEmpty())
+	if (!m_messageData.rawReasoningMsg.isEmpty())
 	{
-		const QString reasoning = htmlToPlainText(m_messageData.reasoningText).trimmed();
+		const QString reasoning = m_documentBuilder.toPlainText(m_messageData.rawReasoningMsg).trimmed();
 		if (!reasoning.isEmpty())
 		{
 			sections << tr("### Thinking") << reasoning;
 		}
 	}
-	const QString answer = htmlToPlainText(m_messageData.msg).trimmed();
+	const QString answer = m_documentBuilder.toPlainText(m_messageData.rawMsg).trimmed();
 	if (!answer.isEmpty())
 	{
 		sections << tr("### Answer") << answer;
@@ -203,15 +158,15 @@ QString LLMChatFrame::buildPlainExport() const
 QString LLMChatFrame::buildMarkdownExport() const
 {
 	QStringList lines;
-	if (!m_messageData.reasoningText.isEmpty())
+	if (!m_messageData.rawReasoningMsg.isEmpty())
 	{
-		const QString reasoning = htmlToPlainText(m_messageData.reasoningText).trimmed();
+		const QString reasoning = m_messageData.rawReasoningMsg.trimmed();
 		if (!reasoning.isEmpty())
 		{
 			lines << tr("### Thinking") << QString() << reasoning << QString();
 		}
 	}
-	const QString answer = htmlToPlainText(m_messageData.msg).trimmed();
+	const QString answer = m_messageData.rawMsg.trimmed();
 	if (!answer.isEmpty())
 	{
 		lines << tr("### Answer") << QString() << answer;
@@ -225,17 +180,17 @@ QString LLMChatFrame::buildHtmlExport() const
 		? QStringLiteral("assistant")
 		: (m_UserType == User_Owner ? QStringLiteral("user") : QStringLiteral("system"));
 	QString reasoningSection;
-	if (!m_messageData.reasoningText.isEmpty())
+	if (!m_messageData.rawReasoningMsg.isEmpty())
 	{
 		reasoningSection = QStringLiteral(
 			"<section class=\"reasoning\">"
 			"<h3>%1</h3>%2"
-			"</section>").arg(tr("Thinking"), m_messageData.reasoningText);
+			"</section>").arg(tr("Thinking"), markdownToHtml(m_messageData.rawReasoningMsg));
 	}
 	QString answerSection = QStringLiteral(
 		"<section class=\"answer\">"
 		"<h3>%1</h3>%2"
-		"</section>").arg(tr("Answer"), m_messageData.msg);
+		"</section>").arg(tr("Answer"), markdownToHtml(m_messageData.rawMsg));
 
 static const QString kTemplate = QStringLiteral(
 	R"(<!DOCTYPE html>
@@ -299,15 +254,14 @@ void LLMChatFrame::setUserNote(const QString& note)
 void LLMChatFrame::refreshLayoutAfterContentChange()
 {
 	m_layoutCache.isValid = false;
-	m_docCache.invalidate(); // 使文档缓存失效
 	m_layoutDirty = true;
-	if (m_UserType == User_Customer && !m_messageData.reasoningText.trimmed().isEmpty())
+	if (m_UserType == User_Customer && !m_messageData.rawReasoningMsg.trimmed().isEmpty())
 	{
-		fontRect(m_messageData.reasoningText, m_messageData.msg);
+		fontRect(m_messageData.rawReasoningMsg, m_messageData.rawMsg);
 	}
 	else
 	{
-		fontRect(m_messageData.msg);
+		fontRect(m_messageData.rawMsg);
 	}
 	updateButtonsVisibility();
 	update();
@@ -656,17 +610,14 @@ LLMChatFrame::LLMChatFrame(QWidget *parent)
 	initRescource();
 	initTalkPic();
 	initButtons();
-	m_shadowEffect = new QGraphicsDropShadowEffect(this);
-	m_shadowEffect->setBlurRadius(28);
-	m_shadowEffect->setOffset(0, 12);
-	m_shadowEffect->setColor(QColor(15, 23, 42, 70));
-	m_shadowEffect->setEnabled(false);
-	setGraphicsEffect(m_shadowEffect);
 	setMouseTracking(true);
 	m_allowDeferredDelete = false;
 }
 LLMChatFrame::~LLMChatFrame()
 {
+	// 取消尚未完成的后台渲染，已排版的文档留给其它气泡复用
+	resetSection(m_docCache.answer);
+	resetSection(m_docCache.reasoning);
 }
 
 bool LLMChatFrame::event(QEvent* event)
@@ -807,6 +758,7 @@ void LLMChatFrame::initButtons()
 void LLMChatFrame::initRescource()
 {
 	m_syntaxHighlighter = std::make_unique<SyntaxHighlighter>();
+	m_documentBuilder.setHighlighter(m_syntaxHighlighter.get());
 	m_ui.icons.leftPix = std::make_unique<QPixmap>();
 	m_ui.icons.rightPix = std::make_unique<QPixmap>();
 	m_ui.loading.label = std::make_unique<QLabel>(this);
@@ -840,7 +792,7 @@ void LLMChatFrame::updateButtonsPosition()
 	const int buttonHeight = LayoutConstants::BUTTON_HEIGHT;
 	int currentX = buttonStartX;
 	// 设置"复制思考"按钮
-	if (!m_messageData.reasoningText.isEmpty())
+	if (!m_messageData.rawReasoningMsg.isEmpty())
 	{
 		m_ui.buttons.copyThinking->setGeometry(currentX, buttonY, buttonWidth, buttonHeight);
 		m_ui.buttons.copyThinking->show();
@@ -968,17 +920,13 @@ void LLMChatFrame::drawSectionHeader(QPainter& painter, const QRect& frameRect,
 void LLMChatFrame::onCopyThinkingClicked()
 {
 	QClipboard *clipboard = QApplication::clipboard();
-	QTextDocument doc;
-	doc.setHtml(m_messageData.reasoningText);
-	clipboard->setText(doc.toPlainText());
+	clipboard->setText(m_documentBuilder.toPlainText(m_messageData.rawReasoningMsg));
 	emit copyThinkingClicked();
 }
 void LLMChatFrame::onCopyAnswerClicked()
 {
 	QClipboard *clipboard = QApplication::clipboard();
-	QTextDocument doc;
-	doc.setHtml(m_messageData.msg);
-	clipboard->setText(doc.toPlainText());
+	clipboard->setText(m_documentBuilder.toPlainText(m_messageData.rawMsg));
 	emit copyAnswerClicked();
 }
 void LLMChatFrame::onRegenerateClicked()
@@ -993,7 +941,6 @@ void LLMChatFrame::setCollapsed(bool collapsed)
 		return;
 	}
 	m_messageData.isCollapsed = collapsed;
-	m_docCache.invalidate(); // 折叠状态改变，使文档缓存失效
 	refreshLayoutAfterContentChange();
 	if (!m_messageData.uniqueID.isEmpty())
 	{
@@ -1018,10 +965,8 @@ void LLMChatFrame::onReasoningCollapseToggleClicked()
 
 QString LLMChatFrame::getCollapsedSummary() const
 {
-	QString content = m_messageData.rawMsg.isEmpty() ? m_messageData.msg : m_messageData.rawMsg;
-	QTextDocument doc;
-	doc.setHtml(content);
-	QString plainText = doc.toPlainText();
+	const QString& markdown = m_messageData.rawMsg;
+	QString plainText = m_documentBuilder.toPlainText(markdown.left(kSummarySourceChars));
 	
 	// 获取前100个字符作为摘要
 	const int maxLength = 100;
@@ -1029,15 +974,17 @@ QString LLMChatFrame::getCollapsedSummary() const
 	{
 		return plainText.left(maxLength) + "...";
 	}
+	if (markdown.size() > kSummarySourceChars)
+	{
+		return plainText + "...";
+	}
 	return plainText;
 }
 
 QString LLMChatFrame::getReasoningCollapsedSummary() const
 {
-	QString content = m_messageData.rawReasoningMsg.isEmpty() ? m_messageData.reasoningText : m_messageData.rawReasoningMsg;
-	QTextDocument doc;
-	doc.setHtml(content);
-	QString plainText = doc.toPlainText();
+	const QString& markdown = m_messageData.rawReasoningMsg;
+	QString plainText = m_documentBuilder.toPlainText(markdown.left(kSummarySourceChars));
 	
 	// 获取前100个字符作为摘要
 	const int maxLength = 100;
@@ -1045,6 +992,10 @@ QString LLMChatFrame::getReasoningCollapsedSummary() const
 	{
 		return plainText.left(maxLength) + "...";
 	}
+	if (markdown.size() > kSummarySourceChars)
+	{
+		return plainText + "...";
+	}
 	return plainText;
 }
 
@@ -1055,7 +1006,11 @@ void LLMChatFrame::setReasoningCollapsed(bool collapsed)
 		return;
 	}
 	m_messageData.isReasoningCollapsed = collapsed;
-	m_docCache.invalidate(); // 折叠状态改变，使文档缓存失效
+	if (!collapsed)
+	{
+		// 用户展开时正在看这一段，不再延迟
+		m_state.reasoningDeferred = false;
+	}
 	refreshLayoutAfterContentChange();
 	if (!m_messageData.uniqueID.isEmpty())
 	{
@@ -1068,115 +1023,21 @@ void LLMChatFrame::toggleReasoningCollapsed()
 	setReasoningCollapsed(!m_messageData.isReasoningCollapsed);
 }
 
-QString LLMChatFrame::markdownToHtml(const QString &markdown)
+QString LLMChatFrame::markdownToHtml(const QString &markdown) const
 {
-	// 添加Markdown转换缓存以提高性能
-	static QHash<QString, QString> mdCache;
-	static const int MAX_CACHE_SIZE = 100;
-
-	// 检查缓存
-	auto it = mdCache.find(markdown);
-	if (it != mdCache.end()) {
-		return *it;
+	// 渲染缓存在进程内共享，键包含高亮主题；代码块原文随HTML一起缓存
+	const quint32 renderer = kExportHtmlRenderer ^ SyntaxHighlighter::themeHash(m_syntaxHighlighter->getTheme());
+	const quint64 key = RenderCache::key(markdown, renderer);
+	RenderCacheEntry entry;
+	if (RenderCache::instance().find(key, entry)) {
+		return entry.html;
 	}
 
-	// 如果缓存过大，清除一半
-	if (mdCache.size() >= MAX_CACHE_SIZE) {
-		// 清除较旧的缓存项（简单的策略：清除一半）
-		QHash<QString, QString> newCache;
-		int count = 0;
-		for (auto it = mdCache.begin(); it != mdCache.end(); ++it) {
-			if (count++ % 2 == 0) {
-				newCache.insert(it.key(), it.value());
-			}
-		}
-		mdCache = newCache;
-	}
-
-	QByteArray markdownData = markdown.toUtf8();
-	char *html = cmark_markdown_to_html(markdownData.data(), markdownData.size(), CMARK_OPT_DEFAULT);
-	QString htmlString = QString::fromUtf8(html);
-	//	free(html);  // 释放cmark分配的内存
-
-	// 使用 SyntaxHighlighter 处理代码块
-	static const QRegularExpression codeBlockRegex(
-		"<pre><code(?:\\s+class=\"language-([^\"]*)\")?(.*?)>(.*?)</code></pre>",
-		QRegularExpression::DotMatchesEverythingOption);
-	QRegularExpressionMatchIterator iterator = codeBlockRegex.globalMatch(htmlString);
-	QString result = htmlString;
-	// 从后往前替换，避免位置偏移
-	QList<QRegularExpressionMatch> matches;
-	while (iterator.hasNext())
-	{
-		matches.prepend(iterator.next());
-	}
-	for (const auto& match : matches)
-	{
-		QString language = match.captured(1).toLower(); // 语言标识
-		QString code = match.captured(3);               // 代码内容
-														// HTML解码
-		code = code.replace("&lt;", "<").replace("&gt;", ">").replace("&amp;", "&");
-		// 使用语法高亮器生成高亮后的HTML
-		QString highlightedHtml = m_syntaxHighlighter->highlightCodeBlock(code, language);
-		// 从高亮后的HTML中提取代码块ID并保存代码内容
-		static const QRegularExpression idRegex("codeblock://copy\\?id=([^\"]+)");
-		QRegularExpressionMatch idMatch = idRegex.match(highlightedHtml);
-		if (idMatch.hasMatch())
-		{
-			QString codeBlockId = idMatch.captured(1);
-			m_codeBlockMap[codeBlockId] = code;
-		}
-		result.replace(match.captured(0), highlightedHtml);
-	}
-	// 处理行内代码
-	static const QRegularExpression inlineCodeRegex("<code>(.*?)</code>");
-	QRegularExpressionMatchIterator inlineIterator = inlineCodeRegex.globalMatch(result);
-	QList<QRegularExpressionMatch> inlineMatches;
-	while (inlineIterator.hasNext())
-	{
-		inlineMatches.prepend(inlineIterator.next());
-	}
-	for (const auto& match : inlineMatches)
-	{
-		QString code = match.captured(1);
-		QString highlightedInline = m_syntaxHighlighter->highlightInlineCode(code);
-		result.replace(match.captured(0), highlightedInline);
-	}
-
-	// 缓存结果
-	mdCache.insert(markdown, result);
-
-	return result;
-}
-void LLMChatFrame::setTextDocs(QTextDocument& docText, const QString& src, const int& iWidth, const QString& defaultColor)
-{
-	QString html = src;
-	const QString baseStyle = QStringLiteral(
-		"font-family:'Source Sans Pro','Microsoft YaHei','Segoe UI',sans-serif;"
-		"font-size:14.5px; line-height:1.7;"
-		);
-	if (!defaultColor.isEmpty())
-	{
-		html = QStringLiteral("<div style=\"color:%1;%2\">%3</div>")
-			.arg(defaultColor, baseStyle, src);
-	}
-	else
-	{
-		html = QStringLiteral("<div style=\"%1\">%2</div>")
-			.arg(baseStyle, src);
-	}
-	docText.setHtml(html);
-	QFont font("MicrosoftYaHei", 12);
-	docText.setDefaultFont(font);
-	QTextOption option(Qt::AlignLeft | Qt::AlignVCenter);
-	option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-	docText.setDefaultTextOption(option);
-	docText.setTextWidth(iWidth);
-	
-	// 性能优化：禁用不必要的功能以提升渲染速度
-	docText.setUndoRedoEnabled(false);
-	// 使用更快的渲染模式（如果可用）
-	docText.setUseDesignMetrics(false);
+	const QString htmlString = StreamingMarkdownRenderer::renderMarkdown(markdown);
+	// 使用 SyntaxHighlighter 处理代码块和行内代码
+	entry.html = m_syntaxHighlighter->highlightRenderedHtml(htmlString, &entry.codeBlocks);
+	RenderCache::instance().insert(key, entry);
+	return entry.html;
 }
 int LLMChatFrame::computeTimeExtraHeight() const
 {
@@ -1334,11 +1195,8 @@ void LLMChatFrame::layoutReasoningMessage(const QSize& reasoningSize, const QSiz
 }
 void LLMChatFrame::setText(QString text, QString time, QSize allSize, LLMChatFrame::User_Type userType)
 {
-	QString AnswerHtml = markdownToHtml(text);
-	m_messageData.msg = AnswerHtml;
-	m_messageData.rawMsg = AnswerHtml;
+	m_messageData.rawMsg = text;
 	m_messageData.rawReasoningMsg.clear();
-	m_messageData.reasoningText.clear();
 	m_messageData.isImportant = false;
 	m_messageData.userNote.clear();
 	applyNoteToolTip();
@@ -1361,9 +1219,7 @@ void LLMChatFrame::setText(QString text, QString time, QSize allSize, LLMChatFra
 }
 void LLMChatFrame::setTextWithReason(const QString& reasoning, const QString& answer, QString time, QSize allSize, User_Type userType)
 {
-	QString AnswerHtml = markdownToHtml(answer);
-	m_messageData.msg = AnswerHtml;
-	m_messageData.rawMsg = AnswerHtml;
+	m_messageData.rawMsg = answer;
 	m_UserType = userType;
 	m_messageData.time = time;
 	m_messageData.curTime = QDateTime::fromTime_t(time.toInt()).toString("hh:mm");
@@ -1373,9 +1229,9 @@ void LLMChatFrame::setTextWithReason(const QString& reasoning, const QString& an
 	applyNoteToolTip();
 	if (userType == User_Customer)
 	{
-		QString ReasoningHtml = markdownToHtml(reasoning);
-		m_messageData.rawReasoningMsg = ReasoningHtml;
-		m_messageData.reasoningText = ReasoningHtml;//只有回答者才区分
+		m_messageData.rawReasoningMsg = reasoning;//只有回答者才区分
+		// 推理内容往往比回答还长，先按估算尺寸排版，进入视口后再解析
+		m_state.reasoningDeferred = !reasoning.isEmpty();
 		if (!m_state.isSending)
 		{
 			m_ui.loading.label->move(m_layoutData.rects.frameLeft.x() - m_ui.loading.label->width() - 10,
@@ -1388,7 +1244,6 @@ void LLMChatFrame::setTextWithReason(const QString& reasoning, const QString& an
 	{
 		m_ui.loading.label->hide();
 		m_messageData.rawReasoningMsg.clear();
-		m_messageData.reasoningText.clear();
 	}
 	this->update();
 }
@@ -1402,13 +1257,14 @@ void LLMChatFrame::setTextSuccess()
 	m_layoutDirty = true;
 	if (m_UserType == User_Customer)
 	{
-		if (!m_messageData.reasoningText.isEmpty())
+		// 接收完成后尾部块也成为闭合块，此时才登记其中代码块的复制内容
+		if (!m_messageData.rawReasoningMsg.isEmpty())
 		{
-			fontRect(m_messageData.reasoningText, m_messageData.msg);
+			fontRect(m_messageData.rawReasoningMsg, m_messageData.rawMsg);
 		}
 		else
 		{
-			fontRect(m_messageData.msg);
+			fontRect(m_messageData.rawMsg);
 		}
 	}
 	updateButtonsVisibility();
@@ -1416,14 +1272,17 @@ void LLMChatFrame::setTextSuccess()
 }
 void LLMChatFrame::resetForReuse()
 {
-	// 清理代码块映射
-	m_codeBlockMap.clear();
+	m_answerRenderer.reset();
+	m_reasoningRenderer.reset();
+	m_thinkSplitter.reset();
 	// 恢复基础数据
 	m_messageData = MessageData();
 	m_layoutData = LayoutData();
 	m_state = StateFlags();
 	m_layoutCache = LayoutCache();
-	m_docCache.invalidate(); // 清除文档缓存
+	// 清除文档缓存（取消进行中的后台渲染）
+	resetSection(m_docCache.answer);
+	resetSection(m_docCache.reasoning);
 	m_UserType = User_System;
 	m_allowDeferredDelete = false;
 
@@ -1465,11 +1324,8 @@ void LLMChatFrame::resetForReuse()
 	// 清空辅助状态
 	m_SuggestButton.clear();
 
-	// 关掉阴影效果，等待重新布局时启用
-	if (m_shadowEffect)
-	{
-		m_shadowEffect->setEnabled(false);
-	}
+	m_isHovered = false;
+	setFastPaint(false);
 
 	setMinimumSize(QSize(0, 0));
 	update();
@@ -1480,6 +1336,30 @@ void LLMChatFrame::prepareForDeletion()
 	m_allowDeferredDelete = true;
 }
 
+void LLMChatFrame::setFastPaint(bool enabled)
+{
+	if (enabled == m_fastPaint)
+	{
+		return;
+	}
+	m_fastPaint = enabled;
+	if (!enabled)
+	{
+		m_fastSnapshot = QPixmap();
+		update();
+		return;
+	}
+	// 只渲染气泡自身（不含背景和子控件），按钮等子控件照常自己绘制
+	const qreal dpr = devicePixelRatioF();
+	QPixmap snapshot(size() * dpr);
+	snapshot.setDevicePixelRatio(dpr);
+	snapshot.fill(Qt::transparent);
+	m_fastPaint = false;
+	render(&snapshot, QPoint(), QRegion(), QWidget::RenderFlags());
+	m_fastPaint = true;
+	m_fastSnapshot = snapshot;
+}
+
 QSize LLMChatFrame::fontRect(const QString& str)
 {
 	if (str.isEmpty()) return QSize();
@@ -1497,12 +1377,15 @@ QSize LLMChatFrame::fontRect(const QString& str)
 		return m_layoutCache.cachedSize;
 	}
 
-	QString html = str.contains("</p>") ? str : markdownToHtml(str);
-	m_messageData.msg = html;
+	m_messageData.rawMsg = str;
+	return applySingleLayout();
+}
+QSize LLMChatFrame::applySingleLayout()
+{
+	int currentWidth = width();
 	calculateLayout();
-	// 如果折叠，使用摘要文本计算高度
-	QString contentForLayout = m_messageData.isCollapsed ? getCollapsedSummary() : m_messageData.msg;
-	QSize size = getRealString(contentForLayout);
+	// 文档会根据折叠状态使用摘要文本
+	QSize size = measureSection(false);
 	int timeExtraHeight = computeTimeExtraHeight();
 	int extraHeight = computeAdditionalHeight();
 	layoutSingleMessage(size, timeExtraHeight);
@@ -1511,7 +1394,7 @@ QSize LLMChatFrame::fontRect(const QString& str)
 
 	// 更新缓存
 	m_layoutCache.cachedSize = m_layoutData.allSize;
-	m_layoutCache.cachedText = str;
+	m_layoutCache.cachedText = m_messageData.rawMsg;
 	m_layoutCache.cachedWidth = currentWidth;
 	m_layoutCache.isValid = true;
 
@@ -1525,14 +1408,16 @@ QSize LLMChatFrame::fontRect(const QString& str)
 QSize LLMChatFrame::fontRect(const QString& reasoning, const QString& answer)
 {
 	if (reasoning.isEmpty() && answer.isEmpty()) return QSize();
-	m_messageData.reasoningText = reasoning.contains("</p>") ? reasoning : markdownToHtml(reasoning);
-	m_messageData.msg = answer.contains("</p>") ? answer : markdownToHtml(answer);
+	m_messageData.rawReasoningMsg = reasoning;
+	m_messageData.rawMsg = answer;
+	return applyReasoningLayout();
+}
+QSize LLMChatFrame::applyReasoningLayout()
+{
 	calculateLayout();
-	// 如果折叠，使用摘要文本计算高度
-	QString answerForLayout = m_messageData.isCollapsed ? getCollapsedSummary() : m_messageData.msg;
-	QString reasoningForLayout = m_messageData.isReasoningCollapsed ? getReasoningCollapsedSummary() : m_messageData.reasoningText;
-	QSize answerSize = getRealString(answerForLayout);
-	QSize reasoningSize = getRealString(reasoningForLayout);
+	// 文档会根据折叠状态使用摘要文本
+	QSize answerSize = measureSection(false);
+	QSize reasoningSize = measureSection(true);
 	int timeExtraHeight = computeTimeExtraHeight();
 	int extraHeight = computeAdditionalHeight();
 	layoutReasoningMessage(reasoningSize, answerSize, timeExtraHeight);
@@ -1554,39 +1439,320 @@ QSize LLMChatFrame::fontRect(const QString& reasoning, const QString& answer)
 	}
 	return m_layoutData.allSize;
 }
-QSize LLMChatFrame::getRealString(QString src)
+QSize LLMChatFrame::refreshStreamingLayout()
+{
+	syncStreamRenderers();
+	if (m_reasoningRenderer.isEmpty() && m_answerRenderer.isEmpty()) return QSize();
+	if (!m_messageData.rawReasoningMsg.trimmed().isEmpty())
+	{
+		return applyReasoningLayout();
+	}
+	return applySingleLayout();
+}
+void LLMChatFrame::syncStreamRenderers()
+{
+	// 渲染器只跟随 appendText 增长，原始文本被 setText 等接口替换后需要整体重建
+	if (m_answerRenderer.markdown().size() != m_messageData.rawMsg.size())
+	{
+		m_answerRenderer.reset();
+		m_answerRenderer.append(m_messageData.rawMsg);
+	}
+	if (m_reasoningRenderer.markdown().size() != m_messageData.rawReasoningMsg.size())
+	{
+		m_reasoningRenderer.reset();
+		m_reasoningRenderer.append(m_messageData.rawReasoningMsg);
+	}
+}
+const QString& LLMChatFrame::sectionMarkdown(bool reasoningSection) const
+{
+	return (reasoningSection && !m_messageData.rawReasoningMsg.isEmpty())
+		? m_messageData.rawReasoningMsg
+		: m_messageData.rawMsg;
+}
+QColor LLMChatFrame::sectionTextColor() const
+{
+	return (m_UserType == User_Owner) ? QColor(248, 250, 252) : QColor(15, 23, 42);
+}
+QTextDocument* LLMChatFrame::sectionDocument(bool reasoning)
+{
+	SectionDocument& section = reasoning ? m_docCache.reasoning : m_docCache.answer;
+	const QString& markdown = reasoning ? m_messageData.rawReasoningMsg : m_messageData.rawMsg;
+	const bool collapsed = reasoning ? m_messageData.isReasoningCollapsed : m_messageData.isCollapsed;
+	const QColor textColor = sectionTextColor();
+	if ((section.doc || section.pendingTicket) && (section.collapsed != collapsed || section.textColor != textColor))
+	{
+		resetSection(section);
+	}
+
+	if (collapsed)
+	{
+		if (!section.doc)
+		{
+			section.doc = std::make_unique<QTextDocument>();
+			section.collapsed = true;
+			section.textColor = textColor;
+			section.source.clear();
+			if (m_layoutData.iTextWidth > 0)
+			{
+				section.doc->setTextWidth(m_layoutData.iTextWidth);
+			}
+		}
+		// 折叠时只显示摘要，原文变化后才重新生成
+		if (section.source != markdown || section.doc->isEmpty())
+		{
+			const QString summary = reasoning ? getReasoningCollapsedSummary() : getCollapsedSummary();
+			section.doc->clear();
+			MarkdownDocumentBuilder::prepareDocument(*section.doc);
+			QTextCursor cursor(section.doc.get());
+			QTextCharFormat format;
+			format.setForeground(textColor);
+			cursor.insertText(summary, format);
+			section.source = markdown;
+			section.layoutWidth = -1;
+		}
+		return section.doc.get();
+	}
+
+	// 接收中只有流式渲染器判定为闭合的块是稳定的；接收完成后整段都是稳定的
+	const StreamingMarkdownRenderer& renderer = reasoning ? m_reasoningRenderer : m_answerRenderer;
+	const int stableEnd = (!m_state.isSending && renderer.markdown() == markdown)
+		? renderer.stableLength() : markdown.size();
+	if (section.doc && section.source == markdown && section.stableSourceEnd == stableEnd)
+	{
+		return section.doc.get();
+	}
+	if (section.pendingTicket && section.pendingSource == markdown)
+	{
+		return nullptr;
+	}
+
+	// 已接收完成且无法沿用已写入的闭合块（历史消息、被整体替换的内容）时，整段交给后台渲染
+	const bool canAppend = section.doc && section.stableSourceEnd > 0 && section.stableSourceEnd <= stableEnd
+		&& markdown.leftRef(section.stableSourceEnd) == section.source.leftRef(section.stableSourceEnd);
+	if (!canAppend && stableEnd == markdown.size() && markdown.size() >= kAsyncRenderThreshold
+		&& m_layoutData.iTextWidth > 0)
+	{
+		return requestSectionRender(section, reasoning, markdown);
+	}
+
+	if (section.pendingTicket)
+	{
+		BubbleRenderService::instance().cancel(section.pendingTicket);
+		section.pendingTicket = 0;
+		section.pendingSource.clear();
+	}
+	if (!section.doc)
+	{
+		section.doc = std::make_unique<QTextDocument>();
+		MarkdownDocumentBuilder::prepareDocument(*section.doc);
+		section.collapsed = false;
+		section.textColor = textColor;
+		if (m_layoutData.iTextWidth > 0)
+		{
+			section.doc->setTextWidth(m_layoutData.iTextWidth);
+		}
+	}
+	updateSectionDocument(section, markdown, stableEnd);
+	section.layoutWidth = -1;
+	return section.doc.get();
+}
+QTextDocument* LLMChatFrame::requestSectionRender(SectionDocument& section, bool reasoning, const QString& markdown)
+{
+	BubbleRenderRequest request;
+	request.markdown = markdown;
+	request.width = m_layoutData.iTextWidth;
+	request.textColor = sectionTextColor();
+	request.theme = m_syntaxHighlighter->getTheme();
+
+	// 旧文档归还缓存，随后可能被其它气泡复用
+	resetSection(section);
+	section.collapsed = false;
+	section.textColor = request.textColor;
+
+	BubbleRenderService& service = BubbleRenderService::instance();
+	BubbleRenderResult cached;
+	if (service.takeCached(request, cached))
+	{
+		installSectionResult(section, cached);
+		return section.doc.get();
+	}
+	section.pendingSource = markdown;
+	section.pendingTicket = service.submit(request, this, [this, reasoning](BubbleRenderResult& result)
+	{
+		onSectionRendered(reasoning, result);
+	});
+	return nullptr;
+}
+void LLMChatFrame::onSectionRendered(bool reasoning, BubbleRenderResult& result)
+{
+	SectionDocument& section = reasoning ? m_docCache.reasoning : m_docCache.answer;
+	if (!section.pendingTicket || section.pendingSource != result.request.markdown)
+	{
+		return;
+	}
+	installSectionResult(section, result);
+	refreshLayoutAfterContentChange();
+	emit contentRendered();
+}
+void LLMChatFrame::installSectionResult(SectionDocument& section, BubbleRenderResult& result)
+{
+	section.doc = std::move(result.document);
+	section.source = result.request.markdown;
+	section.textColor = result.request.textColor;
+	section.collapsed = false;
+	section.stableSourceEnd = section.source.size();
+	section.stableDocEnd = section.doc->characterCount() - 1;
+	section.codeBlocks = result.codeBlocks;
+	section.layoutWidth = result.request.width;
+	section.layoutSize = result.size;
+	section.pendingTicket = 0;
+	section.pendingSource.clear();
+}
+void LLMChatFrame::resetSection(SectionDocument& section)
+{
+	BubbleRenderService& service = BubbleRenderService::instance();
+	if (section.pendingTicket)
+	{
+		service.cancel(section.pendingTicket);
+	}
+	// 只有完整排版过的文档可以按 (原文, 宽度, 颜色, 主题) 复用
+	if (section.doc && m_syntaxHighlighter && !section.collapsed && section.layoutWidth > 0
+		&& !section.source.isEmpty() && section.stableSourceEnd == section.source.size())
+	{
+		BubbleRenderResult result;
+		result.request.markdown = section.source;
+		result.request.width = section.layoutWidth;
+		result.request.textColor = section.textColor;
+		result.request.theme = m_syntaxHighlighter->getTheme();
+		result.document = std::move(section.doc);
+		result.size = section.layoutSize;
+		result.codeBlocks = section.codeBlocks;
+		service.recycle(std::move(result));
+	}
+	section.reset();
+}
+void LLMChatFrame::updateSectionDocument(SectionDocument& section, const QString& markdown, int stableEnd)
+{
+	QTextDocument& doc = *section.doc;
+	const bool keepStable = section.stableSourceEnd > 0 && section.stableSourceEnd <= stableEnd
+		&& markdown.leftRef(section.stableSourceEnd) == section.source.leftRef(section.stableSourceEnd);
+	if (keepStable)
+	{
+		// 只删除上次写入的尾部块
+		QTextCursor cursor(&doc);
+		cursor.setPosition(section.stableDocEnd);
+		cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+		cursor.removeSelectedText();
+	}
+	else
+	{
+		doc.clear();
+		MarkdownDocumentBuilder::prepareDocument(doc);
+		section.stableSourceEnd = 0;
+		section.stableDocEnd = 0;
+		section.codeBlocks.clear();
+	}
+
+	if (stableEnd > section.stableSourceEnd)
+	{
+		// 闭合块只写入一次，同时登记其中代码块的复制内容
+		m_documentBuilder.append(doc, markdown.mid(section.stableSourceEnd, stableEnd - section.stableSourceEnd),
+			section.textColor, &section.codeBlocks);
+		section.stableSourceEnd = stableEnd;
+		section.stableDocEnd = doc.characterCount() - 1;
+	}
+	if (stableEnd < markdown.size())
+	{
+		// 尾部块每次刷新都会重建，不登记代码块避免映射无限增长
+		m_documentBuilder.append(doc, markdown.mid(stableEnd), section.textColor);
+	}
+	section.source = markdown;
+}
+QSize LLMChatFrame::measureSection(bool reasoning)
 {
 	QFontMetricsF fm(this->font());
 	m_layoutData.iLineHeight = fm.lineSpacing();
-	QRectF textRect = fm.boundingRect(QRectF(0, 0, m_layoutData.iTextWidth, 9999),
-		Qt::TextWordWrap, src);
-	int w = textRect.width();
-	int h = textRect.height();
 	// 加一点额外垂直间距，避免被切顶
 	const int extra = 80;
-	QTextDocument doc;
-	setTextDocs(doc, src, w);
-	QSize docSize = doc.size().toSize();
-	return QSize(w + m_layoutData.iSpaceWidth, docSize.height() + extra);
+	const int maxWidth = m_layoutData.iTextWidth;
+	if (reasoning && isReasoningDeferred())
+	{
+		const QSize estimate = estimateSectionSize(true, maxWidth);
+		return QSize(estimate.width() + m_layoutData.iSpaceWidth, estimate.height() + extra);
+	}
+	SectionDocument& section = reasoning ? m_docCache.reasoning : m_docCache.answer;
+	QTextDocument* doc = sectionDocument(reasoning);
+	if (!doc)
+	{
+		const QSize estimate = estimateSectionSize(reasoning, maxWidth);
+		return QSize(estimate.width() + m_layoutData.iSpaceWidth, estimate.height() + extra);
+	}
+	// 宽度与内容都未变化时沿用上次排版（短消息收缩到内容宽度）
+	if (section.layoutWidth != maxWidth || !section.layoutSize.isValid())
+	{
+		section.layoutSize = MarkdownDocumentBuilder::layoutDocument(*doc, qMax(0, maxWidth));
+		section.layoutWidth = maxWidth;
+	}
+	return QSize(section.layoutSize.width() + m_layoutData.iSpaceWidth, section.layoutSize.height() + extra);
 }
-QSize LLMChatFrame::getRealString(const QString& reasoning, const QString& answer)
+QSize LLMChatFrame::estimateSectionSize(bool reasoning, int width) const
 {
-	QFontMetricsF fm(this->font());
-	m_layoutData.iLineHeight = fm.lineSpacing();
-	QSize reasoningSize(0, 0);
-	QSize answerSize(0, 0);
-	if (!reasoning.isEmpty()) {
-		QRectF reasoningRect = fm.boundingRect(QRectF(0, 0, m_layoutData.iTextWidth, 9999), Qt::TextWordWrap, reasoning);
-		reasoningSize = QSize(reasoningRect.width(), reasoningRect.height());
+	const QString& markdown = reasoning ? m_messageData.rawReasoningMsg : m_messageData.rawMsg;
+	if (width <= 0 || markdown.isEmpty())
+	{
+		return QSize(0, 0);
+	}
+	QFont font(QStringLiteral("Microsoft YaHei"));
+	font.setPixelSize(kPlaceholderPixelSize);
+	const QFontMetrics fm(font);
+	const int narrowWidth = qMax(1, fm.averageCharWidth());
+	const int wideWidth = kPlaceholderPixelSize;
+	int lines = 0;
+	int lineWidth = 0;
+	int maxLineWidth = 0;
+	for (const QChar c : markdown)
+	{
+		if (c == QLatin1Char('\n'))
+		{
+			lines += 1 + lineWidth / width;
+			maxLineWidth = qMax(maxLineWidth, lineWidth);
+			lineWidth = 0;
+			continue;
+		}
+		lineWidth += c.unicode() < 0x80 ? narrowWidth : wideWidth;
 	}
-	if (!answer.isEmpty()) {
-		QRectF answerRect = fm.boundingRect(QRectF(0, 0, m_layoutData.iTextWidth, 9999), Qt::TextWordWrap, answer);
-		answerSize = QSize(answerRect.width(), answerRect.height());
+	lines += 1 + lineWidth / width;
+	maxLineWidth = qMax(maxLineWidth, lineWidth);
+	// 与文档的 170% 行高一致
+	return QSize(qMin(width, maxLineWidth), qCeil(lines * fm.height() * 1.7));
+}
+bool LLMChatFrame::isReasoningDeferred() const
+{
+	// 折叠时只显示摘要，构建摘要的开销很小，不需要延迟
+	return m_state.reasoningDeferred && !m_messageData.isReasoningCollapsed;
+}
+void LLMChatFrame::realizeDeferredReasoning()
+{
+	m_state.reasoningRealizeScheduled = false;
+	if (!m_state.reasoningDeferred)
+	{
+		return;
 	}
-	const int extra = 80; // 额外垂直间距
-	int w = qMax(reasoningSize.width(), answerSize.width()) + m_layoutData.iSpaceWidth;
-	int h = reasoningSize.height() + answerSize.height() + extra;
-	return QSize(w, h);
+	m_state.reasoningDeferred = false;
+	refreshLayoutAfterContentChange();
+	emit contentRendered();
+}
+void LLMChatFrame::drawSectionPlaceholder(QPainter& painter, const QRect& textRect, bool reasoning)
+{
+	const QString& markdown = reasoning ? m_messageData.rawReasoningMsg : m_messageData.rawMsg;
+	painter.save();
+	QFont font(QStringLiteral("Microsoft YaHei"));
+	font.setPixelSize(kPlaceholderPixelSize);
+	painter.setFont(font);
+	painter.setPen(sectionTextColor());
+	painter.setClipRect(textRect);
+	painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, markdown.left(kPlaceholderChars));
+	painter.restore();
 }
 void LLMChatFrame::calculateLayout()
 {
@@ -1620,72 +1786,43 @@ void LLMChatFrame::calculateLayout()
 
 void LLMChatFrame::appendText(const QString& delta)
 {
-	static const QString REASONING_START_MARKER = QStringLiteral("---REASONING_START---");
-	static const QString REASONING_END_MARKER = QStringLiteral("---REASONING_END---");
-	static const QString THINK_START_TAG = QStringLiteral("<think>");
-	static const QString THINK_END_TAG = QStringLiteral("</think>");
-
-	auto appendSegment = [this](const QString& segment)
+	// 正在接收的推理内容需要实时显示
+	m_state.reasoningDeferred = false;
+	m_thinkSplitter.feed(delta, [this](bool reasoning, const QStringRef& segment)
 	{
-		if (segment.isEmpty())
-		{
-			return;
-		}
-
-		if (m_state.isReasoning)
-		{
-			m_messageData.reasoningText += segment;
-			m_messageData.rawReasoningMsg += segment;
-		}
-		else
-		{
-			m_messageData.msg += segment;
-			m_messageData.rawMsg += segment;
-		}
-	};
+		appendSegment(reasoning, segment);
+	});
+}
 
-	QString remaining = delta;
-	while (!remaining.isEmpty())
+void LLMChatFrame::appendReasoning(const QString& delta)
+{
+	if (delta.isEmpty())
 	{
-		int nextIndex = -1;
-		QString nextMarker;
-
-		auto considerMarker = [&remaining, &nextIndex, &nextMarker](const QString& marker)
-		{
-			int idx = remaining.indexOf(marker);
-			if (idx != -1 && (nextIndex == -1 || idx < nextIndex))
-			{
-				nextIndex = idx;
-				nextMarker = marker;
-			}
-		};
-
-		considerMarker(REASONING_START_MARKER);
-		considerMarker(REASONING_END_MARKER);
-		considerMarker(THINK_START_TAG);
-		considerMarker(THINK_END_TAG);
-
-		if (nextIndex == -1)
-		{
-			appendSegment(remaining);
-			break;
-		}
-
-		if (nextIndex > 0)
-		{
-			appendSegment(remaining.left(nextIndex));
-		}
+		return;
+	}
+	m_state.reasoningDeferred = false;
+	appendSegment(true, QStringRef(&delta));
+}
 
-		if (nextMarker == REASONING_START_MARKER || nextMarker == THINK_START_TAG)
-		{
-			m_state.isReasoning = true;
-		}
-		else
-		{
-			m_state.isReasoning = false;
-		}
+void LLMChatFrame::finishText()
+{
+	m_thinkSplitter.finish([this](bool reasoning, const QStringRef& segment)
+	{
+		appendSegment(reasoning, segment);
+	});
+}
 
-		remaining = remaining.mid(nextIndex + nextMarker.length());
+void LLMChatFrame::appendSegment(bool reasoning, const QStringRef& segment)
+{
+	if (reasoning)
+	{
+		m_messageData.rawReasoningMsg.append(segment);
+		m_reasoningRenderer.append(segment);
+	}
+	else
+	{
+		m_messageData.rawMsg.append(segment);
+		m_answerRenderer.append(segment);
 	}
 }
 
@@ -1727,45 +1864,38 @@ void LLMChatFrame::drawTimeLabel(QPainter& painter)
 }
 void LLMChatFrame::drawCustomerMessage(QPainter& painter)
 {
-	painter.save();
-	painter.setRenderHint(QPainter::Antialiasing, true);
 	QRect iconRect = m_layoutData.rects.iconLeft;
 	QRect ringRect = iconRect.adjusted(-LayoutConstants::ICON_RING_MARGIN, -LayoutConstants::ICON_RING_MARGIN,
 		LayoutConstants::ICON_RING_MARGIN, LayoutConstants::ICON_RING_MARGIN);
-	QLinearGradient ringGradient(ringRect.topLeft(), ringRect.bottomLeft());
-	ringGradient.setColorAt(0.0, ColorScheme::ICON_RING_OUTER);
-	ringGradient.setColorAt(1.0, ColorScheme::ICON_RING_INNER);
-	painter.setPen(Qt::NoPen);
-	painter.setBrush(ringGradient);
-	painter.drawEllipse(ringRect);
+	BubbleChrome::drawRing(painter, ringRect, ColorScheme::ICON_RING_OUTER, ColorScheme::ICON_RING_INNER);
 	painter.drawPixmap(iconRect, *m_ui.icons.leftPix);
-	painter.restore();
-	QColor reasoningBackground = ColorScheme::REASONING_BACKGROUND;
-	QColor reasoningBorder = ColorScheme::REASONING_BORDER;
-	QColor answerBackground = ColorScheme::ANSWER_BACKGROUND;
-	QColor answerBorder = ColorScheme::ANSWER_BORDER;
-	QColor reasoningShadow = ColorScheme::SHADOW_COLOR;
-	QColor answerShadow = ColorScheme::SHADOW_COLOR;
+	BubbleChrome::Style reasoning;
+	reasoning.fill = ColorScheme::REASONING_BACKGROUND;
+	reasoning.border = ColorScheme::REASONING_BORDER;
+	reasoning.shadow = ColorScheme::SHADOW_COLOR;
+	reasoning.radius = LayoutConstants::BORDER_RADIUS;
+	reasoning.shadowOffset = QPoint(LayoutConstants::SHADOW_OFFSET / 2, LayoutConstants::SHADOW_OFFSET / 2);
+	BubbleChrome::Style answer;
+	answer.fill = ColorScheme::ANSWER_BACKGROUND;
+	answer.border = ColorScheme::ANSWER_BORDER;
+	answer.shadow = ColorScheme::SHADOW_COLOR;
+	answer.radius = LayoutConstants::BORDER_RADIUS;
+	answer.shadowOffset = QPoint(LayoutConstants::SHADOW_OFFSET, LayoutConstants::SHADOW_OFFSET);
 	if (m_isHovered)
 	{
-		reasoningBackground = reasoningBackground.lighter(108);
-		reasoningBorder = reasoningBorder.lighter(115);
-		answerBackground = answerBackground.lighter(107);
-		answerBorder = answerBorder.lighter(112);
-		reasoningShadow.setAlpha(qMin(255, reasoningShadow.alpha() + 40));
-		answerShadow.setAlpha(qMin(255, answerShadow.alpha() + 50));
+		reasoning.fill = reasoning.fill.lighter(108);
+		reasoning.border = reasoning.border.lighter(115);
+		reasoning.shadow.setAlpha(qMin(255, reasoning.shadow.alpha() + 40));
+		answer.fill = answer.fill.lighter(107);
+		answer.border = answer.border.lighter(112);
+		applyHoverShadow(answer);
 	}
 	else
 	{
-		reasoningShadow.setAlpha(qRound(reasoningShadow.alpha() * 0.7));
+		reasoning.shadow.setAlpha(qRound(reasoning.shadow.alpha() * 0.7));
 	}
-	drawBubble(painter, m_layoutData.rects.frameLeftReason, QRect(), true,
-		reasoningBackground, reasoningBorder,
-		reasoningShadow, LayoutConstants::BORDER_RADIUS, LayoutConstants::SHADOW_OFFSET / 2);
-	drawBubble(painter, m_layoutData.rects.frameLeft, m_layoutData.rects.triangleLeft, true,
-		answerBackground, answerBorder,
-		answerShadow, LayoutConstants::BORDER_RADIUS, LayoutConstants::SHADOW_OFFSET);
-	const QString primaryTextColor = QStringLiteral("#0F172A");
+	BubbleChrome::drawBubble(painter, m_layoutData.rects.frameLeftReason, QRect(), true, reasoning);
+	BubbleChrome::drawBubble(painter, m_layoutData.rects.frameLeft, m_layoutData.rects.triangleLeft, true, answer);
 	const bool hasReasoningBubble = m_layoutData.rects.frameLeftReason.isValid();
 
 	if (hasReasoningBubble)
@@ -1773,99 +1903,54 @@ void LLMChatFrame::drawCustomerMessage(QPainter& painter)
 		drawSectionHeader(painter, m_layoutData.rects.frameLeftReason, tr("Think"));
 	}
 	drawSectionHeader(painter, m_layoutData.rects.frameLeft, tr("Answer"));
-	
-	// 获取或创建缓存的文档（优化性能）
-	// 注意：需要传入折叠状态以确保缓存正确性
-	auto getOrCreateDoc = [this, &primaryTextColor](std::unique_ptr<QTextDocument>& doc, 
-		const QString& html, int width, QString& cachedHtml, int& cachedWidth, 
-		bool isCollapsed, bool& cachedCollapsed) -> QTextDocument* {
-		// 检查缓存是否有效（包括折叠状态）
-		if (doc && cachedHtml == html && cachedWidth == width && cachedCollapsed == isCollapsed)
-		{
-			return doc.get();
-		}
-		
-		// 创建新文档或重用现有文档
-		if (!doc)
-		{
-			doc = std::make_unique<QTextDocument>();
-			// 优化文档设置以提升渲染性能
-			doc->setUndoRedoEnabled(false);
-		}
-		
-		setTextDocs(*doc, html, width, primaryTextColor);
-		cachedHtml = html;
-		cachedWidth = width;
-		cachedCollapsed = isCollapsed;
-		return doc.get();
-	};
-	
-	if (m_state.isStreamEnd)
-	{
-		// 流式输出结束后，需要考虑折叠状态
-		QString answerHtml = m_messageData.isCollapsed ? getCollapsedSummary() : markdownToHtml(m_messageData.rawMsg);
-		QTextDocument* docAnswer = getOrCreateDoc(m_docCache.docAnswer, answerHtml, 
-			m_layoutData.rects.textLeft.width(), 
-			m_docCache.cachedAnswerHtml, m_docCache.cachedAnswerWidth,
-			m_messageData.isCollapsed, m_docCache.answerCollapsed);
-		
-		painter.save();
-		painter.translate(m_layoutData.rects.textLeft.topLeft());
-		docAnswer->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
-		painter.restore();
-		
-		if (hasReasoningBubble)
+
+	// 文档由Markdown直接构建并缓存，流式输出时只替换尾部块
+	if (hasReasoningBubble && isReasoningDeferred())
+	{
+		drawSectionPlaceholder(painter, m_layoutData.rects.textLeftReason, true);
+		// 只在推理区域真正绘制到屏幕时才构建文档（快照等离屏渲染不算），排版变化不能在绘制中进行
+		const bool onScreen = painter.device() == this
+			&& (!painter.hasClipping() || painter.clipRegion().intersects(m_layoutData.rects.frameLeftReason));
+		if (onScreen && !m_state.reasoningRealizeScheduled)
 		{
-			QString reasoningHtml = m_messageData.isReasoningCollapsed ? 
-				getReasoningCollapsedSummary() : markdownToHtml(m_messageData.rawReasoningMsg);
-			QTextDocument* docReasoning = getOrCreateDoc(m_docCache.docReasoning, reasoningHtml, 
-				m_layoutData.rects.textLeftReason.width(), 
-				m_docCache.cachedReasoningHtml, m_docCache.cachedReasoningWidth,
-				m_messageData.isReasoningCollapsed, m_docCache.reasoningCollapsed);
-			
-			painter.save();
-			painter.translate(m_layoutData.rects.textLeftReason.topLeft());
-			docReasoning->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
-			painter.restore();
+			m_state.reasoningRealizeScheduled = true;
+			QTimer::singleShot(0, this, &LLMChatFrame::realizeDeferredReasoning);
 		}
 	}
-	else
+	else if (hasReasoningBubble)
 	{
-		if (hasReasoningBubble)
+		QTextDocument* docReasoning = sectionDocument(true);
+		if (docReasoning)
 		{
-			QString reasoningHtml = m_messageData.isReasoningCollapsed ? 
-				getReasoningCollapsedSummary() : m_messageData.reasoningText;
-			QTextDocument* docReasoning = getOrCreateDoc(m_docCache.docReasoning, reasoningHtml, 
-				m_layoutData.rects.textLeftReason.width(), 
-				m_docCache.cachedReasoningHtml, m_docCache.cachedReasoningWidth,
-				m_messageData.isReasoningCollapsed, m_docCache.reasoningCollapsed);
-			
 			painter.save();
 			painter.translate(m_layoutData.rects.textLeftReason.topLeft());
 			docReasoning->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
 			painter.restore();
 		}
-		
-		QString answerHtml = m_messageData.isCollapsed ? getCollapsedSummary() : m_messageData.msg;
-		QTextDocument* docAnswer = getOrCreateDoc(m_docCache.docAnswer, answerHtml, 
-			m_layoutData.rects.textLeft.width(), 
-			m_docCache.cachedAnswerHtml, m_docCache.cachedAnswerWidth,
-			m_messageData.isCollapsed, m_docCache.answerCollapsed);
-		
+		else
+		{
+			drawSectionPlaceholder(painter, m_layoutData.rects.textLeftReason, true);
+		}
+	}
+
+	QTextDocument* docAnswer = sectionDocument(false);
+	if (docAnswer)
+	{
 		painter.save();
 		painter.translate(m_layoutData.rects.textLeft.topLeft());
 		docAnswer->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
 		painter.restore();
 	}
+	else
+	{
+		drawSectionPlaceholder(painter, m_layoutData.rects.textLeft, false);
+	}
 }
 void LLMChatFrame::drawOwnerMessage(QPainter& painter)
 {
-	painter.save();
-	painter.setRenderHint(QPainter::Antialiasing, true);
 	QRect iconRect = m_layoutData.rects.iconRight;
 	QRect ringRect = iconRect.adjusted(-LayoutConstants::ICON_RING_MARGIN, -LayoutConstants::ICON_RING_MARGIN,
 		LayoutConstants::ICON_RING_MARGIN, LayoutConstants::ICON_RING_MARGIN);
-	QLinearGradient ringGradient(ringRect.topLeft(), ringRect.bottomLeft());
 	QColor ringTop = ColorScheme::USER_BACKGROUND;
 	ringTop.setAlpha(110);
 	QColor ringBottom = ColorScheme::USER_BACKGROUND;
@@ -1875,50 +1960,35 @@ void LLMChatFrame::drawOwnerMessage(QPainter& painter)
 		ringTop = ringTop.lighter(118);
 		ringBottom = ringBottom.lighter(122);
 	}
-	ringGradient.setColorAt(0.0, ringTop);
-	ringGradient.setColorAt(1.0, ringBottom);
-	painter.setPen(Qt::NoPen);
-	painter.setBrush(ringGradient);
-	painter.drawEllipse(ringRect);
+	BubbleChrome::drawRing(painter, ringRect, ringTop, ringBottom);
 	painter.drawPixmap(iconRect, *m_ui.icons.rightPix);
-	painter.restore();
-	QColor ownerBackground = ColorScheme::USER_BACKGROUND;
-	QColor ownerBorder = ColorScheme::USER_BACKGROUND.darker(115);
-	QColor ownerShadow = ColorScheme::SHADOW_COLOR;
+	BubbleChrome::Style owner;
+	owner.fill = ColorScheme::USER_BACKGROUND;
+	owner.border = ColorScheme::USER_BACKGROUND.darker(115);
+	owner.shadow = ColorScheme::SHADOW_COLOR;
+	owner.radius = LayoutConstants::BORDER_RADIUS;
+	owner.shadowOffset = QPoint(LayoutConstants::SHADOW_OFFSET, LayoutConstants::SHADOW_OFFSET);
 	if (m_isHovered)
 	{
-		ownerBackground = ownerBackground.lighter(110);
-		ownerBorder = ownerBorder.lighter(118);
-		ownerShadow.setAlpha(qMin(255, ownerShadow.alpha() + 50));
+		owner.fill = owner.fill.lighter(110);
+		owner.border = owner.border.lighter(118);
+		applyHoverShadow(owner);
 	}
-	drawBubble(painter, m_layoutData.rects.frameRight, m_layoutData.rects.triangleRight, false,
-		ownerBackground, ownerBorder,
-		ownerShadow, LayoutConstants::BORDER_RADIUS, LayoutConstants::SHADOW_OFFSET);
+	BubbleChrome::drawBubble(painter, m_layoutData.rects.frameRight, m_layoutData.rects.triangleRight, false, owner);
 	
 	// 使用缓存的文档（优化性能）
-	const QString ownerTextColor = QStringLiteral("#F8FAFC");
-	QString answerHtml = m_messageData.isCollapsed ? getCollapsedSummary() : m_messageData.msg;
-	int textWidth = m_layoutData.rects.textRight.width();
-	
-	// 检查缓存是否有效
-	if (!m_docCache.docOwner || m_docCache.cachedOwnerHtml != answerHtml || 
-		m_docCache.cachedOwnerWidth != textWidth || m_docCache.answerCollapsed != m_messageData.isCollapsed)
+	QTextDocument* docOwner = sectionDocument(false);
+	if (docOwner)
 	{
-		if (!m_docCache.docOwner)
-		{
-			m_docCache.docOwner = std::make_unique<QTextDocument>();
-			m_docCache.docOwner->setUndoRedoEnabled(false);
-		}
-		setTextDocs(*m_docCache.docOwner, answerHtml, textWidth, ownerTextColor);
-		m_docCache.cachedOwnerHtml = answerHtml;
-		m_docCache.cachedOwnerWidth = textWidth;
-		m_docCache.answerCollapsed = m_messageData.isCollapsed;
+		painter.save();
+		painter.translate(m_layoutData.rects.textRight.topLeft());
+		docOwner->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
+		painter.restore();
+	}
+	else
+	{
+		drawSectionPlaceholder(painter, m_layoutData.rects.textRight, false);
 	}
-	
-	painter.save();
-	painter.translate(m_layoutData.rects.textRight.topLeft());
-	m_docCache.docOwner->documentLayout()->draw(&painter, QAbstractTextDocumentLayout::PaintContext());
-	painter.restore();
 }
 void LLMChatFrame::drawTimeMessage(QPainter& painter)
 {
@@ -1934,6 +2004,12 @@ void LLMChatFrame::drawTimeMessage(QPainter& painter)
 void LLMChatFrame::paintEvent(QPaintEvent *event)
 {
 	QPainter painter(this);
+	// 快速滚动期间尺寸未变时直接贴快照
+	if (m_fastPaint && m_fastSnapshot.size() == size() * m_fastSnapshot.devicePixelRatio())
+	{
+		painter.drawPixmap(0, 0, m_fastSnapshot);
+		return;
+	}
 	painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
 	painter.setPen(Qt::NoPen);
 	painter.setBrush(QBrush(Qt::gray));
@@ -2016,10 +2092,6 @@ bool LLMChatFrame::eventFilter(QObject* watched, QEvent* event)
 void LLMChatFrame::enterEvent(QEvent* event)
 {
 	m_isHovered = true;
-	if (m_shadowEffect)
-	{
-		m_shadowEffect->setEnabled(true);
-	}
 	update();
 	QWidget::enterEvent(event);
 }
@@ -2027,10 +2099,6 @@ void LLMChatFrame::enterEvent(QEvent* event)
 void LLMChatFrame::leaveEvent(QEvent* event)
 {
 	m_isHovered = false;
-	if (m_shadowEffect)
-	{
-		m_shadowEffect->setEnabled(false);
-	}
 	update();
 	QWidget::leaveEvent(event);
 }
@@ -2057,19 +2125,18 @@ void LLMChatFrame::resizeEvent(QResizeEvent *event)
 	int newWidth = width();
 
 	if (oldWidth != newWidth) {
-		// 清除布局缓存，因为尺寸已经改变
+		// 清除布局缓存，因为尺寸已经改变（文档内容与宽度无关，只需重新排版）
 		m_layoutCache.isValid = false;
-		m_docCache.invalidate(); // 使文档缓存失效（宽度改变需要重新渲染）
 		m_layoutDirty = true;
 
 		// 当尺寸变化时重新计算布局
 		// 注意：fontRect()内部已经调用了update()，所以这里不需要再次调用
 		if (m_UserType != User_Time)
 		{
-			if (!m_messageData.reasoningText.isEmpty() && m_UserType == User_Customer)
-				fontRect(m_messageData.reasoningText, m_messageData.msg);
+			if (!m_messageData.rawReasoningMsg.isEmpty() && m_UserType == User_Customer)
+				fontRect(m_messageData.rawReasoningMsg, m_messageData.rawMsg);
 			else
-				fontRect(m_messageData.msg);
+				fontRect(m_messageData.rawMsg);
 		}
 	}
 }
@@ -2080,28 +2147,26 @@ void LLMChatFrame::mousePressEvent(QMouseEvent *event)
 	QString anchor;
 	
 	// 检查点击位置是否在文本区域内
+	// 直接使用绘制时的文档命中测试，无需重新构建
 	if (m_UserType == User_Owner && m_layoutData.rects.textRight.contains(localPos))
 	{
-		QTextDocument doc;
-		setTextDocs(doc, m_messageData.msg, m_layoutData.rects.textRight.width(), QStringLiteral("#F8FAFC"));
+		QTextDocument* doc = sectionDocument(false);
 		QPoint textPos = localPos - m_layoutData.rects.textRight.topLeft();
-		anchor = doc.documentLayout()->anchorAt(textPos);
+		anchor = doc ? doc->documentLayout()->anchorAt(textPos) : QString();
 	}
 	else if (m_UserType == User_Customer)
 	{
 		if (m_layoutData.rects.textLeft.contains(localPos))
 		{
-			QTextDocument doc;
-			setTextDocs(doc, m_messageData.msg, m_layoutData.rects.textLeft.width(), QStringLiteral("#0F172A"));
+			QTextDocument* doc = sectionDocument(false);
 			QPoint textPos = localPos - m_layoutData.rects.textLeft.topLeft();
-			anchor = doc.documentLayout()->anchorAt(textPos);
+			anchor = doc ? doc->documentLayout()->anchorAt(textPos) : QString();
 		}
 		else if (m_layoutData.rects.textLeftReason.isValid() && m_layoutData.rects.textLeftReason.contains(localPos))
 		{
-			QTextDocument doc;
-			setTextDocs(doc, m_messageData.reasoningText, m_layoutData.rects.textLeftReason.width(), QStringLiteral("#0F172A"));
+			QTextDocument* doc = sectionDocument(true);
 			QPoint textPos = localPos - m_layoutData.rects.textLeftReason.topLeft();
-			anchor = doc.documentLayout()->anchorAt(textPos);
+			anchor = doc ? doc->documentLayout()->anchorAt(textPos) : QString();
 		}
 	}
 	
@@ -2114,7 +2179,7 @@ void LLMChatFrame::mousePressEvent(QMouseEvent *event)
 		return;
 	}
 	
-	QListWidget* listWidget = qobject_cast<QListWidget*>(parent()->parent());
+	QAbstractItemView* listWidget = qobject_cast<QAbstractItemView*>(parent()->parent());
 	if (listWidget)
 	{
 		QScrollBar* scrollBar = listWidget->verticalScrollBar();
@@ -2127,7 +2192,7 @@ void LLMChatFrame::mousePressEvent(QMouseEvent *event)
 }
 void LLMChatFrame::mouseReleaseEvent(QMouseEvent *event)
 {
-	QListWidget* listWidget = qobject_cast<QListWidget*>(parent()->parent());
+	QAbstractItemView* listWidget = qobject_cast<QAbstractItemView*>(parent()->parent());
 	if (listWidget)
 	{
 		QScrollBar* scrollBar = listWidget->verticalScrollBar();
@@ -2142,7 +2207,7 @@ void LLMChatFrame::mouseReleaseEvent(QMouseEvent *event)
 void LLMChatFrame::contextMenuEvent(QContextMenuEvent *event)
 {
 	const QPoint localPos = mapFromGlobal(event->globalPos());
-	const bool hasReasoning = !m_messageData.reasoningText.isEmpty();
+	const bool hasReasoning = !m_messageData.rawReasoningMsg.isEmpty();
 	const bool reasoningSection = hasReasoning
 		&& m_layoutData.rects.frameLeftReason.contains(localPos)
 		&& m_UserType == User_Customer;
@@ -2216,9 +2281,11 @@ void LLMChatFrame::contextMenuEvent(QContextMenuEvent *event)
 
 void LLMChatFrame::handleCodeBlockCopy(const QString& codeBlockId)
 {
-	if (m_codeBlockMap.contains(codeBlockId))
+	const QHash<QString, QString>& answerBlocks = m_docCache.answer.codeBlocks;
+	const QHash<QString, QString>& reasoningBlocks = m_docCache.reasoning.codeBlocks;
+	if (answerBlocks.contains(codeBlockId) || reasoningBlocks.contains(codeBlockId))
 	{
-		QString code = m_codeBlockMap[codeBlockId];
+		QString code = answerBlocks.value(codeBlockId, reasoningBlocks.value(codeBlockId));
 		QClipboard* clipboard = QApplication::clipboard();
 		if (clipboard)
 		{
@@ -4,7 +4,7 @@
 #include <QTextDocument>
 #include <QApplication>
 #include <QPushButton> 
-#include <QListWidget>
+#include <QAbstractItemView>
 #include <QClipboard>
 #include <QScrollBar>
 #include <QWidget>
@@ -21,6 +21,10 @@
 #include <vector>
 #include <cmark.h>
 #include "SyntaxHighlighter.h"
+#include "StreamingMarkdownRenderer.h"
+#include "ThinkTagSplitter.h"
+#include "MarkdownDocumentBuilder.h"
+#include "BubbleRenderService.h"
 class QPaintEvent;
 class QPainter;
 class QEvent;
@@ -121,18 +125,24 @@ public:
 	QSize fontRect(const QString& str);
 	// 计算带推理消息的尺寸
 	QSize fontRect(const QString& reasoning, const QString& answer);
+	// 流式输出时增量刷新尺寸（只重新渲染尾部未闭合的Markdown块）
+	QSize refreshStreamingLayout();
 	//文本处理接口
-	// 追加文本内容
+	// 追加文本内容（按推理标记分流，标记可以被分片拆开）
 	void appendText(const QString& delta);
-	// 将Markdown转换为HTML
-	QString markdownToHtml(const QString &markdown);
+	// 流结束：写入暂存的不完整标记
+	void finishText();
+	// 追加推理内容（来自推理通道，不做标记分流）
+	void appendReasoning(const QString& delta);
+	// 将Markdown转换为HTML（复制/导出使用，显示时直接由Markdown构建文档）
+	QString markdownToHtml(const QString &markdown) const;
 	//数据获取
 	// 获取消息HTML文本
-	const QString& getText() const { return m_messageData.msg; }
+	QString getText() const { return markdownToHtml(m_messageData.rawMsg); }
 	// 获取原始消息文本
 	const QString& getRawText() const { return m_messageData.rawMsg; }
-	// 获取推理文本
-	const QString& getReasoningText() const { return m_messageData.reasoningText; }
+	// 获取推理HTML文本
+	QString getReasoningText() const { return markdownToHtml(m_messageData.rawReasoningMsg); }
 	// 获取原始推理文本
 	const QString& getReasonRawText() const { return m_messageData.rawReasoningMsg; }
 	// 获取时间
@@ -149,7 +159,7 @@ public:
 	// 标记流式传输结束
 	void ChangeStream() { m_state.isStreamEnd = true; }
 	// 改变接受状态
-	void ChangeAccpetStatus() { m_state.isReasoning = false; m_state.answerHeaderInserted = false; }
+	void ChangeAccpetStatus() { m_thinkSplitter.reset(); m_state.answerHeaderInserted = false; }
 	// 是否正在发送
 	bool isSending() const { return m_state.isSending; }
 	// 设置气泡ID
@@ -158,6 +168,8 @@ public:
 	void resetForReuse();
 	// 准备删除
 	void prepareForDeletion();
+	// 快速滚动时改画快照，不再排版绘制文档；关闭时丢弃快照
+	void setFastPaint(bool enabled);
 	// 构建纯文本导出内容
 	QString buildPlainExport() const;
 	// 构建Markdown格式导出内容
@@ -191,6 +203,8 @@ signals:
 	void bubbleImportantToggled(const QString& bubbleId, bool isImportant);
 	// 气泡折叠状态切换信号
 	void bubbleCollapsedToggled(const QString& bubbleId, bool isCollapsed);
+	// 后台渲染完成并已重新计算尺寸
+	void contentRendered();
 protected:
 	// 事件处理
 	bool event(QEvent* event) override;
@@ -230,6 +244,12 @@ private:
 	void initRescource();
 	// 计算布局
 	void calculateLayout();
+	// 按当前原文计算单条消息尺寸
+	QSize applySingleLayout();
+	// 按当前原文计算带推理消息的尺寸
+	QSize applyReasoningLayout();
+	// 同步流式渲染器与原始文本（原始文本被外部重置时）
+	void syncStreamRenderers();
 	// 更新按钮位置
 	void updateButtonsPosition();
 	// 更新按钮可见性
@@ -244,12 +264,22 @@ private:
 	void drawOwnerMessage(QPainter& painter);
 	// 绘制时间消息
 	void drawTimeMessage(QPainter& painter);
-	// 获取实际字符串尺寸（单条消息）
-	QSize getRealString(QString src);
-	// 获取实际字符串尺寸（带推理消息）
-	QSize getRealString(const QString& reasoning, const QString& answer);
-	// 设置文本文档
-	void setTextDocs(QTextDocument& docText, const QString& src, const int& iWidth, const QString& defaultColor = QString());
+	// 测量回答/推理区域文档的尺寸
+	QSize measureSection(bool reasoning);
+	// 后台渲染完成前按字符宽度估算区域尺寸
+	QSize estimateSectionSize(bool reasoning, int width) const;
+	// 获取回答/推理区域的文档（按需构建）；后台渲染尚未完成时返回 nullptr
+	QTextDocument* sectionDocument(bool reasoning);
+	// 区域文字颜色
+	QColor sectionTextColor() const;
+	// 后台渲染完成前绘制原文开头作为占位
+	void drawSectionPlaceholder(QPainter& painter, const QRect& textRect, bool reasoning);
+	// 推理区域是否仍在延迟（展开但尚未进入视口，只用估算尺寸和占位文本）
+	bool isReasoningDeferred() const;
+	// 推理区域进入视口：构建文档并按实际尺寸重新排版
+	void realizeDeferredReasoning();
+	// 获取回答/推理区域的Markdown原文（没有推理内容时返回回答）
+	const QString& sectionMarkdown(bool reasoningSection) const;
 	// 更新按钮悬停状态
 	void updateButtonHoverState(QPushButton* button, bool hovered);
 	// 内容改变后刷新布局
@@ -279,10 +309,8 @@ private:
 	int computeAdditionalHeight() const;
 	struct MessageData
 	{
-		QString msg;
-		QString rawMsg;
-		QString reasoningText;
-		QString rawReasoningMsg;
+		QString rawMsg;           // 回答Markdown原文
+		QString rawReasoningMsg;  // 推理Markdown原文
 		QString time;
 		QString curTime;
 		QString uniqueID;
@@ -317,9 +345,10 @@ private:
 	{
 		bool isSending = false;
 		bool isStreamEnd = false;
-		bool isReasoning = false;
 		int savedScrollPosition = -1;
 		bool answerHeaderInserted = false;
+		bool reasoningDeferred = false;          // 历史消息的推理内容在进入视口或展开前不解析排版
+		bool reasoningRealizeScheduled = false;
 	} m_state;
 	struct LayoutCache
 	{
@@ -329,43 +358,62 @@ private:
 		bool isValid = false;
 	} m_layoutCache;
 	
-	// QTextDocument 缓存结构（优化代码块渲染性能）
-	struct DocumentCache
+	// 区域文档缓存：内容由Markdown直接构建，与宽度无关，宽度变化只需重新排版
+	// 流式输出时闭合块只写入一次，每次刷新只替换尾部未闭合的块
+	struct SectionDocument
 	{
-		std::unique_ptr<QTextDocument> docAnswer;
-		std::unique_ptr<QTextDocument> docReasoning;
-		std::unique_ptr<QTextDocument> docOwner; // 用户消息的文档缓存
-		QString cachedAnswerHtml;
-		QString cachedReasoningHtml;
-		QString cachedOwnerHtml;
-		int cachedAnswerWidth = -1;
-		int cachedReasoningWidth = -1;
-		int cachedOwnerWidth = -1;
-		bool answerCollapsed = false;
-		bool reasoningCollapsed = false;
-		bool isValid = false;
-		
-		void invalidate()
+		std::unique_ptr<QTextDocument> doc;
+		QString source;            // 构建时的Markdown原文（折叠时文档内容为其摘要）
+		QColor textColor;          // 构建时的文字颜色
+		bool collapsed = false;    // 构建时的折叠状态
+		int stableSourceEnd = 0;   // 已写入的闭合块在原文中的结束位置
+		int stableDocEnd = 0;      // 已写入的闭合块在文档中的结束位置
+		int layoutWidth = -1;      // 上次排版使用的最大宽度，内容变化后置为 -1
+		QSize layoutSize;          // 上次排版（收缩到理想宽度）后的尺寸
+		QHash<QString, QString> codeBlocks; // 闭合块中的代码块：ID -> 代码内容
+		quint64 pendingTicket = 0; // 后台渲染票据，0 表示没有进行中的请求
+		QString pendingSource;     // 后台渲染中的原文
+
+		void reset()
 		{
-			docAnswer.reset();
-			docReasoning.reset();
-			docOwner.reset();
-			cachedAnswerHtml.clear();
-			cachedReasoningHtml.clear();
-			cachedOwnerHtml.clear();
-			cachedAnswerWidth = -1;
-			cachedReasoningWidth = -1;
-			cachedOwnerWidth = -1;
-			isValid = false;
+			doc.reset();
+			source.clear();
+			textColor = QColor();
+			collapsed = false;
+			stableSourceEnd = 0;
+			stableDocEnd = 0;
+			layoutWidth = -1;
+			layoutSize = QSize();
+			codeBlocks.clear();
+			pendingTicket = 0;
+			pendingSource.clear();
 		}
+	};
+	struct DocumentCache
+	{
+		SectionDocument answer;     // 回答（用户消息也使用该文档）
+		SectionDocument reasoning;  // 推理
 	} m_docCache;
+	// 把原文同步到区域文档：保留未变化的闭合块，只追加新闭合块并替换尾部
+	void updateSectionDocument(SectionDocument& section, const QString& markdown, int stableEnd);
+	// 把接收完成的整段原文交给后台渲染；命中渲染缓存时直接返回文档，否则返回 nullptr
+	QTextDocument* requestSectionRender(SectionDocument& section, bool reasoning, const QString& markdown);
+	// 把分流后的片段追加到推理或回答
+	void appendSegment(bool reasoning, const QStringRef& segment);
+	// 后台渲染完成
+	void onSectionRendered(bool reasoning, BubbleRenderResult& result);
+	// 把渲染结果装入区域文档
+	void installSectionResult(SectionDocument& section, BubbleRenderResult& result);
+	// 清空区域文档：取消进行中的后台渲染，完整排版的文档归还渲染缓存
+	void resetSection(SectionDocument& section);
 
 	// UI性能优化：减少不必要的重绘
 	bool m_needsUpdate = false;
 	bool m_layoutDirty = false;
 	bool m_isHovered = false;
 	bool m_allowDeferredDelete = false;
-	QGraphicsDropShadowEffect* m_shadowEffect = nullptr;
+	bool m_fastPaint = false;
+	QPixmap m_fastSnapshot;
 	struct UIComponents
 	{
 		struct Loading
@@ -397,10 +445,14 @@ private:
 	} m_ui;
 	//代码高亮块
 	std::unique_ptr<SyntaxHighlighter> m_syntaxHighlighter;
+	// Markdown -> QTextDocument 构建器
+	MarkdownDocumentBuilder m_documentBuilder;
 	std::vector<QPushButton> m_SuggestButton;
 	User_Type m_UserType = User_System;
-	// 代码块内容映射：ID -> 代码内容
-	QHash<QString, QString> m_codeBlockMap;
+	// 流式增量Markdown渲染器（回答/推理）
+	StreamingMarkdownRenderer m_answerRenderer;
+	StreamingMarkdownRenderer m_reasoningRenderer;
+	ThinkTagSplitter m_thinkSplitter;
 	// 处理代码块复制
 	void handleCodeBlockCopy(const QString& codeBlockId);
 };
@@ -27,6 +27,7 @@ void LLMParams::copyFrom(const LLMParams& other)
 {
 	iChatMode = other.iChatMode;
 	iMaxToken = other.iMaxToken;
+	iContextTokens = other.iContextTokens;
 	iModel = other.iModel;
 	dTemperature = other.dTemperature;
 	bStreamChat = other.bStreamChat;
@@ -66,6 +67,16 @@ int LLMParams::getMaxToken() const
 	return this->iMaxToken;
 }
 
+void LLMParams::setContextTokens(const int &iContextTokens)
+{
+	this->iContextTokens = iContextTokens;
+}
+
+int LLMParams::getContextTokens() const
+{
+	return this->iContextTokens;
+}
+
 void LLMParams::setModel(const int &iModel)
 {
 	this->iModel = iModel;
@@ -195,6 +206,7 @@ bool LLMParams::serialize(const QString& jsonPath)
 	obj["chatMode"] = this->iChatMode;
 	obj["temperature"] = this->dTemperature;
 	obj["maxToken"] = this->iMaxToken;
+	obj["contextTokens"] = this->iContextTokens;
 	obj["streamChat"] = this->bStreamChat;
 	obj["openThink"] = this->bOpenThink;
 	obj["model"] = this->iModel;
@@ -235,6 +247,7 @@ bool LLMParams::deserialize(const QString& jsonPath)
 	this->iChatMode = obj.value("chatMode").toInt(this->iChatMode);
 	this->dTemperature = obj.value("temperature").toDouble(this->dTemperature);
 	this->iMaxToken = obj.value("maxToken").toInt(this->iMaxToken);
+	this->iContextTokens = obj.value("contextTokens").toInt(this->iContextTokens);
 	this->bStreamChat = obj.value("streamChat").toBool(this->bStreamChat);
 	this->bOpenThink = obj.value("openThink").toBool(this->bOpenThink);
 	this->iModel = obj.value("model").toInt(this->iModel);
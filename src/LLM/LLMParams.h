@@ -19,6 +19,7 @@ public:
     //设置模型参数
     void setChatMode(const int &iChatMode);
     void setMaxToken(const int &iMaxToken);
+    void setContextTokens(const int &iContextTokens);
     void setModel(const int &iModel);
     void setTemperature(const double&dTemperature);
     void setStreamChat(const bool& bStreamChat);
@@ -34,6 +35,7 @@ public:
     //获取模型参数
     int getChatMode() const;
     int getMaxToken() const;
+    int getContextTokens() const;
     int getModel() const;
     double getTemperature() const;
     bool getStreamChat() const;
@@ -54,6 +56,7 @@ private:
     //模型参数
     int iChatMode = 0;
     int iMaxToken = 4096;
+    int iContextTokens = 8192;   //多轮对话历史的token预算，0 表示只发送本轮提问
     int iModel = 0;
     double dTemperature = 0.7;
     bool bStreamChat = false;
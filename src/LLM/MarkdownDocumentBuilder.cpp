@@ -0,0 +1,455 @@
+#include "MarkdownDocumentBuilder.h"
+#include "SyntaxHighlighter.h"
+#include <QTextCursor>
+#include <QTextFrame>
+#include <QTextList>
+#include <QTextBlock>
+#include <QVector>
+#include <QtMath>
+#include <cmark.h>
+
+namespace
+{
+	// 标记由构建器写入的块，用于区分 Qt 自动生成的空块（文档首块、框架之后的块），后者可以直接复用
+	constexpr int kBuiltBlockProperty = QTextFormat::UserProperty + 1;
+	constexpr int kBodyPixelSize = 15;          // 正文字号（原样式 14.5px）
+	constexpr int kCodePixelSize = 11;          // 代码字号
+	constexpr qreal kLineHeightPercent = 170;   // 行高，与原样式 line-height:1.7 一致
+	constexpr int kParagraphSpacing = 8;        // 段落间距
+	constexpr int kTightItemSpacing = 2;        // 紧凑列表项间距
+	constexpr int kQuoteIndent = 16;            // 每层引用的缩进
+	constexpr int kCodePadding = 12;            // 代码块内边距
+	const QColor kLinkColor(37, 99, 235);
+	const QColor kQuoteColor(71, 85, 105);
+	const QColor kCodeBorderColor(62, 62, 66);
+
+	QString fromCmark(const char* text)
+	{
+		return text ? QString::fromUtf8(text) : QString();
+	}
+
+	// 按标题级别返回字号
+	int headingPixelSize(int level)
+	{
+		switch (level)
+		{
+		case 1: return 24;
+		case 2: return 21;
+		case 3: return 18;
+		default: return 16;
+		}
+	}
+
+	// 遍历一棵 cmark 语法树并写入文档末尾
+	class DocumentWriter
+	{
+	public:
+		DocumentWriter(QTextDocument& doc, const QColor& textColor, SyntaxHighlighter* highlighter,
+			QHash<QString, QString>* codeBlocks)
+			: m_cursor(&doc)
+			, m_highlighter(highlighter)
+			, m_theme(highlighter ? highlighter->getTheme() : SyntaxHighlighter::darkTheme())
+			, m_codeBlocks(codeBlocks)
+		{
+			QTextCharFormat base;
+			if (textColor.isValid())
+			{
+				base.setForeground(textColor);
+			}
+			m_charFormats.append(base);
+			m_cursor.movePosition(QTextCursor::End);
+		}
+
+		void write(cmark_node* root)
+		{
+			// 合并为一次编辑，文档只在结束时重新排版一次
+			m_cursor.beginEditBlock();
+			cmark_iter* iter = cmark_iter_new(root);
+			cmark_event_type event;
+			while ((event = cmark_iter_next(iter)) != CMARK_EVENT_DONE)
+			{
+				cmark_node* node = cmark_iter_get_node(iter);
+				if (event == CMARK_EVENT_ENTER)
+				{
+					enterNode(node);
+				}
+				else
+				{
+					exitNode(node);
+				}
+			}
+			cmark_iter_free(iter);
+			m_cursor.endEditBlock();
+		}
+
+	private:
+		struct ListState
+		{
+			QTextListFormat format;
+			QTextList* list = nullptr;
+		};
+
+		void enterNode(cmark_node* node)
+		{
+			switch (cmark_node_get_type(node))
+			{
+			case CMARK_NODE_PARAGRAPH:
+				startBlock(paragraphFormat(node));
+				break;
+			case CMARK_NODE_HEADING:
+			{
+				QTextBlockFormat format = paragraphFormat(node);
+				format.setTopMargin(kParagraphSpacing + 2);
+				format.setBottomMargin(kParagraphSpacing - 2);
+				QTextCharFormat charFormat = m_charFormats.last();
+				charFormat.setFontWeight(QFont::Bold);
+				charFormat.setProperty(QTextFormat::FontPixelSize, headingPixelSize(cmark_node_get_heading_level(node)));
+				m_charFormats.append(charFormat);
+				startBlock(format);
+				break;
+			}
+			case CMARK_NODE_BLOCK_QUOTE:
+			{
+				++m_quoteDepth;
+				QTextCharFormat charFormat = m_charFormats.last();
+				charFormat.setForeground(kQuoteColor);
+				m_charFormats.append(charFormat);
+				break;
+			}
+			case CMARK_NODE_LIST:
+			{
+				ListState state;
+				const int depth = m_lists.size();
+				if (cmark_node_get_list_type(node) == CMARK_ORDERED_LIST)
+				{
+					state.format.setStyle(QTextListFormat::ListDecimal);
+				}
+				else
+				{
+					static const QTextListFormat::Style bulletStyles[] = {
+						QTextListFormat::ListDisc, QTextListFormat::ListCircle, QTextListFormat::ListSquare };
+					state.format.setStyle(bulletStyles[depth % 3]);
+				}
+				state.format.setIndent(depth + 1);
+				m_lists.append(state);
+				break;
+			}
+			case CMARK_NODE_ITEM:
+				m_listItemPending = true;
+				break;
+			case CMARK_NODE_CODE_BLOCK:
+				insertCodeBlock(node);
+				break;
+			case CMARK_NODE_THEMATIC_BREAK:
+			{
+				QTextBlockFormat format = paragraphFormat(node);
+				format.setProperty(QTextFormat::BlockTrailingHorizontalRulerWidth,
+					QTextLength(QTextLength::PercentageLength, 100));
+				startBlock(format);
+				break;
+			}
+			case CMARK_NODE_TEXT:
+				m_cursor.insertText(fromCmark(cmark_node_get_literal(node)), m_charFormats.last());
+				break;
+			case CMARK_NODE_SOFTBREAK:
+				m_cursor.insertText(QStringLiteral(" "), m_charFormats.last());
+				break;
+			case CMARK_NODE_LINEBREAK:
+				m_cursor.insertText(QString(QChar::LineSeparator), m_charFormats.last());
+				break;
+			case CMARK_NODE_CODE:
+				m_cursor.insertText(fromCmark(cmark_node_get_literal(node)), inlineCodeFormat());
+				break;
+			case CMARK_NODE_EMPH:
+			{
+				QTextCharFormat charFormat = m_charFormats.last();
+				charFormat.setFontItalic(true);
+				m_charFormats.append(charFormat);
+				break;
+			}
+			case CMARK_NODE_STRONG:
+			{
+				QTextCharFormat charFormat = m_charFormats.last();
+				charFormat.setFontWeight(QFont::Bold);
+				m_charFormats.append(charFormat);
+				break;
+			}
+			case CMARK_NODE_LINK:
+			{
+				QTextCharFormat charFormat = m_charFormats.last();
+				charFormat.setAnchor(true);
+				charFormat.setAnchorHref(fromCmark(cmark_node_get_url(node)));
+				charFormat.setForeground(kLinkColor);
+				charFormat.setFontUnderline(true);
+				m_charFormats.append(charFormat);
+				break;
+			}
+			case CMARK_NODE_IMAGE:
+				// 图片只显示替代文本
+				m_charFormats.append(m_charFormats.last());
+				break;
+			default:
+				// 原始HTML与cmark的安全模式（CMARK_OPT_DEFAULT）保持一致，不输出
+				break;
+			}
+		}
+
+		void exitNode(cmark_node* node)
+		{
+			switch (cmark_node_get_type(node))
+			{
+			case CMARK_NODE_BLOCK_QUOTE:
+				--m_quoteDepth;
+				m_charFormats.removeLast();
+				break;
+			case CMARK_NODE_LIST:
+				m_lists.removeLast();
+				break;
+			case CMARK_NODE_ITEM:
+				m_listItemPending = false;
+				break;
+			case CMARK_NODE_HEADING:
+			case CMARK_NODE_EMPH:
+			case CMARK_NODE_STRONG:
+			case CMARK_NODE_LINK:
+			case CMARK_NODE_IMAGE:
+				m_charFormats.removeLast();
+				break;
+			default:
+				break;
+			}
+		}
+
+		QTextBlockFormat paragraphFormat(cmark_node* node) const
+		{
+			QTextBlockFormat format;
+			format.setLineHeight(kLineHeightPercent, QTextBlockFormat::ProportionalHeight);
+			format.setBottomMargin(kParagraphSpacing);
+			// 紧凑列表中的段落使用较小的间距
+			cmark_node* item = cmark_node_parent(node);
+			if (item && cmark_node_get_type(item) == CMARK_NODE_ITEM)
+			{
+				cmark_node* list = cmark_node_parent(item);
+				if (list && cmark_node_get_list_tight(list))
+				{
+					format.setBottomMargin(kTightItemSpacing);
+				}
+			}
+			return format;
+		}
+
+		QTextCharFormat inlineCodeFormat() const
+		{
+			QTextCharFormat format = m_charFormats.last();
+			format.setFontFamily(QStringLiteral("Consolas"));
+			format.setFontFixedPitch(true);
+			format.setProperty(QTextFormat::FontPixelSize, kCodePixelSize + 2);
+			format.setBackground(QColor(m_theme.background));
+			format.setForeground(QColor(m_theme.string));
+			return format;
+		}
+
+		// 开始一个新块；文档首块或框架后的空块直接复用，避免多出空行
+		void startBlock(QTextBlockFormat format)
+		{
+			format.setProperty(kBuiltBlockProperty, true);
+			format.setLeftMargin(format.leftMargin() + m_quoteDepth * kQuoteIndent);
+			const bool continuesItem = !m_lists.isEmpty() && !m_listItemPending;
+			if (continuesItem)
+			{
+				// 列表项中的后续段落与列表文本对齐
+				format.setIndent(m_lists.size());
+			}
+			const QTextBlock block = m_cursor.block();
+			if (block.length() <= 1 && !block.textList() && !block.blockFormat().hasProperty(kBuiltBlockProperty))
+			{
+				m_cursor.setBlockFormat(format);
+				m_cursor.setBlockCharFormat(m_charFormats.last());
+			}
+			else
+			{
+				m_cursor.insertBlock(format, m_charFormats.last());
+			}
+			if (!m_lists.isEmpty() && m_listItemPending)
+			{
+				ListState& state = m_lists.last();
+				if (!state.list)
+				{
+					state.list = m_cursor.createList(state.format);
+				}
+				else
+				{
+					state.list->add(m_cursor.block());
+				}
+				m_listItemPending = false;
+			}
+		}
+
+		void insertCodeBlock(cmark_node* node)
+		{
+			QString code = fromCmark(cmark_node_get_literal(node));
+			if (code.endsWith(QLatin1Char('\n')))
+			{
+				code.chop(1);
+			}
+			const QString info = fromCmark(cmark_node_get_fence_info(node)).trimmed();
+			const QString language = info.section(QLatin1Char(' '), 0, 0).toLower();
+
+			QTextFrameFormat frameFormat;
+			frameFormat.setBackground(QColor(m_theme.background));
+			frameFormat.setBorder(1);
+			frameFormat.setBorderBrush(kCodeBorderColor);
+			frameFormat.setBorderStyle(QTextFrameFormat::BorderStyle_Solid);
+			frameFormat.setTopMargin(kParagraphSpacing);
+			frameFormat.setBottomMargin(kParagraphSpacing);
+			frameFormat.setLeftMargin(m_quoteDepth * kQuoteIndent);
+			QTextFrame* frame = m_cursor.insertFrame(frameFormat);
+
+			// 工具栏：语言名 + 复制锚点（锚点格式：codeblock://copy?id=uniqueId）
+			QTextBlockFormat toolbarFormat;
+			toolbarFormat.setProperty(kBuiltBlockProperty, true);
+			toolbarFormat.setBackground(QColor(m_theme.toolbar));
+			toolbarFormat.setTextIndent(kCodePadding);
+			toolbarFormat.setLineHeight(kLineHeightPercent, QTextBlockFormat::ProportionalHeight);
+			m_cursor.setBlockFormat(toolbarFormat);
+			QTextCharFormat labelFormat;
+			labelFormat.setForeground(QColor(m_theme.toolbarText));
+			labelFormat.setFontWeight(QFont::DemiBold);
+			labelFormat.setProperty(QTextFormat::FontPixelSize, kCodePixelSize + 1);
+			m_cursor.setBlockCharFormat(labelFormat);
+			m_cursor.insertText(language.isEmpty() ? QStringLiteral("Code") : language.toUpper(), labelFormat);
+			m_cursor.insertText(QStringLiteral("    "), labelFormat);
+
+			const QString uniqueId = SyntaxHighlighter::generateUniqueId();
+			QTextCharFormat buttonFormat;
+			buttonFormat.setAnchor(true);
+			buttonFormat.setAnchorHref(QStringLiteral("codeblock://copy?id=") + uniqueId);
+			buttonFormat.setForeground(QColor(m_theme.toolbarText));
+			buttonFormat.setBackground(QColor(m_theme.button));
+			buttonFormat.setProperty(QTextFormat::FontPixelSize, kCodePixelSize);
+			m_cursor.insertText(QStringLiteral(" Copy "), buttonFormat);
+			if (m_codeBlocks)
+			{
+				m_codeBlocks->insert(uniqueId, code);
+			}
+
+			QTextBlockFormat codeFormat;
+			codeFormat.setProperty(kBuiltBlockProperty, true);
+			codeFormat.setLeftMargin(kCodePadding);
+			codeFormat.setRightMargin(kCodePadding);
+			codeFormat.setTopMargin(kCodePadding / 2);
+			codeFormat.setBottomMargin(kCodePadding / 2);
+			QTextCharFormat codeCharFormat;
+			codeCharFormat.setFontFamily(QStringLiteral("Consolas"));
+			codeCharFormat.setFontFixedPitch(true);
+			codeCharFormat.setProperty(QTextFormat::FontPixelSize, kCodePixelSize);
+			codeCharFormat.setForeground(QColor(m_theme.text));
+			m_cursor.insertBlock(codeFormat, codeCharFormat);
+			// 代码行之间使用行分隔符，整段代码位于同一个块中，块的上下边距只出现一次
+			QString text = code;
+			text.replace(QLatin1Char('\n'), QChar::LineSeparator);
+			if (m_highlighter)
+			{
+				// 按词法单元直接写入字符格式，不再生成并解析HTML
+				const QVector<CodeLexer::Token> tokens = m_highlighter->tokenizeCode(code, language);
+				int pos = 0;
+				for (const CodeLexer::Token& token : tokens)
+				{
+					if (token.start > pos)
+					{
+						m_cursor.insertText(text.mid(pos, token.start - pos), codeCharFormat);
+					}
+					QTextCharFormat tokenFormat = codeCharFormat;
+					tokenFormat.merge(m_highlighter->tokenFormat(token.kind));
+					m_cursor.insertText(text.mid(token.start, token.length), tokenFormat);
+					pos = token.start + token.length;
+				}
+				if (pos < text.size())
+				{
+					m_cursor.insertText(text.mid(pos), codeCharFormat);
+				}
+			}
+			else
+			{
+				m_cursor.insertText(text, codeCharFormat);
+			}
+
+			// 回到框架之后（框架后的空块由下一个块复用）
+			m_cursor = frame->parentFrame()->lastCursorPosition();
+		}
+
+		QTextCursor m_cursor;
+		SyntaxHighlighter* m_highlighter;
+		SyntaxHighlighter::Theme m_theme;
+		QHash<QString, QString>* m_codeBlocks;
+		QVector<QTextCharFormat> m_charFormats; // 行内格式栈
+		QVector<ListState> m_lists;             // 列表嵌套栈
+		bool m_listItemPending = false;         // 列表项的第一个块尚未写入
+		int m_quoteDepth = 0;
+	};
+}
+
+MarkdownDocumentBuilder::MarkdownDocumentBuilder(SyntaxHighlighter* highlighter)
+	: m_highlighter(highlighter)
+{
+}
+
+void MarkdownDocumentBuilder::prepareDocument(QTextDocument& doc)
+{
+	QFont font(QStringLiteral("Microsoft YaHei"));
+	font.setPixelSize(kBodyPixelSize);
+	doc.setDefaultFont(font);
+	QTextOption option(Qt::AlignLeft | Qt::AlignVCenter);
+	option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+	doc.setDefaultTextOption(option);
+	// 性能优化：禁用不必要的功能以提升渲染速度
+	doc.setUndoRedoEnabled(false);
+	doc.setUseDesignMetrics(false);
+}
+
+QSize MarkdownDocumentBuilder::layoutDocument(QTextDocument& doc, int maxWidth)
+{
+	doc.setTextWidth(maxWidth);
+	const int width = qMax(0, qMin(maxWidth, qCeil(doc.idealWidth())));
+	if (width != maxWidth)
+	{
+		doc.setTextWidth(width);
+	}
+	return QSize(width, doc.size().toSize().height());
+}
+
+void MarkdownDocumentBuilder::build(QTextDocument& doc, const QString& markdown, const QColor& textColor,
+	QHash<QString, QString>* codeBlocks) const
+{
+	doc.clear();
+	prepareDocument(doc);
+	append(doc, markdown, textColor, codeBlocks);
+}
+
+void MarkdownDocumentBuilder::append(QTextDocument& doc, const QString& markdown, const QColor& textColor,
+	QHash<QString, QString>* codeBlocks) const
+{
+	if (markdown.isEmpty())
+	{
+		return;
+	}
+	const QByteArray markdownData = markdown.toUtf8();
+	cmark_parser* parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+	cmark_parser_feed(parser, markdownData.constData(), static_cast<size_t>(markdownData.size()));
+	cmark_node* root = cmark_parser_finish(parser);
+	DocumentWriter writer(doc, textColor, m_highlighter, codeBlocks);
+	writer.write(root);
+	cmark_node_free(root);
+	cmark_parser_free(parser);
+}
+
+QString MarkdownDocumentBuilder::toPlainText(const QString& markdown) const
+{
+	if (markdown.isEmpty())
+	{
+		return QString();
+	}
+	QTextDocument doc;
+	build(doc, markdown, QColor());
+	return doc.toPlainText();
+}
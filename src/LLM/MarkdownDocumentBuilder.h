@@ -0,0 +1,35 @@
+#pragma once
+#include <QTextDocument>
+#include <QString>
+#include <QColor>
+#include <QSize>
+#include <QHash>
+
+class SyntaxHighlighter;
+
+// Markdown 文档构建器
+// 遍历 cmark 语法树（cmark_iter），通过 QTextCursor、字符格式和框架直接写入 QTextDocument，
+// 省去 "渲染HTML -> 正则改写 -> QTextDocument 解析HTML" 的往返开销
+class MarkdownDocumentBuilder
+{
+public:
+	explicit MarkdownDocumentBuilder(SyntaxHighlighter* highlighter = nullptr);
+
+	// 设置代码高亮器（为空时代码块只使用默认主题，不做高亮）
+	void setHighlighter(SyntaxHighlighter* highlighter) { m_highlighter = highlighter; }
+	// 初始化文档的默认字体与换行方式（与内容无关，宽度变化时无需重建内容）
+	static void prepareDocument(QTextDocument& doc);
+	// 按最大宽度排版，短内容收缩到理想宽度，返回排版后的尺寸
+	static QSize layoutDocument(QTextDocument& doc, int maxWidth);
+	// 清空文档并写入整段Markdown
+	void build(QTextDocument& doc, const QString& markdown, const QColor& textColor,
+		QHash<QString, QString>* codeBlocks = nullptr) const;
+	// 在文档末尾追加一段Markdown（按块追加，用于流式输出），codeBlocks 不为空时记录 代码块ID -> 代码原文
+	void append(QTextDocument& doc, const QString& markdown, const QColor& textColor,
+		QHash<QString, QString>* codeBlocks = nullptr) const;
+	// 将Markdown转换为纯文本（复制、摘要使用）
+	QString toPlainText(const QString& markdown) const;
+
+private:
+	SyntaxHighlighter* m_highlighter = nullptr;
+};
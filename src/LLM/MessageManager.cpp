@@ -6,11 +6,11 @@
 #include <QDateTime>
 #include <QUrlQuery>
 #include <QSslConfiguration>
-#include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QHttpMultiPart>
 #include <QMimeDatabase>
 #include <QRegularExpression>
+#include <QThread>
 #include <QDebug>
 
 MessageManager::MessageManager(QObject *parent)
@@ -18,6 +18,16 @@ MessageManager::MessageManager(QObject *parent)
 {
 }
 
+MessageManager::~MessageManager()
+{
+    if (m_networkThread)
+    {
+        // 工作对象随线程结束释放，并在释放时中止其中的全部应答
+        m_networkThread->quit();
+        m_networkThread->wait();
+    }
+}
+
 void MessageManager::setLLMParams(LLMParams* params)
 {
     // 如果之前有创建自己的 m_LLMParams，且不是传入的参数，需要先删除（避免内存泄漏）
@@ -40,15 +50,168 @@ void MessageManager::buildRequest()
     m_NetWorkParams->clientRequest.setRawHeader("Content-Type", "application/json");
 }
 
-// 取消当前请求的公共函数
+// 取消所有进行中的请求
 void MessageManager::cancelCurrentRequest()
 {
-    if (m_NetWorkParams && m_NetWorkParams->clientNetWorkReply)
+    if (!m_NetWorkParams)
+        return;
+    while (!m_NetWorkParams->requests.empty())
+    {
+        abortRequest(m_NetWorkParams->requests.begin()->second.get());
+    }
+}
+
+void MessageManager::cancelRequest(quint64 requestId)
+{
+    if (ClientRequest* request = findRequest(requestId))
+    {
+        abortRequest(request);
+    }
+}
+
+void MessageManager::cancelRequests(RequestType type)
+{
+    if (!m_NetWorkParams)
+        return;
+    QList<quint64> matched;
+    for (const auto& entry : m_NetWorkParams->requests)
+    {
+        if (entry.second->type == type)
+            matched.append(entry.first);
+    }
+    for (quint64 requestId : matched)
+    {
+        cancelRequest(requestId);
+    }
+}
+
+QList<quint64> MessageManager::cancelSessionRequests(const QString& sessionId)
+{
+    QList<quint64> cancelled;
+    if (!m_NetWorkParams || sessionId.isEmpty())
+        return cancelled;
+    for (const auto& entry : m_NetWorkParams->requests)
+    {
+        if (entry.second->type == RequestType::ChatRequest && entry.second->sessionId == sessionId)
+        {
+            cancelled.append(entry.first);
+        }
+    }
+    for (quint64 requestId : cancelled)
+    {
+        cancelRequest(requestId);
+    }
+    return cancelled;
+}
+
+bool MessageManager::hasActiveRequest(const QString& sessionId) const
+{
+    if (!m_NetWorkParams)
+        return false;
+    for (const auto& entry : m_NetWorkParams->requests)
+    {
+        if (entry.second->type == RequestType::ChatRequest && entry.second->sessionId == sessionId)
+            return true;
+    }
+    return false;
+}
+
+QString MessageManager::requestSession(quint64 requestId) const
+{
+    const ClientRequest* request = findRequest(requestId);
+    return request ? request->sessionId : QString();
+}
+
+// 登记新请求
+ClientRequest* MessageManager::startRequest(RequestType type, NetworkOperation operation, int timeoutMs, const QString& sessionId)
+{
+    if (!m_NetWorkParams || !m_networkWorker)
+    {
+        delete operation.multiPart;
+        return nullptr;
+    }
+    auto request = std::make_unique<ClientRequest>();
+    request->id = ++m_NetWorkParams->nextRequestId;
+    request->type = type;
+    request->sessionId = sessionId;
+    const quint64 requestId = request->id;
+    if (timeoutMs > 0)
+    {
+        request->timeoutTimer = new QTimer(this);
+        request->timeoutTimer->setSingleShot(true);
+        connect(request->timeoutTimer, &QTimer::timeout, this, [this, requestId, type]() {
+            ClientRequest* expired = findRequest(requestId);
+            if (!expired)
+                return;
+            abortRequest(expired);
+            handleRequestTimeout(type);
+        });
+        request->timeoutTimer->start(timeoutMs);
+    }
+    if (operation.multiPart)
+    {
+        // multiPart（及其中的文件）在网络线程中读取
+        operation.multiPart->moveToThread(m_networkThread);
+    }
+    NetworkWorker* worker = m_networkWorker;
+    QMetaObject::invokeMethod(worker, [worker, requestId, operation]() {
+        worker->start(requestId, operation);
+    }, Qt::QueuedConnection);
+    ClientRequest* result = request.get();
+    m_NetWorkParams->requests.emplace(requestId, std::move(request));
+    return result;
+}
+
+ClientRequest* MessageManager::findRequest(quint64 requestId) const
+{
+    if (!m_NetWorkParams)
+        return nullptr;
+    auto it = m_NetWorkParams->requests.find(requestId);
+    return it != m_NetWorkParams->requests.end() ? it->second.get() : nullptr;
+}
+
+ClientRequest* MessageManager::senderRequest() const
+{
+    return m_dispatchingRequest;
+}
+
+void MessageManager::finishRequest(ClientRequest* request)
+{
+    if (!m_NetWorkParams || !request)
+        return;
+    auto it = m_NetWorkParams->requests.find(request->id);
+    if (it == m_NetWorkParams->requests.end())
+        return;
+    std::unique_ptr<ClientRequest> finished = std::move(it->second);
+    m_NetWorkParams->requests.erase(it);
+    if (finished->timeoutTimer)
+    {
+        finished->timeoutTimer->stop();
+        finished->timeoutTimer->deleteLater();
+    }
+}
+
+void MessageManager::abortRequest(ClientRequest* request)
+{
+    if (!request)
+        return;
+    if (NetworkWorker* worker = m_networkWorker)
     {
-        auto reply = std::move(m_NetWorkParams->clientNetWorkReply);
-        reply->abort();
-        reply->disconnect();
+        // 网络线程中止后不再投递；已在队列中的数据因请求已移除而被忽略
+        const quint64 requestId = request->id;
+        QMetaObject::invokeMethod(worker, [worker, requestId]() {
+            worker->abort(requestId);
+        }, Qt::QueuedConnection);
     }
+    finishRequest(request);
+}
+
+void MessageManager::handleRequestTimeout(RequestType type)
+{
+    if (type == RequestType::ConnectionCheck)
+        onCheckConnectionTimeout();
+    else if (type == RequestType::FetchModels)
+        onFetchModelsTimeout();
 }
 
 // 验证服务器URL
@@ -96,26 +259,43 @@ QNetworkRequest MessageManager::currentRequest() const
 	return m_NetWorkParams->clientRequest;
 }
 
-QNetworkReply* MessageManager::postRequest(const QByteArray& data)
+quint64 MessageManager::postRequest(const QByteArray& data, std::function<void(NetworkReplyData& reply)> handler)
 {
-	if (!m_NetWorkParams || !m_NetWorkParams->clientNetWorkManager)
+	if (!m_NetWorkParams)
+	{
+		return 0;
+	}
+	ClientRequest* request = startRequest(RequestType::ChatRequest,
+		NetworkOperation::post(m_NetWorkParams->clientRequest, data));
+	if (!request)
 	{
-		return nullptr;
+		return 0;
 	}
-	return m_NetWorkParams->clientNetWorkManager->post(m_NetWorkParams->clientRequest, data);
+	request->onFinished = [this, handler]() {
+		if (handler && m_dispatchingRequest)
+			handler(m_dispatchingRequest->result);
+	};
+	return request->id;
 }
 
 // 初始化网络管理器（用于 LLMClientManager 等外部类）
 void MessageManager::initializeNetworkManager()
 {
-	if (!m_NetWorkParams)
+	if (!m_NetWorkParams || m_networkThread)
 	{
 		return;
 	}
-	if (!m_NetWorkParams->clientNetWorkManager)
-	{
-		m_NetWorkParams->clientNetWorkManager = std::make_unique<QNetworkAccessManager>();
-	}
+	qRegisterMetaType<StreamDelta>();
+	qRegisterMetaType<StreamBatch>();
+	qRegisterMetaType<NetworkReplyData>();
+	m_networkThread = new QThread(this);
+	m_networkThread->setObjectName(QStringLiteral("LLMNetwork"));
+	m_networkWorker = new NetworkWorker();
+	m_networkWorker->moveToThread(m_networkThread);
+	connect(m_networkThread, &QThread::finished, m_networkWorker, &QObject::deleteLater);
+	connect(m_networkWorker, &NetworkWorker::streamBatch, this, &MessageManager::onNetworkStreamBatch);
+	connect(m_networkWorker, &NetworkWorker::finished, this, &MessageManager::onNetworkFinished);
+	m_networkThread->start();
 }
 
 // 提取 HTTP 错误短语（如 "Bad Request"、"Unauthorized" 等）
@@ -136,3 +316,77 @@ QString MessageManager::extractJsonField(const QString& jsonText, const QString&
     QJsonObject obj = doc.object();
     return obj.value(fieldName).toString();
 }
+
+// 网络线程投递的一批流式数据
+void MessageManager::onNetworkStreamBatch(quint64 requestId, const StreamBatch& batch)
+{
+    // 已取消或超时的请求丢弃
+    if (ClientRequest* request = findRequest(requestId))
+    {
+        handleStreamBatch(request, batch);
+    }
+}
+
+// 网络线程中请求结束：取出请求并调用其结束处理函数
+void MessageManager::onNetworkFinished(quint64 requestId, const NetworkReplyData& result)
+{
+    if (!m_NetWorkParams)
+        return;
+    auto it = m_NetWorkParams->requests.find(requestId);
+    if (it == m_NetWorkParams->requests.end())
+        return;
+    // 先从请求表移除，处理函数返回后释放；处理函数中的 finishRequest 不再有作用
+    std::unique_ptr<ClientRequest> request = std::move(it->second);
+    m_NetWorkParams->requests.erase(it);
+    if (request->timeoutTimer)
+    {
+        request->timeoutTimer->stop();
+        request->timeoutTimer->deleteLater();
+        request->timeoutTimer = nullptr;
+    }
+    request->result = result;
+    if (request->onFinished)
+    {
+        ClientRequest* previous = m_dispatchingRequest;
+        m_dispatchingRequest = request.get();
+        request->onFinished();
+        m_dispatchingRequest = previous;
+    }
+}
+
+void MessageManager::handleStreamBatch(ClientRequest* request, const StreamBatch& batch)
+{
+    if (!batch.meta.isEmpty())
+    {
+        handleStreamMeta(request, batch.meta);
+    }
+    if (!batch.deltas.isEmpty())
+    {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QString answer;
+        for (StreamDelta delta : batch.deltas)
+        {
+            delta.sequence = request->nextDeltaSequence++;
+            delta.deliveredMs = now;
+            if (delta.channel == StreamChannel::Answer)
+            {
+                answer += delta.text;
+            }
+            emit StreamDeltaReceived(request->id, delta);
+        }
+        if (!answer.isEmpty())
+        {
+            emit AnswerStream(request->id, answer);
+        }
+    }
+    if (!batch.error.isEmpty())
+    {
+        emit Answer(request->id, batch.error, true);
+    }
+}
+
+void MessageManager::handleStreamMeta(ClientRequest* request, const QJsonObject& meta)
+{
+    Q_UNUSED(request);
+    Q_UNUSED(meta);
+}
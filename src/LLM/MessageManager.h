@@ -11,12 +11,12 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <functional>
 #include "CommonTypes.h"
 #include "LLMParams.h"
+#include "NetworkWorker.h"
 
-// ǰʹ std::unique_ptr ʱֻҪǰ
-class QNetworkAccessManager;
-class QNetworkReply;
+class QThread;
 // AIProvider Ƶ CommonTypes.h
 
 enum class RequestType //API
@@ -30,12 +30,22 @@ enum class RequestType //API
 	FileUpload,
 	FileDelete
 };
+struct ClientRequest //еӦ߳Уֻ볬ʱ
+{
+	quint64 id = 0;
+	RequestType type = RequestType::ChatRequest;
+	QString sessionId;                     // ԻĻỰΪգ
+	NetworkReplyData result;               // Ӧ
+	std::function<void()> onFinished;      // ʱڽ߳е
+	QTimer* timeoutTimer = nullptr;        // ʱʱʱΪ
+	QString taskId;                        // IDDify ֹͣʱʹã
+	quint64 nextDeltaSequence = 0;         // һʽ
+};
 struct ClientNetWork //
 {
 	QNetworkRequest clientRequest;
-	std::unique_ptr<QNetworkAccessManager> clientNetWorkManager;
-	std::unique_ptr<QNetworkReply> clientNetWorkReply;
-	QByteArray rawBuffer;
+	std::map<quint64, std::unique_ptr<ClientRequest>> requests; // е󣬰ID
+	quint64 nextRequestId = 0;
 };
 struct KnowledgeBase//֪ʶ
 {
@@ -49,11 +59,22 @@ class MessageManager : public QObject
 	Q_OBJECT
 public:
 	explicit MessageManager(QObject *parent = nullptr);
-	virtual ~MessageManager() = default;
+	virtual ~MessageManager();
 
 	virtual void buildRequest();
 	virtual QUrl buildApiUrl(const QString& apiPath);
+	// ȡне
 	virtual void cancelCurrentRequest();
+	// ȡָ
+	void cancelRequest(quint64 requestId);
+	// ȡĳһ͵µӼ顢ģбȡ
+	void cancelRequests(RequestType type);
+	// ȡỰнеĶԻ󣬷رȡID
+	QList<quint64> cancelSessionRequests(const QString& sessionId);
+	// ỰǷнеĶԻ
+	bool hasActiveRequest(const QString& sessionId) const;
+	// ĻỰ
+	QString requestSession(quint64 requestId) const;
 	virtual bool validateServerUrl();
 	virtual void setLLMParams(LLMParams* params);
 	virtual QStringList getAvailableModels();// ȡģб
@@ -65,31 +86,31 @@ public:
 
 	// body
 	virtual QByteArray buildMessageBody(const ChatSendMessage& msg) = 0;
-	// ǰԤ
-	virtual void SendPreProcess(const ChatSendMessage& msg) = 0;
+	// ǰԤ󲢵Ǽǵdecoder ǿʱʽȡ
+	virtual ClientRequest* SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder = nullptr) = 0;
 	// ݴ
 	virtual QJsonObject parseJsonReplyToMsg(const QByteArray &data) = 0;
-	// Ϣ 
-	virtual int send(const ChatSendMessage& msg) = 0;
-	// Ϣʽ 
-	virtual int StreamSend(const ChatSendMessage& msg) = 0;
+	// ϢIDʧΪ0
+	virtual quint64 send(const ChatSendMessage& msg) = 0;
+	// ϢʽIDʧΪ0
+	virtual quint64 StreamSend(const ChatSendMessage& msg) = 0;
 	// 
 	virtual QString GetError(const QString& errorLevel, const QString& errorContext) = 0;
-	// ʽ
+	// ʽʱã
 	virtual void processStreamEnded() = 0;
 	// API
 	virtual QNetworkRequest createApiRequest(const QUrl& url) = 0;
-	// API
-	virtual void sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs) = 0;
+	// APItimeoutMs Ϊ0ʱʱ
+	virtual void sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs) = 0;
 
 	// === ӿڣװ˽гԱ ===
 	//  SSL 
 	void configureRequestSsl(const QSslConfiguration& config);
 	// ȡǰֻ
 	QNetworkRequest currentRequest() const;
-	//  POST ڹߵõȳ
-	QNetworkReply* postRequest(const QByteArray& data);
-	// ʼ LLMClientManager ⲿࣩ
+	//  POST ڹߵõȳʱڽ߳е handlerIDʧΪ0
+	quint64 postRequest(const QByteArray& data, std::function<void(NetworkReplyData& reply)> handler);
+	// ʼ̣߳ LLMClientManager ⲿࣩ
 	void initializeNetworkManager();
 	// (첽)
 	virtual void checkServerConnectionAsync(int timeoutMs) = 0;
@@ -104,9 +125,9 @@ public:
 	//ɾļ(ݿͻ˷صļID)
 	virtual void DeleteFile(const QString& fileID) = 0;
 	// blocking 
-	virtual void AnalysisBlockResponse(QJsonObject& response_obj) = 0;
+	virtual void AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj) = 0;
 	// streaming
-	virtual void AnalysisStreamResponse(QJsonObject& response_obj) = 0;
+	virtual void AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj) = 0;
 	// ֪ʶ
 	virtual void ChangeKnowledgeGraph(const QString& kownledgeID) = 0;
 	// ȡĳҪϴļ
@@ -117,9 +138,6 @@ public:
 protected:
 	ClientNetWork *m_NetWorkParams = nullptr;
 	LLMParams *m_LLMParams = nullptr;
-	QTimer *m_connectionCheckTimer = nullptr;
-	QTimer* m_fetchModelsTimer = nullptr;
-	RequestType m_currentRequestType; //¼ǰAPI
 	QStringList m_availableModelIds;  // 洢õģIDб
 	std::vector<KnowledgeBase> KnowledgeInfo;
 	QMap<QString, QString>m_UpFiles;
@@ -137,20 +155,23 @@ protected:
 	private slots:
 	// Blocking
 	virtual void getAnswer() = 0;
-	// Streaming
-	virtual void getStreamAnswer() = 0;
+	// ߳Ͷݵʽ
+	void onNetworkStreamBatch(quint64 requestId, const StreamBatch& batch);
+	void onNetworkFinished(quint64 requestId, const NetworkReplyData& result);
 
 signals:
 	// Blockingź 
-	void Answer(const QString& word, bool bError);
-	// Streamingź
-	void AnswerStream(const QString& word);
+	void Answer(quint64 requestId, const QString& word, bool bError);
+	// StreamingźţֻشģһϲΪһΣ
+	void AnswerStream(quint64 requestId, const QString& word);
+	// źʱʽÿһ
+	void StreamDeltaReceived(quint64 requestId, const StreamDelta& delta);
 
 	void ChangeButtonStatus(SendButtonState state);
 
-	void FunctionCallSignal(QJsonObject& Content);
+	void FunctionCallSignal(quint64 requestId, QJsonObject& Content);
 
-	void StreamEnded();
+	void StreamEnded(quint64 requestId);
 
 	void serverConnectionCheckFinished(bool isConnected, const QString &errorMessage);
 
@@ -167,6 +188,36 @@ protected:
 	//  JSON ıȡֶָΣ㣩
 	static QString extractJsonField(const QString& jsonText, const QString& fieldName);
 
+	// ǼͶݵ̷߳timeoutMs 0ʱʱֹ handleRequestTimeout
+	ClientRequest* startRequest(RequestType type, NetworkOperation operation, int timeoutMs = 0,
+		const QString& sessionId = QString());
+	// ʱ receiver  slotslot  senderRequest() ȡ
+	template <typename T>
+	void onRequestFinished(ClientRequest* request, T* receiver, void (T::*slot)())
+	{
+		if (request)
+			request->onFinished = [receiver, slot]() { (receiver->*slot)(); };
+	}
+	// 
+	ClientRequest* findRequest(quint64 requestId) const;
+	// ڽڽеãʱΪ
+	ClientRequest* senderRequest() const;
+	// ɣƳڽеʱڴغͷţ
+	void finishRequest(ClientRequest* request);
+	// ֹ󣬲ٴκδ
+	void abortRequest(ClientRequest* request);
+	// ʱֹƳ
+	virtual void handleRequestTimeout(RequestType type);
+
+	// ߳ѽһʽ
+	virtual void handleStreamBatch(ClientRequest* request, const StreamBatch& batch);
+	// дصĻỰ/ϢID
+	virtual void handleStreamMeta(ClientRequest* request, const QJsonObject& meta);
+
+private:
+	QThread* m_networkThread = nullptr;
+	NetworkWorker* m_networkWorker = nullptr;        //  m_networkThread
+	ClientRequest* m_dispatchingRequest = nullptr;   // ڵý
 };
 
 
@@ -0,0 +1,167 @@
+#include "NetworkWorker.h"
+#include <QNetworkAccessManager>
+#include <QHttpMultiPart>
+#include <QTimer>
+
+NetworkWorker::NetworkWorker(QObject* parent)
+	: QObject(parent)
+{
+}
+
+NetworkWorker::~NetworkWorker()
+{
+	abortAll();
+}
+
+void NetworkWorker::start(quint64 requestId, NetworkOperation operation)
+{
+	// 在网络线程中第一次使用时创建，QNetworkAccessManager 与其应答都属于本线程
+	if (!m_manager)
+	{
+		m_manager = std::make_unique<QNetworkAccessManager>();
+		m_batchTimer = new QTimer(this);
+		m_batchTimer->setSingleShot(true);
+		m_batchTimer->setInterval(kBatchIntervalMs);
+		connect(m_batchTimer, &QTimer::timeout, this, &NetworkWorker::flushBatches);
+	}
+
+	QNetworkReply* reply = nullptr;
+	switch (operation.verb)
+	{
+	case NetworkOperation::Verb::Get:
+		reply = m_manager->get(operation.request);
+		break;
+	case NetworkOperation::Verb::Post:
+		if (operation.multiPart)
+		{
+			reply = m_manager->post(operation.request, operation.multiPart);
+			// multiPart会在reply删除时自动删除
+			operation.multiPart->setParent(reply);
+		}
+		else
+		{
+			reply = m_manager->post(operation.request, operation.body);
+		}
+		break;
+	case NetworkOperation::Verb::Delete:
+		reply = m_manager->deleteResource(operation.request);
+		break;
+	}
+
+	auto job = std::make_unique<Job>();
+	job->reply = reply;
+	job->decoder = std::move(operation.decoder);
+	if (job->decoder)
+	{
+		job->parser.reset(job->decoder->format());
+		// 与应答在同一线程，直接连接，数据到达即读取
+		connect(reply, &QNetworkReply::readyRead, this, [this, requestId]() {
+			auto it = m_jobs.find(requestId);
+			if (it != m_jobs.end() && it->second->reply->error() == QNetworkReply::NoError)
+			{
+				readStream(*it->second);
+			}
+		});
+	}
+	connect(reply, &QNetworkReply::finished, this, [this, requestId]() {
+		onReplyFinished(requestId);
+	});
+	m_jobs.emplace(requestId, std::move(job));
+}
+
+void NetworkWorker::abort(quint64 requestId)
+{
+	auto it = m_jobs.find(requestId);
+	if (it == m_jobs.end())
+	{
+		return;
+	}
+	std::unique_ptr<Job> job = std::move(it->second);
+	m_jobs.erase(it);
+	disconnect(job->reply, nullptr, this, nullptr);
+	job->reply->abort();
+	job->reply->deleteLater();
+}
+
+void NetworkWorker::abortAll()
+{
+	while (!m_jobs.empty())
+	{
+		abort(m_jobs.begin()->first);
+	}
+}
+
+void NetworkWorker::readStream(Job& job)
+{
+	const QByteArray data = job.reply->readAll();
+	StreamDecoder* decoder = job.decoder.get();
+	StreamBatch& out = job.pending;
+	job.parser.feed(data, [decoder, &out](const StreamFrameParser::Frame& frame) {
+		decoder->decode(frame, out);
+	});
+	// 定时器已在运行时不重新计时，持续到达的数据最多延迟一个间隔
+	if (!out.isEmpty() && !m_batchTimer->isActive())
+	{
+		m_batchTimer->start();
+	}
+}
+
+void NetworkWorker::flushBatches()
+{
+	for (auto& entry : m_jobs)
+	{
+		flushJob(entry.first, *entry.second);
+	}
+}
+
+void NetworkWorker::flushJob(quint64 requestId, Job& job)
+{
+	if (job.pending.isEmpty())
+	{
+		return;
+	}
+	StreamBatch batch;
+	std::swap(batch, job.pending);
+	emit streamBatch(requestId, batch);
+}
+
+void NetworkWorker::onReplyFinished(quint64 requestId)
+{
+	auto it = m_jobs.find(requestId);
+	if (it == m_jobs.end())
+	{
+		return;
+	}
+	std::unique_ptr<Job> job = std::move(it->second);
+	m_jobs.erase(it);
+	QNetworkReply* reply = job->reply;
+
+	NetworkReplyData result;
+	result.errorCode = reply->error();
+	result.errorText = reply->errorString();
+	result.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (job->decoder && result.errorCode == QNetworkReply::NoError)
+	{
+		// 处理最后一次 readyRead 之后的数据和没有以换行结束的最后一帧
+		readStream(*job);
+		StreamDecoder* decoder = job->decoder.get();
+		StreamBatch& out = job->pending;
+		job->parser.finish([decoder, &out](const StreamFrameParser::Frame& frame) {
+			decoder->decode(frame, out);
+		});
+		decoder->finish(out);
+		flushJob(requestId, *job);
+	}
+	else
+	{
+		// 出错前已解析、还在等待定时批量发送的片段先发出，已收到的部分回答不丢失
+		if (job->decoder)
+		{
+			flushJob(requestId, *job);
+		}
+		// 非流式请求的响应体，或流式请求出错时的错误内容
+		result.body = reply->readAll();
+	}
+	reply->deleteLater();
+	emit finished(requestId, result);
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QMetaType>
+#include <QVector>
+#include <map>
+#include <memory>
+#include "StreamFrameParser.h"
+
+class QNetworkAccessManager;
+class QHttpMultiPart;
+class QTimer;
+
+// 流式增量的类别
+enum class StreamChannel
+{
+	Reasoning,  // 推理内容
+	Answer,     // 回答正文（模型自己输出的 <think> 标记仍在正文中）
+	ToolCall,   // 工具调用（JSON 文本）
+	Usage       // 用量统计（JSON 文本）
+};
+
+// 一条带类别的流式增量：解码器按帧生成，接收方不必再从文本中查找标记
+struct StreamDelta
+{
+	StreamChannel channel = StreamChannel::Answer;
+	QString text;
+	quint64 sequence = 0;    // 请求内的序号，从 0 开始（界面线程发出时分配）
+	qint64 receivedMs = 0;   // 网络线程解码的时刻（自纪元起的毫秒）
+	qint64 deliveredMs = 0;  // 界面线程发出的时刻
+};
+
+// 一批已解码的流式数据：网络线程按固定间隔合并后一次性投递到界面线程
+struct StreamBatch
+{
+	QVector<StreamDelta> deltas;  // 按到达顺序
+	QJsonObject meta;   // 服务端返回的会话/消息ID等，后到的覆盖先到的
+	QString error;      // 流中的错误事件
+
+	// 追加一条增量，记录解码时刻
+	void append(StreamChannel channel, const QString& text)
+	{
+		if (text.isEmpty())
+		{
+			return;
+		}
+		StreamDelta delta;
+		delta.channel = channel;
+		delta.text = text;
+		delta.receivedMs = QDateTime::currentMSecsSinceEpoch();
+		deltas.append(delta);
+	}
+	bool isEmpty() const { return deltas.isEmpty() && meta.isEmpty() && error.isEmpty(); }
+};
+
+// 流式帧解码器：在网络线程中运行，只能访问自身的状态
+class StreamDecoder
+{
+public:
+	virtual ~StreamDecoder() = default;
+	// 分帧格式
+	virtual StreamFrameParser::Format format() const = 0;
+	// 解码一帧，结果追加到 out
+	virtual void decode(const StreamFrameParser::Frame& frame, StreamBatch& out) = 0;
+	// 流结束，输出解码器中暂存的内容
+	virtual void finish(StreamBatch& out) { Q_UNUSED(out); }
+};
+
+// 在网络线程中结束的应答快照，接口与 QNetworkReply 的常用部分一致
+struct NetworkReplyData
+{
+	QNetworkReply::NetworkError errorCode = QNetworkReply::NoError;
+	QString errorText;
+	int statusCode = 0;
+	QByteArray body;    // 流式请求成功时为空（数据已经解码）
+
+	QNetworkReply::NetworkError error() const { return errorCode; }
+	QString errorString() const { return errorText; }
+	QVariant attribute(QNetworkRequest::Attribute code) const
+	{
+		return code == QNetworkRequest::HttpStatusCodeAttribute ? QVariant(statusCode) : QVariant();
+	}
+	// 与 QNetworkReply::readAll 一样只能读取一次
+	QByteArray readAll()
+	{
+		QByteArray data;
+		data.swap(body);
+		return data;
+	}
+};
+
+// 一次要发出的网络操作
+struct NetworkOperation
+{
+	enum class Verb
+	{
+		Get,
+		Post,
+		Delete
+	};
+	Verb verb = Verb::Get;
+	QNetworkRequest request;
+	QByteArray body;
+	QHttpMultiPart* multiPart = nullptr;      // 非空时以 multipart 发送，所有权转移到网络线程
+	std::shared_ptr<StreamDecoder> decoder;   // 非空时按流式读取并在网络线程中解码
+
+	static NetworkOperation get(const QNetworkRequest& request)
+	{
+		NetworkOperation op;
+		op.verb = Verb::Get;
+		op.request = request;
+		return op;
+	}
+	static NetworkOperation post(const QNetworkRequest& request, const QByteArray& body,
+		std::shared_ptr<StreamDecoder> decoder = nullptr)
+	{
+		NetworkOperation op;
+		op.verb = Verb::Post;
+		op.request = request;
+		op.body = body;
+		op.decoder = std::move(decoder);
+		return op;
+	}
+	static NetworkOperation post(const QNetworkRequest& request, QHttpMultiPart* multiPart)
+	{
+		NetworkOperation op;
+		op.verb = Verb::Post;
+		op.request = request;
+		op.multiPart = multiPart;
+		return op;
+	}
+	static NetworkOperation deleteResource(const QNetworkRequest& request)
+	{
+		NetworkOperation op;
+		op.verb = Verb::Delete;
+		op.request = request;
+		return op;
+	}
+};
+
+Q_DECLARE_METATYPE(StreamDelta)
+Q_DECLARE_METATYPE(StreamBatch)
+Q_DECLARE_METATYPE(NetworkReplyData)
+
+// 网络线程中的工作对象：持有 QNetworkAccessManager 和全部应答
+// 流式数据在本线程中分帧、解码，按 kBatchIntervalMs 合并后发给界面线程，读取不受界面繁忙影响
+// 除构造外的成员函数都只能在网络线程中调用（由 MessageManager 通过 QMetaObject::invokeMethod 投递）
+class NetworkWorker : public QObject
+{
+	Q_OBJECT
+public:
+	explicit NetworkWorker(QObject* parent = nullptr);
+	~NetworkWorker();
+
+	// 发出请求
+	void start(quint64 requestId, NetworkOperation operation);
+	// 中止请求，不再发出任何信号
+	void abort(quint64 requestId);
+	// 中止全部请求（线程退出前调用）
+	void abortAll();
+
+signals:
+	// 流式数据（同一请求的批次按顺序到达，且都在 finished 之前）
+	void streamBatch(quint64 requestId, const StreamBatch& batch);
+	// 请求结束
+	void finished(quint64 requestId, const NetworkReplyData& result);
+
+private:
+	struct Job
+	{
+		QNetworkReply* reply = nullptr;
+		StreamFrameParser parser;
+		std::shared_ptr<StreamDecoder> decoder;
+		StreamBatch pending;   // 尚未投递的解码结果
+	};
+
+	// 读取并解码新到达的流式数据
+	void readStream(Job& job);
+	// 投递所有请求积累的解码结果
+	void flushBatches();
+	void flushJob(quint64 requestId, Job& job);
+	void onReplyFinished(quint64 requestId);
+
+	std::unique_ptr<QNetworkAccessManager> m_manager;
+	std::map<quint64, std::unique_ptr<Job>> m_jobs;
+	QTimer* m_batchTimer = nullptr;
+	static constexpr int kBatchIntervalMs = 16;
+};
@@ -1,32 +1,61 @@
 #include "OllamaClient.h"
 
+namespace
+{
+	// Ollama ʽӦ룺ÿһ JSONġߵúͽʱֱ
+	class OllamaStreamDecoder : public StreamDecoder
+	{
+	public:
+		StreamFrameParser::Format format() const override
+		{
+			return StreamFrameParser::Format::NdJson;
+		}
+
+		void decode(const StreamFrameParser::Frame& frame, StreamBatch& out) override
+		{
+			// frame.data ǻеһУֱӽٸ
+			const QJsonObject obj = QJsonDocument::fromJson(frame.data).object();
+			if (!obj.contains("message"))
+			{
+				return;
+			}
+			const QJsonObject msg = obj["message"].toObject();
+			out.append(StreamChannel::Reasoning, msg.value("thinking").toString());
+			out.append(StreamChannel::Answer, msg.value("content").toString());
+			const QJsonArray toolCalls = msg.value("tool_calls").toArray();
+			if (!toolCalls.isEmpty())
+			{
+				out.append(StreamChannel::ToolCall, QString::fromUtf8(QJsonDocument(toolCalls).toJson(QJsonDocument::Compact)));
+			}
+			if (obj.value("done").toBool())
+			{
+				QJsonObject usage;
+				for (const char* key : { "prompt_eval_count", "eval_count", "prompt_eval_duration", "eval_duration", "total_duration" })
+				{
+					if (obj.contains(key))
+					{
+						usage.insert(key, obj[key]);
+					}
+				}
+				if (!usage.isEmpty())
+				{
+					out.append(StreamChannel::Usage, QString::fromUtf8(QJsonDocument(usage).toJson(QJsonDocument::Compact)));
+				}
+			}
+		}
+	};
+}
+
 OllamaClient::OllamaClient(QObject *parent)
 	: MessageManager(parent)
 {
 	m_LLMParams = new LLMParams();
 	m_NetWorkParams = new ClientNetWork();
-
-	// ʼӲԶʱ
-	m_connectionCheckTimer = new QTimer(this);
-	m_connectionCheckTimer->setSingleShot(true);
-	connect(m_connectionCheckTimer, &QTimer::timeout, this, &OllamaClient::onCheckConnectionTimeout);
-
-	// ʼȡģбʱ
-	m_fetchModelsTimer = new QTimer(this);
-	m_fetchModelsTimer->setSingleShot(true);
-	connect(m_fetchModelsTimer, &QTimer::timeout, this, &OllamaClient::onFetchModelsTimeout);
-
-	m_currentRequestType = RequestType::ConnectionCheck;
 }
 
 OllamaClient::~OllamaClient()
 {
-	if (m_NetWorkParams && m_NetWorkParams->clientNetWorkReply)
-	{
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply->disconnect();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
+	cancelCurrentRequest();
 	// ע⣺m_LLMParams ѱ setLLMParams() ΪⲿĶ
 	// setLLMParams() Ѿ˹캯д m_LLMParams ɾ
 	//  m_LLMParams ⲿģӦɾⲿ
@@ -64,6 +93,18 @@ QByteArray OllamaClient::buildMessageBody(const ChatSendMessage& msg)
 		{ 2, "gkgvision" },
 		{ 3, "Codeinter" }
 	};
+	// ʷԻǰںʷڴǰ֮ǰֽڲ
+	for (const ChatHistoryTurn& turn : msg.history)
+	{
+		QJsonObject historyObject;
+		historyObject["role"] = turn.role;
+		historyObject["content"] = turn.content;
+		if (!turn.reasoning.isEmpty())
+		{
+			historyObject["thinking"] = turn.reasoning;
+		}
+		messagesArray.append(historyObject);
+	}
 	messageObject["role"] = "user";//ɫ
 
 								   //Ϣ:Ϣ+ĵi...
@@ -116,14 +157,15 @@ QByteArray OllamaClient::buildMessageBody(const ChatSendMessage& msg)
 	return QJsonDocument(SendMessageBody).toJson();
 }
 
-void OllamaClient::SendPreProcess(const ChatSendMessage& msg)
+ClientRequest* OllamaClient::SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder)
 {
 	QByteArray postData = buildMessageBody(msg);
 	QSslConfiguration config = QSslConfiguration::defaultConfiguration();
 	config.setProtocol(QSsl::AnyProtocol);
 	config.setPeerVerifyMode(QSslSocket::VerifyNone);
 	m_NetWorkParams->clientRequest.setSslConfiguration(config);
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(m_NetWorkParams->clientNetWorkManager->post(m_NetWorkParams->clientRequest, postData));
+	return startRequest(RequestType::ChatRequest,
+		NetworkOperation::post(m_NetWorkParams->clientRequest, postData, std::move(decoder)), 0, msg.sessionId);
 }
 
 QJsonObject OllamaClient::parseJsonReplyToMsg(const QByteArray &data)
@@ -136,21 +178,22 @@ QJsonObject OllamaClient::parseJsonReplyToMsg(const QByteArray &data)
 	return rsp_json;
 }
 
-int OllamaClient::send(const ChatSendMessage& msg)
+quint64 OllamaClient::send(const ChatSendMessage& msg)
 {
-	m_isStreamingReasoning = false;
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &OllamaClient::getAnswer);
-	return true;
+	ClientRequest* request = SendPreProcess(msg);
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &OllamaClient::getAnswer);
+	return request->id;
 }
 
-int OllamaClient::StreamSend(const ChatSendMessage& msg)
+quint64 OllamaClient::StreamSend(const ChatSendMessage& msg)
 {
-	m_isStreamingReasoning = false;
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::readyRead, this, &OllamaClient::getStreamAnswer, Qt::QueuedConnection);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &OllamaClient::processStreamEnded);
-	return true;
+	ClientRequest* request = SendPreProcess(msg, std::make_shared<OllamaStreamDecoder>());
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &OllamaClient::processStreamEnded);
+	return request->id;
 }
 
 QString OllamaClient::GetError(const QString& errorLevel, const QString& errorContext)
@@ -192,27 +235,33 @@ QString OllamaClient::GetError(const QString& errorLevel, const QString& errorCo
 
 void OllamaClient::processStreamEnded()
 {
-	if (m_NetWorkParams->clientNetWorkReply->error())
-	{
-		QString errorMsg = GetError(m_NetWorkParams->clientNetWorkReply->errorString(), m_NetWorkParams->clientNetWorkReply->readAll());
-		emit Answer(errorMsg, true);
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
-	}
-	if (m_isStreamingReasoning)
+	const quint64 requestId = request->id;
+	NetworkReplyData* reply = &request->result;
+	if (reply->error())
 	{
-		emit AnswerStream(QStringLiteral("</think>"));
-		m_isStreamingReasoning = false;
+		QString errorMsg = GetError(reply->errorString(), reply->readAll());
+		finishRequest(request);
+		emit Answer(requestId, errorMsg, true);
+		return;
 	}
-	m_NetWorkParams->rawBuffer.clear();
-	emit StreamEnded();
+	// ʣݺδպϵ߳ڽź֮ǰͶ
+	finishRequest(request);
+	emit StreamEnded(requestId);
 }
 
 void OllamaClient::getAnswer()
 {
-
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	ClientRequest* request = senderRequest();
+	if (!request)
+		return;
+	const quint64 requestId = request->id;
+	NetworkReplyData* reply = &request->result;
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		QByteArray read_data = m_NetWorkParams->clientNetWorkReply->readAll();
+		QByteArray read_data = reply->readAll();
 		QJsonObject Content = parseJsonReplyToMsg(read_data);
 		QString textresponse;
 		bool isFunctionCall = Content.contains("tool_calls");
@@ -232,74 +281,27 @@ void OllamaClient::getAnswer()
 				{
 					textresponse = content;
 				}
-				emit Answer(textresponse, false);
+				emit Answer(requestId, textresponse, false);
 			}
 			else
 			{
-				emit Answer("Invalid response format", false);
+				emit Answer(requestId, "Invalid response format", false);
 			}
 		}
 		else
 		{
-			emit FunctionCallSignal(Content);
+			emit FunctionCallSignal(requestId, Content);
 
 		}
 	}
 	else
 	{
-		emit Answer(GetError(m_NetWorkParams->clientNetWorkReply->errorString(), m_NetWorkParams->clientNetWorkReply->readAll()), true);
+		emit Answer(requestId, GetError(reply->errorString(), reply->readAll()), true);
 	}
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	ChangeButtonStatus(SendButtonState::Ready);
 }
 
-void OllamaClient::getStreamAnswer()
-{
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
-	{
-		QByteArray response_data = m_NetWorkParams->clientNetWorkReply->readAll();
-		m_NetWorkParams->rawBuffer.append(response_data);
-		QByteArray tmp_data = QByteArray(response_data);
-		int pos;
-		while ((pos = m_NetWorkParams->rawBuffer.indexOf("\n")) != -1)
-		{
-			QByteArray chunk = m_NetWorkParams->rawBuffer.left(pos);
-			m_NetWorkParams->rawBuffer.remove(0, pos + 1);
-			if (chunk.trimmed().isEmpty())
-			{
-				continue;
-			}
-			QJsonObject obj = parseJsonReplyToMsg(chunk);
-			if (obj.contains("message"))
-			{
-				QJsonObject msg = obj["message"].toObject();
-				const QString reasoning = msg.value("thinking").toString();
-				const QString content = msg.value("content").toString();
-
-				if (!reasoning.isEmpty()) {
-					if (!m_isStreamingReasoning) {
-						emit AnswerStream(QStringLiteral("<think>%1").arg(reasoning));
-						m_isStreamingReasoning = true;
-					}
-					else {
-						emit AnswerStream(reasoning);
-					}
-				}
-
-				if (!content.isEmpty()) {
-					if (m_isStreamingReasoning) {
-						emit AnswerStream(QStringLiteral("</think>%1").arg(content));
-						m_isStreamingReasoning = false;
-					}
-					else {
-						emit AnswerStream(content);
-					}
-				}
-			}
-		}
-	}
-}
-
 QNetworkRequest OllamaClient::createApiRequest(const QUrl& url)
 {
 	QNetworkRequest request(url);
@@ -324,30 +326,24 @@ QNetworkRequest OllamaClient::createApiRequest(const QUrl& url)
 	return request;
 }
 
-void OllamaClient::sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs)
+void OllamaClient::sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs)
 {
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->get(request));
+	ClientRequest* apiRequest = startRequest(type, NetworkOperation::get(request), timeoutMs);
+	if (!apiRequest)
+		return;
 
 	// ӦĴ
-	if (m_currentRequestType == RequestType::FetchModels)
+	if (type == RequestType::FetchModels)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &OllamaClient::onFetchModelsFinished);
-		// ʱʱ
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &OllamaClient::onFetchModelsFinished);
 	}
-	else if (m_currentRequestType == RequestType::ConnectionCheck)
+	else if (type == RequestType::ConnectionCheck)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &OllamaClient::onCheckConnectionFinished);
-		// ʱʱ
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &OllamaClient::onCheckConnectionFinished);
 	}
-	else if (m_currentRequestType == RequestType::GetKonwledgeBase)
+	else if (type == RequestType::GetKonwledgeBase)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &OllamaClient::onGetKnowledgeBaseFinished);
+		onRequestFinished(apiRequest, this, &OllamaClient::onGetKnowledgeBaseFinished);
 	}
 }
 
@@ -400,11 +396,8 @@ QStringList OllamaClient::parseModelIds(const QByteArray &jsonData)
 
 void OllamaClient::checkServerConnectionAsync(int timeoutMs)
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::ConnectionCheck;
+	// ȡ֮ǰӼ
+	cancelRequests(RequestType::ConnectionCheck);
 
 	// ֤URL
 	if (!validateServerUrl())
@@ -416,29 +409,24 @@ void OllamaClient::checkServerConnectionAsync(int timeoutMs)
 	// 󲢷
 	QUrl testUrl = buildApiUrl("/api/version");
 	QNetworkRequest testRequest = createApiRequest(testUrl);
-	sendApiRequest(testRequest, m_connectionCheckTimer, timeoutMs);
+	sendApiRequest(RequestType::ConnectionCheck, testRequest, timeoutMs);
 }
 
 void OllamaClient::onCheckConnectionFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
-		return;
-	}
-
-	// Ƿʱ
-	if (!m_connectionCheckTimer->isActive()) {
-		m_NetWorkParams->clientNetWorkReply.reset();
+	// ʱѱֹƳ
+	ClientRequest* request = senderRequest();
+	if (!request) {
 		return;
 	}
-
-	m_connectionCheckTimer->stop();
+	NetworkReplyData* reply = &request->result;
 
 	bool isConnected = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
@@ -453,20 +441,17 @@ void OllamaClient::onCheckConnectionFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	emit serverConnectionCheckFinished(isConnected, errorMessage);
 }
 
 void OllamaClient::fetchModelsAsync(int timeoutMs)
 {
-	// ȡ֮ǰ
-	cancelCurrentRequest();
-
-	// 
-	m_currentRequestType = RequestType::FetchModels;
+	// ȡ֮ǰģб
+	cancelRequests(RequestType::FetchModels);
 
 	// ֤URL
 	if (!validateServerUrl())
@@ -478,35 +463,30 @@ void OllamaClient::fetchModelsAsync(int timeoutMs)
 	// 󲢷
 	QUrl modelsUrl = buildApiUrl("/api/tags");
 	QNetworkRequest modelsRequest = createApiRequest(modelsUrl);
-	sendApiRequest(modelsRequest, m_fetchModelsTimer, timeoutMs);
+	sendApiRequest(RequestType::FetchModels, modelsRequest, timeoutMs);
 }
 
 void OllamaClient::onFetchModelsFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
-		return;
-	}
-
-	// Ƿʱ
-	if (!m_fetchModelsTimer->isActive()) {
-		m_NetWorkParams->clientNetWorkReply.reset();
+	// ʱѱֹƳ
+	ClientRequest* request = senderRequest();
+	if (!request) {
 		return;
 	}
-
-	m_fetchModelsTimer->stop();
+	NetworkReplyData* reply = &request->result;
 
 	bool success = false;
 	QString errorMessage;
 	QStringList models;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			models = parseModelIds(responseData);
 
 			if (!models.isEmpty())
@@ -529,40 +509,24 @@ void OllamaClient::onFetchModelsFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	emit modelsListFetched(success, models, errorMessage);
 }
 
 void OllamaClient::onCheckConnectionTimeout()
 {
-	if (m_NetWorkParams->clientNetWorkReply)
-	{
-		disconnect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &OllamaClient::onCheckConnectionFinished);
-
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
 	emit serverConnectionCheckFinished(false, tr("Please Check IP Address or Network Setting"));
 }
 
 void OllamaClient::onFetchModelsTimeout()
 {
-	if (m_NetWorkParams->clientNetWorkReply)
-	{
-		disconnect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &OllamaClient::onFetchModelsFinished);
-
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
 	emit modelsListFetched(false, QStringList(), tr("Fetch ModelList Timeout"));
 }
 
-void OllamaClient::AnalysisBlockResponse(QJsonObject& response_obj)
+void OllamaClient::AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj)
 {
 	QString textresponse;
 	bool isFunctionCall = response_obj.contains("tool_calls");
@@ -573,21 +537,21 @@ void OllamaClient::AnalysisBlockResponse(QJsonObject& response_obj)
 		if (value.isString())
 		{
 			textresponse = value.toString();
-			emit Answer(textresponse, false);
+			emit Answer(request->id, textresponse, false);
 		}
 		else
 		{
-			emit Answer("Invalid response format", false);
+			emit Answer(request->id, "Invalid response format", false);
 		}
 	}
 	else
 	{
-		emit FunctionCallSignal(response_obj);
+		emit FunctionCallSignal(request->id, response_obj);
 
 	}
 }
 
-void OllamaClient::AnalysisStreamResponse(QJsonObject& response_obj)
+void OllamaClient::AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj)
 {
 
 }
@@ -19,13 +19,13 @@ public:
 	// Ϣ
 	QByteArray buildMessageBody(const ChatSendMessage& msg) override;
 	// ǰԤ
-	void SendPreProcess(const ChatSendMessage& msg) override;
+	ClientRequest* SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder = nullptr) override;
 	// JSONظΪϢ
 	QJsonObject parseJsonReplyToMsg(const QByteArray &data) override;
 	// Ϣʽ
-	int send(const ChatSendMessage& msg) override;
+	quint64 send(const ChatSendMessage& msg) override;
 	// Ϣʽ䣩
-	int StreamSend(const ChatSendMessage& msg) override;
+	quint64 StreamSend(const ChatSendMessage& msg) override;
 	// ȡϢ
 	QString GetError(const QString& errorLevel, const QString& errorContext) override;
 	// ʽ
@@ -33,7 +33,7 @@ public:
 	// API
 	QNetworkRequest createApiRequest(const QUrl& url) override;
 	// API
-	void sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs) override;
+	void sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs) override;
 	// ӣ첽
 	void checkServerConnectionAsync(int timeoutMs) override;
 	// ģIDб
@@ -49,9 +49,9 @@ public:
 	// ɾļ
 	void DeleteFile(const QString& fileID) override;
 	// ʽӦ
-	void AnalysisBlockResponse(QJsonObject& response_obj) override;
+	void AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj) override;
 	// ʽӦ
-	void AnalysisStreamResponse(QJsonObject& response_obj) override;
+	void AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj) override;
 	// ֪ʶͼ
 	void ChangeKnowledgeGraph(const QString& kownledgeID) override;
 	// ȡļϴ
@@ -61,10 +61,6 @@ public:
 
 	// ӵ֪ʶ⼯
 	std::set<QString> addKnowledge;
-private:
-	// Ƿʽ
-	bool m_isStreamingReasoning = false;
-
 	public slots:
 	// ȡģбɴ
 	void onFetchModelsFinished() override;
@@ -84,8 +80,6 @@ private:
 	private slots:
 	// ʽش
 	void getAnswer() override;
-	// ʽش
-	void getStreamAnswer() override;
 
 };
 
@@ -4,33 +4,145 @@
 #include <QHttpMultiPart>
 #include <QMimeDatabase>
 
+namespace
+{
+	// 取出 choices[0] 中的消息对象（流式为 delta，非流式为 message），格式不符时为空
+	// root 非空时同时取出根对象（用量等字段在根对象中）
+	QJsonObject choiceMessage(const QByteArray &data, const QString& messageKey, QJsonObject* root = nullptr)
+	{
+		QJsonObject msg;
+
+		// 检查输入数据是否为空
+		if (data.isEmpty())
+		{
+			return msg;
+		}
+
+		QJsonParseError parseError;
+		QJsonDocument response_doc = QJsonDocument::fromJson(data, &parseError);
+
+		// 检查JSON解析是否成功
+		if (parseError.error != QJsonParseError::NoError)
+		{
+			return msg;
+		}
+
+		// 检查文档是否为空或不是对象类型
+		if (response_doc.isNull() || !response_doc.isObject())
+		{
+			return msg;
+		}
+
+		// 获取根JSON对象
+		QJsonObject rsp_json = response_doc.object();
+		if (root)
+		{
+			*root = rsp_json;
+		}
+
+		// 检查是否包含choices字段
+		if (!rsp_json.contains("choices"))
+		{
+			return msg;
+		}
+
+		// 获取choices数组
+		QJsonValue choicesValue = rsp_json.value("choices");
+		if (!choicesValue.isArray())
+		{
+			return msg;
+		}
+
+		QJsonArray choicesArray = choicesValue.toArray();
+
+		// 检查choices数组是否为空
+		if (choicesArray.isEmpty())
+		{
+			return msg;
+		}
+
+		// 获取第一个choice对象
+		QJsonValue firstChoice = choicesArray[0];
+		if (!firstChoice.isObject())
+		{
+			return msg;
+		}
+
+		QJsonObject choiceObj = firstChoice.toObject();
+
+		if (!choiceObj.contains(messageKey))
+		{
+			return msg;
+		}
+
+		QJsonValue messageValue = choiceObj.value(messageKey);
+		if (!messageValue.isObject())
+		{
+			return msg;
+		}
+
+		msg = messageValue.toObject();
+
+		return msg;
+	}
+
+	// OpenAI 兼容流式响应解码：推理、正文、工具调用和用量分别输出，在网络线程中运行
+	class OpenWebUIStreamDecoder : public StreamDecoder
+	{
+	public:
+		// showReasoning 在发送时确定，流式过程中不再读取界面设置
+		explicit OpenWebUIStreamDecoder(bool showReasoning)
+			: m_showReasoning(showReasoning)
+		{
+		}
+
+		StreamFrameParser::Format format() const override
+		{
+			return StreamFrameParser::Format::ServerSentEvents;
+		}
+
+		void decode(const StreamFrameParser::Frame& frame, StreamBatch& out) override
+		{
+			if (frame.done || frame.data.isEmpty())
+			{
+				return;
+			}
+
+			QJsonObject root;
+			const QJsonObject deltaObj = choiceMessage(frame.data, QStringLiteral("delta"), &root);
+			if (m_showReasoning)
+			{
+				out.append(StreamChannel::Reasoning, deltaObj.value("reasoning_content").toString());
+			}
+			out.append(StreamChannel::Answer, deltaObj.value("content").toString());
+			const QJsonArray toolCalls = deltaObj.value("tool_calls").toArray();
+			if (!toolCalls.isEmpty())
+			{
+				out.append(StreamChannel::ToolCall, QString::fromUtf8(QJsonDocument(toolCalls).toJson(QJsonDocument::Compact)));
+			}
+			// 开启 stream_options.include_usage 时最后一帧带用量
+			const QJsonObject usage = root.value("usage").toObject();
+			if (!usage.isEmpty())
+			{
+				out.append(StreamChannel::Usage, QString::fromUtf8(QJsonDocument(usage).toJson(QJsonDocument::Compact)));
+			}
+		}
+
+	private:
+		const bool m_showReasoning;
+	};
+}
+
 Open_WebUIClient::Open_WebUIClient(QObject *parent)
 	: MessageManager(parent)
 {
 	m_LLMParams = new LLMParams();
 	m_NetWorkParams = new ClientNetWork();
-
-	// 初始化连接测试定时器
-	m_connectionCheckTimer = new QTimer(this);
-	m_connectionCheckTimer->setSingleShot(true);
-	connect(m_connectionCheckTimer, &QTimer::timeout, this, &Open_WebUIClient::onCheckConnectionTimeout);
-
-	// 初始化获取模型列表定时器
-	m_fetchModelsTimer = new QTimer(this);
-	m_fetchModelsTimer->setSingleShot(true);
-	connect(m_fetchModelsTimer, &QTimer::timeout, this, &Open_WebUIClient::onFetchModelsTimeout);
-
-	m_currentRequestType = RequestType::ConnectionCheck;
 }
 
 Open_WebUIClient::~Open_WebUIClient()
 {
-	if (m_NetWorkParams && m_NetWorkParams->clientNetWorkReply)
-	{
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply->disconnect();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
+	cancelCurrentRequest();
 	// 注意：m_LLMParams 可能已被 setLLMParams() 设置为外部管理的对象
 	// setLLMParams() 已经处理了构造函数中创建的 m_LLMParams 的删除
 	// 如果 m_LLMParams 是外部传入的，不应该在这里删除，由外部管理其生命周期
@@ -85,6 +197,15 @@ QByteArray Open_WebUIClient::buildMessageBody(const ChatSendMessage& msg)
 		{ 2, "gkgvision" },
 		{ 3, "Codeinter" }
 	};
+	// 历史对话在前，本轮提问在后；历史部分在窗口前移之前逐字节不变
+	// OpenAI 兼容接口不接受回答中的推理内容，这里只发送正文
+	for (const ChatHistoryTurn& turn : msg.history)
+	{
+		QJsonObject historyObject;
+		historyObject["role"] = turn.role;
+		historyObject["content"] = turn.content;
+		messagesArray.append(historyObject);
+	}
 	messageObject["role"] = "user";//角色
 								   //发送信息:输入信息+文档i...
 	QString finalSendMsg = msg.SendText;
@@ -130,107 +251,40 @@ QByteArray Open_WebUIClient::buildMessageBody(const ChatSendMessage& msg)
 	return QJsonDocument(SendMessageBody).toJson();
 }
 
-void Open_WebUIClient::SendPreProcess(const ChatSendMessage& msg)
+ClientRequest* Open_WebUIClient::SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder)
 {
 	QByteArray postData = buildMessageBody(msg);
 	QSslConfiguration config = QSslConfiguration::defaultConfiguration();
 	config.setProtocol(QSsl::AnyProtocol);
 	config.setPeerVerifyMode(QSslSocket::VerifyNone);
 	m_NetWorkParams->clientRequest.setSslConfiguration(config);
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(m_NetWorkParams->clientNetWorkManager->post(m_NetWorkParams->clientRequest, postData));
+	return startRequest(RequestType::ChatRequest,
+		NetworkOperation::post(m_NetWorkParams->clientRequest, postData, std::move(decoder)), 0, msg.sessionId);
 }
 
 QJsonObject Open_WebUIClient::parseJsonReplyToMsg(const QByteArray &data)
 {
-	QJsonObject msg;
-
-	// 检查输入数据是否为空
-	if (data.isEmpty())
-	{
-		return msg;
-	}
-
-	QJsonParseError parseError;
-	QJsonDocument response_doc = QJsonDocument::fromJson(data, &parseError);
-
-	// 检查JSON解析是否成功
-	if (parseError.error != QJsonParseError::NoError)
-	{
-		return msg;
-	}
-
-	// 检查文档是否为空或不是对象类型
-	if (response_doc.isNull() || !response_doc.isObject())
-	{
-		return msg;
-	}
-
-	// 获取根JSON对象
-	QJsonObject rsp_json = response_doc.object();
-
-	// 检查是否包含choices字段
-	if (!rsp_json.contains("choices"))
-	{
-		return msg;
-	}
-
-	// 获取choices数组
-	QJsonValue choicesValue = rsp_json.value("choices");
-	if (!choicesValue.isArray())
-	{
-		return msg;
-	}
-
-	QJsonArray choicesArray = choicesValue.toArray();
-
-	// 检查choices数组是否为空
-	if (choicesArray.isEmpty())
-	{
-		return msg;
-	}
-
-	// 获取第一个choice对象
-	QJsonValue firstChoice = choicesArray[0];
-	if (!firstChoice.isObject())
-	{
-		return msg;
-	}
-
-	QJsonObject choiceObj = firstChoice.toObject();
-
 	// 根据流式或非流式模式获取消息对象
-	QString messageKey = m_LLMParams->getStreamChat() ? "delta" : "message";
-
-	if (!choiceObj.contains(messageKey))
-	{
-		return msg;
-	}
-
-	QJsonValue messageValue = choiceObj.value(messageKey);
-	if (!messageValue.isObject())
-	{
-		return msg;
-	}
-
-	msg = messageValue.toObject();
-
-	return msg;
+	return choiceMessage(data, m_LLMParams->getStreamChat() ? "delta" : "message");
 }
 
-int Open_WebUIClient::send(const ChatSendMessage& msg)
+quint64 Open_WebUIClient::send(const ChatSendMessage& msg)
 {
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &Open_WebUIClient::getAnswer);
-	return true;
+	ClientRequest* request = SendPreProcess(msg);
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &Open_WebUIClient::getAnswer);
+	return request->id;
 }
 
-int Open_WebUIClient::StreamSend(const ChatSendMessage& msg)
+quint64 Open_WebUIClient::StreamSend(const ChatSendMessage& msg)
 {
-	m_isStreamingReasoning = false;
-	SendPreProcess(msg);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::readyRead, this, &Open_WebUIClient::getStreamAnswer, Qt::QueuedConnection);
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished, this, &Open_WebUIClient::processStreamEnded);
-	return true;
+	ClientRequest* request = SendPreProcess(msg,
+		std::make_shared<OpenWebUIStreamDecoder>(m_LLMParams->getOpenThink()));
+	if (!request)
+		return 0;
+	onRequestFinished(request, this, &Open_WebUIClient::processStreamEnded);
+	return request->id;
 }
 
 QString Open_WebUIClient::GetError(const QString& errorLevel, const QString& errorContext)
@@ -272,40 +326,37 @@ QString Open_WebUIClient::GetError(const QString& errorLevel, const QString& err
 
 void Open_WebUIClient::processStreamEnded()
 {
-	QNetworkReply* reply = m_NetWorkParams->clientNetWorkReply.get();
-	if (!reply)
-	{
-		// 请求在外部已被取消或清理
-		m_NetWorkParams->rawBuffer.clear();
-		emit StreamEnded();
+	// 已取消的请求在网络线程中中止，这里只会收到仍在表中的请求
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
-	}
+	const quint64 requestId = request->id;
+	NetworkReplyData* reply = &request->result;
 
 	if (reply->error() && reply->error() != QNetworkReply::OperationCanceledError)
-
 	{
 		QString errorMsg = GetError(reply->errorString(), reply->readAll());
-		emit Answer(errorMsg, true);
-		m_NetWorkParams->rawBuffer.clear();
-		emit StreamEnded();
+		finishRequest(request);
+		emit Answer(requestId, errorMsg, true);
+		emit StreamEnded(requestId);
 		return;
 	}
 
-	if (m_isStreamingReasoning) {
-		emit AnswerStream(QStringLiteral("---REASONING_END---"));
-		m_isStreamingReasoning = false;
-	}
-
-	m_NetWorkParams->rawBuffer.clear();
-	emit StreamEnded();
+	// 剩余数据和未闭合的推理标记已由网络线程在结束信号之前投递
+	finishRequest(request);
+	emit StreamEnded(requestId);
 }
 
 void Open_WebUIClient::getAnswer()
 {
-
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	ClientRequest* request = senderRequest();
+	if (!request)
+		return;
+	const quint64 requestId = request->id;
+	NetworkReplyData* reply = &request->result;
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		QByteArray read_data = m_NetWorkParams->clientNetWorkReply->readAll();
+		QByteArray read_data = reply->readAll();
 		QJsonObject Content = parseJsonReplyToMsg(read_data);
 		QString textresponse;
 		bool isFunctionCall = Content.contains("tool_calls");
@@ -326,87 +377,27 @@ void Open_WebUIClient::getAnswer()
 				{
 					textresponse = content;
 				}
-				emit Answer(textresponse, false);
+				emit Answer(requestId, textresponse, false);
 			}
 			else
 			{
-				emit Answer("Invalid response format", false);
+				emit Answer(requestId, "Invalid response format", false);
 			}
 		}
 		else
 		{
-			emit FunctionCallSignal(Content);
+			emit FunctionCallSignal(requestId, Content);
 
 		}
 	}
 	else
 	{
-		emit Answer(GetError(m_NetWorkParams->clientNetWorkReply->errorString(), m_NetWorkParams->clientNetWorkReply->readAll()), true);
+		emit Answer(requestId, GetError(reply->errorString(), reply->readAll()), true);
 	}
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	ChangeButtonStatus(SendButtonState::Ready);
 }
 
-void Open_WebUIClient::getStreamAnswer()
-{
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
-	{
-		QByteArray response_data = m_NetWorkParams->clientNetWorkReply->readAll();
-		m_NetWorkParams->rawBuffer.append(response_data);
-		QByteArray tmp_data = QByteArray(response_data);
-		int pos = response_data.indexOf("\n\n");
-		while (pos != -1)
-		{
-			QByteArray chunk = tmp_data.left(pos);
-			if (chunk.startsWith("data: ")) {
-				chunk = chunk.mid(6);
-			}
-			const QString trimmed = QString::fromUtf8(chunk).trimmed();
-			if (trimmed.isEmpty()) {
-				if (pos + 2 >= tmp_data.size()) break;
-				tmp_data = tmp_data.mid(pos + 2);
-				pos = tmp_data.indexOf("\n\n");
-				continue;
-			}
-			if (trimmed == "[DONE]") {
-				if (pos + 2 >= tmp_data.size()) break;
-				tmp_data = tmp_data.mid(pos + 2);
-				pos = tmp_data.indexOf("\n\n");
-				continue;
-			}
-
-			QJsonObject deltaObj = parseJsonReplyToMsg(chunk);
-			const QString reasoningChunk = deltaObj.value("reasoning_content").toString();
-			const QString contentChunk = deltaObj.value("content").toString();
-			const bool shouldShowReasoning = m_LLMParams->getOpenThink();
-
-			if (!reasoningChunk.isEmpty() && shouldShowReasoning) {
-				if (!m_isStreamingReasoning) {
-					emit AnswerStream(QStringLiteral("---REASONING_START---") + reasoningChunk);
-					m_isStreamingReasoning = true;
-				}
-				else {
-					emit AnswerStream(reasoningChunk);
-				}
-			}
-
-			if (!contentChunk.isEmpty()) {
-				if (m_isStreamingReasoning && shouldShowReasoning) {
-					emit AnswerStream(QStringLiteral("---REASONING_END---") + contentChunk);
-					m_isStreamingReasoning = false;
-				}
-				else {
-					emit AnswerStream(contentChunk);
-				}
-			}
-
-			if (pos + 2 >= tmp_data.size()) break;
-			tmp_data = tmp_data.mid(pos + 2);
-			pos = tmp_data.indexOf("\n\n");
-		}
-	}
-}
-
 QNetworkRequest Open_WebUIClient::createApiRequest(const QUrl& url)
 {
 	QNetworkRequest request(url);
@@ -431,30 +422,24 @@ QNetworkRequest Open_WebUIClient::createApiRequest(const QUrl& url)
 	return request;
 }
 
-void Open_WebUIClient::sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs)
+void Open_WebUIClient::sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs)
 {
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->get(request));
+	ClientRequest* apiRequest = startRequest(type, NetworkOperation::get(request), timeoutMs);
+	if (!apiRequest)
+		return;
 
 	// 根据请求类型连接相应的处理函数
-	if (m_currentRequestType == RequestType::FetchModels)
+	if (type == RequestType::FetchModels)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &Open_WebUIClient::onFetchModelsFinished);
-		// 启动超时定时器
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &Open_WebUIClient::onFetchModelsFinished);
 	}
-	else if (m_currentRequestType == RequestType::ConnectionCheck)
+	else if (type == RequestType::ConnectionCheck)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &Open_WebUIClient::onCheckConnectionFinished);
-		// 启动超时定时器
-		timeoutTimer->start(timeoutMs);
+		onRequestFinished(apiRequest, this, &Open_WebUIClient::onCheckConnectionFinished);
 	}
-	else if (m_currentRequestType == RequestType::GetKonwledgeBase)
+	else if (type == RequestType::GetKonwledgeBase)
 	{
-		connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &Open_WebUIClient::onGetKnowledgeBaseFinished);
+		onRequestFinished(apiRequest, this, &Open_WebUIClient::onGetKnowledgeBaseFinished);
 	}
 }
 
@@ -507,11 +492,8 @@ QStringList Open_WebUIClient::parseModelIds(const QByteArray &jsonData)
 
 void Open_WebUIClient::checkServerConnectionAsync(int timeoutMs)
 {
-	// 取消之前的请求
-	cancelCurrentRequest();
-
-	// 设置请求类型
-	m_currentRequestType = RequestType::ConnectionCheck;
+	// 取消之前的连接检查
+	cancelRequests(RequestType::ConnectionCheck);
 
 	// 验证URL
 	if (!validateServerUrl())
@@ -523,29 +505,24 @@ void Open_WebUIClient::checkServerConnectionAsync(int timeoutMs)
 	// 构建请求并发送
 	QUrl testUrl = buildApiUrl("/api/models");
 	QNetworkRequest testRequest = createApiRequest(testUrl);
-	sendApiRequest(testRequest, m_connectionCheckTimer, timeoutMs);
+	sendApiRequest(RequestType::ConnectionCheck, testRequest, timeoutMs);
 }
 
 void Open_WebUIClient::onCheckConnectionFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
+	// 超时的请求已被中止并移除
+	ClientRequest* request = senderRequest();
+	if (!request) {
 		return;
 	}
-
-	// 检查是否超时
-	if (!m_connectionCheckTimer->isActive()) {
-		m_NetWorkParams->clientNetWorkReply.reset();
-		return;
-	}
-
-	m_connectionCheckTimer->stop();
+	NetworkReplyData* reply = &request->result;
 
 	bool isConnected = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
@@ -560,20 +537,17 @@ void Open_WebUIClient::onCheckConnectionFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	emit serverConnectionCheckFinished(isConnected, errorMessage);
 }
 
 void Open_WebUIClient::fetchModelsAsync(int timeoutMs)
 {
-	// 取消之前的请求
-	cancelCurrentRequest();
-
-	// 设置请求类型
-	m_currentRequestType = RequestType::FetchModels;
+	// 取消之前的模型列表请求
+	cancelRequests(RequestType::FetchModels);
 
 	// 验证URL
 	if (!validateServerUrl())
@@ -585,35 +559,30 @@ void Open_WebUIClient::fetchModelsAsync(int timeoutMs)
 	// 构建请求并发送
 	QUrl modelsUrl = buildApiUrl("/api/models");
 	QNetworkRequest modelsRequest = createApiRequest(modelsUrl);
-	sendApiRequest(modelsRequest, m_fetchModelsTimer, timeoutMs);
+	sendApiRequest(RequestType::FetchModels, modelsRequest, timeoutMs);
 }
 
 void Open_WebUIClient::onFetchModelsFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply) {
+	// 超时的请求已被中止并移除
+	ClientRequest* request = senderRequest();
+	if (!request) {
 		return;
 	}
-
-	// 检查是否超时
-	if (!m_fetchModelsTimer->isActive()) {
-		m_NetWorkParams->clientNetWorkReply.reset();
-		return;
-	}
-
-	m_fetchModelsTimer->stop();
+	NetworkReplyData* reply = &request->result;
 
 	bool success = false;
 	QString errorMessage;
 	QStringList models;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			models = parseModelIds(responseData);
 
 			if (!models.isEmpty())
@@ -636,36 +605,20 @@ void Open_WebUIClient::onFetchModelsFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 	emit modelsListFetched(success, models, errorMessage);
 }
 
 void Open_WebUIClient::onCheckConnectionTimeout()
 {
-	if (m_NetWorkParams->clientNetWorkReply)
-	{
-		disconnect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &Open_WebUIClient::onCheckConnectionFinished);
-
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
 	emit serverConnectionCheckFinished(false, tr("Please Check IP Address or Network Setting"));
 }
 
 void Open_WebUIClient::onFetchModelsTimeout()
 {
-	if (m_NetWorkParams->clientNetWorkReply)
-	{
-		disconnect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-			this, &Open_WebUIClient::onFetchModelsFinished);
-
-		m_NetWorkParams->clientNetWorkReply->abort();
-		m_NetWorkParams->clientNetWorkReply.reset();
-	}
 	emit modelsListFetched(false, QStringList(), tr("Fetch ModelList Timeout"));
 }
 
@@ -677,13 +630,10 @@ QStringList Open_WebUIClient::GetFollowUpSuggestions()
 
 void Open_WebUIClient::getKnowledgeBase()
 {
-	// 取消之前的请求
+	// 取消之前的知识库请求
 	if (KnowledgeInfo.size() > 0)
 		return;
-	cancelCurrentRequest();
-
-	// 设置请求类型
-	m_currentRequestType = RequestType::GetKonwledgeBase;
+	cancelRequests(RequestType::GetKonwledgeBase);
 
 	// 验证URL
 	if (!validateServerUrl())
@@ -692,30 +642,35 @@ void Open_WebUIClient::getKnowledgeBase()
 	// 构建请求并发送
 	QUrl modelsUrl = buildApiUrl("/api/v1/knowledge/");
 	QNetworkRequest modelsRequest = createApiRequest(modelsUrl);
-	sendApiRequest(modelsRequest, m_fetchModelsTimer, 50000);
+	sendApiRequest(RequestType::GetKonwledgeBase, modelsRequest, 0);
 }
 
 void Open_WebUIClient::onGetKnowledgeBaseFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 
 	bool success = false;
 	QString errorMessage;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
 			if (error.error != QJsonParseError::NoError || !doc.isArray())
+			{
+				finishRequest(request);
 				return;
+			}
 
 			QJsonArray jsonArray = doc.array();
 			std::map<QString, std::pair<QString, QString>> knowBase;
@@ -748,18 +703,14 @@ void Open_WebUIClient::onGetKnowledgeBaseFinished()
 	}
 	else
 	{
-		errorMessage = m_NetWorkParams->clientNetWorkReply->errorString();
+		errorMessage = reply->errorString();
 	}
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
 void Open_WebUIClient::uploadFile(const QString& filePath)
 {
-	// 取消之前的请求
-	cancelCurrentRequest();
-
-	// 设置请求类型
-	m_currentRequestType = RequestType::FileUpload;
+	// 上传与对话等其他请求并行，不取消其他请求
 
 	// 验证URL
 	if (!validateServerUrl())
@@ -809,24 +760,15 @@ void Open_WebUIClient::uploadFile(const QString& filePath)
 	multiPart->append(filePart);
 
 	// 发送POST请求
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->post(uploadRequest, multiPart));
-
-	// multiPart会在reply删除时自动删除
-	multiPart->setParent(m_NetWorkParams->clientNetWorkReply.get());
-
-	// 连接信号
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-		this, &Open_WebUIClient::onFileUploadFinished);
+	// multiPart 由网络线程接管，随应答删除；登记失败时已删除
+	ClientRequest* request = startRequest(RequestType::FileUpload,
+		NetworkOperation::post(uploadRequest, multiPart));
+	onRequestFinished(request, this, &Open_WebUIClient::onFileUploadFinished);
 }
 
 void Open_WebUIClient::DeleteFile(const QString& fileID)
 {
-	// 取消之前的请求
-	cancelCurrentRequest();
-
-	// 设置请求类型
-	m_currentRequestType = RequestType::FileDelete;
+	// 删除与其他请求并行，不取消其他请求
 
 	// 验证URL
 	if (!validateServerUrl())
@@ -848,31 +790,30 @@ void Open_WebUIClient::DeleteFile(const QString& fileID)
 		DeleteFileRequest.setRawHeader("Authorization", authHeader.toByteArray());
 	}
 	// 发送POST请求
-	m_NetWorkParams->clientNetWorkReply = std::unique_ptr<QNetworkReply>(
-		m_NetWorkParams->clientNetWorkManager->deleteResource(DeleteFileRequest));
-
-	// 连接信号
-	connect(m_NetWorkParams->clientNetWorkReply.get(), &QNetworkReply::finished,
-		this, &Open_WebUIClient::onDeleteFileFinished);
+	ClientRequest* request = startRequest(RequestType::FileDelete,
+		NetworkOperation::deleteResource(DeleteFileRequest));
+	onRequestFinished(request, this, &Open_WebUIClient::onDeleteFileFinished);
 }
 
 void Open_WebUIClient::onFileUploadFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 	bool success = false;
 	QString errorMessage;
 	QString fileId;
 	QString fileName;
 
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200 || statusCode == 201)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
@@ -901,7 +842,7 @@ void Open_WebUIClient::onFileUploadFinished()
 		}
 		else
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonDocument doc = QJsonDocument::fromJson(responseData);
 			if (doc.isObject())
 			{
@@ -923,27 +864,29 @@ void Open_WebUIClient::onFileUploadFinished()
 	}
 	else
 	{
-		errorMessage = GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll());
+		errorMessage = GetError(reply->errorString(),
+			reply->readAll());
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
 void Open_WebUIClient::onDeleteFileFinished()
 {
-	if (!m_NetWorkParams->clientNetWorkReply)
+	ClientRequest* request = senderRequest();
+	if (!request)
 		return;
+	NetworkReplyData* reply = &request->result;
 	bool success = false;
 	QString errorMessage;
-	if (m_NetWorkParams->clientNetWorkReply->error() == QNetworkReply::NoError)
+	if (reply->error() == QNetworkReply::NoError)
 	{
-		int statusCode = m_NetWorkParams->clientNetWorkReply->attribute(
+		int statusCode = reply->attribute(
 			QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
 		if (statusCode == 200 || statusCode == 201)
 		{
-			QByteArray responseData = m_NetWorkParams->clientNetWorkReply->readAll();
+			QByteArray responseData = reply->readAll();
 			QJsonParseError error;
 			QJsonDocument doc = QJsonDocument::fromJson(responseData, &error);
 
@@ -961,14 +904,14 @@ void Open_WebUIClient::onDeleteFileFinished()
 	}
 	else
 	{
-		errorMessage = GetError(m_NetWorkParams->clientNetWorkReply->errorString(),
-			m_NetWorkParams->clientNetWorkReply->readAll());
+		errorMessage = GetError(reply->errorString(),
+			reply->readAll());
 	}
 
-	m_NetWorkParams->clientNetWorkReply.reset();
+	finishRequest(request);
 }
 
-void Open_WebUIClient::AnalysisBlockResponse(QJsonObject& response_obj)
+void Open_WebUIClient::AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj)
 {
 	QString textresponse;
 	bool isFunctionCall = response_obj.contains("tool_calls");
@@ -979,21 +922,21 @@ void Open_WebUIClient::AnalysisBlockResponse(QJsonObject& response_obj)
 		if (value.isString())
 		{
 			textresponse = value.toString();
-			emit Answer(textresponse, false);
+			emit Answer(request->id, textresponse, false);
 		}
 		else
 		{
-			emit Answer("Invalid response format", false);
+			emit Answer(request->id, "Invalid response format", false);
 		}
 	}
 	else
 	{
-		emit FunctionCallSignal(response_obj);
+		emit FunctionCallSignal(request->id, response_obj);
 
 	}
 }
 
-void Open_WebUIClient::AnalysisStreamResponse(QJsonObject& response_obj)
+void Open_WebUIClient::AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj)
 {
 
 }
@@ -24,13 +24,13 @@ public:
 	// 构建消息体
 	QByteArray buildMessageBody(const ChatSendMessage& msg) override;
 	// 发送前预处理
-	void SendPreProcess(const ChatSendMessage& msg) override;
+	ClientRequest* SendPreProcess(const ChatSendMessage& msg, std::shared_ptr<StreamDecoder> decoder = nullptr) override;
 	// 解析JSON回复为消息
 	QJsonObject parseJsonReplyToMsg(const QByteArray &data) override;
 	// 发送消息（阻塞式）
-	int send(const ChatSendMessage& msg) override;
+	quint64 send(const ChatSendMessage& msg) override;
 	// 发送消息（流式传输）
-	int StreamSend(const ChatSendMessage& msg) override;
+	quint64 StreamSend(const ChatSendMessage& msg) override;
 	// 获取错误信息
 	QString GetError(const QString& errorLevel, const QString& errorContext) override;
 	// 流式传输结束处理
@@ -38,7 +38,7 @@ public:
 	// 创建API请求
 	QNetworkRequest createApiRequest(const QUrl& url) override;
 	// 发送API请求
-	void sendApiRequest(const QNetworkRequest& request, QTimer* timeoutTimer, int timeoutMs) override;
+	void sendApiRequest(RequestType type, const QNetworkRequest& request, int timeoutMs) override;
 	// 检查服务器连接（异步）
 	void checkServerConnectionAsync(int timeoutMs) override;
 	// 解析模型ID列表
@@ -54,9 +54,9 @@ public:
 	// 删除文件
 	void DeleteFile(const QString& fileID) override;
 	// 分析阻塞式响应
-	void AnalysisBlockResponse(QJsonObject& response_obj) override;
+	void AnalysisBlockResponse(ClientRequest* request, QJsonObject& response_obj) override;
 	// 分析流式响应
-	void AnalysisStreamResponse(QJsonObject& response_obj) override;
+	void AnalysisStreamResponse(ClientRequest* request, QJsonObject& response_obj) override;
 	// 更改知识图谱
 	void ChangeKnowledgeGraph(const QString& kownledgeID) override;
 	// 取消文件上传
@@ -86,11 +86,6 @@ public slots:
 private slots:
 	// 处理阻塞式回答
 	void getAnswer() override;
-	// 处理流式回答
-	void getStreamAnswer() override;
 
-private:
-	bool m_isStreamingReasoning = false;
-	
 };
 
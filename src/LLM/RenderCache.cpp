@@ -0,0 +1,224 @@
+#include "RenderCache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace
+{
+	constexpr quint32 kDiskMagic = 0x52434831;  // "RCH1"
+	constexpr quint64 kFnvOffset = 14695981039346656037ULL;
+	constexpr quint64 kFnvPrime = 1099511628211ULL;
+}
+
+RenderCache& RenderCache::instance()
+{
+	static RenderCache cache;
+	return cache;
+}
+
+RenderCache::RenderCache()
+	: m_memory(kMemoryMaxBytes)
+{
+}
+
+quint64 RenderCache::key(const QString& markdown, quint32 renderer)
+{
+	// FNV-1a，渲染器编号作为前缀参与哈希
+	quint64 hash = kFnvOffset;
+	hash = (hash ^ renderer) * kFnvPrime;
+	const ushort* data = markdown.utf16();
+	for (int i = 0; i < markdown.size(); ++i)
+	{
+		hash = (hash ^ (data[i] & 0xFF)) * kFnvPrime;
+		hash = (hash ^ (data[i] >> 8)) * kFnvPrime;
+	}
+	return hash;
+}
+
+bool RenderCache::find(quint64 key, RenderCacheEntry& entry)
+{
+	QString directory;
+	{
+		QMutexLocker locker(&m_mutex);
+		if (const RenderCacheEntry* cached = m_memory.object(key))
+		{
+			entry = *cached;
+			return true;
+		}
+		directory = m_diskDirectory;
+	}
+	if (directory.isEmpty() || !readDisk(directory, key, entry))
+	{
+		return false;
+	}
+	QMutexLocker locker(&m_mutex);
+	m_memory.insert(key, new RenderCacheEntry(entry), cost(entry));
+	return true;
+}
+
+void RenderCache::insert(quint64 key, const RenderCacheEntry& entry)
+{
+	QString directory;
+	{
+		QMutexLocker locker(&m_mutex);
+		m_memory.insert(key, new RenderCacheEntry(entry), cost(entry));
+		if (entry.html.size() >= kDiskMinChars)
+		{
+			directory = m_diskDirectory;
+		}
+	}
+	if (directory.isEmpty())
+	{
+		return;
+	}
+	const qint64 written = writeDisk(directory, key, entry);
+	if (written == 0)
+	{
+		return;
+	}
+
+	qint64 maxBytes = 0;
+	{
+		QMutexLocker locker(&m_mutex);
+		if (m_diskDirectory != directory)
+		{
+			return;
+		}
+		m_diskBytes += written;
+		if (m_diskBytes <= m_diskMaxBytes || m_pruning)
+		{
+			return;
+		}
+		m_pruning = true;
+		maxBytes = m_diskMaxBytes;
+	}
+	// 删到上限的 3/4，之后不必每次写入都扫描目录
+	const qint64 remaining = pruneDisk(directory, maxBytes, maxBytes - maxBytes / 4);
+	QMutexLocker locker(&m_mutex);
+	m_pruning = false;
+	if (m_diskDirectory == directory)
+	{
+		m_diskBytes = remaining;
+	}
+}
+
+void RenderCache::setDiskDirectory(const QString& directory, qint64 maxBytes)
+{
+	QString enabled = directory;
+	qint64 bytes = 0;
+	if (!enabled.isEmpty())
+	{
+		if (QDir().mkpath(enabled))
+		{
+			bytes = pruneDisk(enabled, maxBytes, maxBytes);
+		}
+		else
+		{
+			enabled.clear();
+		}
+	}
+	QMutexLocker locker(&m_mutex);
+	m_diskDirectory = enabled;
+	m_diskMaxBytes = maxBytes;
+	m_diskBytes = bytes;
+}
+
+QString RenderCache::diskFile(const QString& directory, quint64 key)
+{
+	return QDir(directory).filePath(QStringLiteral("%1.rc").arg(key, 16, 16, QLatin1Char('0')));
+}
+
+bool RenderCache::readDisk(const QString& directory, quint64 key, RenderCacheEntry& entry)
+{
+	QFile file(diskFile(directory, key));
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	QDataStream in(&file);
+	quint32 magic = 0;
+	quint64 storedKey = 0;
+	in >> magic >> storedKey;
+	if (magic != kDiskMagic || storedKey != key)
+	{
+		return false;
+	}
+	in >> entry.html >> entry.codeBlocks;
+	if (in.status() != QDataStream::Ok)
+	{
+		return false;
+	}
+	// 淘汰按修改时间进行，命中时更新修改时间才是最久未使用的先删；一段时间内只更新一次，减少写入
+	const QDateTime now = QDateTime::currentDateTime();
+	if (file.fileTime(QFileDevice::FileModificationTime).secsTo(now) >= kDiskTouchIntervalSecs)
+	{
+		file.close();
+		QFile touched(file.fileName());
+		if (touched.open(QIODevice::Append))
+		{
+			touched.setFileTime(now, QFileDevice::FileModificationTime);
+		}
+	}
+	return true;
+}
+
+qint64 RenderCache::writeDisk(const QString& directory, quint64 key, const RenderCacheEntry& entry)
+{
+	const QString filePath = diskFile(directory, key);
+	if (QFileInfo::exists(filePath))
+	{
+		return 0;
+	}
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return 0;
+	}
+	QDataStream out(&file);
+	out << kDiskMagic << key << entry.html << entry.codeBlocks;
+	const qint64 bytes = file.size();
+	return file.commit() ? bytes : 0;
+}
+
+qint64 RenderCache::pruneDisk(const QString& directory, qint64 maxBytes, qint64 targetBytes)
+{
+	QFileInfoList files = QDir(directory).entryInfoList({ QStringLiteral("*.rc") }, QDir::Files);
+	qint64 total = 0;
+	for (const QFileInfo& info : files)
+	{
+		total += info.size();
+	}
+	if (total <= maxBytes)
+	{
+		return total;
+	}
+	std::sort(files.begin(), files.end(), [](const QFileInfo& a, const QFileInfo& b) {
+		return a.lastModified() < b.lastModified();
+	});
+	for (const QFileInfo& info : files)
+	{
+		if (total <= targetBytes)
+		{
+			break;
+		}
+		if (QFile::remove(info.absoluteFilePath()))
+		{
+			total -= info.size();
+		}
+	}
+	return total;
+}
+
+int RenderCache::cost(const RenderCacheEntry& entry)
+{
+	int bytes = entry.html.size() * int(sizeof(QChar));
+	for (auto it = entry.codeBlocks.constBegin(); it != entry.codeBlocks.constEnd(); ++it)
+	{
+		bytes += (it.key().size() + it.value().size()) * int(sizeof(QChar));
+	}
+	return qMax(1, bytes);
+}
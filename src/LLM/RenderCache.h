@@ -0,0 +1,55 @@
+#pragma once
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// 渲染结果：HTML 及其中代码块的原文（复制按钮按ID取代码）
+struct RenderCacheEntry
+{
+	QString html;
+	QHash<QString, QString> codeBlocks;  // 代码块ID -> 代码原文
+};
+
+// 进程内共享的 Markdown 渲染缓存
+// 键为内容的 64 位哈希与渲染器版本（含主题等影响输出的参数），按占用字节数限制大小，淘汰最久未使用的条目；
+// 设置磁盘目录后未命中内存时再查磁盘，新的结果同时写入磁盘，重新打开旧会话时不必重新渲染
+// 锁只保护内存中的状态，读写磁盘文件都在锁外进行
+class RenderCache
+{
+public:
+	static RenderCache& instance();
+
+	// 计算缓存键：renderer 区分不同的渲染器及其版本
+	static quint64 key(const QString& markdown, quint32 renderer);
+
+	bool find(quint64 key, RenderCacheEntry& entry);
+	void insert(quint64 key, const RenderCacheEntry& entry);
+
+	// 启用磁盘缓存（为空时关闭）；磁盘文件总大小超出 maxBytes 时（启用时和之后的写入后）删除最久未使用（修改时间最早）的文件
+	void setDiskDirectory(const QString& directory, qint64 maxBytes = kDiskMaxBytes);
+
+private:
+	RenderCache();
+
+	static QString diskFile(const QString& directory, quint64 key);
+	// 命中时更新文件的修改时间，淘汰时最近读过的文件保留
+	static bool readDisk(const QString& directory, quint64 key, RenderCacheEntry& entry);
+	// 返回写入的字节数，文件已存在或写入失败时返回 0
+	static qint64 writeDisk(const QString& directory, quint64 key, const RenderCacheEntry& entry);
+	// 总大小超出 maxBytes 时删除最旧的文件直到不超过 targetBytes，返回剩余的总大小
+	static qint64 pruneDisk(const QString& directory, qint64 maxBytes, qint64 targetBytes);
+	static int cost(const RenderCacheEntry& entry);
+
+	static constexpr int kMemoryMaxBytes = 16 * 1024 * 1024;
+	static constexpr qint64 kDiskMaxBytes = 64 * 1024 * 1024;
+	static constexpr int kDiskMinChars = 512;  // 短内容渲染很快，不写磁盘
+	static constexpr qint64 kDiskTouchIntervalSecs = 60 * 60;  // 磁盘命中时更新修改时间的最小间隔
+
+	QMutex m_mutex;
+	QCache<quint64, RenderCacheEntry> m_memory;  // 开销按字节计算
+	QString m_diskDirectory;
+	qint64 m_diskMaxBytes = kDiskMaxBytes;
+	qint64 m_diskBytes = 0;     // 磁盘文件总大小（启用时统计，之后按写入累加）
+	bool m_pruning = false;     // 有线程正在删除旧文件
+};
@@ -0,0 +1,466 @@
+#include "SessionJournal.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QTimer>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+	// 把操作系统缓冲写入磁盘
+	bool syncToDisk(QFile& file) {
+		if (!file.flush())
+			return false;
+#ifdef Q_OS_WIN
+		return _commit(file.handle()) == 0;
+#else
+		return ::fsync(file.handle()) == 0;
+#endif
+	}
+
+	QString rotatedJournalFile(const QString& journalFile) {
+		return journalFile + QStringLiteral(".old");
+	}
+
+	// 写入日志的字段是否相同（排版缓存不计入）
+	bool sameContent(const ChatMessageData& a, const ChatMessageData& b) {
+		return a.m_ChatMsg == b.m_ChatMsg
+			&& a.m_ChatReasonMsg == b.m_ChatReasonMsg
+			&& a.m_ChatTime == b.m_ChatTime
+			&& a.userType == b.userType
+			&& a.m_DialogName == b.m_DialogName
+			&& a.m_IsImportant == b.m_IsImportant
+			&& a.m_Note == b.m_Note;
+	}
+}
+
+// 写入线程中的任务：日志的写入、落盘、切换和快照重写按排队顺序依次执行
+class SessionJournal::WriterTask : public QRunnable {
+public:
+	explicit WriterTask(std::function<void()> work)
+		: m_work(std::move(work)) {
+		setAutoDelete(true);
+	}
+
+	void run() override {
+		m_work();
+	}
+
+private:
+	std::function<void()> m_work;
+};
+
+SessionJournal::SessionJournal(QObject* parent)
+	: QObject(parent) {
+	m_pool.setMaxThreadCount(1);
+	m_pool.setExpiryTimeout(-1);
+	m_syncTimer = new QTimer(this);
+	m_syncTimer->setSingleShot(true);
+	m_syncTimer->setInterval(kSyncDelayMs);
+	connect(m_syncTimer, &QTimer::timeout, this, &SessionJournal::sync);
+}
+
+SessionJournal::~SessionJournal() {
+	m_pool.waitForDone();
+	closeJournal();
+}
+
+void SessionJournal::setStorageFile(const QString& filePath) {
+	if (m_snapshotFile == filePath)
+		return;
+	m_pool.waitForDone();
+	closeJournal();
+	m_snapshotFile = filePath;
+	m_snapshotBytes = QFileInfo(filePath).size();
+	m_snapshotCorrupt = false;
+	m_journaled.clear();
+}
+
+QString SessionJournal::snapshotFile() const {
+	return m_snapshotFile;
+}
+
+QString SessionJournal::journalFile() const {
+	return m_snapshotFile.isEmpty() ? QString() : m_snapshotFile + QStringLiteral(".journal");
+}
+
+bool SessionJournal::load(ChatSessionMap& sessions) {
+	if (m_snapshotFile.isEmpty())
+		return false;
+	m_pool.waitForDone();
+	closeJournal();
+
+	sessions.clear();
+	m_snapshotCorrupt = false;
+	QFile file(m_snapshotFile);
+	if (file.open(QIODevice::ReadOnly)) {
+		const QByteArray data = file.readAll();
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+		if (error.error == QJsonParseError::NoError && doc.isObject()) {
+			const QJsonObject root = doc.object();
+			for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+				ChatSession session;
+				session.fromJson(it.value().toObject());
+				sessions.insert(it.key(), session);
+			}
+		}
+		else if (!data.trimmed().isEmpty()) {
+			// 快照无法解析时不能再重写：之后只追加日志，原文件保留并另存一份副本供修复
+			m_snapshotCorrupt = true;
+			const QString corruptFile = m_snapshotFile + QStringLiteral(".corrupt");
+			if (!QFile::exists(corruptFile))
+				QFile::copy(m_snapshotFile, corruptFile);
+			qWarning() << "SessionJournal: snapshot cannot be parsed, it will not be rewritten:"
+				<< m_snapshotFile << error.errorString() << "copy:" << corruptFile;
+		}
+		m_snapshotBytes = file.size();
+		file.close();
+	}
+
+	// 上次压缩未完成时旧日志还在，先于当前日志重放
+	replay(rotatedJournalFile(journalFile()), sessions);
+	const qint64 validBytes = replay(journalFile(), sessions);
+	m_journaled = sessions;
+	if (!openJournal(false))
+		return !sessions.isEmpty();
+	// 崩溃时写了一半的最后一行截掉，后续记录从完整的行之后开始
+	if (m_journal.size() > validBytes) {
+		m_journal.resize(validBytes);
+		m_journalBytes.store(validBytes);
+	}
+	return !sessions.isEmpty();
+}
+
+bool SessionJournal::saveAll(const ChatSessionMap& sessions) {
+	if (m_snapshotFile.isEmpty() || m_snapshotCorrupt)
+		return false;
+	m_pool.waitForDone();
+	qint64 bytes = 0;
+	if (!writeSnapshotFile(m_snapshotFile, sessions, &bytes))
+		return false;
+	m_snapshotBytes = bytes;
+	m_journaled = sessions;
+	QFile::remove(rotatedJournalFile(journalFile()));
+	closeJournal();
+	return openJournal(true);
+}
+
+// 以下记录函数只复制参数（会话和消息隐式共享），序列化和写入在写入线程中进行
+void SessionJournal::sessionCreated(const QString& sessionId, const ChatSession& session) {
+	const QDateTime saveTime = session.SaveTime;
+	queueRecord([this, sessionId, saveTime]() {
+		ChatSession& journaled = m_journaled[sessionId];
+		journaled.SaveTime = saveTime;
+		append(QStringLiteral("create"), sessionId, &journaled, QJsonObject());
+	});
+}
+
+void SessionJournal::sessionRemoved(const QString& sessionId) {
+	queueRecord([this, sessionId]() {
+		append(QStringLiteral("remove"), sessionId, nullptr, QJsonObject());
+		m_journaled.remove(sessionId);
+	});
+}
+
+void SessionJournal::sessionReplaced(const QString& sessionId, const ChatSession& session) {
+	queueRecord([this, sessionId, session]() {
+		QJsonObject record;
+		record["session"] = session.toJson();
+		append(QStringLiteral("session"), sessionId, &session, record);
+		m_journaled.insert(sessionId, session);
+	});
+}
+
+void SessionJournal::messagePut(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) {
+	queueRecord([this, sessionId, session, message]() {
+		putMessage(sessionId, session, message);
+	});
+}
+
+void SessionJournal::messageAnnotated(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) {
+	queueRecord([this, sessionId, session, message]() {
+		QJsonObject record;
+		record["bubbleid"] = message.m_BubbleID;
+		record["note"] = message.m_Note;
+		record["important"] = message.m_IsImportant;
+		append(QStringLiteral("annotate"), sessionId, &session, record);
+		ChatSession& journaled = m_journaled[sessionId];
+		journaled.SaveTime = session.SaveTime;
+		const int index = journaled.messageIndex(message.m_BubbleID);
+		if (index >= 0) {
+			journaled.sMsg[index].m_Note = message.m_Note;
+			journaled.sMsg[index].m_IsImportant = message.m_IsImportant;
+		}
+	});
+}
+
+void SessionJournal::putMessage(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) {
+	QJsonObject record;
+	record["msg"] = message.toJson();
+	append(QStringLiteral("put"), sessionId, &session, record);
+	// 与 applyRecord 对 put 记录的处理相同
+	ChatSession& journaled = m_journaled[sessionId];
+	journaled.SaveTime = session.SaveTime;
+	const int index = journaled.messageIndex(message.m_BubbleID);
+	if (index >= 0)
+		journaled.sMsg[index] = message;
+	else
+		journaled.appendMessage(message);
+}
+
+void SessionJournal::append(const QString& op, const QString& sessionId, const ChatSession* session, QJsonObject record) {
+	record["op"] = op;
+	record["sid"] = sessionId;
+	if (session)
+		record["saveTime"] = session->SaveTime.toString(Qt::ISODate);
+	QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+	line.append('\n');
+	writeLine(line);
+}
+
+void SessionJournal::writeLine(const QByteArray& line) {
+	if (!m_journal.isOpen() && !openJournal(false))
+		return;
+	m_journal.write(line);
+	// 进程崩溃不丢失：立即交给操作系统；断电保护按批落盘
+	m_journal.flush();
+	m_journalBytes.store(m_journal.size());
+	if (++m_unsyncedRecords >= kSyncBatchRecords)
+		syncJournal();
+}
+
+void SessionJournal::enqueue(std::function<void()> work) {
+	m_pool.start(new WriterTask(std::move(work)));
+}
+
+void SessionJournal::queueRecord(std::function<void()> work) {
+	if (m_snapshotFile.isEmpty())
+		return;
+	enqueue(std::move(work));
+	if (!m_syncTimer->isActive())
+		m_syncTimer->start();
+}
+
+void SessionJournal::compactIfNeeded(const ChatSessionMap& sessions) {
+	if (m_compacting || m_snapshotCorrupt || m_snapshotFile.isEmpty())
+		return;
+	if (m_journalBytes.load() < qMax(kCompactMinBytes, m_snapshotBytes))
+		return;
+
+	// 逐个会话浅拷贝：不共享哈希表本身，GUI线程持有的会话指针保持有效
+	ChatSessionMap copy;
+	copy.reserve(sessions.size());
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it)
+		copy.insert(it.key(), it.value());
+	startSnapshot(copy);
+}
+
+bool SessionJournal::saveAsync(const ChatSessionMap& sessions, const QSet<QString>& changed) {
+	if (m_snapshotFile.isEmpty())
+		return true; // 没有存储文件
+	// GUI线程只取出修改过的会话（浅拷贝），比对、序列化和写入都在写入线程中进行
+	ChatSessionMap modified;
+	for (const QString& sessionId : changed) {
+		auto it = sessions.constFind(sessionId);
+		if (it != sessions.constEnd())
+			modified.insert(sessionId, it.value()); // 已删除的会话删除记录已写入
+	}
+	if (!modified.isEmpty()) {
+		queueRecord([this, modified]() {
+			appendChanges(modified);
+		});
+	}
+	compactIfNeeded(sessions);
+	return true;
+}
+
+void SessionJournal::appendChanges(const ChatSessionMap& sessions) {
+	// 只追加内容变化的消息：接收中的回答每次只多一条 put 记录，快照由 compactIfNeeded 按日志大小重写
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it) {
+		const ChatSession& session = it.value();
+		const ChatSession journaled = m_journaled.value(it.key());
+		for (const ChatMessageData& message : session.sMsg) {
+			if (message.m_BubbleID.isEmpty())
+				continue; // 没有气泡ID的消息无法按ID覆盖
+			const int index = journaled.messageIndex(message.m_BubbleID);
+			if (index < 0 || !sameContent(journaled.sMsg.at(index), message))
+				putMessage(it.key(), session, message);
+		}
+	}
+}
+
+void SessionJournal::startSnapshot(const ChatSessionMap& sessions) {
+	// 排在之前的记录之后：这些记录写入切换前的日志，会话表已包含它们的结果
+	m_compacting = true;
+	enqueue([this, sessions]() {
+		compact(sessions);
+	});
+}
+
+void SessionJournal::compact(const ChatSessionMap& sessions) {
+	const QString rotated = rotatedJournalFile(journalFile());
+	bool success = true;
+	// 上次失败留下的旧日志仍需保留，此时当前日志不切换，新快照写成后一并失效（重放是幂等的）
+	if (!QFile::exists(rotated)) {
+		closeJournal();
+		if (!QFile::rename(journalFile(), rotated)) {
+			openJournal(false);
+			success = false;
+		}
+		else {
+			success = openJournal(true);
+		}
+	}
+	qint64 bytes = 0;
+	success = success && writeSnapshotFile(m_snapshotFile, sessions, &bytes);
+	// 快照已包含切换前的全部记录，旧日志不再需要
+	if (success)
+		QFile::remove(rotated);
+	// 析构时会等待任务结束，这里 this 一定有效
+	QMetaObject::invokeMethod(this, [this, success, bytes]() {
+		onCompactionFinished(success, bytes);
+	}, Qt::QueuedConnection);
+}
+
+void SessionJournal::sync() {
+	m_syncTimer->stop();
+	enqueue([this]() {
+		syncJournal();
+	});
+}
+
+void SessionJournal::syncJournal() {
+	if (m_unsyncedRecords == 0 || !m_journal.isOpen())
+		return;
+	syncToDisk(m_journal);
+	m_unsyncedRecords = 0;
+}
+
+void SessionJournal::applyRecord(ChatSessionMap& sessions, const QJsonObject& record) {
+	const QString op = record.value("op").toString();
+	const QString sessionId = record.value("sid").toString();
+	if (sessionId.isEmpty())
+		return;
+
+	if (op == QLatin1String("remove")) {
+		sessions.remove(sessionId);
+		return;
+	}
+	if (op == QLatin1String("session")) {
+		ChatSession session;
+		session.fromJson(record.value("session").toObject());
+		sessions.insert(sessionId, session);
+		return;
+	}
+
+	ChatSession& session = sessions[sessionId];
+	const QDateTime saveTime = QDateTime::fromString(record.value("saveTime").toString(), Qt::ISODate);
+	if (saveTime.isValid())
+		session.SaveTime = saveTime;
+
+	if (op == QLatin1String("put")) {
+		ChatMessageData message;
+		message.fromJson(record.value("msg").toObject());
+		const int index = session.messageIndex(message.m_BubbleID);
+		if (index >= 0)
+			session.sMsg[index] = message;
+		else
+			session.appendMessage(std::move(message));
+	}
+	else if (op == QLatin1String("annotate")) {
+		const int index = session.messageIndex(record.value("bubbleid").toString());
+		if (index >= 0) {
+			session.sMsg[index].m_Note = record.value("note").toString();
+			session.sMsg[index].m_IsImportant = record.value("important").toBool(false);
+		}
+	}
+}
+
+void SessionJournal::replayJournals(const QString& snapshotFile, ChatSessionMap& sessions) {
+	const QString journal = snapshotFile + QStringLiteral(".journal");
+	replay(rotatedJournalFile(journal), sessions);
+	replay(journal, sessions);
+}
+
+bool SessionJournal::openJournal(bool truncate) {
+	if (m_journal.isOpen())
+		return true;
+	const QString filePath = journalFile();
+	if (filePath.isEmpty())
+		return false;
+	m_journal.setFileName(filePath);
+	QIODevice::OpenMode mode = QIODevice::WriteOnly;
+	mode |= truncate ? QIODevice::Truncate : QIODevice::Append;
+	m_unsyncedRecords = 0;
+	const bool opened = m_journal.open(mode);
+	m_journalBytes.store(opened ? m_journal.size() : 0);
+	return opened;
+}
+
+void SessionJournal::closeJournal() {
+	if (!m_journal.isOpen())
+		return;
+	syncJournal();
+	m_journal.close();
+}
+
+qint64 SessionJournal::replay(const QString& filePath, ChatSessionMap& sessions) {
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+		return 0;
+	const QByteArray data = file.readAll();
+	file.close();
+
+	qint64 validBytes = 0;
+	int lineStart = 0;
+	while (lineStart < data.size()) {
+		const int lineEnd = data.indexOf('\n', lineStart);
+		if (lineEnd < 0)
+			break; // 没有换行的最后一行没有写完
+		QJsonParseError error;
+		const QJsonDocument doc = QJsonDocument::fromJson(
+			QByteArray::fromRawData(data.constData() + lineStart, lineEnd - lineStart), &error);
+		if (error.error != QJsonParseError::NoError || !doc.isObject())
+			break; // 损坏的记录之后的内容不可信
+		applyRecord(sessions, doc.object());
+		lineStart = lineEnd + 1;
+		validBytes = lineStart;
+	}
+	return validBytes;
+}
+
+bool SessionJournal::writeSnapshotFile(const QString& filePath, const ChatSessionMap& sessions, qint64* bytes) {
+	QJsonObject root;
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it) {
+		root.insert(it.key(), it.value().toJson());
+	}
+
+	// 先写临时文件再替换，中途失败时原快照保持完整
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	const QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Indented);
+	if (file.write(data) != data.size())
+		return false;
+	if (!file.commit())
+		return false;
+	if (bytes)
+		*bytes = data.size();
+	return true;
+}
+
+void SessionJournal::onCompactionFinished(bool success, qint64 snapshotBytes) {
+	m_compacting = false;
+	if (success)
+		m_snapshotBytes = snapshotBytes;
+	else
+		m_snapshotBytes = qMax(m_snapshotBytes, m_journalBytes.load()); // 失败后等日志再增长一倍才重试
+}
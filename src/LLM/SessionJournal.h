@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QFile>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+
+#include "SessionStore.h"
+
+class QTimer;
+
+// 会话日志存储（默认后端）
+// 快照文件保存全部会话（格式与原来的会话JSON相同），每次修改只向日志文件（快照路径 + ".journal"）追加一行紧凑JSON；
+// 落盘按 kSyncDelayMs / kSyncBatchRecords 合并；日志超过快照大小时切换到新日志并重写快照
+// 日志文件的写入、落盘、切换和快照重写都在同一个写入线程中按调用顺序执行，GUI线程只排队
+// 自动保存只为内容有变化但还没有记录的消息（接收中的回答）追加记录
+class SessionJournal : public QObject, public SessionStore {
+	Q_OBJECT
+public:
+	explicit SessionJournal(QObject* parent = nullptr);
+	~SessionJournal() override;
+
+	// 快照文件
+	void setStorageFile(const QString& filePath) override;
+	[[nodiscard]] QString snapshotFile() const;
+	[[nodiscard]] QString journalFile() const;
+
+	// 读取快照并按顺序重放日志；之后的记录追加到日志
+	// 快照无法解析时另存为 .corrupt 副本，此后不再重写快照（不压缩、saveAll 失败），修改只追加到日志
+	bool load(ChatSessionMap& sessions) override;
+	// 同步重写快照并清空日志
+	bool saveAll(const ChatSessionMap& sessions) override;
+
+	void sessionCreated(const QString& sessionId, const ChatSession& session) override;
+	void sessionRemoved(const QString& sessionId) override;
+	void sessionReplaced(const QString& sessionId, const ChatSession& session) override;
+	void messagePut(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) override;
+	void messageAnnotated(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) override;
+
+	// 日志超过阈值时切换日志并在后台重写快照
+	void compactIfNeeded(const ChatSessionMap& sessions) override;
+	// 为修改过的会话中与已记录内容不同的消息追加记录，之后按需整理
+	bool saveAsync(const ChatSessionMap& sessions, const QSet<QString>& changed) override;
+	// 在写入线程中落盘（排在已有的写入之后）
+	void sync();
+
+	// 把一条记录应用到会话表；重复应用结果不变，因此快照之后的日志可以整段重放
+	static void applyRecord(ChatSessionMap& sessions, const QJsonObject& record);
+	// 把快照文件对应的旧日志和当前日志依次重放到 sessions，不打开也不修改日志文件
+	static void replayJournals(const QString& snapshotFile, ChatSessionMap& sessions);
+
+private:
+	class WriterTask;
+
+	void enqueue(std::function<void()> work);
+	// 排入一条记录的写入任务，并启动延迟落盘
+	void queueRecord(std::function<void()> work);
+
+	// 以下在写入线程中调用（或在 m_pool 空闲时由 GUI 线程调用）
+	// 追加一条记录（写入操作系统缓冲，落盘延迟合并）
+	void append(const QString& op, const QString& sessionId, const ChatSession* session, QJsonObject record);
+	// 追加一条 put 记录并记下消息已写入日志
+	void putMessage(const QString& sessionId, const ChatSession& session, const ChatMessageData& message);
+	// 为与已记录内容不同的消息追加 put 记录
+	void appendChanges(const ChatSessionMap& sessions);
+	void writeLine(const QByteArray& line);
+	void syncJournal();
+	// 切换日志并重写快照，结束后在GUI线程调用 onCompactionFinished
+	void compact(const ChatSessionMap& sessions);
+	bool openJournal(bool truncate);
+	void closeJournal();
+	// 重放一个日志文件，返回有效记录的字节数（末尾不完整的行不计入）
+	static qint64 replay(const QString& filePath, ChatSessionMap& sessions);
+	// sessions 必须是独立的浅拷贝（不与GUI线程共享哈希表）
+	void startSnapshot(const ChatSessionMap& sessions);
+	static bool writeSnapshotFile(const QString& filePath, const ChatSessionMap& sessions, qint64* bytes);
+	void onCompactionFinished(bool success, qint64 snapshotBytes);
+
+	QString m_snapshotFile;
+	// 快照加日志重放后的会话（与会话表隐式共享），自动保存时据此找出还没有记录的修改；只在写入线程中使用
+	ChatSessionMap m_journaled;
+	QFile m_journal;   // 只在写入线程中使用
+	QTimer* m_syncTimer = nullptr;
+	int m_unsyncedRecords = 0;   // 写入线程
+	QAtomicInteger<qint64> m_journalBytes;   // 日志大小，写入线程更新，GUI线程据此决定何时压缩
+	qint64 m_snapshotBytes = 0;
+	bool m_compacting = false;
+	bool m_snapshotCorrupt = false;   // 快照存在但无法解析，不能覆盖
+	QThreadPool m_pool;   // 单线程且不过期，日志文件始终由同一个线程写入
+
+	static constexpr int kSyncDelayMs = 1000;
+	static constexpr int kSyncBatchRecords = 64;
+	static constexpr qint64 kCompactMinBytes = 4 * 1024 * 1024;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "ChatSessionTypes.h"
+
+// 全文检索命中的会话，按相关度从高到低排列
+struct SessionSearchHit {
+	QString sessionId;
+	QStringList bubbleIds;   // 命中的消息（会话内按相关度排列）
+};
+
+// 会话摘要：填充侧边栏只需要这些信息，不必读取会话全文
+struct ChatSessionSummary {
+	static constexpr int kPreviewLength = 32;
+
+	QString sessionId;
+	QString title;        // 最后一条消息的对话名称
+	QString preview;      // 最后一条消息开头的文字
+	QDateTime saveTime;
+	int messageCount = 0;
+	QString file;         // 所在的历史文件
+	qint64 offset = -1;   // 会话在 JSON 快照或归档文件中的字节位置（数据库中的会话为 -1）
+	qint64 length = 0;
+
+	static ChatSessionSummary fromSession(const QString& sessionId, const ChatSession& session) {
+		ChatSessionSummary summary;
+		summary.sessionId = sessionId;
+		summary.saveTime = session.SaveTime;
+		summary.messageCount = session.sMsg.size();
+		if (!session.sMsg.isEmpty()) {
+			summary.title = session.sMsg.last().m_DialogName;
+			summary.preview = session.sMsg.last().m_ChatMsg.left(kPreviewLength);
+		}
+		return summary;
+	}
+
+	QJsonObject toJson() const {
+		QJsonObject obj;
+		obj["id"] = sessionId;
+		obj["title"] = title;
+		obj["preview"] = preview;
+		obj["saveTime"] = saveTime.toString(Qt::ISODate);
+		obj["count"] = messageCount;
+		obj["offset"] = static_cast<double>(offset);
+		obj["length"] = static_cast<double>(length);
+		return obj;
+	}
+
+	void fromJson(const QJsonObject& obj) {
+		sessionId = obj["id"].toString();
+		title = obj["title"].toString();
+		preview = obj["preview"].toString();
+		saveTime = QDateTime::fromString(obj["saveTime"].toString(), Qt::ISODate);
+		messageCount = obj["count"].toInt();
+		offset = static_cast<qint64>(obj["offset"].toDouble(-1));
+		length = static_cast<qint64>(obj["length"].toDouble());
+	}
+};
+
+// 会话持久化后端
+// ChatSessionService 在内存中保存全部会话，每次修改只把变化的部分交给后端
+class SessionStore {
+public:
+	virtual ~SessionStore() = default;
+
+	virtual void setStorageFile(const QString& filePath) = 0;
+	// 读取全部会话
+	virtual bool load(ChatSessionMap& sessions) = 0;
+	// 完整保存（退出、清空时）
+	virtual bool saveAll(const ChatSessionMap& sessions) = 0;
+
+	virtual void sessionCreated(const QString& sessionId, const ChatSession& session) = 0;
+	virtual void sessionRemoved(const QString& sessionId) = 0;
+	virtual void sessionReplaced(const QString& sessionId, const ChatSession& session) = 0;
+	// 消息新增或内容变化（按气泡ID覆盖）
+	virtual void messagePut(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) = 0;
+	// 消息备注、重要标记变化
+	virtual void messageAnnotated(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) = 0;
+
+	// 每次写入之后调用，后端按需整理存储
+	virtual void compactIfNeeded(const ChatSessionMap& sessions) { Q_UNUSED(sessions); }
+	// 自动保存：sessions 是全部会话的浅拷贝（消息列表隐式共享，不复制），changed 为其中修改过的会话
+	// 序列化和写盘在后台线程完成；后端正忙时返回 false，由调用方稍后重试
+	virtual bool saveAsync(const ChatSessionMap& sessions, const QSet<QString>& changed) {
+		Q_UNUSED(sessions);
+		Q_UNUSED(changed);
+		return true;
+	}
+	// 全文检索；不支持时返回 false，由调用方逐个会话查找
+	virtual bool search(const QString& text, int limit, QList<SessionSearchHit>& hits) {
+		Q_UNUSED(text);
+		Q_UNUSED(limit);
+		Q_UNUSED(hits);
+		return false;
+	}
+};
@@ -0,0 +1,640 @@
+#include "SqliteSessionStore.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QJsonDocument>
+#include <QRunnable>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextDocumentFragment>
+#include <QVariant>
+
+namespace {
+	const QString kDriver = QStringLiteral("QSQLITE");
+
+	bool exec(QSqlQuery& query) {
+		if (query.exec())
+			return true;
+		qWarning() << "SqliteSessionStore:" << query.lastQuery() << query.lastError().text();
+		return false;
+	}
+
+	bool exec(const QSqlDatabase& db, const QString& sql) {
+		QSqlQuery query(db);
+		if (query.exec(sql))
+			return true;
+		qWarning() << "SqliteSessionStore:" << sql << query.lastError().text();
+		return false;
+	}
+
+	// 一次写入在一个事务中完成，析构时未提交则回滚
+	class Transaction {
+	public:
+		explicit Transaction(QSqlDatabase db)
+			: m_db(std::move(db))
+			, m_active(m_db.transaction()) {}
+		~Transaction() {
+			if (m_active)
+				m_db.rollback();
+		}
+		bool commit() {
+			if (!m_active)
+				return false;
+			m_active = false;
+			return m_db.commit();
+		}
+
+	private:
+		QSqlDatabase m_db;
+		bool m_active;
+	};
+
+	// 与其他连接（同步保存、其他进程）的写事务冲突时等待的时间；GUI线程只读，WAL 模式下读取不等待
+	constexpr int kBusyTimeoutMs = 1000;
+
+	QString plainText(const QString& html) {
+		return html.isEmpty() ? QString() : QTextDocumentFragment::fromHtml(html).toPlainText();
+	}
+}
+
+// 写入线程中的任务（QSqlDatabase 连接不能跨线程使用，写入连接只在这个线程中打开和关闭）
+class SqliteSessionStore::WriterTask : public QRunnable {
+public:
+	explicit WriterTask(std::function<void()> work)
+		: m_work(std::move(work)) {
+		setAutoDelete(true);
+	}
+
+	void run() override {
+		m_work();
+	}
+
+private:
+	std::function<void()> m_work;
+};
+
+SqliteSessionStore::SqliteSessionStore()
+	: m_connectionName(QStringLiteral("ChatSessions-%1").arg(reinterpret_cast<quintptr>(this), 0, 16)) {
+	m_pool.setMaxThreadCount(1);
+	m_pool.setExpiryTimeout(-1);
+}
+
+SqliteSessionStore::~SqliteSessionStore() {
+	close();
+}
+
+bool SqliteSessionStore::open(const QString& filePath, OpenMode mode) {
+	close();
+	if (filePath.isEmpty() || !QSqlDatabase::isDriverAvailable(kDriver))
+		return false;
+	m_readOnly = mode == OpenMode::ReadOnly;
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase(kDriver, m_connectionName);
+		db.setDatabaseName(filePath);
+		if (m_readOnly)
+			db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=%1").arg(kBusyTimeoutMs));
+		if (!db.open()) {
+			qWarning() << "SqliteSessionStore: cannot open" << filePath << db.lastError().text();
+		}
+		else {
+			m_open = true;
+		}
+	}
+	if (m_open && m_readOnly)
+		inspectSchema();
+	else if (!m_open || !createSchema()) {
+		close();
+		return false;
+	}
+	m_filePath = filePath;
+	return true;
+}
+
+bool SqliteSessionStore::isOpen() const {
+	return m_open;
+}
+
+bool SqliteSessionStore::isEmpty() const {
+	if (!m_open)
+		return true;
+	QSqlQuery query(database());
+	return !query.exec(QStringLiteral("SELECT 1 FROM sessions LIMIT 1")) || !query.next();
+}
+
+QSqlDatabase SqliteSessionStore::database() const {
+	return QSqlDatabase::database(m_connectionName, false);
+}
+
+void SqliteSessionStore::close() {
+	shutdownWriter();
+	if (!QSqlDatabase::contains(m_connectionName))
+		return;
+	{
+		QSqlDatabase db = database();
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(m_connectionName);
+	m_open = false;
+	m_readOnly = false;
+	m_hasLayout = true;
+	m_filePath.clear();
+}
+
+bool SqliteSessionStore::createSchema() {
+	const QSqlDatabase db = database();
+	// WAL + NORMAL：提交不等待落盘，单条消息的写入不会卡住界面
+	exec(db, QStringLiteral("PRAGMA journal_mode=WAL"));
+	exec(db, QStringLiteral("PRAGMA synchronous=NORMAL"));
+	exec(db, QStringLiteral("PRAGMA foreign_keys=ON"));
+	exec(db, QStringLiteral("PRAGMA busy_timeout=%1").arg(kBusyTimeoutMs));
+
+	if (!exec(db, QStringLiteral(
+		"CREATE TABLE IF NOT EXISTS sessions("
+		"id TEXT PRIMARY KEY, "
+		"save_time TEXT)")))
+		return false;
+	if (!exec(db, QStringLiteral(
+		"CREATE TABLE IF NOT EXISTS messages("
+		"id INTEGER PRIMARY KEY, "
+		"session_id TEXT NOT NULL REFERENCES sessions(id) ON DELETE CASCADE, "
+		"bubble_id TEXT NOT NULL, "
+		"seq INTEGER NOT NULL, "
+		"user_type INTEGER, "
+		"msg TEXT, "
+		"reasoning TEXT, "
+		"time TEXT, "
+		"dialog_name TEXT, "
+		"important INTEGER NOT NULL DEFAULT 0, "
+		"note TEXT, "
+		"layout TEXT, "
+		"UNIQUE(session_id, bubble_id))")))
+		return false;
+	// 早期的库只有单一尺寸（width、height 列，不再使用），补上排版缓存列
+	QSqlQuery columns(db);
+	bool hasLayout = false;
+	columns.exec(QStringLiteral("PRAGMA table_info(messages)"));
+	while (columns.next())
+		hasLayout = hasLayout || columns.value(1).toString() == QLatin1String("layout");
+	if (!hasLayout && !exec(db, QStringLiteral("ALTER TABLE messages ADD COLUMN layout TEXT")))
+		return false;
+	if (!exec(db, QStringLiteral(
+		"CREATE INDEX IF NOT EXISTS messages_by_session ON messages(session_id, seq)")))
+		return false;
+
+	// message_fts 的 rowid 与 messages.id 相同；优先使用 trigram 分词（SQLite 3.34+）
+	QSqlQuery existing(db);
+	existing.exec(QStringLiteral("SELECT sql FROM sqlite_master WHERE name = 'message_fts'"));
+	if (existing.next()) {
+		m_trigram = existing.value(0).toString().contains(QLatin1String("trigram"));
+		return true;
+	}
+	QSqlQuery create(db);
+	if (create.exec(QStringLiteral("CREATE VIRTUAL TABLE message_fts USING fts5(body, tokenize = 'trigram')"))) {
+		m_trigram = true;
+		return true;
+	}
+	m_trigram = false;
+	return exec(db, QStringLiteral("CREATE VIRTUAL TABLE message_fts USING fts5(body, tokenize = 'unicode61')"));
+}
+
+void SqliteSessionStore::inspectSchema() {
+	const QSqlDatabase db = database();
+	QSqlQuery columns(db);
+	m_hasLayout = false;
+	columns.exec(QStringLiteral("PRAGMA table_info(messages)"));
+	while (columns.next())
+		m_hasLayout = m_hasLayout || columns.value(1).toString() == QLatin1String("layout");
+	QSqlQuery existing(db);
+	existing.exec(QStringLiteral("SELECT sql FROM sqlite_master WHERE name = 'message_fts'"));
+	m_trigram = existing.next() && existing.value(0).toString().contains(QLatin1String("trigram"));
+}
+
+QString SqliteSessionStore::layoutColumn() const {
+	return m_hasLayout ? QStringLiteral("layout") : QStringLiteral("NULL");
+}
+
+void SqliteSessionStore::setStorageFile(const QString& filePath) {
+	open(filePath);
+}
+
+bool SqliteSessionStore::load(ChatSessionMap& sessions) {
+	if (!m_open)
+		return false;
+	sessions.clear();
+	const QSqlDatabase db = database();
+
+	QSqlQuery sessionQuery(db);
+	sessionQuery.setForwardOnly(true);
+	if (!sessionQuery.exec(QStringLiteral("SELECT id, save_time FROM sessions")))
+		return false;
+	while (sessionQuery.next()) {
+		ChatSession session;
+		session.SaveTime = QDateTime::fromString(sessionQuery.value(1).toString(), Qt::ISODate);
+		sessions.insert(sessionQuery.value(0).toString(), session);
+	}
+
+	QSqlQuery messageQuery(db);
+	messageQuery.setForwardOnly(true);
+	if (!messageQuery.exec(QStringLiteral(
+		"SELECT session_id, bubble_id, user_type, msg, reasoning, time, dialog_name, important, note, %1 "
+		"FROM messages ORDER BY session_id, seq").arg(layoutColumn())))
+		return !sessions.isEmpty();
+	QString currentId;
+	ChatSession* current = nullptr;
+	while (messageQuery.next()) {
+		const QString sessionId = messageQuery.value(0).toString();
+		if (!current || sessionId != currentId) {
+			currentId = sessionId;
+			auto it = sessions.find(sessionId);
+			current = it != sessions.end() ? &it.value() : nullptr;
+		}
+		if (!current)
+			continue;
+		current->appendMessage(readMessage(messageQuery, 1));
+	}
+	return !sessions.isEmpty();
+}
+
+bool SqliteSessionStore::loadSummaries(QList<ChatSessionSummary>& summaries) {
+	summaries.clear();
+	if (!m_open)
+		return false;
+	QSqlQuery query(database());
+	query.setForwardOnly(true);
+	if (!query.exec(QStringLiteral(
+		"SELECT sessions.id, sessions.save_time, "
+		"(SELECT COUNT(*) FROM messages WHERE session_id = sessions.id), "
+		"last.dialog_name, substr(last.msg, 1, %1) "
+		"FROM sessions LEFT JOIN messages AS last ON last.id = "
+		"(SELECT id FROM messages WHERE session_id = sessions.id ORDER BY seq DESC LIMIT 1)")
+		.arg(ChatSessionSummary::kPreviewLength)))
+		return false;
+	while (query.next()) {
+		ChatSessionSummary summary;
+		summary.sessionId = query.value(0).toString();
+		summary.saveTime = QDateTime::fromString(query.value(1).toString(), Qt::ISODate);
+		summary.messageCount = query.value(2).toInt();
+		summary.title = query.value(3).toString();
+		summary.preview = query.value(4).toString();
+		summaries.append(summary);
+	}
+	return true;
+}
+
+bool SqliteSessionStore::loadSession(const QString& sessionId, ChatSession& session) {
+	if (!m_open)
+		return false;
+	QSqlQuery sessionQuery(database());
+	sessionQuery.prepare(QStringLiteral("SELECT save_time FROM sessions WHERE id = ?"));
+	sessionQuery.addBindValue(sessionId);
+	if (!exec(sessionQuery) || !sessionQuery.next())
+		return false;
+	session = ChatSession();
+	session.SaveTime = QDateTime::fromString(sessionQuery.value(0).toString(), Qt::ISODate);
+
+	QSqlQuery messageQuery(database());
+	messageQuery.setForwardOnly(true);
+	messageQuery.prepare(QStringLiteral(
+		"SELECT bubble_id, user_type, msg, reasoning, time, dialog_name, important, note, %1 "
+		"FROM messages WHERE session_id = ? ORDER BY seq").arg(layoutColumn()));
+	messageQuery.addBindValue(sessionId);
+	if (!exec(messageQuery))
+		return false;
+	while (messageQuery.next())
+		session.appendMessage(readMessage(messageQuery, 0));
+	return true;
+}
+
+bool SqliteSessionStore::saveAll(const ChatSessionMap& sessions) {
+	if (!m_open || m_readOnly)
+		return false;
+	// 先让排队的写入完成，之后写入线程不再持有写锁
+	m_pool.waitForDone();
+	Transaction transaction(database());
+
+	// 删除已不存在的会话
+	QStringList stale;
+	{
+		QSqlQuery query(database());
+		query.setForwardOnly(true);
+		if (!query.exec(QStringLiteral("SELECT id FROM sessions")))
+			return false;
+		while (query.next()) {
+			const QString sessionId = query.value(0).toString();
+			if (!sessions.contains(sessionId))
+				stale.append(sessionId);
+		}
+	}
+	for (const QString& sessionId : stale) {
+		if (!deleteSession(sessionId))
+			return false;
+	}
+
+	// 其余按行覆盖，文本没有变化的消息不重建索引
+	return writeSessions(sessions) && transaction.commit();
+}
+
+bool SqliteSessionStore::saveAsync(const ChatSessionMap& sessions, const QSet<QString>& changed) {
+	if (!m_open)
+		return true;
+	ChatSessionMap modified;
+	for (const QString& sessionId : changed) {
+		auto it = sessions.constFind(sessionId);
+		if (it != sessions.constEnd())
+			modified.insert(it.key(), it.value());
+	}
+	// 排在之前的写入之后、之后的写入之前：较早的快照不会覆盖之后写入的消息
+	if (!modified.isEmpty()) {
+		enqueueWrite([modified](SqliteSessionStore& writer) {
+			// 排队期间被删除的会话不再写回
+			return writer.writeSessions(modified, true);
+		});
+	}
+	return true;
+}
+
+void SqliteSessionStore::sessionCreated(const QString& sessionId, const ChatSession& session) {
+	enqueueWrite([sessionId, session](SqliteSessionStore& writer) {
+		return writer.writeSession(sessionId, session);
+	});
+}
+
+void SqliteSessionStore::sessionRemoved(const QString& sessionId) {
+	enqueueWrite([sessionId](SqliteSessionStore& writer) {
+		return writer.deleteSession(sessionId);
+	});
+}
+
+void SqliteSessionStore::sessionReplaced(const QString& sessionId, const ChatSession& session) {
+	enqueueWrite([sessionId, session](SqliteSessionStore& writer) {
+		if (!writer.deleteSession(sessionId) || !writer.writeSession(sessionId, session))
+			return false;
+		for (int i = 0; i < session.sMsg.size(); ++i) {
+			if (!writer.writeMessage(sessionId, i, session.sMsg.at(i)))
+				return false;
+		}
+		return true;
+	});
+}
+
+void SqliteSessionStore::messagePut(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) {
+	// 序号在提交时确定，会话只按值带上保存时间等字段（消息列表隐式共享，不复制）
+	const int seq = session.messageIndex(message.m_BubbleID);
+	enqueueWrite([sessionId, session, message, seq](SqliteSessionStore& writer) {
+		return writer.writeSession(sessionId, session) && writer.writeMessage(sessionId, seq, message);
+	});
+}
+
+void SqliteSessionStore::messageAnnotated(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) {
+	enqueueWrite([sessionId, session, message](SqliteSessionStore& writer) {
+		if (!writer.writeSession(sessionId, session))
+			return false;
+		QSqlQuery query(writer.database());
+		query.prepare(QStringLiteral(
+			"UPDATE messages SET important = ?, note = ? WHERE session_id = ? AND bubble_id = ?"));
+		query.addBindValue(message.m_IsImportant);
+		query.addBindValue(message.m_Note);
+		query.addBindValue(sessionId);
+		query.addBindValue(message.m_BubbleID);
+		return exec(query);
+	});
+}
+
+void SqliteSessionStore::enqueueWrite(Write write) {
+	if (!m_open || m_readOnly)
+		return;
+	if (!m_writer)
+		m_writer = std::make_unique<SqliteSessionStore>();
+	SqliteSessionStore* writer = m_writer.get();
+	const QString filePath = m_filePath;
+	m_pool.start(new WriterTask([writer, filePath, write]() {
+		if (!writer->isOpen() && !writer->open(filePath))
+			return;
+		Transaction transaction(writer->database());
+		if (!write(*writer) || !transaction.commit())
+			qWarning() << "SqliteSessionStore: write failed" << filePath;
+	}));
+}
+
+void SqliteSessionStore::shutdownWriter() {
+	if (!m_writer)
+		return;
+	SqliteSessionStore* writer = m_writer.get();
+	m_pool.start(new WriterTask([writer]() {
+		writer->close();
+	}));
+	m_pool.waitForDone();
+	m_writer.reset();
+}
+
+bool SqliteSessionStore::search(const QString& text, int limit, QList<SessionSearchHit>& hits) {
+	hits.clear();
+	if (!m_open)
+		return false;
+	const QString needle = text.trimmed();
+	if (needle.isEmpty())
+		return true;
+
+	QSqlQuery query(database());
+	query.setForwardOnly(true);
+	if (m_trigram && needle.size() < 3) {
+		// trigram 索引无法匹配少于三个字符的片段，退回 LIKE（仍只扫描索引文本）
+		QString pattern = needle;
+		pattern.replace(QLatin1Char('\\'), QLatin1String("\\\\"))
+			.replace(QLatin1Char('%'), QLatin1String("\\%"))
+			.replace(QLatin1Char('_'), QLatin1String("\\_"));
+		query.prepare(QStringLiteral(
+			"SELECT messages.session_id, messages.bubble_id FROM message_fts "
+			"JOIN messages ON messages.id = message_fts.rowid "
+			"WHERE message_fts.body LIKE ? ESCAPE '\\' "
+			"ORDER BY messages.id DESC LIMIT ?"));
+		query.addBindValue(QLatin1Char('%') + pattern + QLatin1Char('%'));
+	}
+	else {
+		// trigram 按整个片段做子串匹配；unicode61 按词做前缀匹配
+		QString match;
+		if (m_trigram) {
+			match = QLatin1Char('"') + QString(needle).replace(QLatin1Char('"'), QLatin1String("\"\"")) + QLatin1Char('"');
+		}
+		else {
+			QStringList terms;
+			for (QString term : needle.split(QLatin1Char(' '), QString::SkipEmptyParts)) {
+				terms << QLatin1Char('"') + term.replace(QLatin1Char('"'), QLatin1String("\"\"")) + QLatin1String("\"*");
+			}
+			match = terms.join(QLatin1Char(' '));
+		}
+		query.prepare(QStringLiteral(
+			"SELECT messages.session_id, messages.bubble_id FROM message_fts "
+			"JOIN messages ON messages.id = message_fts.rowid "
+			"WHERE message_fts MATCH ? "
+			"ORDER BY message_fts.rank LIMIT ?"));
+		query.addBindValue(match);
+	}
+	query.addBindValue(limit);
+	if (!exec(query))
+		return false;
+
+	// 会话按其最相关消息的顺序排列
+	QHash<QString, int> sessionRows;
+	while (query.next()) {
+		const QString sessionId = query.value(0).toString();
+		auto it = sessionRows.find(sessionId);
+		if (it == sessionRows.end()) {
+			it = sessionRows.insert(sessionId, hits.size());
+			SessionSearchHit hit;
+			hit.sessionId = sessionId;
+			hits.append(hit);
+		}
+		hits[it.value()].bubbleIds.append(query.value(1).toString());
+	}
+	return true;
+}
+
+bool SqliteSessionStore::writeSessions(const ChatSessionMap& sessions, bool existingOnly) {
+	QSqlQuery exists(database());
+	exists.prepare(QStringLiteral("SELECT 1 FROM sessions WHERE id = ?"));
+	for (auto it = sessions.constBegin(); it != sessions.constEnd(); ++it) {
+		if (existingOnly) {
+			exists.addBindValue(it.key());
+			if (!exec(exists))
+				return false;
+			const bool found = exists.next();
+			exists.finish();
+			if (!found)
+				continue;
+		}
+		if (!writeSession(it.key(), it.value()))
+			return false;
+		const QList<ChatMessageData>& messages = it.value().sMsg;
+		for (int i = 0; i < messages.size(); ++i) {
+			if (!writeMessage(it.key(), i, messages.at(i)))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool SqliteSessionStore::writeSession(const QString& sessionId, const ChatSession& session) {
+	const QString saveTime = session.SaveTime.toString(Qt::ISODate);
+	QSqlQuery update(database());
+	update.prepare(QStringLiteral("UPDATE sessions SET save_time = ? WHERE id = ?"));
+	update.addBindValue(saveTime);
+	update.addBindValue(sessionId);
+	if (!exec(update))
+		return false;
+	if (update.numRowsAffected() > 0)
+		return true;
+	QSqlQuery insert(database());
+	insert.prepare(QStringLiteral("INSERT INTO sessions(id, save_time) VALUES(?, ?)"));
+	insert.addBindValue(sessionId);
+	insert.addBindValue(saveTime);
+	return exec(insert);
+}
+
+bool SqliteSessionStore::writeMessage(const QString& sessionId, int seq, const ChatMessageData& message) {
+	if (seq < 0)
+		return false;
+	const QSqlDatabase db = database();
+	QSqlQuery existing(db);
+	existing.prepare(QStringLiteral(
+		"SELECT id, msg, reasoning FROM messages WHERE session_id = ? AND bubble_id = ?"));
+	existing.addBindValue(sessionId);
+	existing.addBindValue(message.m_BubbleID);
+	if (!exec(existing))
+		return false;
+
+	qint64 rowId = -1;
+	bool textChanged = true;
+	QSqlQuery write(db);
+	if (existing.next()) {
+		rowId = existing.value(0).toLongLong();
+		textChanged = existing.value(1).toString() != message.m_ChatMsg
+			|| existing.value(2).toString() != message.m_ChatReasonMsg;
+		write.prepare(QStringLiteral(
+			"UPDATE messages SET seq = ?, user_type = ?, msg = ?, reasoning = ?, time = ?, "
+			"dialog_name = ?, important = ?, note = ?, layout = ? WHERE id = ?"));
+	}
+	else {
+		write.prepare(QStringLiteral(
+			"INSERT INTO messages(seq, user_type, msg, reasoning, time, dialog_name, important, note, layout, "
+			"session_id, bubble_id) VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+	}
+	write.addBindValue(seq);
+	write.addBindValue(message.userType);
+	write.addBindValue(message.m_ChatMsg);
+	write.addBindValue(message.m_ChatReasonMsg);
+	write.addBindValue(message.m_ChatTime);
+	write.addBindValue(message.m_DialogName);
+	write.addBindValue(message.m_IsImportant);
+	write.addBindValue(message.m_Note);
+	write.addBindValue(message.m_Layout.heights.isEmpty() ? QString()
+		: QString::fromUtf8(QJsonDocument(message.m_Layout.toJson()).toJson(QJsonDocument::Compact)));
+	if (rowId >= 0) {
+		write.addBindValue(rowId);
+	}
+	else {
+		write.addBindValue(sessionId);
+		write.addBindValue(message.m_BubbleID);
+	}
+	if (!exec(write))
+		return false;
+	if (rowId < 0)
+		rowId = write.lastInsertId().toLongLong();
+	if (!textChanged)
+		return true;
+
+	// 只重建这一条消息的索引
+	QSqlQuery removeIndex(db);
+	removeIndex.prepare(QStringLiteral("DELETE FROM message_fts WHERE rowid = ?"));
+	removeIndex.addBindValue(rowId);
+	if (!exec(removeIndex))
+		return false;
+	const QString body = indexText(message);
+	if (body.trimmed().isEmpty())
+		return true;
+	QSqlQuery addIndex(db);
+	addIndex.prepare(QStringLiteral("INSERT INTO message_fts(rowid, body) VALUES(?, ?)"));
+	addIndex.addBindValue(rowId);
+	addIndex.addBindValue(body);
+	return exec(addIndex);
+}
+
+bool SqliteSessionStore::deleteSession(const QString& sessionId) {
+	const QSqlDatabase db = database();
+	QSqlQuery removeIndex(db);
+	removeIndex.prepare(QStringLiteral(
+		"DELETE FROM message_fts WHERE rowid IN (SELECT id FROM messages WHERE session_id = ?)"));
+	removeIndex.addBindValue(sessionId);
+	QSqlQuery removeMessages(db);
+	removeMessages.prepare(QStringLiteral("DELETE FROM messages WHERE session_id = ?"));
+	removeMessages.addBindValue(sessionId);
+	QSqlQuery removeSession(db);
+	removeSession.prepare(QStringLiteral("DELETE FROM sessions WHERE id = ?"));
+	removeSession.addBindValue(sessionId);
+	return exec(removeIndex) && exec(removeMessages) && exec(removeSession);
+}
+
+ChatMessageData SqliteSessionStore::readMessage(const QSqlQuery& query, int column) {
+	ChatMessageData message;
+	message.m_BubbleID = query.value(column).toString();
+	message.userType = query.value(column + 1).toInt();
+	message.m_ChatMsg = query.value(column + 2).toString();
+	message.m_ChatReasonMsg = query.value(column + 3).toString();
+	message.m_ChatTime = query.value(column + 4).toString();
+	message.m_DialogName = query.value(column + 5).toString();
+	message.m_IsImportant = query.value(column + 6).toBool();
+	message.m_Note = query.value(column + 7).toString();
+	const QByteArray layout = query.value(column + 8).toString().toUtf8();
+	if (!layout.isEmpty())
+		message.m_Layout.fromJson(QJsonDocument::fromJson(layout).object());
+	return message;
+}
+
+QString SqliteSessionStore::indexText(const ChatMessageData& message) {
+	// 与逐个会话查找时的范围相同：回答和推理内容
+	const QString reasoning = plainText(message.m_ChatReasonMsg);
+	const QString answer = plainText(message.m_ChatMsg);
+	return reasoning.isEmpty() ? answer : answer + QLatin1Char('\n') + reasoning;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+
+#include "SessionStore.h"
+
+class QSqlDatabase;
+class QSqlQuery;
+
+// SQLite 会话存储（可选后端，需要 QSQLITE 驱动支持 FTS5）
+// sessions / messages 两张表保存会话，message_fts 保存消息纯文本的全文索引；
+// 每次写入只更新对应的行和索引，检索是一次索引查询
+// 所有写入按调用顺序排队，在同一个工作线程中通过独立连接依次完成，GUI线程的连接只用于读取
+class SqliteSessionStore : public SessionStore {
+public:
+	enum class OpenMode {
+		ReadWrite,   // 建表并补齐旧版本缺少的列
+		ReadOnly     // 只读连接，不建表、不迁移、不写入（历史索引读取摘要和会话）
+	};
+
+	SqliteSessionStore();
+	~SqliteSessionStore() override;
+
+	// 打开数据库；ReadWrite 时建表，驱动不可用或不支持 FTS5 时返回 false
+	bool open(const QString& filePath, OpenMode mode = OpenMode::ReadWrite);
+	[[nodiscard]] bool isOpen() const;
+	// 数据库中还没有任何会话（用于从旧的JSON存储导入）
+	[[nodiscard]] bool isEmpty() const;
+
+	void setStorageFile(const QString& filePath) override;
+	bool load(ChatSessionMap& sessions) override;
+	// 同步保存：等待排队的写入完成后在当前线程写入
+	bool saveAll(const ChatSessionMap& sessions) override;
+
+	void sessionCreated(const QString& sessionId, const ChatSession& session) override;
+	void sessionRemoved(const QString& sessionId) override;
+	void sessionReplaced(const QString& sessionId, const ChatSession& session) override;
+	void messagePut(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) override;
+	void messageAnnotated(const QString& sessionId, const ChatSession& session, const ChatMessageData& message) override;
+
+	bool search(const QString& text, int limit, QList<SessionSearchHit>& hits) override;
+	// 修改过的会话与其他写入一起排队
+	bool saveAsync(const ChatSessionMap& sessions, const QSet<QString>& changed) override;
+
+	// 按需读取（历史索引使用）：只读摘要，或只读一个会话
+	bool loadSummaries(QList<ChatSessionSummary>& summaries);
+	bool loadSession(const QString& sessionId, ChatSession& session);
+
+private:
+	class WriterTask;
+	// 一次写入：在写入线程中以 writer 的连接执行，返回 false 时整个事务回滚
+	using Write = std::function<bool(SqliteSessionStore& writer)>;
+
+	QSqlDatabase database() const;
+	void close();
+	// 把写入排到写入线程的队列末尾
+	void enqueueWrite(Write write);
+	// 关闭写入线程中的连接并等待队列清空
+	void shutdownWriter();
+	bool createSchema();
+	// 只读打开时读取现有表结构（是否有排版缓存列、索引的分词方式）
+	void inspectSchema();
+	// 消息查询中排版缓存列的表达式，早期的库没有这一列
+	[[nodiscard]] QString layoutColumn() const;
+	// 按行覆盖会话及其消息（由调用方开启事务）；existingOnly 时跳过已被删除的会话
+	bool writeSessions(const ChatSessionMap& sessions, bool existingOnly = false);
+	bool writeSession(const QString& sessionId, const ChatSession& session);
+	bool writeMessage(const QString& sessionId, int seq, const ChatMessageData& message);
+	bool deleteSession(const QString& sessionId);
+	static ChatMessageData readMessage(const QSqlQuery& query, int column);
+	// 消息的可检索纯文本（去掉HTML标记）
+	static QString indexText(const ChatMessageData& message);
+
+	QString m_filePath;
+	QString m_connectionName;
+	bool m_open = false;
+	bool m_readOnly = false;
+	bool m_hasLayout = true;
+	bool m_trigram = false;   // 索引使用 trigram 分词（支持中文等无空格文本的子串检索）
+	QThreadPool m_pool;       // 单线程且不过期，写入连接一直属于同一个线程
+	std::unique_ptr<SqliteSessionStore> m_writer;   // 写入线程使用的连接，第一次写入时打开
+};
@@ -0,0 +1,239 @@
+#include "StreamFrameParser.h"
+#include <cstring>
+
+namespace
+{
+	// 缓冲区初始容量
+	constexpr int kInitialCapacity = 16 * 1024;
+	// 已处理前缀超过该长度且超过缓冲区一半时才前移未处理的尾部
+	constexpr int kCompactThreshold = 4 * 1024;
+
+	bool isBlank(const char* data, int length)
+	{
+		for (int i = 0; i < length; ++i)
+		{
+			if (data[i] != ' ' && data[i] != '\t' && data[i] != '\r')
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 去掉首尾空白后是否为 [DONE]
+	bool isDoneMarker(const char* data, int length)
+	{
+		while (length > 0 && (*data == ' ' || *data == '\t'))
+		{
+			++data;
+			--length;
+		}
+		while (length > 0 && (data[length - 1] == ' ' || data[length - 1] == '\t' || data[length - 1] == '\r'))
+		{
+			--length;
+		}
+		return length == 6 && std::memcmp(data, "[DONE]", 6) == 0;
+	}
+
+	bool equals(const char* data, int length, const char* literal)
+	{
+		const int literalLength = int(std::strlen(literal));
+		return length == literalLength && std::memcmp(data, literal, length) == 0;
+	}
+}
+
+StreamFrameParser::StreamFrameParser(Format format)
+	: m_format(format)
+{
+	// 预留容量后 resize(0) 不会释放内存
+	m_buffer.reserve(kInitialCapacity);
+}
+
+void StreamFrameParser::reset(Format format)
+{
+	m_format = format;
+	m_buffer.resize(0);
+	m_lineStart = 0;
+	m_scanPos = 0;
+	clearEvent();
+}
+
+void StreamFrameParser::feed(const QByteArray& chunk, const FrameHandler& handler)
+{
+	if (chunk.isEmpty())
+	{
+		return;
+	}
+	compact();
+	m_buffer.append(chunk);
+
+	const char* base = m_buffer.constData();
+	const int size = m_buffer.size();
+	while (m_scanPos < size)
+	{
+		const void* found = std::memchr(base + m_scanPos, '\n', size_t(size - m_scanPos));
+		if (!found)
+		{
+			// 不完整的行：下次从新数据开始查找
+			m_scanPos = size;
+			break;
+		}
+		const int newline = int(static_cast<const char*>(found) - base);
+		const int lineStart = m_lineStart;
+		m_lineStart = newline + 1;
+		m_scanPos = newline + 1;
+		processLine(lineStart, newline - lineStart, handler);
+	}
+}
+
+void StreamFrameParser::finish(const FrameHandler& handler)
+{
+	if (m_lineStart < m_buffer.size())
+	{
+		const int lineStart = m_lineStart;
+		m_lineStart = m_buffer.size();
+		m_scanPos = m_lineStart;
+		processLine(lineStart, m_buffer.size() - lineStart, handler);
+	}
+	if (m_format == Format::ServerSentEvents)
+	{
+		dispatchEvent(handler);
+	}
+	reset(m_format);
+}
+
+void StreamFrameParser::compact()
+{
+	// 未完成的 SSE 事件的各行需要保留到事件结束
+	const int keepFrom = m_eventStart >= 0 ? m_eventStart : m_lineStart;
+	if (keepFrom == 0)
+	{
+		return;
+	}
+	if (keepFrom < m_buffer.size() && (keepFrom < kCompactThreshold || keepFrom * 2 < m_buffer.size()))
+	{
+		return;
+	}
+	if (keepFrom == m_buffer.size())
+	{
+		m_buffer.resize(0);
+	}
+	else
+	{
+		m_buffer.remove(0, keepFrom);
+	}
+	m_lineStart -= keepFrom;
+	m_scanPos -= keepFrom;
+	if (m_eventStart >= 0)
+	{
+		m_eventStart -= keepFrom;
+		m_eventOffset -= keepFrom;
+		m_dataOffset -= keepFrom;
+	}
+}
+
+void StreamFrameParser::processLine(int start, int length, const FrameHandler& handler)
+{
+	const char* line = m_buffer.constData() + start;
+	if (length > 0 && line[length - 1] == '\r')
+	{
+		--length;
+	}
+
+	if (m_format == Format::NdJson)
+	{
+		if (isBlank(line, length))
+		{
+			return;
+		}
+		Frame frame;
+		frame.data = QByteArray::fromRawData(line, length);
+		handler(frame);
+		return;
+	}
+
+	// SSE：空行结束事件，':' 开头为注释
+	if (length == 0)
+	{
+		dispatchEvent(handler);
+		return;
+	}
+	if (line[0] == ':')
+	{
+		return;
+	}
+
+	const void* colon = std::memchr(line, ':', size_t(length));
+	const int fieldLength = colon ? int(static_cast<const char*>(colon) - line) : length;
+	int valueOffset = colon ? fieldLength + 1 : length;
+	if (valueOffset < length && line[valueOffset] == ' ')
+	{
+		++valueOffset;
+	}
+	const int valueLength = length - valueOffset;
+
+	if (m_eventStart < 0)
+	{
+		m_eventStart = start;
+	}
+	if (equals(line, fieldLength, "data"))
+	{
+		if (m_dataLength < 0)
+		{
+			m_dataOffset = start + valueOffset;
+			m_dataLength = valueLength;
+		}
+		else
+		{
+			if (m_joinedData.isEmpty())
+			{
+				m_joinedData.append(m_buffer.constData() + m_dataOffset, m_dataLength);
+			}
+			m_joinedData.append('\n');
+			m_joinedData.append(line + valueOffset, valueLength);
+		}
+	}
+	else if (equals(line, fieldLength, "event"))
+	{
+		m_eventOffset = start + valueOffset;
+		m_eventLength = valueLength;
+	}
+	// id: / retry: 等字段不需要处理
+}
+
+void StreamFrameParser::dispatchEvent(const FrameHandler& handler)
+{
+	if (m_dataLength < 0)
+	{
+		clearEvent();
+		return;
+	}
+
+	const char* base = m_buffer.constData();
+	Frame frame;
+	if (m_eventLength >= 0)
+	{
+		frame.event = QByteArray::fromRawData(base + m_eventOffset, m_eventLength);
+	}
+	if (!m_joinedData.isEmpty())
+	{
+		frame.data = QByteArray::fromRawData(m_joinedData.constData(), m_joinedData.size());
+	}
+	else
+	{
+		frame.data = QByteArray::fromRawData(base + m_dataOffset, m_dataLength);
+	}
+	frame.done = isDoneMarker(frame.data.constData(), frame.data.size());
+	handler(frame);
+	clearEvent();
+}
+
+void StreamFrameParser::clearEvent()
+{
+	m_eventStart = -1;
+	m_eventOffset = 0;
+	m_eventLength = -1;
+	m_dataOffset = 0;
+	m_dataLength = -1;
+	m_joinedData.clear();
+}
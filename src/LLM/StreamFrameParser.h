@@ -0,0 +1,61 @@
+#pragma once
+#include <QByteArray>
+#include <functional>
+
+// 流式响应分帧器
+// 支持 NDJSON（每行一个JSON，Ollama）与 SSE（event:/data: 字段，空行结束一个事件，Dify / OpenAI 兼容接口）；
+// 网络数据只追加一次到内部缓冲区，用读游标标记已处理的位置，用 memchr 查找换行；
+// 已处理的字节不再移动或复制，只有未处理的尾部在缓冲区过半时前移一次
+class StreamFrameParser
+{
+public:
+	// 分帧格式
+	enum class Format
+	{
+		NdJson,
+		ServerSentEvents
+	};
+
+	// 一帧数据：字段都是指向内部缓冲区的视图（QByteArray::fromRawData），只在回调期间有效
+	struct Frame
+	{
+		QByteArray event;   // SSE 的 event 字段，NDJSON 为空
+		QByteArray data;    // NDJSON 的一行，或 SSE 事件的 data 字段（多行 data 以 '\n' 连接）
+		bool done = false;  // SSE 结束标记 [DONE]
+	};
+
+	using FrameHandler = std::function<void(const Frame& frame)>;
+
+	explicit StreamFrameParser(Format format = Format::NdJson);
+
+	// 开始新的响应流：清空缓冲区和未完成的事件
+	void reset(Format format);
+	Format format() const { return m_format; }
+
+	// 追加网络数据，对每个完整的帧调用 handler；不完整的尾部留到下次
+	// handler 中不能再次调用 feed / finish
+	void feed(const QByteArray& chunk, const FrameHandler& handler);
+	// 流结束：处理没有以换行结束的最后一行和未以空行结束的事件
+	void finish(const FrameHandler& handler);
+
+private:
+	// 丢弃已处理的前缀
+	void compact();
+	// 处理 [start, start + length) 这一行（不含换行符）
+	void processLine(int start, int length, const FrameHandler& handler);
+	// SSE：分发当前事件
+	void dispatchEvent(const FrameHandler& handler);
+	void clearEvent();
+
+	Format m_format;
+	QByteArray m_buffer;
+	int m_lineStart = 0;   // 当前行（尚未处理）的起点
+	int m_scanPos = 0;     // 下一次查找换行的起点
+	// SSE 事件状态，位置均为缓冲区偏移
+	int m_eventStart = -1; // 当前事件第一行的起点，-1 表示没有未完成的事件
+	int m_eventOffset = 0;
+	int m_eventLength = -1;
+	int m_dataOffset = 0;
+	int m_dataLength = -1;
+	QByteArray m_joinedData; // 多行 data 时的连接结果（极少出现）
+};
@@ -0,0 +1,73 @@
+#include "StreamRenderScheduler.h"
+#include <QEvent>
+#include <QTimer>
+#include <QWidget>
+
+StreamRenderScheduler::StreamRenderScheduler(QWidget* window, QObject* parent)
+	: QObject(parent)
+	, m_window(window)
+{
+	m_timer = new QTimer(this);
+	m_timer->setSingleShot(true);
+	m_timer->setTimerType(Qt::PreciseTimer);
+	connect(m_timer, &QTimer::timeout, this, &StreamRenderScheduler::onTimeout);
+	if (m_window)
+	{
+		// 最小化和还原时子控件也会收到隐藏/显示事件
+		m_window->installEventFilter(this);
+	}
+}
+
+void StreamRenderScheduler::setFrameInterval(int intervalMs)
+{
+	m_interval = qBound(1, intervalMs, int(kMaxIntervalMs));
+	m_currentInterval = m_interval;
+}
+
+void StreamRenderScheduler::requestFrame()
+{
+	m_pending = true;
+	if (isWindowVisible())
+	{
+		schedule();
+	}
+}
+
+bool StreamRenderScheduler::eventFilter(QObject* watched, QEvent* event)
+{
+	if (watched == m_window && event->type() == QEvent::Show && m_pending)
+	{
+		// 隐藏期间积累的数据在重新显示后一次刷新
+		m_timer->start(0);
+	}
+	return QObject::eventFilter(watched, event);
+}
+
+void StreamRenderScheduler::onTimeout()
+{
+	if (!m_pending || !isWindowVisible())
+	{
+		return;
+	}
+	m_pending = false;
+	QElapsedTimer cost;
+	cost.start();
+	emit frame();
+	m_sinceFrame.start();
+	m_currentInterval = qBound(m_interval, int(cost.elapsed() * 2), int(kMaxIntervalMs));
+}
+
+bool StreamRenderScheduler::isWindowVisible() const
+{
+	return m_window && m_window->isVisible() && !m_window->window()->isMinimized();
+}
+
+void StreamRenderScheduler::schedule()
+{
+	if (m_timer->isActive())
+	{
+		return;
+	}
+	const qint64 elapsed = m_sinceFrame.isValid() ? m_sinceFrame.elapsed() : m_currentInterval;
+	m_timer->start(int(qMax<qint64>(0, m_currentInterval - elapsed)));
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+
+class QTimer;
+class QWidget;
+
+// 流式输出的刷新节拍
+// 数据到达时只登记，按帧间隔最多刷新一次，所有进行中的回答在同一帧里一起排版；
+// 首个数据到达后最迟一个帧间隔内刷新，持续到达的数据不会推迟已安排的刷新；
+// 一帧的耗时超过半个间隔时按耗时放宽间隔（不超过 kMaxIntervalMs），
+// 窗口隐藏或最小化时不刷新，重新显示后立即补一帧
+class StreamRenderScheduler : public QObject
+{
+	Q_OBJECT
+public:
+	// window 为显示流式内容的窗口，用于判断是否可见
+	explicit StreamRenderScheduler(QWidget* window, QObject* parent = nullptr);
+
+	// 设置帧间隔（毫秒），默认 kDefaultIntervalMs
+	void setFrameInterval(int intervalMs);
+	int frameInterval() const { return m_interval; }
+
+	// 有新数据待刷新
+	void requestFrame();
+	// 是否有尚未刷新的数据
+	bool hasPendingFrame() const { return m_pending; }
+
+signals:
+	// 刷新所有待刷新的数据
+	void frame();
+
+protected:
+	bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+	void onTimeout();
+
+private:
+	bool isWindowVisible() const;
+	// 按距上一帧的时间安排下一帧，已安排时不重新计时
+	void schedule();
+
+	QPointer<QWidget> m_window;
+	QTimer* m_timer = nullptr;
+	QElapsedTimer m_sinceFrame;
+	int m_interval = kDefaultIntervalMs;
+	int m_currentInterval = kDefaultIntervalMs;  // 按上一帧耗时放宽后的间隔
+	bool m_pending = false;
+	static constexpr int kDefaultIntervalMs = 33;
+	static constexpr int kMaxIntervalMs = 100;    // 最长刷新延迟
+};
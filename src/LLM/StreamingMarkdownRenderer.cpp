@@ -0,0 +1,283 @@
+#include "StreamingMarkdownRenderer.h"
+#include <cmark.h>
+
+namespace
+{
+	// 跳过行首最多3个空格，返回第一个非空格位置；缩进超过3列时返回 -1
+	int skipBlockIndent(const QString& text, int start, int end, int* indent)
+	{
+		int pos = start;
+		int column = 0;
+		while (pos < end && text.at(pos) == QLatin1Char(' ') && column < 4)
+		{
+			++pos;
+			++column;
+		}
+		if (column > 3 || (pos < end && text.at(pos) == QLatin1Char('\t')))
+		{
+			return -1;
+		}
+		if (indent)
+		{
+			*indent = column;
+		}
+		return pos;
+	}
+
+	// 是否为空行（只包含空白字符）
+	bool isBlankLine(const QString& text, int start, int end)
+	{
+		for (int i = start; i < end; ++i)
+		{
+			if (!text.at(i).isSpace())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 解析代码围栏行（``` 或 ~~~，长度不少于3）
+	bool parseFence(const QString& text, int start, int end, QChar* fenceChar, int* fenceLength, int* indent, int* restStart)
+	{
+		int pos = skipBlockIndent(text, start, end, indent);
+		if (pos < 0 || pos >= end)
+		{
+			return false;
+		}
+		const QChar ch = text.at(pos);
+		if (ch != QLatin1Char('`') && ch != QLatin1Char('~'))
+		{
+			return false;
+		}
+		int count = 0;
+		while (pos < end && text.at(pos) == ch)
+		{
+			++pos;
+			++count;
+		}
+		if (count < 3)
+		{
+			return false;
+		}
+		// 反引号围栏的信息串中不允许再出现反引号
+		if (ch == QLatin1Char('`') && text.midRef(pos, end - pos).contains(QLatin1Char('`')))
+		{
+			return false;
+		}
+		*fenceChar = ch;
+		*fenceLength = count;
+		*restStart = pos;
+		return true;
+	}
+
+	// 是否为ATX标题行（#~######，后跟空白或行尾）
+	bool isAtxHeading(const QString& text, int start, int end)
+	{
+		int pos = start;
+		int count = 0;
+		while (pos < end && text.at(pos) == QLatin1Char('#') && count < 7)
+		{
+			++pos;
+			++count;
+		}
+		return count >= 1 && count <= 6 && (pos == end || text.at(pos).isSpace());
+	}
+
+	// 行首是否为列表标记（-、*、+ 或 1. / 1)），用于判断空行后的内容是否仍属于同一个列表
+	bool startsWithListMarker(const QString& text, int start, int end)
+	{
+		if (start >= end)
+		{
+			return false;
+		}
+		const QChar ch = text.at(start);
+		if (ch == QLatin1Char('-') || ch == QLatin1Char('*') || ch == QLatin1Char('+'))
+		{
+			return start + 1 == end || text.at(start + 1).isSpace();
+		}
+		int pos = start;
+		while (pos < end && pos - start < 9 && text.at(pos).isDigit())
+		{
+			++pos;
+		}
+		if (pos == start || pos >= end)
+		{
+			return false;
+		}
+		if (text.at(pos) != QLatin1Char('.') && text.at(pos) != QLatin1Char(')'))
+		{
+			return false;
+		}
+		return pos + 1 == end || text.at(pos + 1).isSpace();
+	}
+}
+
+StreamingMarkdownRenderer::StreamingMarkdownRenderer(HtmlDecorator decorator)
+	: m_decorator(std::move(decorator))
+{
+}
+
+void StreamingMarkdownRenderer::reset()
+{
+	m_markdown.clear();
+	m_closedHtml.clear();
+	m_tailHtml.clear();
+	m_closedEnd = 0;
+	m_renderedEnd = 0;
+	m_pendingClosed.clear();
+	m_scanPos = 0;
+	m_pendingBoundary = -1;
+	m_tailDirty = false;
+	m_inFence = false;
+	m_fenceIndented = false;
+	m_fenceChar = QChar();
+	m_fenceLength = 0;
+}
+
+void StreamingMarkdownRenderer::append(const QString& delta)
+{
+	append(QStringRef(&delta));
+}
+
+void StreamingMarkdownRenderer::append(const QStringRef& delta)
+{
+	if (delta.isEmpty())
+	{
+		return;
+	}
+	m_markdown.append(delta);
+	m_tailDirty = true;
+	scanCompleteLines();
+}
+
+QString StreamingMarkdownRenderer::html()
+{
+	for (int boundary : m_pendingClosed)
+	{
+		const QString chunk = m_markdown.mid(m_renderedEnd, boundary - m_renderedEnd);
+		if (!isBlankLine(chunk, 0, chunk.size()))
+		{
+			m_closedHtml.append(renderChunk(chunk, true));
+		}
+		m_renderedEnd = boundary;
+	}
+	m_pendingClosed.clear();
+	if (m_tailDirty)
+	{
+		const QString tail = m_markdown.mid(m_closedEnd);
+		m_tailHtml = isBlankLine(tail, 0, tail.size()) ? QString() : renderChunk(tail, false);
+		m_tailDirty = false;
+	}
+	return m_closedHtml + m_tailHtml;
+}
+
+QString StreamingMarkdownRenderer::renderMarkdown(const QString& markdown)
+{
+	const QByteArray markdownData = markdown.toUtf8();
+	cmark_parser* parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+	cmark_parser_feed(parser, markdownData.constData(), static_cast<size_t>(markdownData.size()));
+	cmark_node* document = cmark_parser_finish(parser);
+	char* html = cmark_render_html(document, CMARK_OPT_DEFAULT);
+	const QString result = QString::fromUtf8(html);
+	// 使用cmark自己的分配器释放，避免跨运行库释放内存
+	cmark_get_default_mem_allocator()->free(html);
+	cmark_node_free(document);
+	cmark_parser_free(parser);
+	return result;
+}
+
+void StreamingMarkdownRenderer::scanCompleteLines()
+{
+	// 只扫描新到达的完整行，未结束的最后一行留到下次
+	int newline = m_markdown.indexOf(QLatin1Char('\n'), m_scanPos);
+	while (newline >= 0)
+	{
+		processLine(m_scanPos, newline, newline + 1);
+		m_scanPos = newline + 1;
+		newline = m_markdown.indexOf(QLatin1Char('\n'), m_scanPos);
+	}
+}
+
+void StreamingMarkdownRenderer::processLine(int lineStart, int lineEnd, int nextLineStart)
+{
+	QChar fenceChar;
+	int fenceLength = 0;
+	int indent = 0;
+	int restStart = 0;
+
+	if (m_inFence)
+	{
+		// 结束围栏：同种字符、长度不小于起始围栏、后面只有空白
+		if (parseFence(m_markdown, lineStart, lineEnd, &fenceChar, &fenceLength, &indent, &restStart)
+			&& fenceChar == m_fenceChar && fenceLength >= m_fenceLength
+			&& isBlankLine(m_markdown, restStart, lineEnd))
+		{
+			m_inFence = false;
+			// 顶层代码块到此已完整，可以立即闭合
+			if (!m_fenceIndented)
+			{
+				closeBlocksUpTo(nextLineStart);
+			}
+		}
+		return;
+	}
+
+	if (isBlankLine(m_markdown, lineStart, lineEnd))
+	{
+		if (m_pendingBoundary < 0)
+		{
+			m_pendingBoundary = nextLineStart;
+		}
+		return;
+	}
+
+	const bool topLevel = !m_markdown.at(lineStart).isSpace();
+	if (m_pendingBoundary >= 0)
+	{
+		// 空行后从第0列开始且不是列表项，说明之前的块（段落/列表/引用）已经结束
+		if (topLevel && !startsWithListMarker(m_markdown, lineStart, lineEnd))
+		{
+			closeBlocksUpTo(lineStart);
+		}
+		m_pendingBoundary = -1;
+	}
+
+	if (parseFence(m_markdown, lineStart, lineEnd, &fenceChar, &fenceLength, &indent, &restStart))
+	{
+		m_inFence = true;
+		m_fenceChar = fenceChar;
+		m_fenceLength = fenceLength;
+		m_fenceIndented = indent > 0;
+		// 第0列的围栏会打断前面的段落，也不可能属于前面的列表
+		if (topLevel)
+		{
+			closeBlocksUpTo(lineStart);
+		}
+		return;
+	}
+
+	if (topLevel && isAtxHeading(m_markdown, lineStart, lineEnd))
+	{
+		// ATX标题只占一行，前后都是块边界
+		closeBlocksUpTo(lineStart);
+		closeBlocksUpTo(nextLineStart);
+	}
+}
+
+void StreamingMarkdownRenderer::closeBlocksUpTo(int boundary)
+{
+	if (boundary <= m_closedEnd)
+	{
+		return;
+	}
+	m_pendingClosed.append(boundary);
+	m_closedEnd = boundary;
+	m_tailDirty = true;
+}
+
+QString StreamingMarkdownRenderer::renderChunk(const QString& chunk, bool stable) const
+{
+	const QString html = renderMarkdown(chunk);
+	return m_decorator ? m_decorator(html, stable) : html;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <functional>
+
+// 流式Markdown增量渲染器
+// 已闭合的块只渲染一次并缓存HTML，每次增量只重新渲染尾部未闭合的块（例如未结束的代码围栏），
+// 因此每次刷新的开销只与新增文本和尾部块有关，而与整段回答的长度无关。
+// 闭合位置也可以单独使用（stableLength），HTML只在调用 html() 时才渲染
+class StreamingMarkdownRenderer
+{
+public:
+	// 渲染后HTML的修饰函数（例如代码块高亮）
+	// stable 为 true 表示闭合块（只调用一次），false 表示每次刷新都会重新渲染的尾部块
+	using HtmlDecorator = std::function<QString(const QString& html, bool stable)>;
+
+	explicit StreamingMarkdownRenderer(HtmlDecorator decorator = HtmlDecorator());
+
+	// 设置HTML修饰函数
+	void setDecorator(HtmlDecorator decorator) { m_decorator = std::move(decorator); }
+	// 清空所有状态，开始新的流
+	void reset();
+	// 追加增量文本
+	void append(const QString& delta);
+	void append(const QStringRef& delta);
+	// 获取目前为止的完整HTML（闭合块缓存 + 尾部块）
+	QString html();
+	// 获取累计的Markdown原文
+	const QString& markdown() const { return m_markdown; }
+	// 是否没有任何内容
+	bool isEmpty() const { return m_markdown.isEmpty(); }
+	// 已闭合块在原文中的结束位置，此前的内容不会再因后续增量而改变
+	int stableLength() const { return m_closedEnd; }
+
+	// 使用 cmark_parser_feed 渲染一段Markdown为HTML
+	static QString renderMarkdown(const QString& markdown);
+
+private:
+	// 扫描新到达的完整行，推进块闭合位置
+	void scanCompleteLines();
+	// 处理一行（不含换行符）
+	void processLine(int lineStart, int lineEnd, int nextLineStart);
+	// 将 [m_closedEnd, boundary) 标记为闭合块（在 html() 中渲染）
+	void closeBlocksUpTo(int boundary);
+	// 渲染并修饰一段Markdown
+	QString renderChunk(const QString& chunk, bool stable) const;
+
+	HtmlDecorator m_decorator;
+	QString m_markdown;           // 累计的Markdown原文
+	QString m_closedHtml;         // 已闭合块的HTML缓存
+	QString m_tailHtml;           // 尾部未闭合块的HTML
+	int m_closedEnd = 0;          // 已闭合块在原文中的结束位置
+	int m_renderedEnd = 0;        // 已渲染为HTML的闭合块结束位置
+	QVector<int> m_pendingClosed; // 尚未渲染的闭合块边界
+	int m_scanPos = 0;            // 下一个待扫描行的起始位置
+	int m_pendingBoundary = -1;   // 空行之后的候选闭合位置
+	bool m_tailDirty = false;     // 尾部HTML是否需要重新渲染
+	// 代码围栏状态
+	bool m_inFence = false;
+	bool m_fenceIndented = false;
+	QChar m_fenceChar;
+	int m_fenceLength = 0;
+};
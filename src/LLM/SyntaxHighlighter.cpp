@@ -1,7 +1,7 @@
 ﻿#include "SyntaxHighlighter.h"
 
 // 静态成员初始化
-int SyntaxHighlighter::s_codeBlockCounter = 0;
+QAtomicInt SyntaxHighlighter::s_codeBlockCounter(0);
 
 SyntaxHighlighter::SyntaxHighlighter()
 	: m_theme(darkTheme())
@@ -13,21 +13,68 @@ QString SyntaxHighlighter::highlightCode(const QString& code, const QString& lan
 {
 	if (code.isEmpty()) return QString();
 
-	Language lang = stringToLanguage(language.toLower());
+	const QVector<CodeLexer::Token> tokens = tokenizeCode(code, language);
+	QString result;
+	result.reserve(code.size() * 2);
+	int pos = 0;
+	for (const CodeLexer::Token& token : tokens)
+	{
+		if (token.start > pos)
+		{
+			result += escapeHtml(code.mid(pos, token.start - pos));
+		}
+		result += wrapWithSpan(escapeHtml(code.mid(token.start, token.length)),
+			tokenColor(token.kind), isBoldToken(token.kind), isItalicToken(token.kind));
+		pos = token.start + token.length;
+	}
+	if (pos < code.size())
+	{
+		result += escapeHtml(code.mid(pos));
+	}
+	return result;
+}
+
+QVector<CodeLexer::Token> SyntaxHighlighter::tokenizeCode(const QString& code, const QString& language)
+{
+	const CodeLexer::Grammar grammar = grammarFor(stringToLanguage(language));
+	const int completeEnd = code.lastIndexOf(QLatin1Char('\n')) + 1;
 
-	switch (lang) 
+	// 代码以上次分析过的完整行开头时，沿用其词法单元与行尾状态
+	if (m_lexerCache.language != language || m_lexerCache.prefix.size() > completeEnd
+		|| !code.startsWith(m_lexerCache.prefix))
 	{
-	case Json:
-		return highlightJson(code);
-	case Cpp:
-		return highlightCpp(code);
-	case Python:
-		return highlightPython(code);
-	case JavaScript:
-		return highlightJavaScript(code);
-	default:
-		return highlightGeneric(code);
+		m_lexerCache.language = language;
+		m_lexerCache.prefix.clear();
+		m_lexerCache.state = CodeLexer::State();
+		m_lexerCache.tokens.clear();
+	}
+	const int resumeFrom = m_lexerCache.prefix.size();
+	if (completeEnd > resumeFrom)
+	{
+		CodeLexer::tokenize(grammar, code, resumeFrom, completeEnd, m_lexerCache.state, m_lexerCache.tokens);
+		m_lexerCache.prefix = code.left(completeEnd);
 	}
+
+	// 最后一行可能还不完整，不写入缓存
+	QVector<CodeLexer::Token> tokens = m_lexerCache.tokens;
+	CodeLexer::State tailState = m_lexerCache.state;
+	CodeLexer::tokenize(grammar, code, completeEnd, code.size(), tailState, tokens);
+	return tokens;
+}
+
+QTextCharFormat SyntaxHighlighter::tokenFormat(CodeLexer::TokenKind kind) const
+{
+	QTextCharFormat format;
+	format.setForeground(QColor(tokenColor(kind)));
+	if (isBoldToken(kind))
+	{
+		format.setFontWeight(QFont::Bold);
+	}
+	if (isItalicToken(kind))
+	{
+		format.setFontItalic(true);
+	}
+	return format;
 }
 
 QString SyntaxHighlighter::highlightCodeBlock(const QString& code, const QString& language)
@@ -56,6 +103,55 @@ QString SyntaxHighlighter::highlightInlineCode(const QString& code)
 	).arg(m_theme.background, m_theme.string, escapeHtml(code));
 }
 
+QString SyntaxHighlighter::highlightRenderedHtml(const QString& html, QHash<QString, QString>* codeBlocks)
+{
+	static const QRegularExpression codeBlockRegex(
+		"<pre><code(?:\\s+class=\"language-([^\"]*)\")?(.*?)>(.*?)</code></pre>",
+		QRegularExpression::DotMatchesEverythingOption);
+	static const QRegularExpression idRegex("codeblock://copy\\?id=([^\"]+)");
+	static const QRegularExpression inlineCodeRegex("<code>(.*?)</code>");
+
+	QString result = html;
+	// 从后往前替换，避免位置偏移
+	QList<QRegularExpressionMatch> matches;
+	QRegularExpressionMatchIterator iterator = codeBlockRegex.globalMatch(html);
+	while (iterator.hasNext())
+	{
+		matches.prepend(iterator.next());
+	}
+	for (const auto& match : matches)
+	{
+		QString language = match.captured(1).toLower(); // 语言标识
+		QString code = match.captured(3);               // 代码内容
+		// HTML解码
+		code = code.replace("&lt;", "<").replace("&gt;", ">").replace("&amp;", "&");
+		QString highlightedHtml = highlightCodeBlock(code, language);
+		// 从高亮后的HTML中提取代码块ID并保存代码内容
+		if (codeBlocks)
+		{
+			QRegularExpressionMatch idMatch = idRegex.match(highlightedHtml);
+			if (idMatch.hasMatch())
+			{
+				codeBlocks->insert(idMatch.captured(1), code);
+			}
+		}
+		result.replace(match.capturedStart(0), match.capturedLength(0), highlightedHtml);
+	}
+
+	// 处理行内代码
+	QList<QRegularExpressionMatch> inlineMatches;
+	QRegularExpressionMatchIterator inlineIterator = inlineCodeRegex.globalMatch(result);
+	while (inlineIterator.hasNext())
+	{
+		inlineMatches.prepend(inlineIterator.next());
+	}
+	for (const auto& match : inlineMatches)
+	{
+		result.replace(match.capturedStart(0), match.capturedLength(0), highlightInlineCode(match.captured(1)));
+	}
+	return result;
+}
+
 QString SyntaxHighlighter::createToolbar(const QString& language, const QString& code)
 {
 	QString uniqueId = generateUniqueId();
@@ -87,7 +183,7 @@ QString SyntaxHighlighter::createToolbar(const QString& language, const QString&
 
 QString SyntaxHighlighter::generateUniqueId()
 {
-	return QString("code_%1_%2").arg(++s_codeBlockCounter).arg(QDateTime::currentMSecsSinceEpoch());
+	return QString("code_%1_%2").arg(s_codeBlockCounter.fetchAndAddOrdered(1) + 1).arg(QDateTime::currentMSecsSinceEpoch());
 }
 
 QString SyntaxHighlighter::extractPlainCode(const QString& htmlCode)
@@ -108,157 +204,6 @@ QString SyntaxHighlighter::extractPlainCode(const QString& htmlCode)
 	return plainCode;
 }
 
-QString SyntaxHighlighter::highlightJson(const QString& code)
-{
-	QString result = escapeHtml(code);
-
-	// JSON 字符串 (键和值)
-	QRegularExpression stringRegex("\"([^\"\\\\]|\\\\.)*\"");
-	result = applyPatternHighlight(result, stringRegex, m_theme.string);
-
-	// JSON 数字
-	QRegularExpression numberRegex("\\b-?\\d+(?:\\.\\d+)?(?:[eE][+-]?\\d+)?\\b");
-	result = applyPatternHighlight(result, numberRegex, m_theme.number);
-
-	// JSON 关键字
-	QRegularExpression keywordRegex("\\b(true|false|null)\\b");
-	result = applyPatternHighlight(result, keywordRegex, m_theme.keyword, true);
-
-	// JSON 标点符号
-	QRegularExpression punctRegex("([{}\\[\\]:,])");
-	result = applyPatternHighlight(result, punctRegex, m_theme.punctuation, true);
-
-	return result;
-}
-
-QString SyntaxHighlighter::highlightCpp(const QString& code)
-{
-	QString result = escapeHtml(code);
-
-	// 单行和多行注释
-	QRegularExpression singleCommentRegex("//.*$");
-	QRegularExpression multiCommentRegex("/\\*.*?\\*/");
-	result = applyPatternHighlight(result, singleCommentRegex, m_theme.comment, false, true);
-	result = applyPatternHighlight(result, multiCommentRegex, m_theme.comment, false, true);
-
-	// 字符串和字符
-	QRegularExpression stringRegex("\"([^\"\\\\]|\\\\.)*\"|'([^'\\\\]|\\\\.)*'");
-	result = applyPatternHighlight(result, stringRegex, m_theme.string);
-
-	// 预处理指令
-	QRegularExpression preprocessorRegex("^\\s*#.*$");
-	result = applyPatternHighlight(result, preprocessorRegex, m_theme.preprocessor);
-
-	// C++ 关键字
-	QStringList keywords = getCppKeywords();
-	for (const QString& keyword : keywords)
-	{
-		QRegularExpression keywordRegex(QString("\\b%1\\b").arg(QRegularExpression::escape(keyword)));
-		result = applyPatternHighlight(result, keywordRegex, m_theme.keyword, true);
-	}
-
-	// 数字
-	QRegularExpression numberRegex("\\b\\d+(?:\\.\\d+)?[fFlL]?\\b");
-	result = applyPatternHighlight(result, numberRegex, m_theme.number);
-
-	// 函数调用
-	QRegularExpression functionRegex("\\b([a-zA-Z_][a-zA-Z0-9_]*)\\s*(?=\\()");
-	result = applyPatternHighlight(result, functionRegex, m_theme.function);
-
-	return result;
-}
-
-QString SyntaxHighlighter::highlightPython(const QString& code)
-{
-	QString result = escapeHtml(code);
-
-	// Python 注释
-	QRegularExpression commentRegex("#.*$");
-	result = applyPatternHighlight(result, commentRegex, m_theme.comment, false, true);
-
-	// Python 字符串 (包括三引号字符串)
-	QRegularExpression tripleStringRegex("\"\"\".*?\"\"\"|'''.*?'''");
-	QRegularExpression stringRegex("\"([^\"\\\\]|\\\\.)*\"|'([^'\\\\]|\\\\.)*'");
-	result = applyPatternHighlight(result, tripleStringRegex, m_theme.string);
-	result = applyPatternHighlight(result, stringRegex, m_theme.string);
-
-	// Python 关键字
-	QStringList keywords = getPythonKeywords();
-	for (const QString& keyword : keywords) 
-	{
-		QRegularExpression keywordRegex(QString("\\b%1\\b").arg(QRegularExpression::escape(keyword)));
-		result = applyPatternHighlight(result, keywordRegex, m_theme.keyword, true);
-	}
-
-	// 函数定义
-	QRegularExpression funcDefRegex("\\bdef\\s+([a-zA-Z_][a-zA-Z0-9_]*)");
-	result = applyPatternHighlight(result, funcDefRegex, m_theme.function, true);
-
-	// 类定义
-	QRegularExpression classDefRegex("\\bclass\\s+([a-zA-Z_][a-zA-Z0-9_]*)");
-	result = applyPatternHighlight(result, classDefRegex, m_theme.type, true);
-
-	// 数字
-	QRegularExpression numberRegex("\\b\\d+(?:\\.\\d+)?(?:[eE][+-]?\\d+)?\\b");
-	result = applyPatternHighlight(result, numberRegex, m_theme.number);
-
-	return result;
-}
-
-QString SyntaxHighlighter::highlightJavaScript(const QString& code)
-{
-	QString result = escapeHtml(code);
-
-	// JavaScript 注释
-	QRegularExpression singleCommentRegex("//.*$");
-	QRegularExpression multiCommentRegex("/\\*.*?\\*/");
-	result = applyPatternHighlight(result, singleCommentRegex, m_theme.comment, false, true);
-	result = applyPatternHighlight(result, multiCommentRegex, m_theme.comment, false, true);
-
-	// JavaScript 字符串 (包括模板字符串)
-	QRegularExpression templateStringRegex("`([^`\\\\]|\\\\.)*`");
-	QRegularExpression stringRegex("\"([^\"\\\\]|\\\\.)*\"|'([^'\\\\]|\\\\.)*'");
-	result = applyPatternHighlight(result, templateStringRegex, m_theme.string);
-	result = applyPatternHighlight(result, stringRegex, m_theme.string);
-
-	// JavaScript 关键字
-	QStringList keywords = getJavaScriptKeywords();
-	for (const QString& keyword : keywords)
-	{
-		QRegularExpression keywordRegex(QString("\\b%1\\b").arg(QRegularExpression::escape(keyword)));
-		result = applyPatternHighlight(result, keywordRegex, m_theme.keyword, true);
-	}
-
-	// 函数定义
-	QRegularExpression funcRegex("\\bfunction\\s+([a-zA-Z_$][a-zA-Z0-9_$]*)");
-	result = applyPatternHighlight(result, funcRegex, m_theme.function, true);
-
-	// 数字
-	QRegularExpression numberRegex("\\b\\d+(?:\\.\\d+)?(?:[eE][+-]?\\d+)?\\b");
-	result = applyPatternHighlight(result, numberRegex, m_theme.number);
-
-	return result;
-}
-
-QString SyntaxHighlighter::highlightGeneric(const QString& code)
-{
-	QString result = escapeHtml(code);
-
-	// 通用字符串高亮
-	QRegularExpression stringRegex("\"([^\"\\\\]|\\\\.)*\"|'([^'\\\\]|\\\\.)*'");
-	result = applyPatternHighlight(result, stringRegex, m_theme.string);
-
-	// 通用数字高亮
-	QRegularExpression numberRegex("\\b\\d+(?:\\.\\d+)?\\b");
-	result = applyPatternHighlight(result, numberRegex, m_theme.number);
-
-	// 通用注释高亮
-	QRegularExpression commentRegex("//.*$|#.*$|/\\*.*?\\*/|<!--.*?-->");
-	result = applyPatternHighlight(result, commentRegex, m_theme.comment, false, true);
-
-	return result;
-}
-
 // 辅助函数实现
 QString SyntaxHighlighter::escapeHtml(const QString& text)
 {
@@ -279,25 +224,40 @@ QString SyntaxHighlighter::wrapWithSpan(const QString& text, const QString& colo
 	return QString("<span style=\"%1\">%2</span>").arg(style, text);
 }
 
-QString SyntaxHighlighter::applyPatternHighlight(const QString& code, const QRegularExpression& pattern,
-	const QString& color, bool bold, bool italic)
+QString SyntaxHighlighter::tokenColor(CodeLexer::TokenKind kind) const
 {
-	QString result = code;
-	QRegularExpressionMatchIterator iterator = pattern.globalMatch(result);
-
-	// 从后往前替换，避免位置偏移
-	QList<QRegularExpressionMatch> matches;
-	while (iterator.hasNext()) {
-		matches.prepend(iterator.next());
-	}
-
-	for (const auto& match : matches) 
+	switch (kind)
 	{
-		QString highlighted = wrapWithSpan(match.captured(0), color, bold, italic);
-		result.replace(match.capturedStart(), match.capturedLength(), highlighted);
+	case CodeLexer::TokenKind::Keyword:
+		return m_theme.keyword;
+	case CodeLexer::TokenKind::String:
+		return m_theme.string;
+	case CodeLexer::TokenKind::Comment:
+		return m_theme.comment;
+	case CodeLexer::TokenKind::Number:
+		return m_theme.number;
+	case CodeLexer::TokenKind::Function:
+	case CodeLexer::TokenKind::Definition:
+		return m_theme.function;
+	case CodeLexer::TokenKind::Type:
+		return m_theme.type;
+	case CodeLexer::TokenKind::Preprocessor:
+		return m_theme.preprocessor;
+	case CodeLexer::TokenKind::Punctuation:
+		return m_theme.punctuation;
 	}
+	return m_theme.text;
+}
 
-	return result;
+bool SyntaxHighlighter::isBoldToken(CodeLexer::TokenKind kind)
+{
+	return kind == CodeLexer::TokenKind::Keyword || kind == CodeLexer::TokenKind::Definition
+		|| kind == CodeLexer::TokenKind::Type || kind == CodeLexer::TokenKind::Punctuation;
+}
+
+bool SyntaxHighlighter::isItalicToken(CodeLexer::TokenKind kind)
+{
+	return kind == CodeLexer::TokenKind::Comment;
 }
 
 // 主题相关函数
@@ -311,6 +271,13 @@ SyntaxHighlighter::Theme SyntaxHighlighter::getTheme() const
 	return m_theme;
 }
 
+uint SyntaxHighlighter::themeHash(const Theme& theme)
+{
+	return qHash(theme.keyword + theme.string + theme.comment + theme.number + theme.function
+		+ theme.type + theme.background + theme.text + theme.preprocessor + theme.punctuation
+		+ theme.toolbar + theme.toolbarText + theme.button);
+}
+
 SyntaxHighlighter::Theme SyntaxHighlighter::darkTheme()
 {
 	Theme theme;
@@ -374,48 +341,19 @@ SyntaxHighlighter::Language SyntaxHighlighter::stringToLanguage(const QString& l
 	return m_languageMap.value(langStr.toLower(), Generic);
 }
 
-// 关键字列表
-QStringList SyntaxHighlighter::getCppKeywords()
+CodeLexer::Grammar SyntaxHighlighter::grammarFor(Language language)
 {
-	return{
-		"alignas", "alignof", "and", "and_eq", "asm", "atomic_cancel", "atomic_commit",
-		"atomic_noexcept", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
-		"char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const",
-		"consteval", "constexpr", "constinit", "const_cast", "continue", "co_await",
-		"co_return", "co_yield", "decltype", "default", "delete", "do", "double",
-		"dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
-		"float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
-		"namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
-		"or_eq", "private", "protected", "public", "reflexpr", "register",
-		"reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
-		"static_assert", "static_cast", "struct", "switch", "synchronized", "template",
-		"this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
-		"union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
-		"xor", "xor_eq", "include", "define", "ifdef", "ifndef", "endif", "pragma"
-	};
-}
-
-QStringList SyntaxHighlighter::getPythonKeywords()
-{
-	return{
-		"False", "None", "True", "and", "as", "assert", "async", "await", "break",
-		"class", "continue", "def", "del", "elif", "else", "except", "finally",
-		"for", "from", "global", "if", "import", "in", "is", "lambda", "nonlocal",
-		"not", "or", "pass", "raise", "return", "try", "while", "with", "yield"
-	};
+	switch (language)
+	{
+	case Json:
+		return CodeLexer::Grammar::Json;
+	case Cpp:
+		return CodeLexer::Grammar::Cpp;
+	case Python:
+		return CodeLexer::Grammar::Python;
+	case JavaScript:
+		return CodeLexer::Grammar::JavaScript;
+	default:
+		return CodeLexer::Grammar::Generic;
+	}
 }
-
-QStringList SyntaxHighlighter::getJavaScriptKeywords()
-{
-	return{
-		"abstract", "arguments", "await", "boolean", "break", "byte", "case", "catch",
-		"char", "class", "const", "continue", "debugger", "default", "delete", "do",
-		"double", "else", "enum", "eval", "export", "extends", "false", "final",
-		"finally", "float", "for", "function", "goto", "if", "implements", "import",
-		"in", "instanceof", "int", "interface", "let", "long", "native", "new",
-		"null", "package", "private", "protected", "public", "return", "short",
-		"static", "super", "switch", "synchronized", "this", "throw", "throws",
-		"transient", "true", "try", "typeof", "var", "void", "volatile", "while",
-		"with", "yield", "async", "of"
-	};
-}
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 #include <QRegularExpression>
+#include <QTextCharFormat>
 #include <QStringList>
+#include <QAtomicInt>
 #include <QDateTime>
 #include <QString>
+#include <QHash>
 #include <QMap>
+#include "CodeLexer.h"
 
 class SyntaxHighlighter
 {
@@ -48,12 +52,20 @@ public:
 
     // 主要接口
     QString highlightCode(const QString& code, const QString& language);
+    // 对代码做词法分析；同一代码块在流式输出中不断增长时，从上次最后一个完整行的词法状态继续，只分析新增的行
+    QVector<CodeLexer::Token> tokenizeCode(const QString& code, const QString& language);
+    // 词法单元对应的字符格式（与HTML高亮使用相同的主题颜色、粗体与斜体）
+    QTextCharFormat tokenFormat(CodeLexer::TokenKind kind) const;
     QString highlightCodeBlock(const QString& code, const QString& language);
     QString highlightInlineCode(const QString& code);
+    // 对 cmark 输出的HTML进行代码块/行内代码高亮，codeBlocks 不为空时记录 代码块ID -> 代码原文
+    QString highlightRenderedHtml(const QString& html, QHash<QString, QString>* codeBlocks = nullptr);
 
     // 主题管理
     void setTheme(const Theme& theme);
     Theme getTheme() const;
+    // 主题的哈希值（渲染缓存的键使用）
+    static uint themeHash(const Theme& theme);
 
     // 预设主题
     static Theme darkTheme();
@@ -65,31 +77,36 @@ public:
     // 获取纯代码内容（去除HTML标签）
     QString extractPlainCode(const QString& htmlCode);
 
-private:
-    // 语言特定的高亮函数
-    QString highlightJson(const QString& code);
-    QString highlightCpp(const QString& code);
-    QString highlightPython(const QString& code);
-    QString highlightJavaScript(const QString& code);
-    QString highlightGeneric(const QString& code);
+    // 生成代码块唯一ID（用于 codeblock://copy?id= 锚点）
+    static QString generateUniqueId();
 
+private:
     // 辅助函数
     QString escapeHtml(const QString& text);
     QString wrapWithSpan(const QString& text, const QString& color, bool bold = false, bool italic = false);
-    QString applyPatternHighlight(const QString& code, const QRegularExpression& pattern, const QString& color, bool bold = false, bool italic = false);
+    // 词法单元的颜色与字形
+    QString tokenColor(CodeLexer::TokenKind kind) const;
+    static bool isBoldToken(CodeLexer::TokenKind kind);
+    static bool isItalicToken(CodeLexer::TokenKind kind);
+    // 语言对应的词法规则
+    static CodeLexer::Grammar grammarFor(Language language);
 
     // 创建工具栏HTML
     QString createToolbar(const QString& language, const QString& code);
-    QString generateUniqueId();
-
-    // 获取语言关键字
-    QStringList getCppKeywords();
-    QStringList getPythonKeywords();
-    QStringList getJavaScriptKeywords();
 
 private:
     Theme m_theme;
     QMap<QString, Language> m_languageMap;
-    static int s_codeBlockCounter; // 用于生成唯一ID
+    static QAtomicInt s_codeBlockCounter; // 用于生成唯一ID（后台渲染线程也会调用）
+
+    // 最近一次词法分析的结果（只缓存到最后一个完整行为止）
+    struct LexerCache
+    {
+        QString language;
+        QString prefix;                    // 已分析的代码前缀（以换行结尾）
+        CodeLexer::State state;            // prefix 末尾的词法状态
+        QVector<CodeLexer::Token> tokens;  // prefix 内的词法单元
+    };
+    LexerCache m_lexerCache;
     void initLanguageMap();
 };
@@ -0,0 +1,135 @@
+#include "ThinkTagSplitter.h"
+
+namespace
+{
+	struct Marker
+	{
+		const char* text;
+		int length;
+		bool opensReasoning;
+	};
+	const Marker kMarkers[] = {
+		{ "<think>", 7, true },
+		{ "</think>", 8, false },
+		{ "---REASONING_START---", 21, true },
+		{ "---REASONING_END---", 19, false }
+	};
+
+	enum class Match
+	{
+		None,
+		Partial,  // 文本在标记完成前结束，且已有部分与标记一致
+		Full
+	};
+
+	// 比对 data 开头是否为某个标记
+	Match matchMarker(const QChar* data, int available, const Marker*& matched)
+	{
+		Match result = Match::None;
+		for (const Marker& marker : kMarkers)
+		{
+			const int count = qMin(available, marker.length);
+			int i = 0;
+			while (i < count && data[i] == QLatin1Char(marker.text[i]))
+			{
+				++i;
+			}
+			if (i == marker.length)
+			{
+				matched = &marker;
+				return Match::Full;
+			}
+			if (i == available)
+			{
+				result = Match::Partial;
+			}
+		}
+		return result;
+	}
+}
+
+void ThinkTagSplitter::reset()
+{
+	m_reasoning = false;
+	m_carry.clear();
+}
+
+void ThinkTagSplitter::feed(const QString& chunk, const SegmentHandler& handler)
+{
+	if (chunk.isEmpty())
+	{
+		return;
+	}
+	if (m_carry.isEmpty())
+	{
+		scan(chunk, handler);
+		return;
+	}
+	// 只有上一分片以不完整的标记结束时才拼接
+	QString text;
+	text.swap(m_carry);
+	text.append(chunk);
+	scan(text, handler);
+}
+
+void ThinkTagSplitter::finish(const SegmentHandler& handler)
+{
+	if (m_carry.isEmpty())
+	{
+		return;
+	}
+	const QString text = m_carry;
+	m_carry.clear();
+	handler(m_reasoning, QStringRef(&text));
+}
+
+void ThinkTagSplitter::scan(const QString& text, const SegmentHandler& handler)
+{
+	const QChar* data = text.constData();
+	const int size = text.size();
+	auto emitSegment = [&](int start, int end)
+	{
+		if (end > start)
+		{
+			handler(m_reasoning, QStringRef(&text, start, end - start));
+		}
+	};
+
+	int segmentStart = 0;
+	for (int i = 0; i < size; ++i)
+	{
+		if (data[i] != QLatin1Char('<') && data[i] != QLatin1Char('-'))
+		{
+			continue;
+		}
+		const Marker* marker = nullptr;
+		const Match match = matchMarker(data + i, size - i, marker);
+		if (match == Match::None)
+		{
+			continue;
+		}
+		emitSegment(segmentStart, i);
+		if (match == Match::Partial)
+		{
+			m_carry = text.mid(i);
+			return;
+		}
+		m_reasoning = marker->opensReasoning;
+		i += marker->length - 1;
+		segmentStart = i + 1;
+	}
+	emitSegment(segmentStart, size);
+}
+
+void ThinkTagSplitter::split(const QString& text, QString& answer, QString& reasoning)
+{
+	answer.clear();
+	reasoning.clear();
+	const SegmentHandler handler = [&answer, &reasoning](bool isReasoning, const QStringRef& segment)
+	{
+		(isReasoning ? reasoning : answer).append(segment);
+	};
+	ThinkTagSplitter splitter;
+	splitter.feed(text, handler);
+	splitter.finish(handler);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <QString>
+#include <QStringRef>
+#include <functional>
+
+// 流式文本的推理/回答分流器
+// <think>…</think> 与 ---REASONING_START---…---REASONING_END--- 之间为推理内容，其余为回答；
+// 单遍扫描，只在 '<' 和 '-' 处比对标记，标记之间的文本以视图交给回调，不生成中间副本；
+// 分片末尾可能是标记开头的部分（如 "</thi"）暂存到下一个分片，拼上后再判断
+class ThinkTagSplitter
+{
+public:
+	// 片段回调：text 是输入文本（或暂存拼接结果）的视图，只在回调期间有效
+	using SegmentHandler = std::function<void(bool reasoning, const QStringRef& text)>;
+
+	// 开始新的流：回到回答状态并丢弃暂存
+	void reset();
+	// 当前是否处于推理内容中
+	bool isReasoning() const { return m_reasoning; }
+
+	// 追加一个分片，完整的片段按所属区域交给 handler
+	void feed(const QString& chunk, const SegmentHandler& handler);
+	// 流结束：暂存的不完整标记按普通文本输出
+	void finish(const SegmentHandler& handler);
+
+	// 一次拆分完整文本
+	static void split(const QString& text, QString& answer, QString& reasoning);
+
+private:
+	void scan(const QString& text, const SegmentHandler& handler);
+
+	bool m_reasoning = false;
+	QString m_carry;  // 上一分片末尾不完整的标记，最长为标记长度减一
+};
@@ -1,9 +1,17 @@
 #include <QApplication>
+#include "ChatArchive.h"
 #include "Frm_AIAssit.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
     QApplication::setWindowIcon(QIcon(":/QtWidgetsApp/ICONs/Chat.png"));
+    // AIAssit --history-benchmark <LLMChat_yyyy-MM-dd.json>：对比 JSON 与归档格式的读取性能
+    const QStringList args = app.arguments();
+    const int benchmarkArg = args.indexOf(QStringLiteral("--history-benchmark"));
+    if (benchmarkArg >= 0 && benchmarkArg + 1 < args.size()) {
+        ChatArchive::benchmark(args.at(benchmarkArg + 1));
+        return 0;
+    }
     Frm_AIAssit w;
     w.show();
     return app.exec();
@@ -0,0 +1,17 @@
+QT += core gui widgets testlib
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = tst_chatcontextbuilder
+
+LLM_DIR = $$PWD/../../LLM
+# ChatContextBuilder.cpp 只用到 LLMChatFrame.h 中的消息类型，头文件需要 cmark
+INCLUDEPATH += $$LLM_DIR $$PWD/../../../include/cmark
+
+SOURCES += \
+    tst_chatcontextbuilder.cpp \
+    $$LLM_DIR/ChatContextBuilder.cpp
+
+HEADERS += \
+    $$LLM_DIR/ChatContextBuilder.h \
+    $$LLM_DIR/ChatSessionTypes.h
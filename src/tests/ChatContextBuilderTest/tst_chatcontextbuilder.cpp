@@ -0,0 +1,83 @@
+#include <QtTest>
+
+#include "ChatContextBuilder.h"
+#include "LLMChatFrame.h"
+
+namespace
+{
+	// 长度相同、token数不同的两段文本：ASCII 约四个字符一个token，CJK 约一个字符一个token
+	const QString kAscii = QStringLiteral("abcdabcdabcdabcd");
+	const QString kCjk = QString(kAscii.size(), QChar(0x4E2D));
+
+	ChatMessageData makeMessage(int userType, const QString& text, const QString& reasoning = QString())
+	{
+		return ChatMessageData(text, QStringLiteral("12:00"), userType, QStringLiteral("test"), reasoning,
+			QUuid::createUuid().toString());
+	}
+}
+
+class ChatContextBuilderTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void sampleTextsDiffer();
+	void messageTokensFollowSameLengthEdit();
+	void reasoningTokensFollowSameLengthEdit();
+	void buildUsesEditedContent();
+};
+
+void ChatContextBuilderTest::sampleTextsDiffer()
+{
+	QCOMPARE(kCjk.size(), kAscii.size());
+	QVERIFY(ChatContextBuilder::estimateTokens(kCjk) > ChatContextBuilder::estimateTokens(kAscii));
+}
+
+void ChatContextBuilderTest::messageTokensFollowSameLengthEdit()
+{
+	ChatMessageData message = makeMessage(LLMChatFrame::User_Customer, kAscii);
+	QCOMPARE(ChatContextBuilder::messageTokens(message), ChatContextBuilder::estimateTokens(kAscii));
+
+	// 重新生成的回答长度不变，缓存不能沿用旧的计数
+	message.m_ChatMsg = kCjk;
+	QCOMPARE(ChatContextBuilder::messageTokens(message), ChatContextBuilder::estimateTokens(kCjk));
+
+	message.m_ChatMsg = kAscii;
+	QCOMPARE(ChatContextBuilder::messageTokens(message), ChatContextBuilder::estimateTokens(kAscii));
+}
+
+void ChatContextBuilderTest::reasoningTokensFollowSameLengthEdit()
+{
+	ChatMessageData message = makeMessage(LLMChatFrame::User_Customer, kAscii, kAscii);
+	QCOMPARE(ChatContextBuilder::reasoningTokens(message), ChatContextBuilder::estimateTokens(kAscii));
+
+	message.m_ChatReasonMsg = kCjk;
+	QCOMPARE(ChatContextBuilder::reasoningTokens(message), ChatContextBuilder::estimateTokens(kCjk));
+	// 正文的缓存不受影响
+	QCOMPARE(ChatContextBuilder::messageTokens(message), ChatContextBuilder::estimateTokens(kAscii));
+}
+
+void ChatContextBuilderTest::buildUsesEditedContent()
+{
+	ChatSession session;
+	session.appendMessage(makeMessage(LLMChatFrame::User_Owner, kAscii));
+	session.appendMessage(makeMessage(LLMChatFrame::User_Customer, kAscii));
+	session.appendMessage(makeMessage(LLMChatFrame::User_Owner, QStringLiteral("next")));
+
+	ChatContextBuilder builder;
+	ChatContextReport before;
+	builder.build(QStringLiteral("s"), session, 2, 100000, &before);
+	QCOMPARE(before.includedMessages, 2);
+
+	// 同一条回答改为等长的 CJK 文本，估算必须随之增加
+	session.sMsg[1].m_ChatMsg = kCjk;
+	ChatContextReport after;
+	builder.build(QStringLiteral("s"), session, 2, 100000, &after);
+	QCOMPARE(after.includedMessages, 2);
+	QCOMPARE(after.estimatedTokens - before.estimatedTokens,
+		ChatContextBuilder::estimateTokens(kCjk) - ChatContextBuilder::estimateTokens(kAscii));
+}
+
+QTEST_APPLESS_MAIN(ChatContextBuilderTest)
+
+#include "tst_chatcontextbuilder.moc"
@@ -0,0 +1,16 @@
+QT += core testlib
+QT -= gui
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = tst_thinktagsplitter
+
+LLM_DIR = $$PWD/../../LLM
+INCLUDEPATH += $$LLM_DIR
+
+SOURCES += \
+    tst_thinktagsplitter.cpp \
+    $$LLM_DIR/ThinkTagSplitter.cpp
+
+HEADERS += \
+    $$LLM_DIR/ThinkTagSplitter.h
@@ -0,0 +1,241 @@
+#include <QStringList>
+#include <QtTest>
+
+#include "ThinkTagSplitter.h"
+
+namespace
+{
+	// 两种标记各出现一次，前后和中间都有回答
+	const QString kText = QStringLiteral(
+		"a<b<think>r-1</think>c--d---REASONING_START---r<2---REASONING_END---e-");
+	const QString kAnswer = QStringLiteral("a<bc--de-");
+	const QString kReasoning = QStringLiteral("r-1r<2");
+
+	struct Output
+	{
+		QString answer;
+		QString reasoning;
+	};
+
+	ThinkTagSplitter::SegmentHandler collect(Output& output)
+	{
+		return [&output](bool reasoning, const QStringRef& text)
+		{
+			(reasoning ? output.reasoning : output.answer).append(text);
+		};
+	}
+
+	// 按分片依次输入并结束流
+	Output feedChunks(const QStringList& chunks)
+	{
+		Output output;
+		const ThinkTagSplitter::SegmentHandler handler = collect(output);
+		ThinkTagSplitter splitter;
+		for (const QString& chunk : chunks)
+		{
+			splitter.feed(chunk, handler);
+		}
+		splitter.finish(handler);
+		return output;
+	}
+}
+
+class ThinkTagSplitterTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void wholeText();
+	void splitAtEveryOffset();
+	void splitAtEveryOffsetPair();
+	void singleCharacterChunks();
+	void partialMarkerAtEndOfStream_data();
+	void partialMarkerAtEndOfStream();
+	void chunkEndsInMarkerStart_data();
+	void chunkEndsInMarkerStart();
+	void heldBackTextWaitsForNextChunk();
+	void finishFlushesHeldBackText();
+	void nestedMarkers();
+	void resetDropsState();
+};
+
+void ThinkTagSplitterTest::wholeText()
+{
+	QString answer;
+	QString reasoning;
+	ThinkTagSplitter::split(kText, answer, reasoning);
+	QCOMPARE(answer, kAnswer);
+	QCOMPARE(reasoning, kReasoning);
+}
+
+void ThinkTagSplitterTest::splitAtEveryOffset()
+{
+	for (int i = 0; i <= kText.size(); ++i)
+	{
+		const Output output = feedChunks({ kText.left(i), kText.mid(i) });
+		QVERIFY2(output.answer == kAnswer, qPrintable(QStringLiteral("offset %1").arg(i)));
+		QVERIFY2(output.reasoning == kReasoning, qPrintable(QStringLiteral("offset %1").arg(i)));
+	}
+}
+
+void ThinkTagSplitterTest::splitAtEveryOffsetPair()
+{
+	// 三个分片：标记可能跨过整个中间分片
+	for (int i = 0; i <= kText.size(); ++i)
+	{
+		for (int j = i; j <= kText.size(); ++j)
+		{
+			const Output output = feedChunks({ kText.left(i), kText.mid(i, j - i), kText.mid(j) });
+			const QString where = QStringLiteral("offsets %1, %2").arg(i).arg(j);
+			QVERIFY2(output.answer == kAnswer, qPrintable(where));
+			QVERIFY2(output.reasoning == kReasoning, qPrintable(where));
+		}
+	}
+}
+
+void ThinkTagSplitterTest::singleCharacterChunks()
+{
+	QStringList chunks;
+	for (const QChar ch : kText)
+	{
+		chunks.append(QString(ch));
+	}
+	const Output output = feedChunks(chunks);
+	QCOMPARE(output.answer, kAnswer);
+	QCOMPARE(output.reasoning, kReasoning);
+}
+
+void ThinkTagSplitterTest::partialMarkerAtEndOfStream_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<QString>("answer");
+	QTest::addColumn<QString>("reasoning");
+
+	QTest::newRow("open think") << "answer<thi" << "answer<thi" << "";
+	QTest::newRow("lone <") << "answer<" << "answer<" << "";
+	QTest::newRow("close think") << "<think>r</thi" << "" << "r</thi";
+	QTest::newRow("reasoning start") << "x---REASONING_STA" << "x---REASONING_STA" << "";
+	QTest::newRow("reasoning end") << "---REASONING_START---r---REASONING_E" << "" << "r---REASONING_E";
+	QTest::newRow("dashes") << "a--" << "a--" << "";
+}
+
+void ThinkTagSplitterTest::partialMarkerAtEndOfStream()
+{
+	QFETCH(QString, text);
+	QFETCH(QString, answer);
+	QFETCH(QString, reasoning);
+
+	const Output whole = feedChunks({ text });
+	QCOMPARE(whole.answer, answer);
+	QCOMPARE(whole.reasoning, reasoning);
+
+	QStringList chunks;
+	for (const QChar ch : text)
+	{
+		chunks.append(QString(ch));
+	}
+	const Output pieces = feedChunks(chunks);
+	QCOMPARE(pieces.answer, answer);
+	QCOMPARE(pieces.reasoning, reasoning);
+}
+
+void ThinkTagSplitterTest::chunkEndsInMarkerStart_data()
+{
+	QTest::addColumn<QStringList>("chunks");
+	QTest::addColumn<QString>("answer");
+	QTest::addColumn<QString>("reasoning");
+
+	QTest::newRow("< then text") << QStringList{ "a<", "b" } << "a<b" << "";
+	QTest::newRow("< then think") << QStringList{ "a<", "think>r" } << "a" << "r";
+	QTest::newRow("< then <think") << QStringList{ "a<", "<think>r" } << "a<" << "r";
+	QTest::newRow("- then text") << QStringList{ "1 -", " 2" } << "1 - 2" << "";
+	QTest::newRow("- then marker") << QStringList{ "a-", "--REASONING_START---r" } << "a" << "r";
+	QTest::newRow("--- then text") << QStringList{ "a---", "b" } << "a---b" << "";
+	QTest::newRow("- then -") << QStringList{ "a-", "-", "-", "x" } << "a---x" << "";
+	QTest::newRow("</ in reasoning") << QStringList{ "<think>r</", "p>" } << "" << "r</p>";
+}
+
+void ThinkTagSplitterTest::chunkEndsInMarkerStart()
+{
+	QFETCH(QStringList, chunks);
+	QFETCH(QString, answer);
+	QFETCH(QString, reasoning);
+
+	const Output output = feedChunks(chunks);
+	QCOMPARE(output.answer, answer);
+	QCOMPARE(output.reasoning, reasoning);
+}
+
+void ThinkTagSplitterTest::heldBackTextWaitsForNextChunk()
+{
+	Output output;
+	const ThinkTagSplitter::SegmentHandler handler = collect(output);
+	ThinkTagSplitter splitter;
+
+	// 可能是标记开头的部分暂不输出
+	splitter.feed(QStringLiteral("abc</th"), handler);
+	QCOMPARE(output.answer, QStringLiteral("abc"));
+	splitter.feed(QStringLiteral("i"), handler);
+	QCOMPARE(output.answer, QStringLiteral("abc"));
+
+	// 拼上后不是标记，按普通文本输出
+	splitter.feed(QStringLiteral("s"), handler);
+	QCOMPARE(output.answer, QStringLiteral("abc</this"));
+	QVERIFY(output.reasoning.isEmpty());
+	QVERIFY(!splitter.isReasoning());
+}
+
+void ThinkTagSplitterTest::finishFlushesHeldBackText()
+{
+	Output output;
+	const ThinkTagSplitter::SegmentHandler handler = collect(output);
+	ThinkTagSplitter splitter;
+
+	splitter.feed(QStringLiteral("<think>r---REASONING_EN"), handler);
+	QCOMPARE(output.reasoning, QStringLiteral("r"));
+	QVERIFY(splitter.isReasoning());
+
+	splitter.finish(handler);
+	QCOMPARE(output.reasoning, QStringLiteral("r---REASONING_EN"));
+	QVERIFY(output.answer.isEmpty());
+
+	// 暂存只输出一次
+	splitter.finish(handler);
+	QCOMPARE(output.reasoning, QStringLiteral("r---REASONING_EN"));
+}
+
+void ThinkTagSplitterTest::nestedMarkers()
+{
+	// 标记不计嵌套层数：开始标记总是进入推理，结束标记总是回到回答，两种标记可以互相结束
+	const Output repeated = feedChunks({ QStringLiteral("<think>a<think>b</think>c</think>d") });
+	QCOMPARE(repeated.reasoning, QStringLiteral("ab"));
+	QCOMPARE(repeated.answer, QStringLiteral("cd"));
+
+	const Output mixed = feedChunks({ QStringLiteral("<think>a---REASONING_END---b") });
+	QCOMPARE(mixed.reasoning, QStringLiteral("a"));
+	QCOMPARE(mixed.answer, QStringLiteral("b"));
+
+	// 不完整的标记紧接着完整的标记
+	const Output partial = feedChunks({ QStringLiteral("<thi<think>r</thin</think>a") });
+	QCOMPARE(partial.answer, QStringLiteral("<thia"));
+	QCOMPARE(partial.reasoning, QStringLiteral("r</thin"));
+}
+
+void ThinkTagSplitterTest::resetDropsState()
+{
+	Output output;
+	const ThinkTagSplitter::SegmentHandler handler = collect(output);
+	ThinkTagSplitter splitter;
+
+	splitter.feed(QStringLiteral("<think>r</thi"), handler);
+	splitter.reset();
+	QVERIFY(!splitter.isReasoning());
+	splitter.feed(QStringLiteral("nk>a"), handler);
+	splitter.finish(handler);
+	QCOMPARE(output.answer, QStringLiteral("nk>a"));
+	QCOMPARE(output.reasoning, QStringLiteral("r"));
+}
+
+QTEST_APPLESS_MAIN(ThinkTagSplitterTest)
+
+#include "tst_thinktagsplitter.moc"